@@ -32,6 +32,7 @@
 #include "binder/expressions/bound_constant.h"
 #include "binder/expressions/bound_star.h"
 #include "binder/expressions/bound_unary_op.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/index_statement.h"
 #include "binder/statement/select_statement.h"
@@ -129,7 +130,31 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  // the parser names art as the access method when there is no USING clause, USING radix asks for the radix tree
+  auto index_type = StringUtil::Lower(stmt->accessMethod == nullptr ? "btree" : stmt->accessMethod);
+  if (index_type == "art") {
+    index_type = "btree";
+  }
+  if (index_type != "btree" && index_type != "hash" && index_type != "linear_probe" && index_type != "radix") {
+    throw NotImplementedException(fmt::format("index type {} is not supported", index_type));
+  }
+
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), stmt->unique,
+                                          std::move(index_type));
+}
+
+auto Binder::BindAnalyze(duckdb_libpgquery::PGVacuumStmt *stmt) -> std::unique_ptr<AnalyzeStatement> {
+  if ((stmt->options & duckdb_libpgquery::PG_VACOPT_VACUUM) != 0) {
+    throw NotImplementedException("vacuum is not supported");
+  }
+  if (stmt->va_cols != nullptr) {
+    throw NotImplementedException("analyze on columns is not supported");
+  }
+  if (stmt->relation == nullptr) {
+    return std::make_unique<AnalyzeStatement>("");
+  }
+  auto table = BindBaseTableRef(stmt->relation->relname, std::nullopt);
+  return std::make_unique<AnalyzeStatement>(table->table_);
 }
 
 }  // namespace bustub
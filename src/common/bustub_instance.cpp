@@ -6,6 +6,7 @@
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
@@ -226,21 +227,24 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
 
         std::vector<uint32_t> col_ids;
         for (const auto &col : index_stmt.cols_) {
-          auto idx = index_stmt.table_->schema_.GetColIdx(col->col_name_.back());
-          col_ids.push_back(idx);
-          if (index_stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
-            throw NotImplementedException("only support creating index on integer column");
-          }
-        }
-        if (col_ids.size() != 1) {
-          throw NotImplementedException("only support creating index with exactly one column");
+          col_ids.push_back(index_stmt.table_->schema_.GetColIdx(col->col_name_.back()));
         }
         auto key_schema = Schema::CopySchema(&index_stmt.table_->schema_, col_ids);
+        if (index_stmt.index_type_ != "radix" && KeyEncoding::MaxKeySize(key_schema) > GENERIC_KEY_MAX_SIZE) {
+          throw NotImplementedException(fmt::format("index keys are limited to {} bytes", GENERIC_KEY_MAX_SIZE));
+        }
 
         std::unique_lock<std::shared_mutex> l(catalog_lock_);
-        auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
-            txn, index_stmt.index_name_, index_stmt.table_->table_, index_stmt.table_->schema_, key_schema, col_ids,
-            INTEGER_SIZE, IntegerHashFunctionType{});
+        auto index_type = IndexType::BPlusTreeIndex;
+        if (index_stmt.index_type_ == "hash") {
+          index_type = IndexType::HashTableIndex;
+        } else if (index_stmt.index_type_ == "linear_probe") {
+          index_type = IndexType::LinearProbeHashTableIndex;
+        } else if (index_stmt.index_type_ == "radix") {
+          index_type = IndexType::ArtIndex;
+        }
+        auto info = catalog_->CreateIndex(txn, index_stmt.index_name_, index_stmt.table_->table_,
+                                          index_stmt.table_->schema_, col_ids, index_stmt.is_unique_, index_type);
         l.unlock();
 
         if (info == nullptr) {
@@ -249,6 +253,19 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
         WriteOneCell(fmt::format("Index created with id = {}", info->index_oid_), writer);
         continue;
       }
+      case StatementType::ANALYZE_STATEMENT: {
+        const auto &analyze_stmt = dynamic_cast<const AnalyzeStatement &>(*statement);
+
+        std::shared_lock<std::shared_mutex> l(catalog_lock_);
+        auto table_names = analyze_stmt.table_.empty() ? catalog_->GetTableNames() : std::vector{analyze_stmt.table_};
+        for (const auto &table_name : table_names) {
+          for (auto *index_info : catalog_->GetTableIndexes(table_name)) {
+            index_info->index_->Analyze(txn);
+          }
+        }
+        l.unlock();
+        continue;
+      }
       case StatementType::VARIABLE_SHOW_STATEMENT: {
         const auto &show_stmt = dynamic_cast<const VariableShowStatement &>(*statement);
         auto content = GetSessionVariable(show_stmt.variable_);
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -22,11 +23,22 @@
 
 namespace bustub {
 
+/*
+ * A new table has a directory of global depth 0 pointing to a single empty bucket
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::DiskExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                          const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+  auto *dir_page =
+      reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPage(&directory_page_id_)->GetData());
+  dir_page->SetPageId(directory_page_id_);
+  page_id_t bucket_page_id;
+  buffer_pool_manager_->NewPage(&bucket_page_id);
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  dir_page->SetLocalDepth(0, 0);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
 }
 
 /*****************************************************************************
@@ -46,22 +58,27 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
-  return 0;
+  return Hash(key) & dir_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t {
-  return 0;
+  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return nullptr;
+  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> Page * {
+  return buffer_pool_manager_->FetchPage(bucket_page_id);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  return nullptr;
+auto HASH_TABLE_TYPE::AsBucket(Page *page) -> HASH_TABLE_BUCKET_TYPE * {
+  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
 }
 
 /*****************************************************************************
@@ -69,20 +86,111 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *page = FetchBucketPage(bucket_page_id);
+  page->RLatch();
+  bool found = AsBucket(page)->GetValue(key, comparator_, result);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return found;
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+/*
+ * Only the bucket is latched, a full bucket is split by SplitInsert
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *page = FetchBucketPage(bucket_page_id);
+  page->WLatch();
+  auto *bucket = AsBucket(page);
+  bool is_full = bucket->IsFull();
+  bool inserted = !is_full && bucket->Insert(key, value, comparator_);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (!is_full) {
+    return inserted;
+  }
+  return SplitInsert(transaction, key, value);
 }
 
+/*
+ * The bucket may have changed since Insert let go of it, so look again and
+ * split until the pair fits, or until the bucket holds nothing but pairs
+ * that hash alike and the directory is full
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool inserted = false;
+  bool is_dirty = false;
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    auto *bucket = AsBucket(FetchBucketPage(bucket_page_id));
+    if (!bucket->IsFull()) {
+      inserted = bucket->Insert(key, value, comparator_);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+      break;
+    }
+    std::vector<ValueType> values;
+    bucket->GetValue(key, comparator_, &values);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    if (std::find(values.begin(), values.end(), value) != values.end() || !SplitBucket(dir_page, bucket_idx)) {
+      break;
+    }
+    is_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, is_dirty);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::SplitBucket(HashTableDirectoryPage *dir_page, uint32_t bucket_idx) -> bool {
+  uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+  if (local_depth == dir_page->GetGlobalDepth()) {
+    if (dir_page->IsFull()) {
+      return false;
+    }
+    dir_page->IncrGlobalDepth();
+  }
+  page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+  page_id_t image_page_id;
+  auto *image = AsBucket(buffer_pool_manager_->NewPage(&image_page_id));
+  auto *bucket = AsBucket(FetchBucketPage(bucket_page_id));
+
+  // every index of the bucket gets the new depth, those with the new high bit set point to the image
+  uint32_t high_bit = 1U << local_depth;
+  for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+    if (dir_page->GetBucketPageId(idx) == bucket_page_id) {
+      dir_page->IncrLocalDepth(idx);
+      if ((idx & high_bit) != 0) {
+        dir_page->SetBucketPageId(idx, image_page_id);
+      }
+    }
+  }
+  for (uint32_t slot_idx = 0; slot_idx < BUCKET_ARRAY_SIZE; slot_idx++) {
+    if (bucket->IsReadable(slot_idx) && (Hash(bucket->KeyAt(slot_idx)) & high_bit) != 0) {
+      image->Insert(bucket->KeyAt(slot_idx), bucket->ValueAt(slot_idx), comparator_);
+      bucket->RemoveAt(slot_idx);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(image_page_id, true);
+  return true;
 }
 
 /*****************************************************************************
@@ -90,14 +198,73 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.RLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *page = FetchBucketPage(bucket_page_id);
+  page->WLatch();
+  auto *bucket = AsBucket(page);
+  bool removed = bucket->Remove(key, value, comparator_);
+  bool is_empty = removed && bucket->IsEmpty();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (is_empty) {
+    Merge(transaction, key, value);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  bool is_dirty = false;
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (local_depth == 0) {
+      break;
+    }
+    uint32_t image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+    if (dir_page->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = dir_page->GetBucketPageId(image_idx);
+    // an empty image takes the place of the bucket just as well
+    auto *bucket = AsBucket(FetchBucketPage(bucket_page_id));
+    auto *image = AsBucket(FetchBucketPage(image_page_id));
+    bool is_bucket_empty = bucket->IsEmpty();
+    bool is_image_empty = image->IsEmpty();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    if (!is_bucket_empty && !is_image_empty) {
+      break;
+    }
+    page_id_t kept_page_id = is_bucket_empty ? image_page_id : bucket_page_id;
+    page_id_t deleted_page_id = is_bucket_empty ? bucket_page_id : image_page_id;
+    for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+      auto page_id = dir_page->GetBucketPageId(idx);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        dir_page->SetBucketPageId(idx, kept_page_id);
+        dir_page->DecrLocalDepth(idx);
+      }
+    }
+    buffer_pool_manager_->DeletePage(deleted_page_id);
+    is_dirty = true;
+  }
+  while (dir_page->CanShrink()) {
+    dir_page->DecrGlobalDepth();
+    is_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, is_dirty);
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
@@ -134,5 +301,7 @@ template class DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>
 template class DiskExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class DiskExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class DiskExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+template class DiskExtendibleHashTable<GenericKey<128>, RID, GenericComparator<128>>;
+template class DiskExtendibleHashTable<GenericKey<256>, RID, GenericComparator<256>>;
 
 }  // namespace bustub
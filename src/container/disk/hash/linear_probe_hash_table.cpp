@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -23,46 +25,343 @@
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                      const KeyComparator &comparator, size_t num_buckets,
-                                      HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+LINEAR_PROBE_HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                   const KeyComparator &comparator, size_t num_buckets,
+                                                   HashFunction<KeyType> hash_fn, size_t resize_step)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)),
+      resize_step_(std::max<size_t>(resize_step, 1)) {
+  header_page_ = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&header_page_id_)->GetData());
+  header_page_->SetPageId(header_page_id_);
+  CreateNewBlockPages(header_page_, std::clamp<size_t>((num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE, 1,
+                                                       HashTableHeaderPage::MAX_BLOCKS));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+LINEAR_PROBE_HASH_TABLE_TYPE::~LinearProbeHashTable() {
+  if (old_header_page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(old_header_page_->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                            std::vector<ValueType> *result) -> bool {
+  table_latch_.RLock();
+  bool found = GetValueLatchFree(header_page_, key, result);
+  if (old_header_page_ != nullptr) {
+    found = GetValueLatchFree(old_header_page_, key, result) || found;
+  }
+  table_latch_.RUnlock();
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetValueLatchFree(HashTableHeaderPage *header_page, const KeyType &key,
+                                                     std::vector<ValueType> *result) -> bool {
+  bool found = false;
+  Probe(header_page, hash_fn_.GetHash(key) % header_page->GetSize(), key,
+        [&](HASH_TABLE_BLOCK_TYPE *block, const std::vector<slot_offset_t> &slots) {
+          for (auto slot : slots) {
+            result->push_back(block->ValueAt(slot));
+          }
+          found = true;
+          return false;
+        });
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visit>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Probe(HashTableHeaderPage *header_page, size_t slot, const KeyType &key,
+                                         Visit &&visit) -> size_t {
+  auto num_slots = header_page->GetSize();
+  auto num_blocks = header_page->NumBlocks();
+  std::vector<slot_offset_t> slots;
+  for (size_t scanned = 0; scanned < num_slots;) {
+    auto block_ind = slot / BLOCK_ARRAY_SIZE;
+    auto block_page_id = header_page->GetBlockPageId(block_ind);
+    auto *block = GetBlockPage(block_page_id);
+    slots.clear();
+    auto end = block->FindKey(slot % BLOCK_ARRAY_SIZE, key, comparator_, &slots);
+    bool done = !slots.empty() && visit(block, slots);
+    buffer_pool_manager_->UnpinPage(block_page_id, done);
+    if (done) {
+      return num_slots;
+    }
+    if (end < BLOCK_ARRAY_SIZE) {
+      return block_ind * BLOCK_ARRAY_SIZE + end;
+    }
+    // the run goes on in the next block
+    scanned += BLOCK_ARRAY_SIZE - slot % BLOCK_ARRAY_SIZE;
+    slot = (block_ind + 1) % num_blocks * BLOCK_ARRAY_SIZE;
+  }
+  return num_slots;
 }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value)
+    -> bool {
+  table_latch_.RLock();
+  if (old_header_page_ == nullptr && ResizeBlocks() == 0) {
+    auto inserted = InsertLatchFree(key, value);
+    table_latch_.RUnlock();
+    return inserted;
+  }
+  table_latch_.RUnlock();
+
+  table_latch_.WLock();
+  if (old_header_page_ == nullptr) {
+    auto num_blocks = ResizeBlocks();
+    if (num_blocks > 0) {
+      StartResize(num_blocks);
+    }
+  }
+  if (old_header_page_ != nullptr) {
+    MigrateSlots(resize_step_);
+  }
+  auto inserted = InsertLatchFree(key, value);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::InsertLatchFree(const KeyType &key, const ValueType &value) -> bool {
+  // the pairs left in the old table only change under the exclusive latch
+  if (old_header_page_ != nullptr) {
+    std::vector<ValueType> values;
+    GetValueLatchFree(old_header_page_, key, &values);
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      return false;
+    }
+  }
+
+  auto num_slots = header_page_->GetSize();
+  auto home = hash_fn_.GetHash(key) % num_slots;
+  // inserts of one key queue up on the latch of its home block, so each sees the pair the one before it wrote
+  auto home_page_id = header_page_->GetBlockPageId(home / BLOCK_ARRAY_SIZE);
+  auto *home_page = buffer_pool_manager_->FetchPage(home_page_id);
+  home_page->WLatch();
+  bool duplicate = false;
+  auto find_pair = [&](HASH_TABLE_BLOCK_TYPE *block, const std::vector<slot_offset_t> &slots) {
+    duplicate = std::any_of(slots.begin(), slots.end(), [&](auto slot) { return block->ValueAt(slot) == value; });
+    return duplicate;
+  };
+  bool inserted = false;
+  for (auto slot = Probe(header_page_, home, key, find_pair); !duplicate && slot < num_slots;
+       slot = Probe(header_page_, slot, key, find_pair)) {
+    // one slot is always left unoccupied, it ends every run
+    if (num_occupied_.fetch_add(1) + 2 > num_slots) {
+      num_occupied_.fetch_sub(1);
+      break;
+    }
+    auto block_page_id = header_page_->GetBlockPageId(slot / BLOCK_ARRAY_SIZE);
+    inserted = GetBlockPage(block_page_id)->Insert(slot % BLOCK_ARRAY_SIZE, key, value);
+    buffer_pool_manager_->UnpinPage(block_page_id, inserted);
+    if (inserted) {
+      break;
+    }
+    // an insert of another key took the slot first, the run goes on past it
+    num_occupied_.fetch_sub(1);
+  }
+  home_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(home_page_id, false);
+  if (inserted) {
+    num_entries_++;
+  }
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::ResizeInsert(HashTableHeaderPage *header_page, const KeyType &key,
+                                                const ValueType &value) {
+  auto num_slots = header_page->GetSize();
+  auto slot = hash_fn_.GetHash(key) % num_slots;
+  // the new table is sized to have room for every pair, the first unoccupied slot is taken
+  for (size_t scanned = 0; scanned < num_slots;) {
+    auto block_ind = slot / BLOCK_ARRAY_SIZE;
+    auto block_page_id = header_page->GetBlockPageId(block_ind);
+    auto *block = GetBlockPage(block_page_id);
+    auto unoccupied = block->FindUnoccupied(slot % BLOCK_ARRAY_SIZE);
+    if (unoccupied < BLOCK_ARRAY_SIZE) {
+      block->Insert(unoccupied, key, value);
+      buffer_pool_manager_->UnpinPage(block_page_id, true);
+      num_occupied_++;
+      return;
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, false);
+    scanned += BLOCK_ARRAY_SIZE - slot % BLOCK_ARRAY_SIZE;
+    slot = (block_ind + 1) % header_page->NumBlocks() * BLOCK_ARRAY_SIZE;
+  }
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value)
+    -> bool {
+  table_latch_.RLock();
+  if (old_header_page_ == nullptr) {
+    auto removed = RemoveLatchFree(header_page_, key, value);
+    table_latch_.RUnlock();
+    return removed;
+  }
+  table_latch_.RUnlock();
+
+  table_latch_.WLock();
+  if (old_header_page_ != nullptr) {
+    MigrateSlots(resize_step_);
+  }
+  auto removed = RemoveLatchFree(header_page_, key, value) ||
+                 (old_header_page_ != nullptr && RemoveLatchFree(old_header_page_, key, value));
+  table_latch_.WUnlock();
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::RemoveLatchFree(HashTableHeaderPage *header_page, const KeyType &key,
+                                                   const ValueType &value) -> bool {
+  bool removed = false;
+  Probe(header_page, hash_fn_.GetHash(key) % header_page->GetSize(), key,
+        [&](HASH_TABLE_BLOCK_TYPE *block, const std::vector<slot_offset_t> &slots) {
+          // the slot stays occupied as a tombstone, two removes of the pair race for its readable bit
+          removed = std::any_of(slots.begin(), slots.end(),
+                                [&](auto slot) { return block->ValueAt(slot) == value && block->Remove(slot); });
+          return removed;
+        });
+  if (removed) {
+    num_entries_--;
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void LINEAR_PROBE_HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  if (old_header_page_ != nullptr) {
+    MigrateSlots(std::numeric_limits<size_t>::max());
+  }
+  // never too small for the pairs there are
+  auto num_slots = std::max(2 * initial_size, static_cast<size_t>(num_entries_ / LINEAR_PROBE_MAX_LOAD));
+  StartResize(
+      std::clamp<size_t>((num_slots + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE, 1, HashTableHeaderPage::MAX_BLOCKS));
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::ResizeBlocks() -> size_t {
+  auto num_slots = header_page_->GetSize();
+  if (static_cast<double>(num_occupied_) <= LINEAR_PROBE_MAX_LOAD * static_cast<double>(num_slots)) {
+    return 0;
+  }
+  auto num_blocks = header_page_->NumBlocks();
+  // most occupied slots are tombstones, a table as large is enough without them
+  if (num_entries_ * 2 <= num_occupied_) {
+    return num_blocks;
+  }
+  return num_blocks < HashTableHeaderPage::MAX_BLOCKS ? std::min(num_blocks * 2, HashTableHeaderPage::MAX_BLOCKS) : 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::StartResize(size_t num_blocks) {
+  page_id_t header_page_id;
+  auto *header_page =
+      reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&header_page_id)->GetData());
+  header_page->SetPageId(header_page_id);
+  CreateNewBlockPages(header_page, num_blocks);
+  old_header_page_ = header_page_;
+  header_page_ = header_page;
+  header_page_id_ = header_page_id;
+  next_migrate_slot_ = 0;
+  num_occupied_ = 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MigrateSlots(size_t num_slots) {
+  auto old_size = old_header_page_->GetSize();
+  while (num_slots > 0 && next_migrate_slot_ < old_size) {
+    auto block_page_id = old_header_page_->GetBlockPageId(next_migrate_slot_ / BLOCK_ARRAY_SIZE);
+    auto *block = GetBlockPage(block_page_id);
+    auto count = std::min(num_slots, BLOCK_ARRAY_SIZE - next_migrate_slot_ % BLOCK_ARRAY_SIZE);
+    for (size_t i = 0; i < count; i++) {
+      auto ind = next_migrate_slot_ % BLOCK_ARRAY_SIZE + i;
+      if (block->IsReadable(ind)) {
+        ResizeInsert(header_page_, block->KeyAt(ind), block->ValueAt(ind));
+        // lookups still walk the old table
+        block->Remove(ind);
+      }
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+    next_migrate_slot_ += count;
+    num_slots -= count;
+  }
+  if (next_migrate_slot_ == old_size) {
+    DeleteBlockPages(old_header_page_);
+    old_header_page_ = nullptr;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks) {
+  for (size_t i = 0; i < num_blocks; i++) {
+    page_id_t block_page_id;
+    // new pages are zeroed, every slot is unoccupied
+    buffer_pool_manager_->NewPage(&block_page_id);
+    header_page->AddBlockPageId(block_page_id);
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+  }
+  header_page->SetSize(num_blocks * BLOCK_ARRAY_SIZE);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::DeleteBlockPages(HashTableHeaderPage *old_header_page) {
+  for (size_t i = 0; i < old_header_page->NumBlocks(); i++) {
+    buffer_pool_manager_->DeletePage(old_header_page->GetBlockPageId(i));
+  }
+  auto header_page_id = old_header_page->GetPageId();
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  buffer_pool_manager_->DeletePage(header_page_id);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE * {
+  return reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::GetSize() -> size_t {
-  return 0;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetSize() -> size_t {
+  table_latch_.RLock();
+  auto size = header_page_->GetSize();
+  table_latch_.RUnlock();
+  return size;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetNumEntries() -> size_t {
+  return num_entries_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::IsResizing() -> bool {
+  table_latch_.RLock();
+  bool resizing = old_header_page_ != nullptr;
+  table_latch_.RUnlock();
+  return resizing;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -72,5 +371,7 @@ template class LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>>;
 template class LinearProbeHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class LinearProbeHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+template class LinearProbeHashTable<GenericKey<128>, RID, GenericComparator<128>>;
+template class LinearProbeHashTable<GenericKey<256>, RID, GenericComparator<256>>;
 
 }  // namespace bustub
@@ -16,186 +16,207 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <utility>
 
 #include "container/hash/extendible_hash_table.h"
+#include "container/hash/hash_function.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
-template <typename K, typename V>
-ExtendibleHashTable<K, V>::ExtendibleHashTable(size_t bucket_size)
-    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1) {
-  this->dir_.push_back(std::make_shared<Bucket>(this->bucket_size_, 0));
+template <typename K, typename V, typename Hash>
+ExtendibleHashTable<K, V, Hash>::ExtendibleHashTable(size_t bucket_size, Hash hash)
+    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1), hash_(std::move(hash)) {
+  this->buckets_.push_back(std::make_unique<Bucket>(this->bucket_size_, 0));
+  this->dir_.push_back(this->buckets_.back().get());
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::IndexOf(const K &key) -> size_t {
-  int mask = (1 << global_depth_) - 1;
-  return std::hash<K>()(key) & mask;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::IndexOf(size_t hash) const -> size_t {
+  return hash & ((static_cast<size_t>(1) << global_depth_) - 1);
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetGlobalDepth() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Fingerprint(size_t hash) -> uint8_t {
+  return static_cast<uint8_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetGlobalDepth() const -> int {
+  std::shared_lock lock(latch_);
   return GetGlobalDepthInternal();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetGlobalDepthInternal() const -> int {
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetGlobalDepthInternal() const -> int {
   return global_depth_;
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetLocalDepth(int dir_index) const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetLocalDepth(int dir_index) const -> int {
+  std::shared_lock lock(latch_);
   return GetLocalDepthInternal(dir_index);
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetLocalDepthInternal(int dir_index) const -> int {
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetLocalDepthInternal(int dir_index) const -> int {
   return dir_[dir_index]->GetDepth();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetNumBuckets() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetNumBuckets() const -> int {
+  std::shared_lock lock(latch_);
   return GetNumBucketsInternal();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetNumBucketsInternal() const -> int {
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::GetNumBucketsInternal() const -> int {
   return num_buckets_;
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Find(const K &key, V &value) -> bool {
-  // UNREACHABLE("not implemented");
-  std::scoped_lock<std::mutex> lock(this->latch_);
-  size_t index = this->IndexOf(key);
-  std::shared_ptr<Bucket> target_bucket = this->dir_[index];
-  return target_bucket->Find(key, value);
-}
-
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Remove(const K &key) -> bool {
-  // UNREACHABLE("not implemented");
-  std::scoped_lock<std::mutex> lock(this->latch_);
-  size_t index = this->IndexOf(key);
-  std::shared_ptr<Bucket> target_bucket = this->dir_[index];
-  return target_bucket->Remove(key);
-}
-
-template <typename K, typename V>
-void ExtendibleHashTable<K, V>::Insert(const K &key, const V &value) {
-  // UNREACHABLE("not implemented");
-  std::scoped_lock<std::mutex> lock(this->latch_);
-  while (!this->dir_[this->IndexOf(key)]->Insert(key, value)) {
-    auto index = this->IndexOf(key);
-    auto target_bucket = this->dir_[index];
-    if (target_bucket->GetDepth() == this->GetGlobalDepthInternal()) {
-      // Now need to increment the global depth
-      this->global_depth_ += 1;
-      // Increment the local depth of the buckect
-      target_bucket->IncrementDepth();
-      // Redistribute the buckets
-      auto target_index = index + (1 << (GetGlobalDepthInternal() - 1));
-      auto new_bucket = this->RedistributeBucket(target_bucket, target_index, key, value);
-      // Make a new dir
-      std::vector<std::shared_ptr<Bucket>> new_dir(1 << GetGlobalDepthInternal(), nullptr);
-      for (size_t i = 0; i < (1 << (GetGlobalDepthInternal() - 1)); i++) {
-        if (i == index) {
-          new_dir[i] = dir_[i];
-          new_dir[target_index] = new_bucket;
-        } else {
-          new_dir[i] = dir_[i];
-          new_dir[i + (1 << (GetGlobalDepthInternal() - 1))] = dir_[i];
-        }
-      }
-      this->dir_ = new_dir;
-      this->num_buckets_ += 1;
-    } else {
-      // Increment local depth
-      target_bucket->IncrementDepth();
-      // Redistrubute buckets
-      auto mask = (1 << target_bucket->GetDepth()) - 1;
-      auto target_index = std::hash<K>()(key) & mask;
-      auto new_bucket = this->RedistributeBucket(target_bucket, target_index, key, value);
-      auto pre_num_ptr = GetGlobalDepthInternal() - target_bucket->GetDepth() + 1;
-      auto now_num_ptr = GetGlobalDepthInternal() - target_bucket->GetDepth();
-      for (size_t i = 0; i < ((1 << pre_num_ptr) - (1 << now_num_ptr)); i++) {
-        this->dir_[target_index + i * (1 << target_bucket->GetDepth())] = new_bucket;
-      }
-      this->num_buckets_ += 1;
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Find(const K &key, V &value) -> bool {
+  auto hash = this->hash_(key);
+  std::shared_lock lock(this->latch_);
+  Bucket *bucket = this->dir_[this->IndexOf(hash)];
+  std::shared_lock bucket_lock(bucket->GetLatch());
+  return bucket->Find(key, Fingerprint(hash), value);
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Remove(const K &key) -> bool {
+  auto hash = this->hash_(key);
+  std::shared_lock lock(this->latch_);
+  Bucket *bucket = this->dir_[this->IndexOf(hash)];
+  std::unique_lock bucket_lock(bucket->GetLatch());
+  return bucket->Remove(key, Fingerprint(hash));
+}
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Insert(const K &key, const V &value) {
+  auto hash = this->hash_(key);
+  auto fingerprint = Fingerprint(hash);
+  {
+    // Most inserts find room in their bucket and leave the directory alone
+    std::shared_lock lock(this->latch_);
+    Bucket *bucket = this->dir_[this->IndexOf(hash)];
+    std::unique_lock bucket_lock(bucket->GetLatch());
+    if (bucket->Insert(key, fingerprint, value)) {
+      return;
     }
   }
+  // Nobody else holds a bucket while the directory is latched exclusively
+  std::unique_lock lock(this->latch_);
+  while (!this->dir_[this->IndexOf(hash)]->Insert(key, fingerprint, value)) {
+    this->SplitBucket(this->dir_[this->IndexOf(hash)], hash);
+  }
 }
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::RedistributeBucket(std::shared_ptr<Bucket> bucket, size_t index, const K &key,
-                                                   const V &value) -> std::shared_ptr<Bucket> {
-  std::shared_ptr<Bucket> new_bucket = std::make_shared<Bucket>(this->bucket_size_, bucket->GetDepth());
-  for (auto item = bucket->GetItems().begin(); item != bucket->GetItems().end();) {
-    auto current_item_hash = std::hash<K>()(item->first);
-    auto lower_bits = current_item_hash & ((1 << bucket->GetDepth()) - 1);
-    if (lower_bits == index) {
-      new_bucket->Insert(item->first, item->second);
-      item = bucket->GetItems().erase(item);
-    } else {
-      item++;
+
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::SplitBucket(Bucket *bucket, size_t hash) {
+  if (bucket->GetDepth() == this->GetGlobalDepthInternal()) {
+    // The upper half of the doubled directory points where the lower half does
+    auto size = this->dir_.size();
+    for (size_t i = 0; i < size; i++) {
+      this->dir_.push_back(this->dir_[i]);
     }
+    this->global_depth_++;
   }
-  return new_bucket;
+  auto bit = static_cast<size_t>(1) << bucket->GetDepth();
+  bucket->IncrementDepth();
+  this->buckets_.push_back(std::make_unique<Bucket>(this->bucket_size_, bucket->GetDepth()));
+  Bucket *image = this->buckets_.back().get();
+  bucket->Split(image, this->hash_, bit);
+  // The entries of the bucket share the low bits of hash, the image takes those of them that have bit set
+  for (size_t i = (hash & (bit - 1)) | bit; i < this->dir_.size(); i += bit << 1) {
+    this->dir_[i] = image;
+  }
+  this->num_buckets_++;
 }
 
 //===--------------------------------------------------------------------===//
 // Bucket
 //===--------------------------------------------------------------------===//
-template <typename K, typename V>
-ExtendibleHashTable<K, V>::Bucket::Bucket(size_t array_size, int depth) : size_(array_size), depth_(depth) {}
-
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Find(const K &key, V &value) -> bool {
-  // UNREACHABLE("not implemented");
-  for (auto item = this->list_.begin(); item != this->list_.end(); item++) {
-    if (item->first == key) {
-      value = item->second;
-      return true;
+template <typename K, typename V, typename Hash>
+ExtendibleHashTable<K, V, Hash>::Bucket::Bucket(size_t array_size, int depth) : size_(array_size), depth_(depth) {
+  this->fingerprints_.reserve(array_size);
+  this->items_.reserve(array_size);
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::IndexOf(const K &key, uint8_t fingerprint) const -> size_t {
+  for (size_t i = 0; i < this->fingerprints_.size(); i++) {
+    if (this->fingerprints_[i] == fingerprint && this->items_[i].first == key) {
+      return i;
     }
   }
-  return false;
+  return this->items_.size();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Remove(const K &key) -> bool {
-  // UNREACHABLE("not implemented");
-  for (auto item = this->list_.begin(); item != this->list_.end(); item++) {
-    if (item->first == key) {
-      this->list_.erase(item);
-      return true;
-    }
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::RemoveAt(size_t index) {
+  if (index + 1 != this->items_.size()) {
+    this->fingerprints_[index] = this->fingerprints_.back();
+    this->items_[index] = std::move(this->items_.back());
   }
-  return false;
+  this->fingerprints_.pop_back();
+  this->items_.pop_back();
 }
 
-template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Insert(const K &key, const V &value) -> bool {
-  // UNREACHABLE("not implemented")
-  for (auto item = this->list_.begin(); item != this->list_.end(); item++) {
-    if (item->first == key) {
-      item->second = value;
-      return true;
-    }
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Find(const K &key, uint8_t fingerprint, V &value) const -> bool {
+  auto index = this->IndexOf(key, fingerprint);
+  if (index == this->items_.size()) {
+    return false;
+  }
+  value = this->items_[index].second;
+  return true;
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Remove(const K &key, uint8_t fingerprint) -> bool {
+  auto index = this->IndexOf(key, fingerprint);
+  if (index == this->items_.size()) {
+    return false;
+  }
+  this->RemoveAt(index);
+  return true;
+}
+
+template <typename K, typename V, typename Hash>
+auto ExtendibleHashTable<K, V, Hash>::Bucket::Insert(const K &key, uint8_t fingerprint, const V &value) -> bool {
+  auto index = this->IndexOf(key, fingerprint);
+  if (index != this->items_.size()) {
+    this->items_[index].second = value;
+    return true;
   }
   if (IsFull()) {
     return false;
   }
-  this->list_.emplace_back(key, value);
+  this->fingerprints_.push_back(fingerprint);
+  this->items_.emplace_back(key, value);
   return true;
 }
 
+template <typename K, typename V, typename Hash>
+void ExtendibleHashTable<K, V, Hash>::Bucket::Split(Bucket *image, Hash &hash, size_t bit) {
+  for (size_t i = 0; i < this->items_.size();) {
+    if ((hash(this->items_[i].first) & bit) != 0) {
+      image->fingerprints_.push_back(this->fingerprints_[i]);
+      image->items_.push_back(std::move(this->items_[i]));
+      this->RemoveAt(i);
+    } else {
+      i++;
+    }
+  }
+}
+
 template class ExtendibleHashTable<page_id_t, Page *>;
 template class ExtendibleHashTable<Page *, std::list<Page *>::iterator>;
 template class ExtendibleHashTable<int, int>;
+template class ExtendibleHashTable<int, int, HashFunction<int>>;
 // test purpose
 template class ExtendibleHashTable<int, std::string>;
 template class ExtendibleHashTable<int, std::list<int>::iterator>;
@@ -12,11 +12,125 @@
 #include "execution/executors/index_scan_executor.h"
 
 namespace bustub {
+
+namespace {
+
+// Tuples a worker reads before handing them over, so that it takes the latch less often
+constexpr size_t WORKER_BATCH_SIZE = 64;
+
+}  // namespace
+
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+IndexScanExecutor::~IndexScanExecutor() { StopWorkers(); }
+
+void IndexScanExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  auto *index_info = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info->table_name_);
+  // release the leaf of a previous scan before latching the first one again
+  StopWorkers();
+  cursor_.reset();
+  if (plan_->GetNumParts() > 1 && !plan_->IsDescending()) {
+    part_cursors_ = index_info->index_->ScanPartitions(plan_->GetNumParts());
+  }
+  if (part_cursors_.size() <= 1) {
+    part_cursors_.clear();
+    cursor_ = index_info->index_->Scan(plan_->IsDescending());
+    BUSTUB_ENSURE(cursor_ != nullptr, "Index scan needs an ordered index");
+    return;
+  }
+  parts_ = std::vector<Part>(part_cursors_.size());
+  for (size_t i = 0; i < part_cursors_.size(); i++) {
+    workers_.emplace_back(&IndexScanExecutor::ScanPart, this, part_cursors_[i].get(), &parts_[i]);
+  }
+}
+
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!parts_.empty()) {
+    return NextFromParts(tuple, rid);
+  }
+  while (cursor_->Next(rid)) {
+    if (table_info_->table_->GetTuple(*rid, tuple, exec_ctx_->GetTransaction())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void IndexScanExecutor::ScanPart(IndexCursor *cursor, Part *part) {
+  std::vector<std::pair<Tuple, RID>> batch;
+  RID rid;
+  bool has_more = true;
+  while (has_more) {
+    Tuple tuple;
+    has_more = cursor->Next(&rid);
+    if (has_more && table_info_->table_->GetTuple(rid, &tuple, exec_ctx_->GetTransaction())) {
+      batch.emplace_back(std::move(tuple), rid);
+    }
+    if (batch.size() < WORKER_BATCH_SIZE && has_more) {
+      continue;
+    }
+    std::unique_lock lock(latch_);
+    part_changed_.wait(lock, [&] { return is_stopped_ || part->tuples_.size() < INDEX_SCAN_PART_BUFFER; });
+    if (is_stopped_) {
+      break;
+    }
+    for (auto &entry : batch) {
+      part->tuples_.push_back(std::move(entry));
+    }
+    batch.clear();
+    part->is_done_ = !has_more;
+    part_changed_.notify_all();
+  }
+}
 
-void IndexScanExecutor::Init() { throw NotImplementedException("IndexScanExecutor is not implemented"); }
+auto IndexScanExecutor::NextFromParts(Tuple *tuple, RID *rid) -> bool {
+  std::unique_lock lock(latch_);
+  while (true) {
+    bool is_pending = false;
+    for (size_t i = next_part_; i < parts_.size(); i++) {
+      auto &part = parts_[i];
+      if (!part.tuples_.empty()) {
+        *tuple = std::move(part.tuples_.front().first);
+        *rid = part.tuples_.front().second;
+        part.tuples_.pop_front();
+        part_changed_.notify_all();
+        return true;
+      }
+      if (part.is_done_) {
+        next_part_ += i == next_part_ ? 1 : 0;
+        continue;
+      }
+      is_pending = true;
+      // in key order the first part that is not done has to be emptied before the next
+      if (plan_->KeepsOrder()) {
+        break;
+      }
+    }
+    if (!is_pending) {
+      return false;
+    }
+    part_changed_.wait(lock);
+  }
+}
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+void IndexScanExecutor::StopWorkers() {
+  {
+    std::scoped_lock lock(latch_);
+    is_stopped_ = true;
+  }
+  part_changed_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  // the cursors keep their leaves latched until they are gone
+  part_cursors_.clear();
+  parts_.clear();
+  next_part_ = 0;
+  is_stopped_ = false;
+}
 
 }  // namespace bustub
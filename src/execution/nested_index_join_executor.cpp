@@ -11,20 +11,86 @@
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/nested_index_join_executor.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {
   if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
     // Note for 2022 Fall: You ONLY need to implement left join and inner join.
     throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
   }
 }
 
-void NestIndexJoinExecutor::Init() { throw NotImplementedException("NestIndexJoinExecutor is not implemented"); }
+void NestIndexJoinExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(plan_->GetInnerTableOid());
+  child_executor_->Init();
+  output_.clear();
+  output_index_ = 0;
+}
 
-auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (output_index_ == output_.size()) {
+    if (!JoinNextBatch()) {
+      return false;
+    }
+  }
+  *tuple = std::move(output_[output_index_++]);
+  *rid = tuple->GetRid();
+  return true;
+}
+
+auto NestIndexJoinExecutor::JoinNextBatch() -> bool {
+  output_.clear();
+  output_index_ = 0;
+  const auto &outer_schema = child_executor_->GetOutputSchema();
+  const auto *key_schema = index_info_->index_->GetKeySchema();
+  std::vector<Tuple> outer_tuples;
+  std::vector<Tuple> keys;
+  Tuple outer_tuple;
+  RID outer_rid;
+  while (outer_tuples.size() < static_cast<size_t>(INDEX_JOIN_BATCH_SIZE) &&
+         child_executor_->Next(&outer_tuple, &outer_rid)) {
+    keys.emplace_back(std::vector<Value>{plan_->KeyPredicate()->Evaluate(&outer_tuple, outer_schema)}, key_schema);
+    outer_tuples.push_back(outer_tuple);
+  }
+  if (outer_tuples.empty()) {
+    return false;
+  }
+
+  std::vector<std::vector<RID>> inner_rids;
+  index_info_->index_->ScanKeys(keys, &inner_rids, exec_ctx_->GetTransaction());
+  const auto &inner_schema = plan_->InnerTableSchema();
+  for (size_t i = 0; i < outer_tuples.size(); i++) {
+    std::vector<Value> values;
+    for (uint32_t column = 0; column < outer_schema.GetColumnCount(); column++) {
+      values.push_back(outer_tuples[i].GetValue(&outer_schema, column));
+    }
+    bool is_matched = false;
+    Tuple inner_tuple;
+    for (const auto &inner_rid : inner_rids[i]) {
+      if (!table_info_->table_->GetTuple(inner_rid, &inner_tuple, exec_ctx_->GetTransaction())) {
+        continue;
+      }
+      is_matched = true;
+      auto joined_values = values;
+      for (uint32_t column = 0; column < inner_schema.GetColumnCount(); column++) {
+        joined_values.push_back(inner_tuple.GetValue(&inner_schema, column));
+      }
+      output_.emplace_back(joined_values, &GetOutputSchema());
+    }
+    if (!is_matched && plan_->GetJoinType() == JoinType::LEFT) {
+      for (uint32_t column = 0; column < inner_schema.GetColumnCount(); column++) {
+        values.push_back(ValueFactory::GetNullValueByType(inner_schema.GetColumn(column).GetType()));
+      }
+      output_.emplace_back(values, &GetOutputSchema());
+    }
+  }
+  return true;
+}
 
 }  // namespace bustub
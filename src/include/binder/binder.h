@@ -76,6 +76,7 @@ class BoundExpression;
 class BoundExpressionListRef;
 class BoundOrderBy;
 class BoundSubqueryRef;
+class AnalyzeStatement;
 class CreateStatement;
 class ExplainStatement;
 class IndexStatement;
@@ -204,6 +205,8 @@ class Binder {
 
   auto BindVariableShow(duckdb_libpgquery::PGVariableShowStmt *stmt) -> std::unique_ptr<VariableShowStatement>;
 
+  auto BindAnalyze(duckdb_libpgquery::PGVacuumStmt *stmt) -> std::unique_ptr<AnalyzeStatement>;
+
   class ContextGuard {
    public:
     explicit ContextGuard(const BoundTableRef **scope, const CTEList **cte_scope) {
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -21,9 +22,11 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/art_index.h"
 #include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/index/linear_probe_hash_table_index.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -58,6 +61,17 @@ struct TableInfo {
   const table_oid_t oid_;
 };
 
+/**
+ * The data structures an index can be built on, HashTableIndex is the extendible hash table and ArtIndex the
+ * in-memory adaptive radix tree
+ */
+enum class IndexType { BPlusTreeIndex, HashTableIndex, LinearProbeHashTableIndex, ArtIndex };
+
+/** @return Whether indexes of the type keep their keys in order */
+inline auto IsOrderedIndex(IndexType index_type) -> bool {
+  return index_type == IndexType::BPlusTreeIndex || index_type == IndexType::ArtIndex;
+}
+
 /**
  * The IndexInfo class maintains metadata about a index.
  */
@@ -70,15 +84,17 @@ struct IndexInfo {
    * @param index_oid The unique OID for the index
    * @param table_name The name of the table on which the index is created
    * @param key_size The size of the index key, in bytes
+   * @param index_type The data structure of the index
    */
   IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
-            std::string table_name, size_t key_size)
+            std::string table_name, size_t key_size, IndexType index_type = IndexType::BPlusTreeIndex)
       : key_schema_{std::move(key_schema)},
         name_{std::move(name)},
         index_{std::move(index)},
         index_oid_{index_oid},
         table_name_{std::move(table_name)},
-        key_size_{key_size} {}
+        key_size_{key_size},
+        index_type_{index_type} {}
   /** The schema for the index key */
   Schema key_schema_;
   /** The name of the index */
@@ -91,6 +107,11 @@ struct IndexInfo {
   std::string table_name_;
   /** The size of the index key, in bytes */
   const size_t key_size_;
+  /** The data structure of the index, see IsOrderedIndex */
+  const IndexType index_type_;
+
+  /** @return Statistics about the contents of the index, std::nullopt if the index keeps none */
+  auto GetStatistics() const -> std::optional<IndexStatistics> { return index_->GetStatistics(); }
 };
 
 /**
@@ -196,12 +217,15 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param is_unique Whether a key may only have one value
+   * @param index_type The data structure of the index
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, bool is_unique = true,
+                   IndexType index_type = IndexType::BPlusTreeIndex) -> IndexInfo * {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
@@ -218,29 +242,40 @@ class Catalog {
     }
 
     // Construct index metdata
-    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
-
-    // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
-
-    // TODO(chi): support both hash index and btree index
-    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs, is_unique);
 
-    // Populate the index with all tuples in table heap
+    // Construct the index, take ownership of metadata, and populate it with all tuples in table heap
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+    std::unique_ptr<Index> index;
+    if (index_type == IndexType::HashTableIndex) {
+      index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                             hash_function);
+    } else if (index_type == IndexType::LinearProbeHashTableIndex) {
+      // a single block to start with, the table grows as the tuples go in
+      index = std::make_unique<LinearProbeHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_, 0,
+                                                                                              hash_function);
+    } else if (index_type == IndexType::ArtIndex) {
+      // keeps the whole encoded key, KeyType only picks the instantiation
+      index = std::make_unique<ArtIndex>(std::move(meta));
+    } else {
+      // sorted and built bottom-up
+      auto tree_index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+      tree_index->BulkLoad(heap, schema, txn);
+      index = std::move(tree_index);
+    }
+    if (index_type != IndexType::BPlusTreeIndex) {
+      for (auto iter = heap->Begin(txn); iter != heap->End(); ++iter) {
+        index->InsertEntry(iter->KeyFromTuple(schema, key_schema, key_attrs), iter->GetRid(), txn);
+      }
     }
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
 
     // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    auto index_info = std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name,
+                                                  keysize, index_type);
     auto *tmp = index_info.get();
 
     // Update internal tracking
@@ -250,6 +285,60 @@ class Catalog {
     return tmp;
   }
 
+  /**
+   * Create a new index on the given columns, keyed by the smallest generic key
+   * that holds the encoding of any value of those columns.
+   * @param txn The transaction in which the table is being created
+   * @param index_name The name of the new index
+   * @param table_name The name of the table
+   * @param schema The schema of the table
+   * @param key_attrs Key attributes
+   * @param is_unique Whether a key may only have one value
+   * @param index_type The data structure of the index
+   * @return A (non-owning) pointer to the metadata of the new index, NULL_INDEX_INFO if the key is too large
+   * for the generic keys of any index but an ArtIndex
+   */
+  auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
+                   const std::vector<uint32_t> &key_attrs, bool is_unique = true,
+                   IndexType index_type = IndexType::BPlusTreeIndex) -> IndexInfo * {
+    auto key_schema = Schema::CopySchema(&schema, key_attrs);
+    auto key_size = KeyEncoding::MaxKeySize(key_schema);
+    if (key_size <= 4) {
+      return CreateGenericIndex<4>(txn, index_name, table_name, schema, key_schema, key_attrs, is_unique,
+                                   index_type);
+    }
+    if (key_size <= 8) {
+      return CreateGenericIndex<8>(txn, index_name, table_name, schema, key_schema, key_attrs, is_unique,
+                                   index_type);
+    }
+    if (key_size <= 16) {
+      return CreateGenericIndex<16>(txn, index_name, table_name, schema, key_schema, key_attrs, is_unique,
+                                    index_type);
+    }
+    if (key_size <= 32) {
+      return CreateGenericIndex<32>(txn, index_name, table_name, schema, key_schema, key_attrs, is_unique,
+                                    index_type);
+    }
+    if (key_size <= 64) {
+      return CreateGenericIndex<64>(txn, index_name, table_name, schema, key_schema, key_attrs, is_unique,
+                                    index_type);
+    }
+    if (key_size <= 128) {
+      return CreateGenericIndex<128>(txn, index_name, table_name, schema, key_schema, key_attrs, is_unique,
+                                     index_type);
+    }
+    if (key_size <= GENERIC_KEY_MAX_SIZE) {
+      return CreateGenericIndex<GENERIC_KEY_MAX_SIZE>(txn, index_name, table_name, schema, key_schema, key_attrs,
+                                                      is_unique, index_type);
+    }
+    if (index_type == IndexType::ArtIndex) {
+      // the radix tree is not bound to a key size
+      return CreateGenericIndex<GENERIC_KEY_MAX_SIZE>(txn, index_name, table_name, schema, key_schema, key_attrs,
+                                                      is_unique, index_type);
+    }
+    return NULL_INDEX_INFO;
+  }
+
   /**
    * Get the index `index_name` for table `table_name`.
    * @param index_name The name of the index for which to query
@@ -342,6 +431,15 @@ class Catalog {
   }
 
  private:
+  template <size_t KeySize>
+  auto CreateGenericIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                          bool is_unique, IndexType index_type) -> IndexInfo * {
+    return CreateIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>(
+        txn, index_name, table_name, schema, key_schema, key_attrs, KeySize, HashFunction<GenericKey<KeySize>>{},
+        is_unique, index_type);
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
@@ -36,6 +36,20 @@ static constexpr int BUFFER_POOL_SIZE = 10;
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int EXTERNAL_SORT_BUFFER_PAGES = 256;  // pages worth of pairs sorted in memory per run
+static constexpr int EXTERNAL_SORT_FAN_IN = 16;         // runs merged at once, one pinned page each
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;    // how full bulk loaded b+ tree pages are packed
+static constexpr double BPLUS_TREE_MERGE_FILL = 0.5;    // b+ tree leaves less full are merged, 0 only merges empty ones
+static constexpr int POSTING_LIST_INLINE_SIZE = 256;    // longest posting list in bytes kept inside of a leaf
+static constexpr int INDEX_JOIN_BATCH_SIZE = 256;       // outer tuples whose keys are looked up in the index at once
+static constexpr int B_EPSILON_TREE_FANOUT = 16;        // children of a b-epsilon tree node, the rest buffers
+static constexpr int BPLUS_TREE_PINNED_PAGES = 64;      // upper b+ tree pages kept pinned, at most 1/8 of the pool
+static constexpr int INDEX_HISTOGRAM_BUCKETS = 32;      // buckets of the equi-depth histogram of an index
+static constexpr int INDEX_HISTOGRAM_SAMPLE = 1024;     // keys sampled at least to build an index histogram
+static constexpr int INDEX_SCAN_LEAVES_PER_PART = 64;   // fewest leaves an index scan gives each of its threads
+static constexpr int INDEX_SCAN_PART_BUFFER = 1024;     // tuples a parallel index scan thread reads ahead
+static constexpr double LINEAR_PROBE_MAX_LOAD = 0.6;    // occupied share of slots a linear probe table resizes at
+static constexpr int LINEAR_PROBE_RESIZE_STEP = 64;     // old slots each write moves over while a table resizes
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
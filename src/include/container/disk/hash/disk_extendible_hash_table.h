@@ -30,6 +30,12 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * Lookups, inserts and removes hold the table latch in read mode and latch
+ * the one bucket page they use. Splits and merges change the directory and
+ * hold the table latch in write mode, which keeps everybody else out, so the
+ * directory page itself is never latched. The directory is a single page, so
+ * the table has at most DIRECTORY_ARRAY_SIZE buckets.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class DiskExtendibleHashTable {
@@ -50,7 +56,7 @@ class DiskExtendibleHashTable {
    * @param transaction the current transaction
    * @param key the key to create
    * @param value the value to be associated with the key
-   * @return true if insert succeeded, false otherwise
+   * @return true if insert succeeded, false if the pair exists or its bucket can not be split any further
    */
   auto Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool;
 
@@ -132,9 +138,15 @@ class DiskExtendibleHashTable {
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
    *
    * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @return a pointer to the page, which has to be latched before its bucket is used
    */
-  auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
+  auto FetchBucketPage(page_id_t bucket_page_id) -> Page *;
+
+  /**
+   * @param page a page fetched by FetchBucketPage
+   * @return the bucket stored in page
+   */
+  static auto AsBucket(Page *page) -> HASH_TABLE_BUCKET_TYPE *;
 
   /**
    * Performs insertion with an optional bucket splitting.
@@ -146,9 +158,21 @@ class DiskExtendibleHashTable {
    */
   auto SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool;
 
+  /**
+   * Move the pairs of the full bucket at bucket_idx that belong to its new
+   * split image to a new bucket, growing the directory if it has to.
+   * Caller holds the table latch in write mode.
+   *
+   * @param dir_page the directory page
+   * @param bucket_idx a directory index of the bucket to split
+   * @return false if the directory is already as large as it can get
+   */
+  auto SplitBucket(HashTableDirectoryPage *dir_page, uint32_t bucket_idx) -> bool;
+
   /**
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
-   * if Remove makes a bucket empty.
+   * if Remove makes a bucket empty. The merged bucket may be empty as well and
+   * is merged again, then the directory shrinks as far as it can.
    *
    * There are three conditions under which we skip the merge:
    * 1. The bucket is no longer empty.
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -24,12 +25,26 @@
 
 namespace bustub {
 
-#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
+#define LINEAR_PROBE_HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
 
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * Slots are found, claimed and removed with atomic operations on the block
+ * bitmaps, so lookups, inserts and removes all run under the shared table
+ * latch; inserts of one key are serialized by the latch of its home block.
+ * Removed slots stay occupied as tombstones until the next resize.
+ *
+ * Once more than LINEAR_PROBE_MAX_LOAD of the slots are occupied the table
+ * resizes incrementally: a table twice as large takes over (or one as large,
+ * if most occupied slots are tombstones) and every following insert or remove
+ * moves resize_step slots of the old table over, under the exclusive table
+ * latch. Lookups look in both tables until the old one is empty. The header
+ * pages are kept pinned. A header page holds up to
+ * HashTableHeaderPage::MAX_BLOCKS block pages, inserts fail once the largest
+ * table is full.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable {
@@ -41,9 +56,13 @@ class LinearProbeHashTable {
    * @param comparator comparator for keys
    * @param num_buckets initial number of buckets contained by this hash table
    * @param hash_fn the hash function
+   * @param resize_step slots moved to the new table by each write while resizing
    */
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
+                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn,
+                                size_t resize_step = LINEAR_PROBE_RESIZE_STEP);
+
+  ~LinearProbeHashTable();
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -73,7 +92,8 @@ class LinearProbeHashTable {
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. The pairs
+   * move over with the following writes, a resize in progress is finished first.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
@@ -84,13 +104,40 @@ class LinearProbeHashTable {
    */
   auto GetSize() -> size_t;
 
+  /**
+   * @return the number of key-value pairs in the hash table
+   */
+  auto GetNumEntries() -> size_t;
+
+  /**
+   * @return whether pairs of an old table are still moving over
+   */
+  auto IsResizing() -> bool;
+
  private:
-  auto GetHeaderPage() -> HashTableHeaderPage *;
   auto GetBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE *;
   void ResizeInsert(HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value);
   void DeleteBlockPages(HashTableHeaderPage *old_header_page);
   void CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks);
-  auto GetValueLatchFree(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
+  auto GetValueLatchFree(HashTableHeaderPage *header_page, const KeyType &key, std::vector<ValueType> *result)
+      -> bool;
+  auto InsertLatchFree(const KeyType &key, const ValueType &value) -> bool;
+  auto RemoveLatchFree(HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value) -> bool;
+
+  /**
+   * Walks the run of key in the table of header_page from slot on, calling
+   * visit(block, slots) with the slots holding key of each block it reaches
+   * until visit returns true, which it does once it changed the block.
+   * @return the slot that ends the run, the table size if visit stopped it
+   */
+  template <typename Visit>
+  auto Probe(HashTableHeaderPage *header_page, size_t slot, const KeyType &key, Visit &&visit) -> size_t;
+
+  // Blocks of the table to resize to, 0 if the current one is fine
+  auto ResizeBlocks() -> size_t;
+  void StartResize(size_t num_blocks);
+  // Moves num_slots slots of the old table over, drops it once it is empty
+  void MigrateSlots(size_t num_slots);
 
   // member variable
   page_id_t header_page_id_;
@@ -102,6 +149,16 @@ class LinearProbeHashTable {
 
   // Hash function
   HashFunction<KeyType> hash_fn_;
+
+  // Pinned header pages of the table and, while resizing, of the old one
+  HashTableHeaderPage *header_page_;
+  HashTableHeaderPage *old_header_page_{nullptr};
+  // Slots of the old table below it are moved over
+  size_t next_migrate_slot_{0};
+  size_t resize_step_;
+  // Occupied slots of the current table, tombstones included, and pairs of both tables
+  std::atomic<size_t> num_occupied_{0};
+  std::atomic<size_t> num_entries_{0};
 };
 
 }  // namespace bustub
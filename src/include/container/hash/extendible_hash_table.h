@@ -18,9 +18,10 @@
 #pragma once
 
 #include <cstddef>
-#include <list>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
@@ -30,20 +31,27 @@ namespace bustub {
 
 /**
  * ExtendibleHashTable implements a hash table using the extendible hashing algorithm.
+ *
+ * The directory has a reader-writer latch and so has every bucket. Lookups,
+ * updates and removes hold the directory latch shared and latch only their
+ * bucket; an insert into a full bucket takes the directory latch exclusively
+ * to split it. A bucket keeps its pairs in one flat array, next to an array
+ * of one byte fingerprints of their hashes that is scanned before any key is
+ * compared.
+ *
  * @tparam K key type
  * @tparam V value type
+ * @tparam Hash hash function of keys, the low bits of the hash index the directory
  */
-template <typename K, typename V>
+template <typename K, typename V, typename Hash = std::hash<K>>
 class ExtendibleHashTable : public HashTable<K, V> {
  public:
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief Create a new ExtendibleHashTable.
    * @param bucket_size: fixed size for each bucket
+   * @param hash: the hash function
    */
-  explicit ExtendibleHashTable(size_t bucket_size);
+  explicit ExtendibleHashTable(size_t bucket_size, Hash hash = Hash());
 
   /**
    * @brief Get the global depth of the directory.
@@ -65,9 +73,6 @@ class ExtendibleHashTable : public HashTable<K, V> {
   auto GetNumBuckets() const -> int;
 
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief Find the value associated with the given key.
    *
    * Use IndexOf(key) to find the directory index the key hashes to.
@@ -79,9 +84,6 @@ class ExtendibleHashTable : public HashTable<K, V> {
   auto Find(const K &key, V &value) -> bool override;
 
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief Insert the given key-value pair into the hash table.
    * If a key already exists, the value should be updated.
    * If the bucket is full and can't be inserted, do the following steps before retrying:
@@ -96,9 +98,6 @@ class ExtendibleHashTable : public HashTable<K, V> {
   void Insert(const K &key, const V &value) override;
 
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief Given the key, remove the corresponding key-value pair in the hash table.
    * Shrink & Combination is not required for this project
    * @param key The key to be deleted.
@@ -114,7 +113,7 @@ class ExtendibleHashTable : public HashTable<K, V> {
     explicit Bucket(size_t size, int depth = 0);
 
     /** @brief Check if a bucket is full. */
-    inline auto IsFull() const -> bool { return list_.size() == size_; }
+    inline auto IsFull() const -> bool { return items_.size() == size_; }
 
     /** @brief Get the local depth of the bucket. */
     inline auto GetDepth() const -> int { return depth_; }
@@ -122,78 +121,94 @@ class ExtendibleHashTable : public HashTable<K, V> {
     /** @brief Increment the local depth of a bucket. */
     inline void IncrementDepth() { depth_++; }
 
-    inline auto GetItems() -> std::list<std::pair<K, V>> & { return list_; }
+    /** @brief The pairs of the bucket, in no particular order. */
+    inline auto GetItems() const -> const std::vector<std::pair<K, V>> & { return items_; }
+
+    /** @brief The latch of the bucket, taken under the shared directory latch. */
+    inline auto GetLatch() const -> std::shared_mutex & { return latch_; }
 
     /**
-     *
-     * TODO(P1): Add implementation
-     *
      * @brief Find the value associated with the given key in the bucket.
      * @param key The key to be searched.
+     * @param fingerprint The fingerprint of the key's hash.
      * @param[out] value The value associated with the key.
      * @return True if the key is found, false otherwise.
      */
-    auto Find(const K &key, V &value) -> bool;
+    auto Find(const K &key, uint8_t fingerprint, V &value) const -> bool;
 
     /**
-     *
-     * TODO(P1): Add implementation
-     *
      * @brief Given the key, remove the corresponding key-value pair in the bucket.
      * @param key The key to be deleted.
+     * @param fingerprint The fingerprint of the key's hash.
      * @return True if the key exists, false otherwise.
      */
-    auto Remove(const K &key) -> bool;
+    auto Remove(const K &key, uint8_t fingerprint) -> bool;
 
     /**
-     *
-     * TODO(P1): Add implementation
-     *
      * @brief Insert the given key-value pair into the bucket.
      *      1. If a key already exists, the value should be updated.
      *      2. If the bucket is full, do nothing and return false.
      * @param key The key to be inserted.
+     * @param fingerprint The fingerprint of the key's hash.
      * @param value The value to be inserted.
      * @return True if the key-value pair is inserted, false otherwise.
      */
-    auto Insert(const K &key, const V &value) -> bool;
+    auto Insert(const K &key, uint8_t fingerprint, const V &value) -> bool;
+
+    /**
+     * @brief Move the pairs whose hash has the given bit set to the split image of the bucket.
+     * @param image The new bucket.
+     * @param hash The hash function of the table.
+     * @param bit The bit told apart by the incremented local depth.
+     */
+    void Split(Bucket *image, Hash &hash, size_t bit);
 
    private:
-    // TODO(student): You may add additional private members and helper functions
+    // Index of key in items_, items_.size() if it is not there
+    auto IndexOf(const K &key, uint8_t fingerprint) const -> size_t;
+
+    // Fill the hole at index with the last pair
+    void RemoveAt(size_t index);
+
     size_t size_;
     int depth_;
-    std::list<std::pair<K, V>> list_;
+    // fingerprints_[i] belongs to items_[i], both are filled up to the same size
+    std::vector<uint8_t> fingerprints_;
+    std::vector<std::pair<K, V>> items_;
+    mutable std::shared_mutex latch_;
   };
 
  private:
-  // TODO(student): You may add additional private members and helper functions and remove the ones
-  // you don't need.
-
   int global_depth_;    // The global depth of the directory
   size_t bucket_size_;  // The size of a bucket
   int num_buckets_;     // The number of buckets in the hash table
-  mutable std::mutex latch_;
-  std::vector<std::shared_ptr<Bucket>> dir_;  // The directory of the hash table
+  Hash hash_;
+  mutable std::shared_mutex latch_;              // Latch of the directory
+  std::vector<std::unique_ptr<Bucket>> buckets_;  // The buckets, each owned once
+  std::vector<Bucket *> dir_;                    // The directory of the hash table
 
-  // The following functions are completely optional, you can delete them if you have your own ideas.
+  /**
+   * @brief Split a full bucket, moving the pairs of the new one over and pointing half of its directory entries to it.
+   * @param bucket The bucket to be split.
+   * @param hash The hash of a key of the bucket.
+   */
+  void SplitBucket(Bucket *bucket, size_t hash);
 
   /**
-   * @brief Redistribute the kv pairs in a full bucket.
-   * @param bucket The bucket to be redistributed.
+   * @brief The fingerprint kept for a hash, taken from all of its bits since the directory only looks at the low ones.
    */
-  auto RedistributeBucket(std::shared_ptr<Bucket> bucket, size_t index, const K &key, const V &value)
-      -> std::shared_ptr<Bucket>;
+  static auto Fingerprint(size_t hash) -> uint8_t;
 
   /*****************************************************************
    * Must acquire latch_ first before calling the below functions. *
    *****************************************************************/
 
   /**
-   * @brief For the given key, return the entry index in the directory where the key hashes to.
-   * @param key The key to be hashed.
+   * @brief For the given hash of a key, return the entry index in the directory where the key hashes to.
+   * @param hash The hash of the key.
    * @return The entry index in the directory.
    */
-  auto IndexOf(const K &key) -> size_t;
+  auto IndexOf(size_t hash) const -> size_t;
 
   auto GetGlobalDepthInternal() const -> int;
   auto GetLocalDepthInternal(int dir_index) const -> int;
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include "murmur3/MurmurHash3.h"
@@ -31,6 +32,9 @@ class HashFunction {
                                  reinterpret_cast<void *>(&hash));
     return hash[0];
   }
+
+  /** @brief GetHash as a function object, so in-memory containers can take it as their hash. */
+  auto operator()(const KeyType &key) -> size_t { return GetHash(key); }
 };
 
 }  // namespace bustub
@@ -12,18 +12,32 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "common/rid.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/index_scan_plan.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table, in ascending or
+ * descending key order. Tuples are fetched one at a time while the index is
+ * iterated, so a limit on top stops the scan early.
+ *
+ * A plan with several parts splits an ascending scan into key ranges, each of
+ * which a worker thread reads into a buffer of its own. The ranges are output
+ * one after another if the plan keeps order, otherwise from whichever buffer
+ * has tuples. Workers read at most INDEX_SCAN_PART_BUFFER tuples ahead.
  */
 
 class IndexScanExecutor : public AbstractExecutor {
@@ -41,8 +55,42 @@ class IndexScanExecutor : public AbstractExecutor {
 
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  // Workers are stopped before the executor goes away
+  ~IndexScanExecutor() override;
+
  private:
+  /** Tuples of one key range, read by its worker */
+  struct Part {
+    std::deque<std::pair<Tuple, RID>> tuples_;
+    bool is_done_{false};
+  };
+
+  /** Worker: read the tuples of a range into its part */
+  void ScanPart(IndexCursor *cursor, Part *part);
+
+  /** Take the next tuple of a parallel scan, waiting for the workers if need be */
+  auto NextFromParts(Tuple *tuple, RID *rid) -> bool;
+
+  /** Stop the workers of a parallel scan, join them and drop their parts */
+  void StopWorkers();
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The table the index refers to */
+  TableInfo *table_info_{nullptr};
+  /** Position in the index, keeps its current leaf latched until it reaches the end */
+  std::unique_ptr<IndexCursor> cursor_;
+
+  /** Parallel scan: one cursor, part and worker per key range */
+  std::vector<std::unique_ptr<IndexCursor>> part_cursors_;
+  std::vector<Part> parts_;
+  std::vector<std::thread> workers_;
+  /** Protects the parts, whose changes are signaled on part_changed_ */
+  std::mutex latch_;
+  std::condition_variable part_changed_;
+  /** Parts before it are done and empty */
+  size_t next_part_{0};
+  /** Set when the workers have to stop early */
+  bool is_stopped_{false};
 };
 }  // namespace bustub
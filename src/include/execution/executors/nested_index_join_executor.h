@@ -28,7 +28,9 @@
 namespace bustub {
 
 /**
- * IndexJoinExecutor executes index join operations.
+ * IndexJoinExecutor executes index join operations. Outer tuples are taken
+ * from the child in batches of INDEX_JOIN_BATCH_SIZE, and the keys of a batch
+ * are looked up in the index together, so that the index can share the work.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -48,7 +50,18 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  // Join the next batch of outer tuples into output_, false if the child is exhausted
+  auto JoinNextBatch() -> bool;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  /** The outer table */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The index that is probed and the inner table it refers to */
+  IndexInfo *index_info_{nullptr};
+  TableInfo *table_info_{nullptr};
+  /** Joined tuples of the current batch and the next one to emit */
+  std::vector<Tuple> output_;
+  size_t output_index_{0};
 };
 }  // namespace bustub
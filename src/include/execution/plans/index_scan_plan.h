@@ -29,25 +29,60 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_oid the identifier of table to be scanned
+   * @param is_descending whether to scan from the largest key down
+   * @param num_parts how many key ranges of an ascending scan are read by threads of their own
+   * @param keep_order whether the tuples of a parallel scan come out in key order
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, bool is_descending = false, int num_parts = 1,
+                    bool keep_order = true)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        is_descending_(is_descending),
+        num_parts_(num_parts),
+        keep_order_(keep_order) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the identifier of the table that should be scanned */
   auto GetIndexOid() const -> index_oid_t { return index_oid_; }
 
+  /** @return whether the index is scanned in descending key order */
+  auto IsDescending() const -> bool { return is_descending_; }
+
+  /** @return the number of key ranges scanned in parallel, 1 for a serial scan */
+  auto GetNumParts() const -> int { return num_parts_; }
+
+  /** @return whether a parallel scan puts its tuples back into key order */
+  auto KeepsOrder() const -> bool { return keep_order_; }
+
   BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(IndexScanPlanNode);
 
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
 
-  // Add anything you want here for index lookup
+  /** Scan from the largest key down, for ORDER BY ... DESC */
+  bool is_descending_;
+
+  /** Key ranges read by threads of their own, ranges are only split for ascending scans */
+  int num_parts_;
+
+  /**
+   * Whether the ranges are output one after another, in key order. Otherwise
+   * tuples are output as soon as any thread has read them.
+   */
+  bool keep_order_;
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    std::string options;
+    if (is_descending_) {
+      options += ", descending=true";
+    }
+    if (num_parts_ > 1) {
+      options += fmt::format(", parts={}", num_parts_);
+      options += keep_order_ ? "" : ", keep_order=false";
+    }
+    return fmt::format("IndexScan {{ index_oid={}{} }}", index_oid_, options);
   }
 };
 
@@ -95,14 +95,25 @@ class Optimizer {
   auto OptimizeSortLimitAsTopN(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
   /**
-   * @brief get the estimated cardinality for a table based on the table name. Useful when join reordering. BusTub
-   * doesn't support statistics for now, so it's the only way for you to get the table size :(
+   * @brief get the estimated cardinality for a table. Useful when join reordering. Tables with an index that keeps
+   * statistics have its number of values, the size of others is guessed from the table name.
    *
    * @param table_name
    * @return std::optional<size_t>
    */
   auto EstimatedCardinality(const std::string &table_name) -> std::optional<size_t>;
 
+  /**
+   * @brief check from the statistics of an index whether reading its table in key order through the index costs less
+   * than a sequential scan followed by a sort
+   */
+  auto IsIndexOrderCheaper(const IndexStatistics &statistics) -> bool;
+
+  /**
+   * @brief the number of key ranges an index scan is split into, for threads to read them in parallel
+   */
+  auto IndexScanParts(const IndexStatistics &statistics) -> int;
+
   /** Catalog will be used during the planning process. USERS SHOULD ENSURE IT OUTLIVES
    * OPTIMIZER, otherwise it's a dangling reference.
    */
@@ -12,9 +12,13 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -22,7 +26,6 @@
 #include <vector>
 
 #include "common/exception.h"
-#include "common/rwlatch.h"
 
 namespace bustub {
 
@@ -244,29 +247,181 @@ class TrieNodeWithValue : public TrieNode {
   T GetValue() const { return value_; }
 };
 
+/** Node types of the adaptive radix tree that Trie keeps its keys in. */
+enum class ArtNodeType : uint8_t { Leaf, Node4, Node16, Node48, Node256 };
+
+/**
+ * ArtNode is the header of every node of the adaptive radix tree. A child
+ * slot holds either an inner node, which tells its children apart by one key
+ * byte, or a leaf. Nodes are never changed once a version of the tree that
+ * has them is published, writers change copies of them.
+ */
+class ArtNode {
+ public:
+  explicit ArtNode(ArtNodeType type) : type_(type) {}
+  ArtNode(const ArtNode &) = default;
+  auto operator=(const ArtNode &) -> ArtNode & = delete;
+  virtual ~ArtNode() = default;
+
+  auto GetType() const -> ArtNodeType { return type_; }
+  auto IsLeaf() const -> bool { return type_ == ArtNodeType::Leaf; }
+
+ private:
+  ArtNodeType type_;
+};
+
+/**
+ * ArtLeaf holds a whole key. Leaves hang off the inner node where their key
+ * parts from every other key (lazy expansion), so a key with no neighbours
+ * costs one leaf rather than a node per character.
+ */
+class ArtLeaf : public ArtNode {
+ public:
+  ArtLeaf(std::string key, const void *value_type)
+      : ArtNode(ArtNodeType::Leaf), key_(std::move(key)), value_type_(value_type) {}
+
+  auto GetKey() const -> const std::string & { return key_; }
+
+  /** @return The tag of the type of the value, see ArtLeafWithValue::ValueType. */
+  auto GetValueType() const -> const void * { return value_type_; }
+
+ private:
+  std::string key_;
+  const void *value_type_;
+};
+
+/**
+ * ArtLeafWithValue is a leaf with a value of type T. Its type is told by a
+ * tag, so a lookup checks it without a dynamic_cast.
+ */
+template <typename T>
+class ArtLeafWithValue : public ArtLeaf {
+ public:
+  ArtLeafWithValue(std::string key, T value) : ArtLeaf(std::move(key), ValueType()), value_(std::move(value)) {}
+
+  /** @return The tag of T, the address of a static that differs for every T. */
+  static auto ValueType() -> const void * {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  auto GetValue() const -> T { return value_; }
+
+ private:
+  T value_;
+};
+
+/**
+ * ArtInnerNode is the part of the header shared by inner nodes. A node skips
+ * the bytes its keys have in common after the byte of its parent (path
+ * compression): all of them are counted in prefix_len_ but only the first
+ * MAX_PREFIX_LEN are kept, lookups skip the rest and compare the whole key
+ * at the leaf. The key that ends right after the prefix is kept in leaf_.
+ */
+class ArtInnerNode : public ArtNode {
+ public:
+  static constexpr uint32_t MAX_PREFIX_LEN = 8;
+
+  explicit ArtInnerNode(ArtNodeType type) : ArtNode(type) {}
+
+  uint16_t num_children_{0};
+  uint32_t prefix_len_{0};
+  std::array<uint8_t, MAX_PREFIX_LEN> prefix_{};
+  std::shared_ptr<const ArtLeaf> leaf_;
+};
+
+/** Up to 4 children, keys_ sorted. */
+class ArtNode4 : public ArtInnerNode {
+ public:
+  ArtNode4() : ArtInnerNode(ArtNodeType::Node4) {}
+
+  std::array<uint8_t, 4> keys_{};
+  std::array<std::shared_ptr<const ArtNode>, 4> children_;
+};
+
+/** Up to 16 children, keys_ sorted and searched all at once with SSE2. */
+class ArtNode16 : public ArtInnerNode {
+ public:
+  ArtNode16() : ArtInnerNode(ArtNodeType::Node16) {}
+
+  std::array<uint8_t, 16> keys_{};
+  std::array<std::shared_ptr<const ArtNode>, 16> children_;
+};
+
+/** Up to 48 children, child_index_ maps a key byte to its slot in children_ plus one, 0 if there is none. */
+class ArtNode48 : public ArtInnerNode {
+ public:
+  ArtNode48() : ArtInnerNode(ArtNodeType::Node48) {}
+
+  std::array<uint8_t, 256> child_index_{};
+  std::array<std::shared_ptr<const ArtNode>, 48> children_;
+};
+
+/** A child slot for every key byte. */
+class ArtNode256 : public ArtInnerNode {
+ public:
+  ArtNode256() : ArtInnerNode(ArtNodeType::Node256) {}
+
+  std::array<std::shared_ptr<const ArtNode>, 256> children_;
+};
+
 /**
  * Trie is a concurrent key-value store. Each key is a string and its corresponding
  * value can be any type.
+ *
+ * The keys are kept in an adaptive radix tree: inner nodes grow from 4 to 16,
+ * 48 and 256 children as they fill up and shrink back as they empty, so a
+ * node is about as large as its fanout needs.
+ *
+ * The tree is persistent. A writer copies the nodes on the path to the key it
+ * changes and publishes the new root; readers take the root that is current
+ * when they start and walk its version without a latch or reference counts.
+ * Nodes are shared between versions. Readers count themselves in the epoch
+ * they start in. A writer keeps the versions it replaces, and moves on to a
+ * new epoch once no reader is left in the one before the current one; the
+ * versions replaced before that are read by nobody then and are dropped,
+ * which frees the nodes no other version has. Writers never wait for readers.
  */
 class Trie {
  private:
-  /* Root node of the trie */
-  std::unique_ptr<TrieNode> root_;
-  /* Read-write lock for the trie */
-  ReaderWriterLatch latch_;
+  /* Root of the current version of the tree, nullptr if the trie is empty. Only writers touch it */
+  std::shared_ptr<const ArtNode> root_;
+  /* The same root, for readers */
+  std::atomic<const ArtNode *> reader_root_{nullptr};
+  /* Bumped by every writer after publishing a version */
+  std::atomic<uint64_t> epoch_{0};
+  /* Readers in an even and an odd epoch */
+  std::array<std::atomic<int64_t>, 2> num_readers_{};
+  /* Roots replaced in the current epoch, and in the one before it */
+  std::vector<std::shared_ptr<const ArtNode>> retired_;
+  std::vector<std::shared_ptr<const ArtNode>> previous_retired_;
+  /* Serializes the writers, readers take no latch */
+  std::mutex write_latch_;
+
+  /** @return False if the key of the leaf is already there, the leaf is dropped then. */
+  auto InsertLeaf(std::shared_ptr<const ArtLeaf> leaf) -> bool;
+
+  /** @return True if the key was there and is removed. */
+  auto RemoveLeaf(const std::string &key) -> bool;
+
+  /** @return The leaf of the key in the version of root, nullptr if there is none. */
+  static auto FindLeaf(const ArtNode *root, const std::string &key) -> const ArtLeaf *;
+
+  /** Make root the current version, and drop the replaced versions nobody reads anymore. */
+  void Publish(std::shared_ptr<const ArtNode> root);
+
+  /** @return The epoch the reader is counted in, the version it reads lives until EndRead. */
+  auto BeginRead() -> uint64_t;
+
+  void EndRead(uint64_t epoch);
 
  public:
   /**
-   * TODO(P0): Add implementation
-   *
-   * @brief Construct a new Trie object. Initialize the root node with '\0'
-   * character.
+   * @brief Construct a new, empty Trie object.
    */
-  Trie() { this->root_ = std::make_unique<TrieNode>('\0'); }
+  Trie() = default;
 
   /**
-   * TODO(P0): Add implementation
-   *
    * @brief Insert key-value pair into the trie.
    *
    * If the key is an empty string, return false immediately.
@@ -274,18 +429,6 @@ class Trie {
    * If the key already exists, return false. Duplicated keys are not allowed and
    * you should never overwrite value of an existing key.
    *
-   * When you reach the ending character of a key:
-   * 1. If TrieNode with this ending character does not exist, create new TrieNodeWithValue
-   * and add it to parent node's children_ map.
-   * 2. If the terminal node is a TrieNode, then convert it into TrieNodeWithValue by
-   * invoking the appropriate constructor.
-   * 3. If it is already a TrieNodeWithValue,
-   * then insertion fails and returns false. Do not overwrite existing data with new data.
-   *
-   * You can quickly check whether a TrieNode pointer holds TrieNode or TrieNodeWithValue
-   * by checking the is_end_ flag. If is_end_ == false, then it points to TrieNode. If
-   * is_end_ == true, it points to TrieNodeWithValue.
-   *
    * @param key Key used to traverse the trie and find the correct node
    * @param value Value to be inserted
    * @return True if insertion succeeds, false if the key already exists
@@ -295,45 +438,13 @@ class Trie {
     if (key.empty()) {
       return false;
     }
-    this->latch_.WLock();
-    std::unique_ptr<TrieNode> *node = &this->root_;
-    for (char c : key) {
-      // if ((*node)->IsEndNode()) {
-      //   (*node)->SetEndNode(false);
-      // }
-      if ((*node)->HasChild(c)) {
-        std::unique_ptr<TrieNode> *child_node = (*node)->GetChildNode(c);
-        node = child_node;
-      } else {
-        (*node)->InsertChildNode(c, std::make_unique<TrieNode>(c));
-        std::unique_ptr<TrieNode> *child_node = (*node)->GetChildNode(c);
-        node = child_node;
-      }
-    }
-    if ((*node)->IsEndNode()) {
-      // It is a TrieNodeWithValue node
-      this->latch_.WUnlock();
-      return false;
-    }
-    (*node).reset(new TrieNodeWithValue<T>(std::move(*(*node)), value));
-    // This syntax is extremely important!!!
-    this->latch_.WUnlock();
-    return true;
+    return this->InsertLeaf(std::make_shared<ArtLeafWithValue<T>>(key, std::move(value)));
   }
 
   /**
-   * TODO(P0): Add implementation
-   *
    * @brief Remove key value pair from the trie.
-   * This function should also remove nodes that are no longer part of another
-   * key. If key is empty or not found, return false.
-   *
-   * You should:
-   * 1) Find the terminal node for the given key.
-   * 2) If this terminal node does not have any children, remove it from its
-   * parent's children_ map.
-   * 3) Recursively remove nodes that have no children and are not terminal node
-   * of another key.
+   * Nodes that are left with a single entry are merged into their parent.
+   * If key is empty or not found, return false.
    *
    * @param key Key used to traverse the trie and find the correct node
    * @return True if the key exists and is removed, false otherwise
@@ -342,75 +453,36 @@ class Trie {
     if (key.empty()) {
       return false;
     }
-    this->latch_.WLock();
-    auto flag = RemoveRecursion(key, &(this->root_), 0);
-    this->latch_.WUnlock();
-    return flag;
-  }
-
-  bool RemoveRecursion(const std::string &key, std::unique_ptr<TrieNode> *node, size_t index) {
-    if (index == key.size()) {
-      if (!(*node)->IsEndNode()) {
-        return false;
-      }
-      (*node)->SetEndNode(false);
-      return true;
-    }
-    if (!(*node)->HasChild(key.at(index))) {
-      return false;
-    }
-    if ((*node)->HasChild(key.at(index))) {
-      std::unique_ptr<TrieNode> *target_node = (*node)->GetChildNode(key.at(index));
-      if (RemoveRecursion(key, target_node, index + 1)) {
-        if (!(*target_node)->HasChildren() && !(*target_node)->IsEndNode()) {
-          (*node)->RemoveChildNode(key.at(index));
-        }
-        return true;
-      }
-      return false;
-    }
-    return false;  // NOT HERE
+    return this->RemoveLeaf(key);
   }
 
   /**
-   * TODO(P0): Add implementation
-   *
    * @brief Get the corresponding value of type T given its key.
    * If key is empty, set success to false.
    * If key does not exist in trie, set success to false.
-   * If the given type T is not the same as the value type stored in TrieNodeWithValue
-   * (ie. GetValue<int> is called but terminal node holds std::string),
+   * If the given type T is not the same as the value type stored in the leaf
+   * (ie. GetValue<int> is called but the leaf holds std::string),
    * set success to false.
    *
-   * To check whether the two types are the same, dynamic_cast
-   * the terminal TrieNode to TrieNodeWithValue<T>. If the casted result
-   * is not nullptr, then type T is the correct type.
-   *
    * @param key Key used to traverse the trie and find the correct node
    * @param success Whether GetValue is successful or not
    * @return Value of type T if type matches
    */
   template <typename T>
   T GetValue(const std::string &key, bool *success) {
-    std::unique_ptr<TrieNode> *node = &this->root_;
-    this->latch_.RLock();
-    for (char c : key) {
-      if (!(*node)->HasChild(c)) {
-        *success = false;
-        this->latch_.RUnlock();
-        return {};
-      }
-      node = (*node)->GetChildNode(c);
-    }
-    auto t_node = dynamic_cast<TrieNodeWithValue<T> *>(node->get());
-    if (t_node == nullptr) {
+    if (key.empty()) {
       *success = false;
-      this->latch_.RUnlock();
       return {};
     }
-    *success = true;
-    this->latch_.RUnlock();
-    return t_node->GetValue();
+    auto epoch = this->BeginRead();
+    const ArtLeaf *leaf = FindLeaf(this->reader_root_.load(), key);
+    *success = leaf != nullptr && leaf->GetValueType() == ArtLeafWithValue<T>::ValueType();
+    T value{};
+    if (*success) {
+      value = static_cast<const ArtLeafWithValue<T> *>(leaf)->GetValue();
+    }
+    this->EndRead(epoch);
+    return value;
   }
 };
 }  // namespace bustub
@@ -83,6 +83,9 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of disk reads */
+  auto GetNumReads() const -> int;
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -102,6 +105,7 @@ class DiskManager {
   std::string file_name_;
   int num_flushes_{0};
   int num_writes_{0};
+  int num_reads_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
   // With multiple buffer pool instances, need to protect file access
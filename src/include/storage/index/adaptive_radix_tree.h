@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree.h
+//
+// Identification: src/include/storage/index/adaptive_radix_tree.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+
+#include "common/rid.h"
+
+namespace bustub {
+
+struct RadixNode;
+
+/**
+ * AdaptiveRadixTree is an in-memory map from byte strings to RIDs, ordered
+ * like memcmp orders the keys.
+ *
+ * Inner nodes tell their children apart by one key byte and grow from 4 to
+ * 16, 48 and 256 children as they fill up, and shrink back as they empty.
+ * Bytes all keys below a node share are kept in the node (path compression)
+ * and a key with no neighbours is a leaf right below the node where it parts
+ * from the others (lazy expansion), so a lookup touches about one node per
+ * byte that tells the key apart rather than one per key byte.
+ *
+ * One reader-writer latch guards the whole tree.
+ */
+class AdaptiveRadixTree {
+ public:
+  /** Visits a pair of a scan, returns false to stop the scan */
+  using Visitor = std::function<bool(const std::string &key, const RID &value)>;
+
+  AdaptiveRadixTree();
+  ~AdaptiveRadixTree();
+
+  /** @return False if the key is already there */
+  auto Insert(const std::string &key, const RID &value) -> bool;
+
+  /** @return True if the key was there with the value and is removed */
+  auto Remove(const std::string &key, const RID &value) -> bool;
+
+  /** @return Whether the key is there, its value goes to value */
+  auto GetValue(const std::string &key, RID *value) const -> bool;
+
+  /**
+   * Visit the pairs whose keys are in [begin, end), in order of their keys or
+   * from the largest key down, until visitor returns false. The tree is read
+   * latched all along, visitor must not change it.
+   * @param begin The smallest key to visit
+   * @param end The key to stop at, std::nullopt to visit up to the largest key
+   * @param descending Whether to visit from the largest key down
+   */
+  void Scan(const std::string &begin, const std::optional<std::string> &end, bool descending,
+            const Visitor &visitor) const;
+
+  /** @return The number of keys */
+  auto GetSize() const -> size_t;
+
+  /**
+   * @return The smallest key greater than all keys that start with prefix,
+   * std::nullopt if there is none, i.e. prefix is all 0xFF bytes
+   */
+  static auto PrefixEnd(std::string prefix) -> std::optional<std::string>;
+
+ private:
+  std::unique_ptr<RadixNode> root_;
+  size_t size_{0};
+  mutable std::shared_mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index.h
+//
+// Identification: src/include/storage/index/art_index.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "storage/index/adaptive_radix_tree.h"
+#include "storage/index/index.h"
+
+namespace bustub {
+
+/**
+ * ArtIndex keeps the keys of an index in an in-memory adaptive radix tree.
+ *
+ * Keys are stored in the order preserving encoding of KeyEncoding, not cut
+ * off at a generic key size, so the tree orders them like SQL does and a
+ * lookup compares key bytes only where keys part rather than column values
+ * at every level, which is what makes long VARCHAR and composite keys cheap.
+ * A key of an index that is not unique is followed by the RID of its tuple,
+ * so every entry has a key of its own and the entries of a key are next to
+ * each other in RID order.
+ *
+ * The index is not stored on disk and is built again with the catalog.
+ */
+class ArtIndex : public Index {
+ public:
+  explicit ArtIndex(std::unique_ptr<IndexMetadata> &&metadata);
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  auto Scan(bool descending) -> std::unique_ptr<IndexCursor> override;
+
+  /**
+   * Scan the entries with keys in [begin, end) in key order.
+   * @param begin The smallest key, std::nullopt to start at the smallest key of the index
+   * @param end The key to stop before, std::nullopt to scan up to the largest key of the index
+   */
+  auto ScanRange(const std::optional<Tuple> &begin, const std::optional<Tuple> &end) -> std::unique_ptr<IndexCursor>;
+
+  /**
+   * Scan the entries whose first key columns equal prefix, in key order.
+   * @param prefix Values of the first key columns, at most as many as there are key columns
+   * @param partial_last Whether the last value is a VARCHAR the column only has to start with, like LIKE 'abc%'
+   */
+  auto ScanPrefix(const std::vector<Value> &prefix, bool partial_last = false) -> std::unique_ptr<IndexCursor>;
+
+  /** @return The number of entries */
+  auto GetNumEntries() const -> size_t { return container_.GetSize(); }
+
+ private:
+  /** @return The encoding of the key columns of key */
+  auto EncodeKey(const Tuple &key) const -> std::string;
+
+  /** @return The key of the entry of key and rid in the tree */
+  auto EntryKey(const Tuple &key, RID rid) const -> std::string;
+
+  AdaptiveRadixTree container_;
+};
+
+}  // namespace bustub
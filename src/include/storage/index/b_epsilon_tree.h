@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/index/b_epsilon_tree.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "concurrency/transaction.h"
+#include "storage/page/b_epsilon_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+
+namespace bustub {
+
+#define BEPSILONTREE_TYPE BEpsilonTree<KeyType, ValueType, KeyComparator>
+
+/**
+ * Write optimized variant of the B+ tree for unique keys.
+ *
+ * Leaves are B+ tree leaves, but internal pages spend most of their space on
+ * a buffer of messages (see b_epsilon_tree_internal_page.h) and only have a
+ * small fanout. Inserts and removes add a message to the root buffer, a full
+ * buffer is flushed by moving the messages of the child that gets the most of
+ * them down in one batch. A random insert thus costs a fraction of a page
+ * write, where a B+ tree writes a leaf for every one of them.
+ * (1) Insert overwrites the value of an existing key and Remove of a missing
+ *     key does nothing, since neither looks at the leaves
+ * (2) Point lookups return the newest message for the key on the way down,
+ *     and only look at the leaf if there is none
+ * (3) Pages split but are never merged, leaves that lose all of their keys
+ *     stay in the tree
+ * (4) Writers hold the tree latch exclusively, lookups share it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BEpsilonTree {
+  using InternalPage = BEpsilonTreeInternalPage<KeyType, ValueType, KeyComparator>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using Pivot = typename InternalPage::Pivot;
+  using Message = typename InternalPage::Message;
+
+ public:
+  explicit BEpsilonTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                        int leaf_max_size = LEAF_PAGE_SIZE, int fanout = B_EPSILON_TREE_FANOUT);
+
+  // Returns true if this tree has no keys and no messages.
+  auto IsEmpty() const -> bool;
+
+  // Insert a key-value pair, or replace the value of key if it exists.
+  void Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // Remove a key and its value.
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
+
+  // return the page id of the root node
+  auto GetRootPageId() -> page_id_t;
+
+ private:
+  // Send a message down from the root, growing the tree if the root splits
+  void Apply(const Message &message);
+
+  /*
+   * Apply sorted messages to the subtree of page_id, flushing buffers that
+   * overflow. Returns the pivots of the pages page_id was split into, other
+   * than itself.
+   */
+  auto PushDown(page_id_t page_id, std::vector<Message> &&messages) -> std::vector<Pivot>;
+  auto PushDownLeaf(LeafPage *leaf_page, std::vector<Message> &&messages) -> std::vector<Pivot>;
+  auto PushDownInternal(InternalPage *internal_page, std::vector<Message> &&messages) -> std::vector<Pivot>;
+
+  // Store pivots and messages in page and as many new pages as needed, returns the pivots of the new pages
+  auto StoreInternal(InternalPage *internal_page, const std::vector<Pivot> &pivots,
+                     const std::vector<Message> &messages) -> std::vector<Pivot>;
+
+  // Merge two sorted message lists, newer replaces older for the same key
+  auto MergeMessages(std::vector<Message> &&older, std::vector<Message> &&newer) const -> std::vector<Message>;
+
+  void UpdateRootPageId();
+
+  // member variable
+  std::string index_name_;
+  page_id_t root_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  int leaf_max_size_;
+  int fanout_;
+  ReaderWriterLatch latch_;
+};
+
+}  // namespace bustub
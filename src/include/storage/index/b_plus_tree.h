@@ -10,10 +10,19 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
 #include <queue>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -29,19 +38,39 @@ namespace bustub {
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique unless the tree is created with is_unique unset, then
+ *     every key holds a sorted posting list of its values
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ * (5) Concurrent access via latch crabbing: readers couple read latches down
+ *     the tree, writers first try an optimistic descent that only write-latches
+ *     the leaf and fall back to write-latching the unsafe part of the path.
+ * (6) Point lookups use optimistic lock coupling on page versions and do not
+ *     latch at all unless they keep conflicting with writers.
+ * (7) Range scans keep their current leaf read latched and only try-latch the
+ *     next one, since writers latch siblings in both directions. Leaves are
+ *     linked both ways, so scans can also run from right to left.
+ * (8) The top levels of internal pages stay pinned, descents take them from a
+ *     snapshot instead of the buffer pool. Writers collect the snapshot again
+ *     when the pinned epoch says the root or an internal page changed.
+ * (9) Writers keep counts of keys, values, leaves and levels for the planner,
+ *     a histogram of the keys is built by bulk loads and Analyze.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  // iterators search the tree again when they can not latch the next leaf
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     bool is_unique = true, double merge_fill = BPLUS_TREE_MERGE_FILL);
+
+  // Pinned pages are not given back, the buffer pool may already be gone
+  ~BPlusTree();
 
   // Accroding to the given key, find the leaf page id
   auto FindLeaf(const KeyType &key, page_id_t *page_id) -> bool;
@@ -49,15 +78,55 @@ class BPlusTree {
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
 
-  // Insert a key-value pair into this B+ tree.
+  // Returns false if a key may have several values
+  auto IsUnique() const -> bool;
+
+  // Insert a key-value pair into this B+ tree, false if the key (or the pair in a non-unique tree) exists.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
+  // Build the tree bottom-up from pairs returned in key order by next_pair, only works on an empty tree
+  auto BulkLoad(const std::function<bool(MappingType *)> &next_pair, double fill_factor = BULK_LOAD_FILL_FACTOR)
+      -> bool;
+
+  // Remove a key and all of its values from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // Return the value associated with a given key
+  // Remove a key-value pair from this B+ tree.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // Merge the leaves less than fill full into their siblings, for trees that merge lazily. Safe to run alongside
+  // other operations, e.g. from a background thread.
+  void Compact(double fill = 0.5, Transaction *transaction = nullptr);
+
+  // Return the values associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
+  // Call consumer on the values of a given key in order until it returns false, the tree must not be modified by it
+  auto ScanKey(const KeyType &key, const std::function<bool(const ValueType &)> &consumer,
+               Transaction *transaction = nullptr) -> bool;
+
+  // Look up several keys in one walk down the tree, results[i] gets the values of keys[i]. Sorted keys are cheapest.
+  void GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                 Transaction *transaction = nullptr);
+
+  // Statistics of the tree, the histogram is on whole keys
+  struct Statistics {
+    uint64_t num_keys_;
+    uint64_t num_values_;
+    uint32_t height_;
+    uint64_t num_leaves_;
+    double leaf_fill_factor_;
+    // bucket i holds histogram_counts_[i] values with keys in (histogram_bounds_[i], histogram_bounds_[i + 1]]
+    std::vector<KeyType> histogram_bounds_;
+    std::vector<uint64_t> histogram_counts_;
+  };
+
+  // Counts are exact unless a writer is in progress, the histogram is as of the last BulkLoad or Analyze
+  auto GetStatistics() const -> Statistics;
+
+  // Count keys and values again in a walk over the leaves and rebuild the histogram with up to num_buckets buckets
+  void Analyze(int num_buckets = INDEX_HISTOGRAM_BUCKETS);
+
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
@@ -71,6 +140,14 @@ class BPlusTree {
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
   auto End() -> INDEXITERATOR_TYPE;
+  // reverse index iterator, from the largest key (not greater than key) down to the smallest, ends at End()
+  auto RBegin() -> INDEXITERATOR_TYPE;
+  auto RBegin(const KeyType &key) -> INDEXITERATOR_TYPE;
+
+  // Up to num_parts - 1 increasing keys in (low, high] from the upper levels, which split the keys in [low, high]
+  // into ranges of about as many leaves each, e.g. for threads to scan them with Begin(key) in parallel
+  auto SplitKeys(const std::optional<KeyType> &low, const std::optional<KeyType> &high, int num_parts)
+      -> std::vector<KeyType>;
 
   // print the B+ tree
   void Print(BufferPoolManager *bpm);
@@ -85,8 +162,119 @@ class BPlusTree {
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
  private:
+  // Kind of tree operation, used to decide whether a node is safe to release ancestors
+  // COMPACT keeps the parent of the leaf latched
+  enum class Operation { INSERT, DELETE, COMPACT };
+
+  // Outcome of a latch free lookup, LATCH if the values are in posting pages
+  enum class LookupResult { FOUND, NOT_FOUND, RETRY, LATCH };
+
+  // Number of latch free lookups tried before falling back to read crabbing
+  static constexpr int OPTIMISTIC_READ_ATTEMPTS = 4;
+
+  // Internal pages at the top of the tree, whole levels from the root down as long as they fit
+  struct PinnedPages {
+    // pinned_epoch_ at the time the pages were collected
+    uint64_t epoch_;
+    // sorted by page id
+    std::vector<std::pair<page_id_t, Page *>> pages_;
+
+    auto Find(page_id_t page_id) const -> Page *;
+  };
+
+  // A descent takes the current snapshot of pinned pages and has to end before its pages may be unpinned
+  auto BeginPinnedDescent() -> const PinnedPages *;
+  void EndPinnedDescent();
+  // Frame of a tree page, pinned pages are neither fetched nor unpinned
+  auto FetchTreePage(const PinnedPages *pinned_pages, page_id_t page_id) -> Page *;
+  void UnpinTreePage(const PinnedPages *pinned_pages, page_id_t page_id);
+  // Collect the pinned pages again if the tree changed since, called by writers holding no latch
+  void RefreshPinnedPages();
+  // Unpin pages only older snapshots hold once no descent uses them, caller holds pinned_latch_
+  void ReclaimPinnedPages();
+
+  // Evenly spaced sample of the keys of values added in key order, the gap doubles once it has twice enough keys
+  struct KeySample {
+    std::vector<KeyType> keys_;
+    uint64_t stride_{1};
+    // values added so far
+    uint64_t count_{0};
+    KeyType last_;
+
+    void Add(const KeyType &key);
+  };
+
+  // Replace the histogram with up to num_buckets buckets of about the same number of values
+  void BuildHistogram(const KeySample &sample, int num_buckets);
+
   void UpdateRootPageId(int insert_record = 0);
 
+  // Descend with read crabbing, return the read-latched and pinned leaf (nullptr on empty tree).
+  // With before_key it is the leaf that holds the largest keys smaller than key instead.
+  auto FindLeafPageRead(const KeyType &key, bool left_most = false, bool right_most = false, bool before_key = false)
+      -> Page *;
+
+  // Latch free lookup validated with page versions
+  auto GetValueOptimistic(const KeyType &key, std::vector<ValueType> *result, const PinnedPages *pinned_pages)
+      -> LookupResult;
+
+  // Write latch helpers that also maintain the page version
+  void WLatchPage(Page *page);
+  void WUnlatchPage(Page *page, bool is_dirty);
+
+  // Descend with read crabbing, write-latch only the leaf (nullptr on empty tree)
+  auto FindLeafPageOptimistic(const KeyType &key) -> Page *;
+
+  // Descend with write crabbing, keep the unsafe part of the path latched in latched_pages
+  void FindLeafPagePessimistic(const KeyType &key, Operation op, std::deque<Page *> *latched_pages,
+                               bool *root_locked);
+
+  // Whether a node can absorb the operation without touching its parent
+  auto IsSafe(BPlusTreePage *node, Operation op) const -> bool;
+
+  // Unlatch and unpin every page in latched_pages, release the root latch if it is still held
+  void ReleaseLatchedPages(std::deque<Page *> *latched_pages, bool *root_locked, bool is_dirty);
+
+  void StartNewTree(const KeyType &key, const ValueType &value);
+
+  // Propagate a split upwards along the latched path
+  void InsertIntoParent(std::deque<Page *> *latched_pages, const KeyType &key, page_id_t new_page_id);
+  auto SplitPosition(const std::vector<std::pair<KeyType, page_id_t>> &entries, bool by_count) const -> int;
+  auto SplitPosition(const LeafPage *leaf) const -> int;
+
+  // Fix underflow from the bottom of the latched path, pages to be freed are appended to deleted_pages
+  void HandleUnderflow(std::deque<Page *> *latched_pages, std::vector<Page *> *sibling_pages,
+                       std::vector<page_id_t> *deleted_pages, double merge_fill);
+  // HandleUnderflow on a path latched by FindLeafPagePessimistic, then release it and free the deleted pages
+  void Rebalance(std::deque<Page *> *latched_pages, bool *root_locked, double merge_fill);
+
+  void SetParentOf(page_id_t child_page_id, page_id_t parent_page_id);
+  // Write latch the leaf leaf_page_id and set its prev link
+  void SetPrevOf(page_id_t leaf_page_id, page_id_t prev_page_id);
+
+  // Remove key or one of its values from a write latched leaf, false if the entry has to go but can not
+  auto RemoveFromLeaf(LeafPage *leaf, const KeyType &key, const ValueType *value, bool can_remove_entry,
+                      bool *is_dirty) -> bool;
+  void RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction);
+
+  // Posting list helpers of non-unique trees, leaves passed in are write latched
+  auto InsertIntoPostingList(LeafPage *leaf, int index, const ValueType &value) -> bool;
+  auto RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &value) -> bool;
+  auto ScanValues(const LeafPage *leaf, int index, const std::function<bool(const ValueType &)> &consumer) -> bool;
+  // Move the inline list of the entry at index to posting pages
+  void SpillPostingList(LeafPage *leaf, int index);
+  // Spill the largest inline lists until leaf has bytes free
+  void MakeRoom(LeafPage *leaf, int bytes);
+  // Make room in to_leaf for the entry at from_index of from_leaf
+  void MakeRoomForEntry(LeafPage *to_leaf, LeafPage *from_leaf, int from_index);
+  // Make room in left_leaf for every entry of right_leaf
+  void MakeRoomForMerge(LeafPage *left_leaf, LeafPage *right_leaf);
+
+  // Bulk load helpers, a level is the (separator, page id) list of its pages from left to right
+  void BalanceLastLeaves(std::vector<std::pair<KeyType, page_id_t>> *level);
+  auto BuildInternalLevel(const std::vector<std::pair<KeyType, page_id_t>> &children, double fill_factor)
+      -> std::vector<std::pair<KeyType, page_id_t>>;
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
@@ -94,11 +282,44 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // written under root_latch_, read without it by optimistic lookups
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool is_unique_;
+  // leaves are merged once they are less full than this
+  double merge_fill_;
+  // protects root_page_id_
+  ReaderWriterLatch root_latch_;
+
+  // most pages kept pinned
+  size_t max_pinned_pages_;
+  // moves on whenever the root or an internal page changes
+  std::atomic<uint64_t> pinned_epoch_{0};
+  // the current snapshot and its epoch, replaced by RefreshPinnedPages
+  std::atomic<PinnedPages *> pinned_pages_{nullptr};
+  std::atomic<uint64_t> pinned_pages_epoch_{0};
+  // descents between BeginPinnedDescent and EndPinnedDescent
+  std::atomic<int> pinned_readers_{0};
+  std::atomic<bool> has_retired_pinned_pages_{false};
+  // serializes refreshes, protects the members below
+  std::mutex pinned_latch_;
+  // replaced snapshots some descent may still use
+  std::vector<std::unique_ptr<PinnedPages>> retired_pinned_pages_;
+  // every page the tree holds a pin on, in the current or a retired snapshot
+  std::unordered_map<page_id_t, Page *> pinned_frames_;
+
+  // statistics, updated by writers while they hold the latches of the pages they change
+  std::atomic<uint64_t> num_keys_{0};
+  std::atomic<uint64_t> num_values_{0};
+  std::atomic<uint64_t> num_leaves_{0};
+  std::atomic<uint32_t> height_{0};
+  // protects the histogram
+  mutable std::mutex histogram_latch_;
+  std::vector<KeyType> histogram_bounds_;
+  std::vector<uint64_t> histogram_counts_;
 };
 
 }  // namespace bustub
@@ -11,8 +11,10 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -22,6 +24,8 @@
 
 namespace bustub {
 
+class TableHeap;
+
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -35,13 +39,41 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  // Sort the keys and look them all up in one walk down the tree
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  // Stream the RIDs of key in order until consumer returns false, without collecting them first
+  void ScanKey(const Tuple &key, const std::function<bool(const RID &)> &consumer, Transaction *transaction);
+
+  // Build the index from every tuple in table_heap, the index must be empty
+  void BulkLoad(TableHeap *table_heap, const Schema &tuple_schema, Transaction *transaction,
+                double fill_factor = BULK_LOAD_FILL_FACTOR);
+
+  auto GetStatistics() const -> std::optional<IndexStatistics> override;
+
+  // Walk the leaves to recount keys and values and to rebuild the histogram
+  void Analyze(Transaction *transaction) override;
+
+  // Scan through an iterator, which keeps its current leaf latched until the cursor is done or destroyed
+  auto Scan(bool descending) -> std::unique_ptr<IndexCursor> override;
+
+  // Ranges between keys from the upper levels of the tree, see BPlusTree::SplitKeys
+  auto ScanPartitions(int num_parts) -> std::vector<std::unique_ptr<IndexCursor>> override;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  // Iterators from the largest key (not greater than key) down, they also end at GetEndIterator()
+  auto GetReverseBeginIterator() -> INDEXITERATOR_TYPE;
+
+  auto GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
+
  protected:
+  BufferPoolManager *buffer_pool_manager_;
   // comparator for key
   KeyComparator comparator_;
   // container
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/storage/index/external_merge_sort.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+/**
+ * external_merge_sort.h
+ * Sort key/value pairs for bulk loading an index
+ */
+#pragma once
+
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define EXTERNAL_MERGE_SORT_TYPE ExternalMergeSort<KeyType, ValueType, KeyComparator>
+
+/**
+ * Sorts key/value pairs by key. Pairs are buffered in memory until the buffer
+ * reaches buffer_pages pages worth of pairs, then the buffer is sorted and
+ * spilled through the buffer pool as a run of pages. After Finish(), Next()
+ * returns the pairs in key order, merging the runs if anything was spilled.
+ * At most merge_fan_in runs are merged at once, so more runs than that are
+ * first merged into longer runs in extra passes.
+ *
+ * Run page format:
+ *  ----------------------------------------------------
+ * | Count (4) | KEY(1) + VALUE(1) | ... | KEY(n) + VALUE(n) |
+ *  ----------------------------------------------------
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class ExternalMergeSort {
+ public:
+  ExternalMergeSort(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                    int buffer_pages = EXTERNAL_SORT_BUFFER_PAGES, int merge_fan_in = EXTERNAL_SORT_FAN_IN);
+  ~ExternalMergeSort();
+
+  DISALLOW_COPY_AND_MOVE(ExternalMergeSort);
+
+  // Add a pair, may spill a sorted run to the buffer pool
+  void Add(const KeyType &key, const ValueType &value);
+
+  // No more pairs will be added, prepare for reading the sorted output
+  void Finish();
+
+  // Read the next pair in key order, false once every pair is returned
+  auto Next(MappingType *pair) -> bool;
+
+  // Number of runs spilled to the buffer pool
+  auto GetRunCount() const -> size_t { return run_count_; }
+
+ private:
+  // A sorted run stored in buffer pool pages, read one page at a time
+  struct Run {
+    std::vector<page_id_t> page_ids_;
+    size_t page_index_{0};
+    int offset_{0};
+    Page *page_{nullptr};
+  };
+
+  void SpillRun();
+  // Merge runs_[begin, end) into a single run
+  auto MergeRuns(size_t begin, size_t end) -> Run;
+  // Position the run on its next pair, false once it is exhausted
+  auto AdvanceRun(Run *run) -> bool;
+  auto RunPairAt(const Run &run) const -> MappingType;
+
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  size_t buffer_capacity_;
+  size_t merge_fan_in_;
+  size_t run_count_{0};
+  std::vector<MappingType> buffer_;
+  size_t buffer_index_{0};
+  std::vector<Run> runs_;
+  // (pair, run index) ordered so that the smallest key is on top
+  using HeapEntry = std::pair<MappingType, size_t>;
+  struct HeapCompare {
+    const KeyComparator *comparator_;
+    auto operator()(const HeapEntry &lhs, const HeapEntry &rhs) const -> bool {
+      return (*comparator_)(lhs.first.first, rhs.first.first) > 0;
+    }
+  };
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>, HeapCompare> heap_;
+};
+
+}  // namespace bustub
@@ -12,13 +12,21 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <vector>
 
+#include "storage/index/key_encoding.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
+/** Size of the largest generic key that indexes are instantiated with */
+static constexpr size_t GENERIC_KEY_MAX_SIZE = 256;
+
 /**
  * Generic key is used for indexing with opaque data.
  *
@@ -29,35 +37,51 @@ namespace bustub {
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  // Encode the columns of a key tuple, see KeyEncoding
+  inline void SetFromKey(const Tuple &tuple, const Schema *key_schema) {
+    std::vector<Value> values;
+    values.reserve(key_schema->GetColumnCount());
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      values.push_back(tuple.GetValue(key_schema, i));
+    }
+    SetFromValues(values);
+  }
+
+  // Encode values column by column, returns false if the encoding was cut off at KeySize
+  inline auto SetFromValues(const std::vector<Value> &values) -> bool {
     // intialize to 0
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    size_t offset = 0;
+    for (const auto &value : values) {
+      offset = KeyEncoding::Encode(value, data_, KeySize, offset);
+    }
+    return offset <= KeySize;
   }
 
   // NOTE: for test purpose only
+  // encoded as a BIGINT column
   inline void SetFromInteger(int64_t key) {
+    char buffer[sizeof(int64_t)];
+    KeyEncoding::WriteInteger<int64_t>(key, buffer);
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    memcpy(data_, buffer, std::min(sizeof(buffer), KeySize));
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      KeyEncoding::Decode(schema->GetColumn(i).GetType(), data_, KeySize, &offset);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return KeyEncoding::Decode(schema->GetColumn(column_idx).GetType(), data_, KeySize, &offset);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline auto ToString() const -> int64_t { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the first 8 bytes as a BIGINT column
+  inline auto ToString() const -> int64_t {
+    char buffer[sizeof(int64_t)] = {};
+    memcpy(buffer, data_, std::min(sizeof(buffer), KeySize));
+    return KeyEncoding::ReadInteger<int64_t>(buffer);
+  }
 
   // NOTE: for test purpose only
   // interpret the first 8 bytes as int64_t from data vector
@@ -72,35 +96,119 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys are stored in an order preserving encoding, so they compare with a
+ * single memcmp no matter what their columns are.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
-    uint32_t column_count = key_schema_->GetColumnCount();
+    int result = memcmp(lhs.data_, rhs.data_, KeySize);
+    return static_cast<int>(result > 0) - static_cast<int>(result < 0);
+  }
 
+  /**
+   * Shortest key that is greater than lhs and not greater than rhs, requires lhs < rhs.
+   * B+ tree splits push it up instead of rhs so that internal pages store short keys:
+   * the first differing VARCHAR column is cut to the shortest prefix of rhs that is
+   * still greater than lhs, an integer column may step just past lhs, and once the
+   * key is strictly between lhs and rhs the remaining columns are left empty.
+   */
+  inline auto Separator(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const
+      -> GenericKey<KeySize> {
+    uint32_t column_count = key_schema_->GetColumnCount();
+    std::vector<Value> values;
+    values.reserve(column_count);
+    bool is_differing = false;
+    bool is_between = false;
     for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
+      TypeId column_type = key_schema_->GetColumn(i).GetType();
+      if (is_between) {
+        values.push_back(column_type == TypeId::VARCHAR ? ValueFactory::GetVarcharValue(std::string())
+                                                        : ValueFactory::GetZeroValueByType(column_type));
+        continue;
       }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
+      Value rhs_value = rhs.ToValue(key_schema_, i);
+      Value lhs_value = lhs.ToValue(key_schema_, i);
+      if (is_differing || lhs_value.CompareLessThan(rhs_value) != CmpBool::CmpTrue) {
+        values.push_back(rhs_value);
+        continue;
       }
+      is_differing = true;
+      values.push_back(rhs_value);
+      switch (column_type) {
+        case TypeId::VARCHAR: {
+          auto rhs_length = rhs_value.GetLength() - 1;
+          for (uint32_t length = 1; length < rhs_length; length++) {
+            auto candidate = ValueFactory::GetVarcharValue(std::string(rhs_value.GetData(), length));
+            if (candidate.CompareGreaterThan(lhs_value) == CmpBool::CmpTrue) {
+              values.back() = candidate;
+              is_between = true;
+              break;
+            }
+          }
+          break;
+        }
+        case TypeId::TINYINT:
+        case TypeId::SMALLINT:
+        case TypeId::INTEGER:
+        case TypeId::BIGINT: {
+          auto candidate = lhs_value.Add(ValueFactory::GetIntegerValue(1)).CastAs(column_type);
+          if (candidate.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
+            values.back() = candidate;
+            is_between = true;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    GenericKey<KeySize> separator;
+    if (!separator.SetFromValues(values)) {
+      return rhs;
+    }
+    if ((*this)(lhs, separator) >= 0 || (*this)(separator, rhs) > 0) {
+      return rhs;
     }
-    // equals
-    return 0;
+    return separator;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  // Type of the key if it is a single integer column, INVALID otherwise
+  inline auto GetIntegerType() const -> TypeId { return integer_type_; }
+
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, integer_type_{other.integer_type_} {}
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {
+    if (key_schema_->GetColumnCount() == 1) {
+      auto type = key_schema_->GetColumn(0).GetType();
+      auto size = KeyEncoding::IntegerSize(type);
+      if (size > 0 && static_cast<size_t>(size) <= KeySize) {
+        integer_type_ = type;
+      }
+    }
+  }
 
  private:
   Schema *key_schema_;
+  TypeId integer_type_{TypeId::INVALID};
 };
 
+/*
+ * Integer type of the keys a comparator orders, used by pages to search keys
+ * as integers. Only generic comparators of a single integer column have one.
+ */
+template <typename KeyComparator>
+inline auto IntegerKeyTypeOf(const KeyComparator &comparator) -> TypeId {
+  return TypeId::INVALID;
+}
+
+template <size_t KeySize>
+inline auto IntegerKeyTypeOf(const GenericComparator<KeySize> &comparator) -> TypeId {
+  return comparator.GetIntegerType();
+}
+
 }  // namespace bustub
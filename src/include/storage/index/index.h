@@ -13,11 +13,13 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "storage/index/index_statistics.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -43,10 +45,14 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param is_unique Whether a key may only have one value
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, bool is_unique = true)
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        is_unique_(is_unique) {
     key_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, key_attrs_));
   }
 
@@ -72,6 +78,9 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return key_attrs_; }
 
+  /** @return Whether a key may only have one value */
+  inline auto IsUnique() const -> bool { return is_unique_; }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -92,10 +101,27 @@ class IndexMetadata {
   std::string table_name_;
   /** The mapping relation between key schema and tuple schema */
   const std::vector<uint32_t> key_attrs_;
+  /** Whether a key may only have one value */
+  bool is_unique_;
   /** The schema of the indexed key */
   std::shared_ptr<Schema> key_schema_;
 };
 
+/**
+ * Pull based scan over the RIDs of an index in key order, see Index::Scan.
+ */
+class IndexCursor {
+ public:
+  virtual ~IndexCursor() = default;
+
+  /**
+   * Step to the next RID of the scan.
+   * @param[out] rid The RID
+   * @return false once the scan is done
+   */
+  virtual auto Next(RID *rid) -> bool = 0;
+};
+
 /////////////////////////////////////////////////////////////////////
 // Index class definition
 /////////////////////////////////////////////////////////////////////
@@ -175,6 +201,54 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for several keys at once. Indexes that can share work
+   * between the keys override this, by default every key is searched alone.
+   * @param keys The index keys
+   * @param results Populated with one collection of RIDs per key, in the order of keys
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Ordered Scan
+  ///////////////////////////////////////////////////////////////////
+
+  /**
+   * Scan the RIDs of the whole index in key order, whatever its key type.
+   * @param descending Whether to scan from the largest key down
+   * @return The cursor, nullptr if the index keeps no order
+   */
+  virtual auto Scan(bool descending) -> std::unique_ptr<IndexCursor> { return nullptr; }
+
+  /**
+   * Split an ascending scan of the whole index into scans of consecutive key ranges,
+   * about even in size, which may run on different threads.
+   * @param num_parts The most ranges to split into
+   * @return The cursors in key order, empty if the index keeps no order
+   */
+  virtual auto ScanPartitions(int num_parts) -> std::vector<std::unique_ptr<IndexCursor>> { return {}; }
+
+  ///////////////////////////////////////////////////////////////////
+  // Statistics
+  ///////////////////////////////////////////////////////////////////
+
+  /** @return Statistics about the contents of the index, std::nullopt if the index keeps none */
+  virtual auto GetStatistics() const -> std::optional<IndexStatistics> { return std::nullopt; }
+
+  /**
+   * Recompute the statistics from the contents of the index, like ANALYZE does.
+   * Indexes that keep no statistics do nothing.
+   * @param transaction The transaction context
+   */
+  virtual void Analyze(Transaction *transaction) {}
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -13,7 +13,11 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <vector>
+
 #include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
@@ -21,31 +25,74 @@ namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
+/**
+ * Range scan over the leaves of a b+ tree. The iterator keeps the leaf it is
+ * positioned on pinned and read latched, so stepping through a leaf does not
+ * go through the buffer pool. The leaf is only released when moving on to its
+ * sibling or when the iterator reaches the end or is destroyed.
+ *
+ * A reverse iterator walks the same way from right to left, ++ moves it to
+ * the previous pair.
+ *
+ * Writers block on the leaf while the iterator is on it, so a thread must not
+ * modify the tree while it holds an iterator that is not at the end.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
-  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  // compaction looks at whole leaves
+  friend class BPlusTree<KeyType, ValueType, KeyComparator>;
 
  public:
-  // you may define your own constructor based on your member variables
-  IndexIterator(page_id_t leaf_id, BufferPoolManager *bpm, int index);
+  // The end iterator
+  IndexIterator() = default;
+  // Position at index of page, which is pinned and read latched and now owned by the iterator
+  IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index, bool is_reverse = false);
   ~IndexIterator();  // NOLINT
 
+  IndexIterator(IndexIterator &&other) noexcept;
+  auto operator=(IndexIterator &&other) noexcept -> IndexIterator &;
+  DISALLOW_COPY(IndexIterator);
+
   auto IsEnd() -> bool;
 
+  auto IsReverse() const -> bool;
+
   auto operator*() -> const MappingType &;
 
   auto operator++() -> IndexIterator &;
 
+  // Append up to max_size pairs to batch and step past them, return the number appended (0 at the end)
+  auto NextBatch(std::vector<MappingType> *batch, int max_size) -> int;
+
   auto operator==(const IndexIterator &itr) const -> bool;
 
   auto operator!=(const IndexIterator &itr) const -> bool;
 
  private:
-  // add your own private member variables here
-  page_id_t leaf_id_;
-  BufferPoolManager *bpm_;
-  int index_;
+  // Skip to the next (previous if reverse) leaf until the position has an entry, then load its posting list
+  void Settle();
+  void MoveToNextLeaf();
+  void MoveToPrevLeaf();
+  // Move to the first entry of the next leaf in scan order
+  void SkipLeaf();
+  // Load the values of the current entry if it is a posting list
+  void LoadValues();
+  // Unlatch and unpin the current leaf, the iterator is at the end afterwards
+  void Release();
+
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_{nullptr};
+  Page *page_{nullptr};
+  LeafPage *leaf_{nullptr};
+  int index_{0};
+  bool is_reverse_{false};
+  // posting list of the current entry in a non-unique tree, the iterator is on its value_index_th value
+  std::vector<ValueType> values_;
+  int value_index_{0};
+  MappingType current_;
 };
 
 }  // namespace bustub
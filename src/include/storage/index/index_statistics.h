@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_statistics.h
+//
+// Identification: src/include/storage/index/index_statistics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * What an index knows about its contents, for the optimizer to cost plans
+ * with. The counts and the shape of the index are kept up to date by every
+ * change, the histogram is only built by bulk loads and ANALYZE.
+ */
+struct IndexStatistics {
+  /** Number of key value pairs, one per indexed tuple */
+  uint64_t num_values_{0};
+  /** Number of distinct keys */
+  uint64_t num_keys_{0};
+  /** Levels from the root down to the leaves, 0 if the index is empty */
+  uint32_t height_{0};
+  /** Number of leaf pages */
+  uint64_t num_leaves_{0};
+  /** Share of the leaf slots in use */
+  double leaf_fill_factor_{0};
+  /**
+   * Equi-depth histogram on the first key column. Bucket i holds histogram_counts_[i]
+   * values with keys in (histogram_bounds_[i], histogram_bounds_[i + 1]], the first
+   * bucket also holds histogram_bounds_[0]. Empty until the index is analyzed.
+   */
+  std::vector<Value> histogram_bounds_;
+  std::vector<uint64_t> histogram_counts_;
+
+  /** @return the average number of values of a key */
+  auto ValuesPerKey() const -> double;
+
+  /**
+   * Estimate the share of values whose first key column is in [low, high]. Buckets that
+   * are only partly covered count in proportion for numeric columns and by half otherwise.
+   * @param low the lower bound, std::nullopt if unbounded
+   * @param high the upper bound, std::nullopt if unbounded
+   */
+  auto EstimateSelectivity(const std::optional<Value> &low, const std::optional<Value> &high) const -> double;
+};
+
+}  // namespace bustub
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_encoding.h
+//
+// Identification: src/include/storage/index/key_encoding.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "type/type_id.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class Schema;
+
+/**
+ * Order preserving encoding of index keys. Two keys of the same schema
+ * compare like their values when their encodings are compared with memcmp,
+ * column by column and NULL first:
+ *  - integers (and booleans) are stored big endian with the sign bit flipped,
+ *    in as many bytes as their type has; NULL is the smallest integer anyway
+ *  - decimals are stored as their IEEE bits, with all bits flipped if
+ *    negative and only the sign bit flipped otherwise; NULL is all zeros
+ *  - timestamps are stored big endian plus one, NULL is all zeros
+ *  - VARCHAR is 0x00 if NULL, otherwise 0x01 followed by the string with every
+ *    0x00 escaped as 0x00 0xFF and terminated by 0x00 0x00
+ *
+ * Keys are zero padded, so a key cut off at its size still compares right
+ * against any key that differs within that size.
+ */
+class KeyEncoding {
+ public:
+  // Bytes of an integer key of the given type, 0 if the type is not an integer type
+  static inline auto IntegerSize(TypeId type) -> int {
+    switch (type) {
+      case TypeId::TINYINT:
+        return sizeof(int8_t);
+      case TypeId::SMALLINT:
+        return sizeof(int16_t);
+      case TypeId::INTEGER:
+        return sizeof(int32_t);
+      case TypeId::BIGINT:
+        return sizeof(int64_t);
+      default:
+        return 0;
+    }
+  }
+
+  // Decode an integer of type T from data
+  template <typename T>
+  static inline auto ReadInteger(const char *data) -> T {
+    return static_cast<T>(ReadOrdered<T>(data) ^ SignBit<T>());
+  }
+
+  // Encoded integer of type T at data as an unsigned number, which orders like the integer
+  template <typename T>
+  static inline auto ReadOrdered(const char *data) -> std::make_unsigned_t<T> {
+    std::make_unsigned_t<T> bits;
+    memcpy(&bits, data, sizeof(bits));
+    return ByteSwap(bits);
+  }
+
+  // What ReadOrdered returns for value
+  template <typename T>
+  static inline auto Ordered(T value) -> std::make_unsigned_t<T> {
+    return static_cast<std::make_unsigned_t<T>>(static_cast<std::make_unsigned_t<T>>(value) ^ SignBit<T>());
+  }
+
+  template <typename T>
+  static inline void WriteInteger(T value, char *data) {
+    auto bits = ByteSwap(Ordered<T>(value));
+    memcpy(data, &bits, sizeof(bits));
+  }
+
+  // Decode an integer key column of the given integer type from data
+  static inline auto ReadInteger(const char *data, TypeId type) -> int64_t {
+    switch (type) {
+      case TypeId::TINYINT:
+        return ReadInteger<int8_t>(data);
+      case TypeId::SMALLINT:
+        return ReadInteger<int16_t>(data);
+      case TypeId::INTEGER:
+        return ReadInteger<int32_t>(data);
+      default:
+        return ReadInteger<int64_t>(data);
+    }
+  }
+
+  /**
+   * Largest encoding of a key of the given schema, with VARCHAR columns at their declared
+   * length and strings assumed to have no zero bytes to escape.
+   */
+  static auto MaxKeySize(const Schema &key_schema) -> size_t;
+
+  /**
+   * Append the encoding of value to the size bytes at data, starting at offset.
+   * Bytes past size are dropped.
+   * @return offset after the value, which may be past size
+   */
+  static auto Encode(const Value &value, char *data, size_t size, size_t offset) -> size_t;
+
+  /**
+   * Decode a value of the given type from the size bytes at data, starting at
+   * *offset, and move *offset past it. Never reads past size bytes, a value
+   * cut off at size is decoded from the bytes that are there.
+   */
+  static auto Decode(TypeId type, const char *data, size_t size, size_t *offset) -> Value;
+
+ private:
+  template <typename T>
+  static inline auto SignBit() -> std::make_unsigned_t<T> {
+    return static_cast<std::make_unsigned_t<T>>(std::make_unsigned_t<T>{1} << (sizeof(T) * 8 - 1));
+  }
+
+  // Keys are big endian, this converts from and to the byte order of the machine (little endian)
+  static inline auto ByteSwap(uint8_t bits) -> uint8_t { return bits; }
+  static inline auto ByteSwap(uint16_t bits) -> uint16_t { return __builtin_bswap16(bits); }
+  static inline auto ByteSwap(uint32_t bits) -> uint32_t { return __builtin_bswap32(bits); }
+  static inline auto ByteSwap(uint64_t bits) -> uint64_t { return __builtin_bswap64(bits); }
+};
+
+}  // namespace bustub
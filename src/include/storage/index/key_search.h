@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search.h
+//
+// Identification: src/include/storage/index/key_search.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+#include "storage/index/key_encoding.h"
+#include "type/type_id.h"
+
+namespace bustub {
+
+/**
+ * Lower bound search over the keys of an index on a single integer column.
+ * Keys are read straight from the page, stride bytes apart, and compared as
+ * integers instead of with memcmp (see KeyEncoding).
+ *
+ * A branch free binary search narrows the range down to WINDOW keys, which
+ * are then compared at once. The instruction set is picked at compile time:
+ * AVX2 gathers 4 (BIGINT) or 8 (INTEGER) keys per compare, SSE4.2 compares 2
+ * or 4, and anything else, as well as TINYINT and SMALLINT keys, falls back
+ * to a scalar loop. Build with BUSTUB_NATIVE_ARCH to enable them.
+ */
+class KeySearch {
+ public:
+  static constexpr int WINDOW = 16;
+
+  // Number of keys at data, data + stride, ... (count in total, sorted) that are smaller than key
+  static inline auto LowerBound(const char *data, int stride, int count, int64_t key, TypeId type) -> int {
+    switch (type) {
+      case TypeId::TINYINT:
+        return Search<int8_t>(data, stride, count, key);
+      case TypeId::SMALLINT:
+        return Search<int16_t>(data, stride, count, key);
+      case TypeId::INTEGER:
+        return Search<int32_t>(data, stride, count, key);
+      default:
+        return Search<int64_t>(data, stride, count, key);
+    }
+  }
+
+ private:
+  template <typename T>
+  static inline auto Read(const char *data) -> int64_t {
+    return KeyEncoding::ReadInteger<T>(data);
+  }
+
+  template <typename T>
+  static inline auto Search(const char *data, int stride, int count, int64_t key) -> int {
+    // a search key outside of the range of T is greater or smaller than every key
+    if constexpr (sizeof(T) < sizeof(int64_t)) {
+      if (key > std::numeric_limits<T>::max()) {
+        return count;
+      }
+      if (key <= std::numeric_limits<T>::min()) {
+        return 0;
+      }
+    }
+    // encoded keys are compared without decoding them, as unsigned numbers
+    auto target = KeyEncoding::Ordered<T>(static_cast<T>(key));
+    // the answer stays in [base, base + length]
+    int base = 0;
+    int length = count;
+    while (length > WINDOW) {
+      int half = length / 2;
+      base = KeyEncoding::ReadOrdered<T>(data + (base + half - 1) * stride) < target ? base + half : base;
+      length -= half;
+    }
+    return base + CountLess<T>(data + base * stride, stride, length, key);
+  }
+
+  template <typename T>
+  static inline auto CountLess(const char *data, int stride, int count, int64_t key) -> int {
+    auto target = KeyEncoding::Ordered<T>(static_cast<T>(key));
+    int less = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    if constexpr (sizeof(T) == sizeof(int64_t)) {
+      const __m256i keys = _mm256_set1_epi64x(key);
+      // keys are big endian with the sign bit flipped
+      const __m256i swap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,  //
+                                            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+      const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+      const __m128i offsets = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+      for (; i + 4 <= count; i += 4) {
+        __m256i values = _mm256_i32gather_epi64(reinterpret_cast<const long long *>(data + i * stride),  // NOLINT
+                                                offsets, 1);
+        values = _mm256_xor_si256(_mm256_shuffle_epi8(values, swap), sign);
+        less += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(keys, values))));
+      }
+    } else if constexpr (sizeof(T) == sizeof(int32_t)) {
+      const __m256i keys = _mm256_set1_epi32(static_cast<int32_t>(key));
+      const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,  //
+                                            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+      const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+      const __m256i offsets = _mm256_mullo_epi32(_mm256_set1_epi32(stride), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+      for (; i + 8 <= count; i += 8) {
+        __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int *>(data + i * stride), offsets, 1);
+        values = _mm256_xor_si256(_mm256_shuffle_epi8(values, swap), sign);
+        less += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(keys, values))));
+      }
+    }
+#elif defined(__SSE4_2__)
+    if constexpr (sizeof(T) == sizeof(int64_t)) {
+      const __m128i keys = _mm_set1_epi64x(key);
+      for (; i + 2 <= count; i += 2) {
+        const char *pos = data + i * stride;
+        __m128i values = _mm_set_epi64x(Read<T>(pos + stride), Read<T>(pos));
+        less += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(keys, values))));
+      }
+    } else if constexpr (sizeof(T) == sizeof(int32_t)) {
+      const __m128i keys = _mm_set1_epi32(static_cast<int32_t>(key));
+      for (; i + 4 <= count; i += 4) {
+        const char *pos = data + i * stride;
+        __m128i values = _mm_setr_epi32(Read<T>(pos), Read<T>(pos + stride), Read<T>(pos + 2 * stride),
+                                        Read<T>(pos + 3 * stride));
+        less += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(keys, values))));
+      }
+    }
+#endif
+    for (; i < count; i++) {
+      less += static_cast<int>(KeyEncoding::ReadOrdered<T>(data + i * stride) < target);
+    }
+    return less;
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_epsilon_tree_internal_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_EPSILON_TREE_INTERNAL_PAGE_TYPE BEpsilonTreeInternalPage<KeyType, ValueType, KeyComparator>
+#define B_EPSILON_INTERNAL_PAGE_HEADER_SIZE 36
+
+/**
+ * Internal page of a B-epsilon tree. Besides up to max size pivots, which
+ * direct the search like the entries of a B+ tree internal page (the first
+ * key is invalid), it buffers messages on their way down to the leaves.
+ *
+ * The buffer is sorted by key and holds at most one message per key: a newer
+ * message for a key replaces the older one. A message either puts a value or
+ * deletes the key.
+ *
+ * Internal page format:
+ *  -------------------------------------------------------------------------
+ * | HEADER | PIVOT(0) | ... | PIVOT(max size - 1) | MESSAGE(0) | MESSAGE(1) ...
+ *  -------------------------------------------------------------------------
+ *
+ * Header format (size in byte, 36 bytes in total):
+ *  ------------------------------------------------
+ * | B+ tree page header (32) | BufferSize (4) |
+ *  ------------------------------------------------
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BEpsilonTreeInternalPage : public BPlusTreePage {
+ public:
+  using Pivot = std::pair<KeyType, page_id_t>;
+
+  struct Message {
+    KeyType key_;
+    ValueType value_;
+    bool is_delete_;
+  };
+
+  // must call initialize method after "create" a new node
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = B_EPSILON_TREE_FANOUT);
+
+  // Largest max size that still leaves room for as many messages as pivots
+  static auto MaxFanout() -> int;
+
+  auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> page_id_t;
+  // Return the offset of the child that may contain key, i.e. the last PAGE_ID(i) with K(i) <= key
+  auto LookUpIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+
+  auto GetBufferSize() const -> int;
+  auto GetBufferCapacity() const -> int;
+  // The buffered message for key, nullptr if there is none
+  auto FindMessage(const KeyType &key, const KeyComparator &comparator) const -> const Message *;
+
+  // Pivots and messages are rearranged in vectors and written back as a whole
+  void LoadPivots(std::vector<Pivot> *pivots) const;
+  void StorePivots(const std::vector<Pivot> &pivots);
+  void LoadBuffer(std::vector<Message> *messages) const;
+  void StoreBuffer(const std::vector<Message> &messages);
+
+ private:
+  auto PivotArray() const -> const Pivot *;
+  auto PivotArray() -> Pivot *;
+  auto MessageArray() const -> const Message *;
+  auto MessageArray() -> Message *;
+
+  int buffer_size_;
+  // Flexible array member for page data.
+  char data_[1];
+};
+}  // namespace bustub
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
@@ -20,8 +22,10 @@
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE 40
+#define INTERNAL_PAGE_SLOT_SIZE 8
+#define INTERNAL_PAGE_USABLE_SIZE (BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE)
+#define INTERNAL_PAGE_SIZE (INTERNAL_PAGE_USABLE_SIZE / INTERNAL_PAGE_SLOT_SIZE)
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -30,10 +34,28 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Keys are compressed, so the number of entries a page holds depends on its
+ * keys and not only on max size:
+ *  - trailing zero bytes of a key are not stored (generic keys are zero padded)
+ *  - the longest prefix shared by the keys of the page is stored once, keys
+ *    added later that do not share it are stored in full until the page is
+ *    compacted again
+ * KeyAt() rebuilds the full key, so searches still go through the comparator.
+ *
+ * Internal page format (slots are stored in increasing key order):
+ *  ---------------------------------------------------------------------------
+ * | HEADER | SLOT(0) | SLOT(1) | ... | SLOT(n) | FREE | KEY HEAP | KEY PREFIX |
+ *  ---------------------------------------------------------------------------
+ *
+ * Header format (size in byte, 40 bytes in total):
+ *  ---------------------------------------------------------------------------
+ * | B+ tree page header (32) | PrefixSize (2) | HeapBegin (2) | KeyBytes (2) |
+ *  ---------------------------------------------------------------------------
+ *
+ * Slot format (size in byte, 8 bytes in total):
+ *  ---------------------------------------------
+ * | PAGE_ID (4) | KeyOffset (2) | KeySize (2) |
+ *  ---------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
@@ -44,24 +66,72 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
 
   auto KeyAt(int index) const -> KeyType;
+  // The caller must make sure the key fits, see CanSetKeyAt
   void SetKeyAt(int index, const KeyType &key);
   void SetValueAt(int index, const page_id_t &value);
   auto ValueAt(int index) const -> ValueType;
   auto Bisect(KeyType const &key, page_id_t *page_id, KeyComparator const &comparator) const -> bool;
   auto BisectPosition(KeyType const &key, KeyComparator const &comparator) const -> int;
+  // Return the child that may contain key, i.e. the last PAGE_ID(i) with K(i) <= key
+  auto LookUp(KeyType const &key, KeyComparator const &comparator) const -> ValueType;
+  // Same as LookUp, but return the array offset of the child
+  auto LookUpIndex(KeyType const &key, KeyComparator const &comparator) const -> int;
+  // Return the child that may contain the largest keys smaller than key, i.e. the last PAGE_ID(i) with K(i) < key
+  auto LookUpBefore(KeyType const &key, KeyComparator const &comparator) const -> ValueType;
+  // Return the array offset of the given child, -1 if it is not a child of this page
+  auto ValueIndex(const ValueType &value) const -> int;
+  // The caller must make sure the entry fits, see HasRoomFor
   auto InsertAt(int index, KeyType const &key, page_id_t const &page_id) -> void;
   auto IncrementSize() -> void;
   auto DecrementSize() -> void;
-  auto RedistributeFrom(BPlusTreeInternalPage<KeyType, ValueType, KeyComparator> *from_page, int index) -> void;
   auto RemoveAt(int index) -> KeyType;
   auto UpdateChildrenPointers(BufferPoolManager *bmp) -> void;
   auto GetPairAt(int index) const -> MappingType;
   auto Rearrange() -> KeyType;
-  auto StealOrMerge(bool *is_merge, bool *is_right, BufferPoolManager *bpm, KeyComparator &cmp,
-                    page_id_t *sibling_page_id, int *sibling_index) -> void;
+  // Replace the whole content of the page with the given entries, the first key is ignored
+  void Assign(const std::pair<KeyType, page_id_t> *entries, int count);
+  // Rewrite the key heap without garbage and with the longest shared prefix
+  void Compact();
+
+  /*
+   * Space accounting. Pages hold at most max size entries, but may fill up
+   * earlier with long keys, so splits and merges ask the page.
+   */
+  // Bytes an entry with this key takes at most
+  static auto EntrySize(const KeyType &key) -> int;
+  auto GetUsedBytes() const -> int;
+  auto HasRoomFor(const KeyType &key) const -> bool;
+  auto CanSetKeyAt(int index, const KeyType &key) const -> bool;
+  // Whether any single insert still fits, i.e. the page can not split
+  auto IsFull() const -> bool;
+  // Below min size and less than half of the page in use
+  auto IsUnderflow() const -> bool;
+  // Whether removing any single entry leaves the page without underflow
+  auto CanLendEntry() const -> bool;
+  auto CanMergeWith(const BPlusTreeInternalPage *right_page, const KeyType &separator) const -> bool;
 
  private:
+  struct Slot {
+    page_id_t page_id_;
+    uint16_t key_offset_;
+    // high bit set if the key does not share the page prefix
+    uint16_t key_size_;
+  };
+
+  auto KeyPrefix() const -> const char *;
+  auto FreeBytes() const -> int;
+  // Store key in the heap and point the slot at it
+  void StoreKey(int index, const KeyType &key);
+  void WriteKey(int index, const KeyType &key);
+  void Rebuild(const std::vector<KeyType> &keys);
+  void ReleaseKey(int index);
+
+  uint16_t prefix_size_;
+  // the key heap takes [heap_begin_, BUSTUB_PAGE_SIZE - prefix_size_)
+  uint16_t heap_begin_;
+  // live bytes in the key heap and prefix, the rest of the heap is garbage
+  uint16_t key_bytes_;
   // Flexible array member for page data.
-  MappingType array_[1];
+  Slot slots_[1];
 };
 }  // namespace bustub
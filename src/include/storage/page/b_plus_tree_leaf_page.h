@@ -11,65 +11,176 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
 #include "storage/page/b_plus_tree_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 #include "type/value.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 48
+#define LEAF_PAGE_USABLE_SIZE (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE)
+#define LEAF_PAGE_KEY_HEAD_SIZE 8
+#define LEAF_PAGE_SIZE (LEAF_PAGE_USABLE_SIZE / sizeof(BPlusTreeLeafSlot<KeyType, ValueType>))
+#define LEAF_PAGE_OVERFLOW_SLOT UINT32_MAX
+
+/**
+ * Slot of a leaf entry. Keys of up to LEAF_PAGE_KEY_HEAD_SIZE bytes are stored
+ * in the slot. Longer keys keep their first LEAF_PAGE_KEY_HEAD_SIZE bytes there
+ * and the rest in the heap of the page, without their trailing zero bytes.
+ * Either way integer keys sit at the start of every slot, a fixed stride apart.
+ */
+template <typename KeyType, typename ValueType, bool HasKeyTail = (sizeof(KeyType) > LEAF_PAGE_KEY_HEAD_SIZE)>
+struct BPlusTreeLeafSlot {
+  char key_head_[LEAF_PAGE_KEY_HEAD_SIZE];
+  ValueType value_;
+  uint16_t tail_offset_;
+  uint16_t tail_size_;
+};
+
+template <typename KeyType, typename ValueType>
+struct BPlusTreeLeafSlot<KeyType, ValueType, false> {
+  char key_head_[sizeof(KeyType)];
+  ValueType value_;
+};
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page.
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Leaf page format (slots are stored in increasing key order):
+ *  -------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | SLOT(2) | ... | SLOT(n) | FREE | KEY TAILS AND LISTS |
+ *  -------------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 48 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | Version (8) |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | NextPageId (4) | PrevPageId (4) | HeapBegin (2) | HeapSize (2) |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | TailBytes (2) | HasPostingLists (2) |
+ *  ---------------------------------------------------------------------
+ *
+ *  Slot format, see BPlusTreeLeafSlot (size in byte):
+ *  ----------------------------------------------------------------------
+ * | KEY (up to 8) + RID (8) | or | KEY HEAD (8) + RID (8) | TailOffset (2) | TailSize (2) |
+ *  ----------------------------------------------------------------------
+ *
+ * Leaves form a doubly linked list in key order. A link is only changed while
+ * both leaves it connects are write latched.
+ *
+ * Leaves with long keys may run out of bytes before they reach max size, so
+ * splits and merges ask the page how full it is. A leaf always keeps room for
+ * one more entry, however long its key: inserts go in first and split after.
+ *
+ * In a non-unique tree the value of a key with several RIDs refers to its
+ * posting list instead (see b_plus_tree_posting_page.h): RID(INVALID_PAGE_ID,
+ * offset << 16 | size) for a list stored in the heap at the end of this page,
+ * which grows down towards the slots, and RID(first page, LEAF_PAGE_OVERFLOW_SLOT)
+ * for a list stored in posting pages. Inline lists do not count towards how
+ * full a leaf is, they are moved to posting pages whenever the entries need
+ * their room.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE,
+            bool has_posting_lists = false);
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
+  auto GetPrevPageId() const -> page_id_t;
+  void SetPrevPageId(page_id_t prev_page_id);
   auto KeyAt(int index) const -> KeyType;
   auto ValueAt(int index) const -> ValueType;
   auto Bisect(KeyType const &key, ValueType *value, KeyComparator const &comparator) const -> bool;
   auto BisectPosition(KeyType const &key, KeyComparator const &comparator) const -> int;
   auto GetPairAt(int index) const -> MappingType;
-  auto GetPairAt(int index) -> MappingType &;
   auto InsertAt(int index, KeyType const &key, ValueType const &value) -> void;
   auto IncrementSize() -> void;
   auto DecrementSize() -> void;
   auto RemoveAt(int index) -> KeyType;
   auto RedistributeFrom(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *from_page, int index) -> void;
   auto MergeWith(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *from_page, bool is_right) -> void;
-  auto StealOrMerge(bool *is_merge, bool *is_right, BufferPoolManager *bpm, KeyComparator &cmp,
-                    page_id_t *sibling_page_id, int *sibling_index) -> void;
+  // Replace the whole content of the page with the given entries, whose values must not be inline lists
+  void Assign(const MappingType *entries, int count);
+
+  /*
+   * Space accounting. Pages hold less than max size entries, but may fill up
+   * earlier with long keys.
+   */
+  // Bytes an entry with this key takes, not counting its inline list
+  static auto EntrySize(const KeyType &key) -> int;
+  // Bytes an entry with the longest possible key takes
+  static auto LargestEntrySize() -> int;
+  // Bytes of the slots and key tails
+  auto GetUsedBytes() const -> int;
+  // Whether the page has to split, i.e. it may not have room for another entry
+  auto IsOverflow() const -> bool;
+  // Whether an insert may make the page split
+  auto IsFull() const -> bool;
+  // Size below which a page with less than merge_fill of its bytes in use is merged, min size for the root
+  auto GetMergeSize(double merge_fill = BPLUS_TREE_MERGE_FILL) const -> int;
+  // Below merge size and less than merge_fill of the page in use, e.g. less than half of it by default
+  auto IsUnderflow(double merge_fill = BPLUS_TREE_MERGE_FILL) const -> bool;
+  // Whether removing any single entry leaves the page without underflow
+  auto CanLendEntry(double merge_fill = BPLUS_TREE_MERGE_FILL) const -> bool;
+  auto CanMergeWith(const BPlusTreeLeafPage *right_page) const -> bool;
+
+  // Posting lists, only used by leaves of non-unique trees
+  auto HasPostingLists() const -> bool;
+  static auto IsInlineList(const ValueType &value) -> bool;
+  static auto IsOverflowList(const ValueType &value) -> bool;
+  static auto MakeOverflowList(page_id_t head_page_id) -> ValueType;
+  // Append the RIDs of the inline list value refers to
+  void GetInlineList(const ValueType &value, std::vector<ValueType> *result) const;
+  // Store at least two sorted RIDs as the inline list of the entry at index, false if they do not fit
+  auto SetInlineList(int index, const std::vector<ValueType> &values) -> bool;
+  // Replace the value of the entry at index, releasing its inline list
+  void SetValueAt(int index, const ValueType &value);
+  auto InlineListSizeAt(int index) const -> int;
+  // Index of the entry with the largest inline list, -1 if there is none
+  auto LargestInlineList() const -> int;
+  auto GetFreeBytes() const -> int;
+  // Insert a copy of the entry at from_index of from_page, including its inline list
+  void InsertFrom(int index, const BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *from_page, int from_index);
 
  private:
+  using Slot = BPlusTreeLeafSlot<KeyType, ValueType>;
+  static constexpr bool HAS_KEY_TAIL = sizeof(KeyType) > LEAF_PAGE_KEY_HEAD_SIZE;
+
+  // Bytes of key stored in the heap
+  static auto TailSize(const KeyType &key) -> int;
+  // Make sure one more entry with a tail of tail_size bytes does not run into the heap
+  void ReserveEntry(int tail_size);
+  void Compact();
+  void ReleaseInlineList(const ValueType &value);
+  void ReleaseHeapBytes(int size);
+
   page_id_t next_page_id_;
+  page_id_t prev_page_id_;
+  // the heap takes [heap_begin_, BUSTUB_PAGE_SIZE), heap_size_ bytes of it are live
+  uint16_t heap_begin_;
+  uint16_t heap_size_;
+  // live bytes of key tails in the heap, the rest are inline lists
+  uint16_t tail_bytes_;
+  uint16_t has_posting_lists_;
   // Flexible array member for page data.
-  MappingType array_[1];
+  Slot slots_[1];
 };
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <cstdlib>
@@ -24,6 +25,17 @@ namespace bustub {
 
 #define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
 
+// Generic keys are zero padded, so trailing zero bytes do not need to be stored
+template <typename KeyType>
+inline auto KeySignificantSize(const KeyType &key) -> int {
+  const auto *data = reinterpret_cast<const char *>(&key);
+  auto size = static_cast<int>(sizeof(KeyType));
+  while (size > 0 && data[size - 1] == 0) {
+    size--;
+  }
+  return size;
+}
+
 // define page type enum
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
@@ -33,17 +45,22 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 32 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | Version (8) |
  * ----------------------------------------------------------------------------
+ *
+ * Version is used for optimistic lock coupling: a writer holding the page
+ * write latch makes it odd before modifying the page and even again when it
+ * is done, so readers can traverse without latches and validate afterwards.
  */
 class BPlusTreePage {
  public:
   auto IsLeafPage() const -> bool;
   auto IsRootPage() const -> bool;
+  auto GetPageType() const -> IndexPageType;
   void SetPageType(IndexPageType page_type);
 
   auto GetSize() const -> int;
@@ -62,6 +79,13 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  // Version helpers for optimistic lock coupling
+  void ResetVersion();
+  auto GetVersion() const -> uint64_t;
+  auto ValidateVersion(uint64_t version) const -> bool;
+  void BeginWrite();
+  void EndWrite(bool is_dirty);
+
  private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_ __attribute__((__unused__));
@@ -70,6 +94,7 @@ class BPlusTreePage {
   int max_size_ __attribute__((__unused__));
   page_id_t parent_page_id_ __attribute__((__unused__));
   page_id_t page_id_ __attribute__((__unused__));
+  std::atomic<uint64_t> version_;
 };
 
 }  // namespace bustub
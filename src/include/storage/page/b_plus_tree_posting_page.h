@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 20
+#define POSTING_PAGE_DATA_SIZE (BUSTUB_PAGE_SIZE - POSTING_PAGE_HEADER_SIZE)
+
+/**
+ * A posting list holds every RID of one key of a non-unique b+ tree. RIDs are
+ * sorted by RID::Get() and delta encoded: the first one is stored as a varint,
+ * every following one as the varint of its distance to the previous one, so
+ * RIDs of the same table page mostly take a single byte.
+ *
+ * Short lists are stored inside of their leaf page. Longer ones are stored in
+ * a chain of posting pages, each page covering a range of the sorted RIDs.
+ * Posting pages are only accessed while their leaf is latched.
+ *
+ * Posting page format:
+ *  ---------------------------------------------------------------------------
+ * | LastRid (8) | NextPageId (4) | Count (4) | DataSize (4) | delta encoded RIDs
+ *  ---------------------------------------------------------------------------
+ */
+class BPlusTreePostingPage {
+ public:
+  void Init();
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
+  auto GetCount() const -> int;
+  auto GetDataSize() const -> int;
+  // Append the RIDs of this page to result
+  void GetRids(std::vector<RID> *result) const;
+  // Replace the RIDs of this page, false if they do not fit
+  auto SetRids(const std::vector<RID> &rids) -> bool;
+
+  // Bytes needed to encode rids, which must be sorted and unique
+  static auto EncodedSize(const std::vector<RID> &rids) -> int;
+  // Encode rids into data, which must have room for EncodedSize(rids) bytes
+  static void Encode(const std::vector<RID> &rids, char *data);
+  // Decode size bytes of data into result, stops at the first malformed RID
+  static void Decode(const char *data, int size, std::vector<RID> *result);
+
+  // Build a chain of pages holding rids, return its first page
+  static auto CreateChain(BufferPoolManager *bpm, const std::vector<RID> &rids) -> page_id_t;
+  // Insert rid into the chain, false if it is already there
+  static auto InsertIntoChain(BufferPoolManager *bpm, page_id_t head_page_id, const RID &rid) -> bool;
+  // Remove rid from the chain, false if it is not there. The first page is never freed.
+  static auto RemoveFromChain(BufferPoolManager *bpm, page_id_t head_page_id, const RID &rid) -> bool;
+  // Call consumer on every RID in order until it returns false, false if it was stopped
+  static auto ScanChain(BufferPoolManager *bpm, page_id_t head_page_id,
+                        const std::function<bool(const RID &)> &consumer) -> bool;
+  // Read the chain into result if it is a single page of at most max_size bytes
+  static auto ReadShortChain(BufferPoolManager *bpm, page_id_t head_page_id, int max_size, std::vector<RID> *result)
+      -> bool;
+  static void FreeChain(BufferPoolManager *bpm, page_id_t head_page_id);
+
+ private:
+  int64_t last_rid_;
+  page_id_t next_page_id_;
+  int count_;
+  int data_size_;
+  char data_[1];
+};
+
+}  // namespace bustub
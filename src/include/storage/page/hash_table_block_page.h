@@ -74,8 +74,9 @@ class HashTableBlockPage {
    * Removes a key and value at index.
    *
    * @param bucket_ind ind to remove the value
+   * @return true if this call removed it, false if the index was not readable
    */
-  void Remove(slot_offset_t bucket_ind);
+  auto Remove(slot_offset_t bucket_ind) -> bool;
 
   /**
    * Returns whether or not an index is occupied (key/value pair or tombstone)
@@ -94,51 +95,30 @@ class HashTableBlockPage {
   auto IsReadable(slot_offset_t bucket_ind) const -> bool;
 
   /**
-   * Scan the bucket and collect values that have the matching key
+   * Collects the readable indexes holding key, from bucket_ind up to the first
+   * index that is not occupied. The bitmaps are read 64 indexes at a time, and
+   * the keys of those are compared with key at once (see HashTableProbe).
    *
-   * @return true if at least one key matched
+   * @param bucket_ind index to start at
+   * @param key key to look for
+   * @param cmp comparator for keys
+   * @param[out] slots the indexes holding key are appended to it
+   * @return the first index from bucket_ind on that is not occupied, BLOCK_ARRAY_SIZE if the run goes on in the
+   * next block
    */
-  auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool;
+  auto FindKey(slot_offset_t bucket_ind, const KeyType &key, KeyComparator cmp,
+               std::vector<slot_offset_t> *slots) const -> slot_offset_t;
 
   /**
-   * Attempts to insert a key and value in the bucket.
-   * The insert is thread safe. It uses compare and swap to claim the index,
-   * and then writes the key and value into the index, and then marks the
-   * index as readable.
-   *
-   * @param key key to insert
-   * @param value value to insert
-   * @return true if inserted, false if duplicate KV pair or bucket is full
-   */
-  auto Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool;
-
-  /**
-   * Removes a key and value.
-   * @return true if removed, false if not found
-   */
-  auto Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool;
-
-  /**
-   * @return the number of readable elements, i.e. current size
-   */
-  auto NumReadable() -> uint32_t;
-
-  /**
-   * @return whether the bucket is full
+   * @param bucket_ind index to start at
+   * @return the first index from bucket_ind on that is not occupied, BLOCK_ARRAY_SIZE if there is none
    */
-  auto IsFull() -> bool;
-
-  /**
-   * @return whether the bucket is empty
-   */
-  auto IsEmpty() -> bool;
-
-  /**
-   * Prints the bucket's occupancy information
-   */
-  void PrintBucket();
+  auto FindUnoccupied(slot_offset_t bucket_ind) const -> slot_offset_t;
 
  private:
+  // Bits of the 64 indexes from word * 64 on, bit i for index word * 64 + i
+  auto LoadWord(const std::atomic_char *bits, size_t word) const -> uint64_t;
+
   std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
 
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
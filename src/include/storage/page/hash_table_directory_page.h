@@ -123,6 +123,11 @@ class HashTableDirectoryPage {
    */
   void DecrGlobalDepth();
 
+  /**
+   * @return true if the directory can not grow any further
+   */
+  auto IsFull() -> bool;
+
   /**
    * @return true if the directory can be shrunk
    */
@@ -165,6 +170,7 @@ class HashTableDirectoryPage {
    * Gets the high bit corresponding to the bucket's local depth.
    * This is not the same as the bucket index itself.  This method
    * is helpful for finding the pair, or "split image", of a bucket.
+   * A bucket of local depth 0 has no high bit and is its own image.
    *
    * @param bucket_idx bucket index to lookup
    * @return the high bit corresponding to the bucket's local depth
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_probe.h
+//
+// Identification: src/include/storage/page/hash_table_probe.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace bustub {
+
+/**
+ * Compares a key with the keys of up to 64 consecutive slots of a hash table
+ * page at once. Only a prefix of 8 bytes (4 for smaller keys) is compared, as
+ * an integer: GenericKey is compared with memcmp, so a slot whose prefix
+ * differs cannot hold the key, and the slots that are left are checked with
+ * the comparator.
+ *
+ * The instruction set is picked at compile time: AVX2 gathers 4 (8 byte
+ * prefixes) or 8 (4 byte prefixes) slots per compare, SSE4.2 compares 2 or 4,
+ * and anything else falls back to a scalar loop. Build with
+ * BUSTUB_NATIVE_ARCH to enable them.
+ */
+class HashTableProbe {
+ public:
+  // Bit i is set if the key at data + i * stride (count <= 64 keys) starts like key
+  static inline auto MatchPrefix(const char *data, int stride, int count, const char *key, size_t key_size)
+      -> uint64_t {
+    if (key_size >= sizeof(uint64_t)) {
+      return Match<uint64_t>(data, stride, count, key);
+    }
+    if (key_size >= sizeof(uint32_t)) {
+      return Match<uint32_t>(data, stride, count, key);
+    }
+    // too short to have a prefix, every slot is left to the comparator
+    return count == 64 ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+  }
+
+ private:
+  template <typename T>
+  static inline auto Read(const char *data) -> T {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  template <typename T>
+  static inline auto Match(const char *data, int stride, int count, const char *key) -> uint64_t {
+    auto target = Read<T>(key);
+    uint64_t matches = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    if constexpr (sizeof(T) == sizeof(uint64_t)) {
+      const __m256i keys = _mm256_set1_epi64x(static_cast<int64_t>(target));
+      const __m128i offsets = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+      for (; i + 4 <= count; i += 4) {
+        __m256i values = _mm256_i32gather_epi64(reinterpret_cast<const long long *>(data + i * stride),  // NOLINT
+                                                offsets, 1);
+        auto mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(keys, values)));
+        matches |= static_cast<uint64_t>(mask) << i;
+      }
+    } else {
+      const __m256i keys = _mm256_set1_epi32(static_cast<int32_t>(target));
+      const __m256i offsets = _mm256_mullo_epi32(_mm256_set1_epi32(stride), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+      for (; i + 8 <= count; i += 8) {
+        __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int *>(data + i * stride), offsets, 1);
+        auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(keys, values)));
+        matches |= static_cast<uint64_t>(mask) << i;
+      }
+    }
+#elif defined(__SSE4_2__)
+    if constexpr (sizeof(T) == sizeof(uint64_t)) {
+      const __m128i keys = _mm_set1_epi64x(static_cast<int64_t>(target));
+      for (; i + 2 <= count; i += 2) {
+        const char *pos = data + i * stride;
+        __m128i values = _mm_set_epi64x(Read<int64_t>(pos + stride), Read<int64_t>(pos));
+        auto mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(keys, values)));
+        matches |= static_cast<uint64_t>(mask) << i;
+      }
+    } else {
+      const __m128i keys = _mm_set1_epi32(static_cast<int32_t>(target));
+      for (; i + 4 <= count; i += 4) {
+        const char *pos = data + i * stride;
+        __m128i values = _mm_setr_epi32(Read<int32_t>(pos), Read<int32_t>(pos + stride),
+                                        Read<int32_t>(pos + 2 * stride), Read<int32_t>(pos + 3 * stride));
+        auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(keys, values)));
+        matches |= static_cast<uint64_t>(mask) << i;
+      }
+    }
+#endif
+    for (; i < count; i++) {
+      matches |= static_cast<uint64_t>(Read<T>(data + i * stride) == target) << i;
+    }
+    return matches;
+  }
+};
+
+}  // namespace bustub
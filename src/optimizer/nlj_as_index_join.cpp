@@ -24,12 +24,18 @@ namespace bustub {
 auto Optimizer::MatchIndex(const std::string &table_name, uint32_t index_key_idx)
     -> std::optional<std::tuple<index_oid_t, std::string>> {
   const auto key_attrs = std::vector{index_key_idx};
+  std::optional<std::tuple<index_oid_t, std::string>> match;
   for (const auto *index_info : catalog_.GetTableIndexes(table_name)) {
     if (key_attrs == index_info->index_->GetKeyAttrs()) {
-      return std::make_optional(std::make_tuple(index_info->index_oid_, index_info->name_));
+      // the join only looks up single keys, which a hash index or the in-memory radix tree does without a descent
+      // through pages
+      if (index_info->index_type_ != IndexType::BPlusTreeIndex) {
+        return std::make_optional(std::make_tuple(index_info->index_oid_, index_info->name_));
+      }
+      match = match.value_or(std::make_tuple(index_info->index_oid_, index_info->name_));
     }
   }
-  return std::nullopt;
+  return match;
 }
 
 auto Optimizer::OptimizeNLJAsIndexJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
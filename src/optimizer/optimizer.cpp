@@ -1,5 +1,8 @@
 #include "optimizer/optimizer.h"
+#include <algorithm>
+#include <cmath>
 #include <optional>
+#include <thread>  // NOLINT
 #include "common/util/string_util.h"
 #include "execution/plans/abstract_plan.h"
 
@@ -21,6 +24,12 @@ auto Optimizer::Optimize(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef
 }
 
 auto Optimizer::EstimatedCardinality(const std::string &table_name) -> std::optional<size_t> {
+  for (const auto *index : catalog_.GetTableIndexes(table_name)) {
+    auto statistics = index->GetStatistics();
+    if (statistics.has_value()) {
+      return std::make_optional(statistics->num_values_);
+    }
+  }
   if (StringUtil::EndsWith(table_name, "_1m")) {
     return std::make_optional(1000000);
   }
@@ -42,4 +51,32 @@ auto Optimizer::EstimatedCardinality(const std::string &table_name) -> std::opti
   return std::nullopt;
 }
 
+/*
+ * Costs are counted in tuples read by a sequential scan. The index reads its
+ * leaves and fetches every tuple by RID, the sort compares about log2(n) times
+ * per tuple. Small tables are sorted, large ones are read through the index.
+ */
+auto Optimizer::IsIndexOrderCheaper(const IndexStatistics &statistics) -> bool {
+  // fetching a tuple by RID, a page is fetched and latched for every tuple
+  constexpr double RANDOM_TUPLE_COST = 2.0;
+  // reading an index page
+  constexpr double INDEX_PAGE_COST = 1.0;
+  // one comparison of the sort
+  constexpr double SORT_COMPARE_COST = 0.25;
+  auto num_rows = static_cast<double>(statistics.num_values_);
+  auto index_cost = static_cast<double>(statistics.height_ + statistics.num_leaves_) * INDEX_PAGE_COST +
+                    num_rows * RANDOM_TUPLE_COST;
+  auto sort_cost = num_rows + num_rows * std::log2(std::max(num_rows, 2.0)) * SORT_COMPARE_COST;
+  return index_cost <= sort_cost;
+}
+
+/*
+ * A thread per INDEX_SCAN_LEAVES_PER_PART leaves, but no more threads than
+ * the machine runs at once.
+ */
+auto Optimizer::IndexScanParts(const IndexStatistics &statistics) -> int {
+  auto max_parts = static_cast<uint64_t>(std::max(std::thread::hardware_concurrency(), 1U));
+  return static_cast<int>(std::clamp<uint64_t>(statistics.num_leaves_ / INDEX_SCAN_LEAVES_PER_PART, 1, max_parts));
+}
+
 }  // namespace bustub
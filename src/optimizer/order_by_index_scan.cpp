@@ -37,11 +37,12 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
       return optimized_plan;
     }
 
-    // Order type is asc or default
+    // Any order type, desc is served by scanning the index backwards
     const auto &[order_type, expr] = order_bys[0];
-    if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+    if (order_type == OrderByType::INVALID) {
       return optimized_plan;
     }
+    bool is_descending = order_type == OrderByType::DESC;
 
     // Order expression is a column value expression
     const auto *column_value_expr = dynamic_cast<ColumnValueExpression *>(expr.get());
@@ -62,10 +63,21 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
 
       for (const auto *index : indices) {
         const auto &columns = index->key_schema_.GetColumns();
-        if (columns.size() == 1 &&
+        // hash indexes keep no order
+        if (IsOrderedIndex(index->index_type_) && columns.size() == 1 &&
             columns[0].GetName() == table_info->schema_.GetColumn(order_by_column_id).GetName()) {
-          // Index matched, return index scan instead
-          return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
+          // Keep sorting if the statistics say it is cheaper, the starter rules always take the index
+          auto statistics = index->GetStatistics();
+          if (!force_starter_rule_ && statistics.has_value() && !IsIndexOrderCheaper(*statistics)) {
+            return optimized_plan;
+          }
+          // Index matched, return index scan instead, large ascending scans read their key ranges in parallel
+          auto num_parts = 1;
+          if (!force_starter_rule_ && statistics.has_value() && !is_descending) {
+            num_parts = IndexScanParts(*statistics);
+          }
+          return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_,
+                                                     is_descending, num_parts);
         }
       }
     }
@@ -1,9 +1,568 @@
-#include "primer/p0_trie.h"
-
-// This is a placeholder file for clang-tidy check.
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
 //
-// With this file, we can fire run_clang_tidy.py to check `p0_trie.h`,
-// as it will filter out all header files and won't check header-only code.
+// p0_trie.cpp
 //
-// This file is not part of the submission. All of the modifications should
-// be done in `src/include/primer/p0_trie.h`.
+// Identification: src/primer/p0_trie.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "primer/p0_trie.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+using ArtNodePtr = std::shared_ptr<const ArtNode>;
+using ArtInnerPtr = std::shared_ptr<ArtInnerNode>;
+
+auto AsInner(const ArtNode *node) -> const ArtInnerNode * { return static_cast<const ArtInnerNode *>(node); }
+
+auto KeyByte(const std::string &key, size_t depth) -> uint8_t { return static_cast<uint8_t>(key[depth]); }
+
+// Slot of the child for byte, nullptr if there is none
+auto FindChild(const ArtInnerNode *node, uint8_t byte) -> const ArtNodePtr * {
+  switch (node->GetType()) {
+    case ArtNodeType::Node4: {
+      const auto *node4 = static_cast<const ArtNode4 *>(node);
+      for (int i = 0; i < node4->num_children_; i++) {
+        if (node4->keys_[i] == byte) {
+          return &node4->children_[i];
+        }
+      }
+      return nullptr;
+    }
+    case ArtNodeType::Node16: {
+      const auto *node16 = static_cast<const ArtNode16 *>(node);
+#if defined(__SSE2__)
+      auto keys = _mm_loadu_si128(reinterpret_cast<const __m128i *>(node16->keys_.data()));
+      auto match = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(byte)));
+      auto mask = static_cast<uint32_t>(_mm_movemask_epi8(match)) & ((1U << node16->num_children_) - 1);
+      return mask == 0 ? nullptr : &node16->children_[__builtin_ctz(mask)];
+#else
+      for (int i = 0; i < node16->num_children_; i++) {
+        if (node16->keys_[i] == byte) {
+          return &node16->children_[i];
+        }
+      }
+      return nullptr;
+#endif
+    }
+    case ArtNodeType::Node48: {
+      const auto *node48 = static_cast<const ArtNode48 *>(node);
+      auto index = node48->child_index_[byte];
+      return index == 0 ? nullptr : &node48->children_[index - 1];
+    }
+    case ArtNodeType::Node256: {
+      const auto *node256 = static_cast<const ArtNode256 *>(node);
+      return node256->children_[byte] == nullptr ? nullptr : &node256->children_[byte];
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// The same slot of a copy that is not published yet
+auto FindChild(ArtInnerNode *node, uint8_t byte) -> ArtNodePtr * {
+  return const_cast<ArtNodePtr *>(FindChild(static_cast<const ArtInnerNode *>(node), byte));
+}
+
+// Slot of the child with the smallest byte, nullptr if there are no children
+auto FirstChild(const ArtInnerNode *node) -> const ArtNodePtr * {
+  if (node->num_children_ == 0) {
+    return nullptr;
+  }
+  switch (node->GetType()) {
+    case ArtNodeType::Node4:
+      return &static_cast<const ArtNode4 *>(node)->children_[0];
+    case ArtNodeType::Node16:
+      return &static_cast<const ArtNode16 *>(node)->children_[0];
+    case ArtNodeType::Node48: {
+      const auto *node48 = static_cast<const ArtNode48 *>(node);
+      for (auto index : node48->child_index_) {
+        if (index != 0) {
+          return &node48->children_[index - 1];
+        }
+      }
+      return nullptr;
+    }
+    case ArtNodeType::Node256: {
+      const auto *node256 = static_cast<const ArtNode256 *>(node);
+      for (const auto &child : node256->children_) {
+        if (child != nullptr) {
+          return &child;
+        }
+      }
+      return nullptr;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+// Some leaf below node, every one of them has the whole prefix of node in its key
+auto AnyLeaf(const ArtNode *node) -> const ArtLeaf * {
+  while (!node->IsLeaf()) {
+    const auto *inner = AsInner(node);
+    if (inner->leaf_ != nullptr) {
+      return inner->leaf_.get();
+    }
+    node = FirstChild(inner)->get();
+  }
+  return static_cast<const ArtLeaf *>(node);
+}
+
+// Byte i of the prefix of node, which starts at depth of the key
+auto PrefixByte(const ArtInnerNode *node, const ArtLeaf *any_leaf, size_t depth, uint32_t i) -> uint8_t {
+  return i < ArtInnerNode::MAX_PREFIX_LEN ? node->prefix_[i] : KeyByte(any_leaf->GetKey(), depth + i);
+}
+
+// Number of bytes of the prefix of node the key has from depth on
+auto PrefixMismatch(const ArtInnerNode *node, const std::string &key, size_t depth) -> uint32_t {
+  auto stored = std::min(node->prefix_len_, ArtInnerNode::MAX_PREFIX_LEN);
+  for (uint32_t i = 0; i < stored; i++) {
+    if (depth + i >= key.size() || node->prefix_[i] != KeyByte(key, depth + i)) {
+      return i;
+    }
+  }
+  if (node->prefix_len_ > stored) {
+    const auto &leaf_key = AnyLeaf(node)->GetKey();
+    for (uint32_t i = stored; i < node->prefix_len_; i++) {
+      if (depth + i >= key.size() || leaf_key[depth + i] != key[depth + i]) {
+        return i;
+      }
+    }
+  }
+  return node->prefix_len_;
+}
+
+// Whether the stored bytes of the prefix of node match the key, the skipped ones are compared at the leaf
+auto PrefixMatches(const ArtInnerNode *node, const std::string &key, size_t depth) -> bool {
+  if (depth + node->prefix_len_ > key.size()) {
+    return false;
+  }
+  auto stored = std::min(node->prefix_len_, ArtInnerNode::MAX_PREFIX_LEN);
+  for (uint32_t i = 0; i < stored; i++) {
+    if (node->prefix_[i] != KeyByte(key, depth + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A copy of the node for a writer to change, it shares the children of the node
+auto CopyInner(const ArtInnerNode *node) -> ArtInnerPtr {
+  switch (node->GetType()) {
+    case ArtNodeType::Node4:
+      return std::make_shared<ArtNode4>(*static_cast<const ArtNode4 *>(node));
+    case ArtNodeType::Node16:
+      return std::make_shared<ArtNode16>(*static_cast<const ArtNode16 *>(node));
+    case ArtNodeType::Node48:
+      return std::make_shared<ArtNode48>(*static_cast<const ArtNode48 *>(node));
+    default:
+      return std::make_shared<ArtNode256>(*static_cast<const ArtNode256 *>(node));
+  }
+}
+
+template <size_t N>
+void InsertSorted(std::array<uint8_t, N> *keys, std::array<ArtNodePtr, N> *children, int count, uint8_t byte,
+                  ArtNodePtr child) {
+  int pos = count;
+  for (; pos > 0 && (*keys)[pos - 1] > byte; pos--) {
+    (*keys)[pos] = (*keys)[pos - 1];
+    (*children)[pos] = std::move((*children)[pos - 1]);
+  }
+  (*keys)[pos] = byte;
+  (*children)[pos] = std::move(child);
+}
+
+template <size_t N>
+void RemoveSorted(std::array<uint8_t, N> *keys, std::array<ArtNodePtr, N> *children, int count, uint8_t byte) {
+  int pos = 0;
+  while (pos < count && (*keys)[pos] != byte) {
+    pos++;
+  }
+  for (; pos + 1 < count; pos++) {
+    (*keys)[pos] = (*keys)[pos + 1];
+    (*children)[pos] = std::move((*children)[pos + 1]);
+  }
+  (*children)[count - 1].reset();
+}
+
+// Move everything but the children from one node to the node that replaces it
+void MoveHeader(ArtInnerNode *to, ArtInnerNode *from) {
+  to->num_children_ = from->num_children_;
+  to->prefix_len_ = from->prefix_len_;
+  to->prefix_ = from->prefix_;
+  to->leaf_ = std::move(from->leaf_);
+}
+
+// Add a child to an unpublished node, which is replaced by a larger one if it is full
+void AddChild(ArtInnerPtr *ref, uint8_t byte, ArtNodePtr child) {
+  ArtInnerNode *node = ref->get();
+  switch (node->GetType()) {
+    case ArtNodeType::Node4: {
+      auto *node4 = static_cast<ArtNode4 *>(node);
+      if (node4->num_children_ < 4) {
+        InsertSorted(&node4->keys_, &node4->children_, node4->num_children_++, byte, std::move(child));
+        return;
+      }
+      auto node16 = std::make_shared<ArtNode16>();
+      MoveHeader(node16.get(), node4);
+      for (int i = 0; i < 4; i++) {
+        node16->keys_[i] = node4->keys_[i];
+        node16->children_[i] = std::move(node4->children_[i]);
+      }
+      *ref = std::move(node16);
+      break;
+    }
+    case ArtNodeType::Node16: {
+      auto *node16 = static_cast<ArtNode16 *>(node);
+      if (node16->num_children_ < 16) {
+        InsertSorted(&node16->keys_, &node16->children_, node16->num_children_++, byte, std::move(child));
+        return;
+      }
+      auto node48 = std::make_shared<ArtNode48>();
+      MoveHeader(node48.get(), node16);
+      for (int i = 0; i < 16; i++) {
+        node48->child_index_[node16->keys_[i]] = i + 1;
+        node48->children_[i] = std::move(node16->children_[i]);
+      }
+      *ref = std::move(node48);
+      break;
+    }
+    case ArtNodeType::Node48: {
+      auto *node48 = static_cast<ArtNode48 *>(node);
+      if (node48->num_children_ < 48) {
+        int slot = 0;
+        while (node48->children_[slot] != nullptr) {
+          slot++;
+        }
+        node48->child_index_[byte] = slot + 1;
+        node48->children_[slot] = std::move(child);
+        node48->num_children_++;
+        return;
+      }
+      auto node256 = std::make_shared<ArtNode256>();
+      MoveHeader(node256.get(), node48);
+      for (int b = 0; b < 256; b++) {
+        if (node48->child_index_[b] != 0) {
+          node256->children_[b] = std::move(node48->children_[node48->child_index_[b] - 1]);
+        }
+      }
+      *ref = std::move(node256);
+      break;
+    }
+    case ArtNodeType::Node256: {
+      auto *node256 = static_cast<ArtNode256 *>(node);
+      node256->children_[byte] = std::move(child);
+      node256->num_children_++;
+      return;
+    }
+    default:
+      return;
+  }
+  AddChild(ref, byte, std::move(child));
+}
+
+// Remove a child of an unpublished node, which is replaced by a smaller one once it is mostly empty
+void RemoveChild(ArtInnerPtr *ref, uint8_t byte) {
+  ArtInnerNode *node = ref->get();
+  switch (node->GetType()) {
+    case ArtNodeType::Node4: {
+      auto *node4 = static_cast<ArtNode4 *>(node);
+      RemoveSorted(&node4->keys_, &node4->children_, node4->num_children_--, byte);
+      return;
+    }
+    case ArtNodeType::Node16: {
+      auto *node16 = static_cast<ArtNode16 *>(node);
+      RemoveSorted(&node16->keys_, &node16->children_, node16->num_children_--, byte);
+      if (node16->num_children_ > 3) {
+        return;
+      }
+      auto node4 = std::make_shared<ArtNode4>();
+      MoveHeader(node4.get(), node16);
+      for (int i = 0; i < node16->num_children_; i++) {
+        node4->keys_[i] = node16->keys_[i];
+        node4->children_[i] = std::move(node16->children_[i]);
+      }
+      *ref = std::move(node4);
+      return;
+    }
+    case ArtNodeType::Node48: {
+      auto *node48 = static_cast<ArtNode48 *>(node);
+      node48->children_[node48->child_index_[byte] - 1].reset();
+      node48->child_index_[byte] = 0;
+      if (--node48->num_children_ > 12) {
+        return;
+      }
+      auto node16 = std::make_shared<ArtNode16>();
+      MoveHeader(node16.get(), node48);
+      int i = 0;
+      for (int b = 0; b < 256; b++) {
+        if (node48->child_index_[b] != 0) {
+          node16->keys_[i] = b;
+          node16->children_[i++] = std::move(node48->children_[node48->child_index_[b] - 1]);
+        }
+      }
+      *ref = std::move(node16);
+      return;
+    }
+    case ArtNodeType::Node256: {
+      auto *node256 = static_cast<ArtNode256 *>(node);
+      node256->children_[byte].reset();
+      if (--node256->num_children_ > 37) {
+        return;
+      }
+      auto node48 = std::make_shared<ArtNode48>();
+      MoveHeader(node48.get(), node256);
+      int slot = 0;
+      for (int b = 0; b < 256; b++) {
+        if (node256->children_[b] != nullptr) {
+          node48->child_index_[b] = slot + 1;
+          node48->children_[slot++] = std::move(node256->children_[b]);
+        }
+      }
+      *ref = std::move(node48);
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+// Put a leaf below an unpublished node, whose prefix ends at depth of the key
+void PlaceLeaf(ArtInnerPtr *ref, std::shared_ptr<const ArtLeaf> leaf, size_t depth) {
+  const auto &key = leaf->GetKey();
+  if (key.size() == depth) {
+    (*ref)->leaf_ = std::move(leaf);
+    return;
+  }
+  AddChild(ref, KeyByte(key, depth), std::move(leaf));
+}
+
+// What replaces an unpublished node, whose prefix starts at depth, once it may have a single entry left
+auto Collapse(ArtInnerPtr node, size_t depth) -> ArtNodePtr {
+  if (node->num_children_ == 0) {
+    return node->leaf_;
+  }
+  if (node->num_children_ > 1 || node->leaf_ != nullptr) {
+    return node;
+  }
+  const ArtNodePtr &child = *FirstChild(node.get());
+  if (child->IsLeaf()) {
+    return child;
+  }
+  // A copy of the child takes over the prefix of the node and the byte between them
+  auto merged = CopyInner(AsInner(child.get()));
+  merged->prefix_len_ += node->prefix_len_ + 1;
+  const auto &leaf_key = AnyLeaf(merged.get())->GetKey();
+  for (uint32_t i = 0; i < std::min(merged->prefix_len_, ArtInnerNode::MAX_PREFIX_LEN); i++) {
+    merged->prefix_[i] = KeyByte(leaf_key, depth + i);
+  }
+  return merged;
+}
+
+// The node that replaces node once the leaf is added below it, nullptr if the key is there already
+auto InsertInto(const ArtNodePtr &node, const std::shared_ptr<const ArtLeaf> &leaf, size_t depth) -> ArtNodePtr {
+  const auto &key = leaf->GetKey();
+  if (node == nullptr) {
+    return leaf;
+  }
+
+  if (node->IsLeaf()) {
+    const auto &other_key = static_cast<const ArtLeaf *>(node.get())->GetKey();
+    if (other_key == key) {
+      return nullptr;
+    }
+    // The two keys get a node where they part
+    ArtInnerPtr inner = std::make_shared<ArtNode4>();
+    uint32_t common = 0;
+    while (depth + common < std::min(key.size(), other_key.size()) &&
+           key[depth + common] == other_key[depth + common]) {
+      if (common < ArtInnerNode::MAX_PREFIX_LEN) {
+        inner->prefix_[common] = KeyByte(key, depth + common);
+      }
+      common++;
+    }
+    inner->prefix_len_ = common;
+    PlaceLeaf(&inner, std::static_pointer_cast<const ArtLeaf>(node), depth + common);
+    PlaceLeaf(&inner, leaf, depth + common);
+    return inner;
+  }
+
+  const auto *inner = AsInner(node.get());
+  if (inner->prefix_len_ > 0) {
+    auto mismatch = PrefixMismatch(inner, key, depth);
+    if (mismatch < inner->prefix_len_) {
+      // A new node takes the common part of the prefix, a copy of the old one keeps the part past the mismatch
+      ArtInnerPtr parent = std::make_shared<ArtNode4>();
+      parent->prefix_len_ = mismatch;
+      std::copy_n(inner->prefix_.begin(), std::min(mismatch, ArtInnerNode::MAX_PREFIX_LEN), parent->prefix_.begin());
+      const ArtLeaf *any_leaf = AnyLeaf(inner);
+      auto rest = CopyInner(inner);
+      rest->prefix_len_ = inner->prefix_len_ - mismatch - 1;
+      for (uint32_t i = 0; i < std::min(rest->prefix_len_, ArtInnerNode::MAX_PREFIX_LEN); i++) {
+        rest->prefix_[i] = PrefixByte(inner, any_leaf, depth, mismatch + 1 + i);
+      }
+      AddChild(&parent, PrefixByte(inner, any_leaf, depth, mismatch), std::move(rest));
+      PlaceLeaf(&parent, leaf, depth + mismatch);
+      return parent;
+    }
+    depth += inner->prefix_len_;
+  }
+
+  if (depth == key.size()) {
+    if (inner->leaf_ != nullptr) {
+      return nullptr;
+    }
+    auto copy = CopyInner(inner);
+    copy->leaf_ = leaf;
+    return copy;
+  }
+  const ArtNodePtr *child = FindChild(inner, KeyByte(key, depth));
+  if (child == nullptr) {
+    auto copy = CopyInner(inner);
+    AddChild(&copy, KeyByte(key, depth), leaf);
+    return copy;
+  }
+  auto new_child = InsertInto(*child, leaf, depth + 1);
+  if (new_child == nullptr) {
+    return nullptr;
+  }
+  auto copy = CopyInner(inner);
+  *FindChild(copy.get(), KeyByte(key, depth)) = std::move(new_child);
+  return copy;
+}
+
+// Whether the key is below node, and what replaces node once it is removed
+auto RemoveFrom(const ArtNodePtr &node, const std::string &key, size_t depth, ArtNodePtr *result) -> bool {
+  if (node == nullptr) {
+    return false;
+  }
+  if (node->IsLeaf()) {
+    if (static_cast<const ArtLeaf *>(node.get())->GetKey() != key) {
+      return false;
+    }
+    *result = nullptr;
+    return true;
+  }
+
+  const auto *inner = AsInner(node.get());
+  if (!PrefixMatches(inner, key, depth)) {
+    return false;
+  }
+  auto node_depth = depth;
+  depth += inner->prefix_len_;
+  if (depth == key.size()) {
+    if (inner->leaf_ == nullptr || inner->leaf_->GetKey() != key) {
+      return false;
+    }
+    auto copy = CopyInner(inner);
+    copy->leaf_.reset();
+    *result = Collapse(std::move(copy), node_depth);
+    return true;
+  }
+  const ArtNodePtr *child = FindChild(inner, KeyByte(key, depth));
+  ArtNodePtr new_child;
+  if (child == nullptr || !RemoveFrom(*child, key, depth + 1, &new_child)) {
+    return false;
+  }
+  auto copy = CopyInner(inner);
+  if (new_child == nullptr) {
+    RemoveChild(&copy, KeyByte(key, depth));
+  } else {
+    *FindChild(copy.get(), KeyByte(key, depth)) = std::move(new_child);
+  }
+  *result = Collapse(std::move(copy), node_depth);
+  return true;
+}
+
+}  // namespace
+
+auto Trie::InsertLeaf(std::shared_ptr<const ArtLeaf> leaf) -> bool {
+  std::scoped_lock lock(this->write_latch_);
+  auto root = InsertInto(this->root_, leaf, 0);
+  if (root == nullptr) {
+    return false;
+  }
+  this->Publish(std::move(root));
+  return true;
+}
+
+auto Trie::RemoveLeaf(const std::string &key) -> bool {
+  std::scoped_lock lock(this->write_latch_);
+  ArtNodePtr root;
+  if (!RemoveFrom(this->root_, key, 0, &root)) {
+    return false;
+  }
+  this->Publish(std::move(root));
+  return true;
+}
+
+void Trie::Publish(std::shared_ptr<const ArtNode> root) {
+  this->retired_.push_back(std::move(this->root_));
+  this->root_ = std::move(root);
+  this->reader_root_.store(this->root_.get());
+  auto epoch = this->epoch_.load();
+  if (this->num_readers_[(epoch + 1) % 2].load() == 0) {
+    // The readers of the epoch before are gone, and the roots retired back then were replaced before the current
+    // epoch started, so no reader has them. Readers of the current epoch move to the other count from now on.
+    this->previous_retired_ = std::move(this->retired_);
+    this->retired_.clear();
+    this->epoch_.store(epoch + 1);
+  }
+}
+
+auto Trie::BeginRead() -> uint64_t {
+  while (true) {
+    auto epoch = this->epoch_.load();
+    this->num_readers_[epoch % 2].fetch_add(1);
+    // Counted before the epoch moved on, so the writer that moves it on waits for this reader
+    if (this->epoch_.load() == epoch) {
+      return epoch;
+    }
+    this->num_readers_[epoch % 2].fetch_sub(1);
+  }
+}
+
+void Trie::EndRead(uint64_t epoch) { this->num_readers_[epoch % 2].fetch_sub(1); }
+
+auto Trie::FindLeaf(const ArtNode *root, const std::string &key) -> const ArtLeaf * {
+  const ArtNode *node = root;
+  size_t depth = 0;
+  while (node != nullptr) {
+    if (node->IsLeaf()) {
+      const auto *leaf = static_cast<const ArtLeaf *>(node);
+      return leaf->GetKey() == key ? leaf : nullptr;
+    }
+    const auto *inner = AsInner(node);
+    if (!PrefixMatches(inner, key, depth)) {
+      return nullptr;
+    }
+    depth += inner->prefix_len_;
+    if (depth == key.size()) {
+      const ArtLeaf *leaf = inner->leaf_.get();
+      return leaf != nullptr && leaf->GetKey() == key ? leaf : nullptr;
+    }
+    const ArtNodePtr *child = FindChild(inner, KeyByte(key, depth));
+    node = child == nullptr ? nullptr : child->get();
+    depth++;
+  }
+  return nullptr;
+}
+
+}  // namespace bustub
@@ -105,6 +105,7 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
     // std::cerr << "I/O error while reading" << std::endl;
   } else {
     // set read cursor to offset
+    num_reads_ += 1;
     db_io_.seekp(offset);
     db_io_.read(page_data, BUSTUB_PAGE_SIZE);
     if (db_io_.bad()) {
@@ -194,6 +195,11 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
  */
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
+/**
+ * Returns number of Reads made so far
+ */
+auto DiskManager::GetNumReads() const -> int { return num_reads_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
@@ -0,0 +1,729 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree.cpp
+//
+// Identification: src/storage/index/adaptive_radix_tree.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/adaptive_radix_tree.h"
+
+#include <algorithm>
+#include <array>
+#include <mutex>  // NOLINT
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bustub {
+
+enum class RadixNodeType : uint8_t { Leaf, Node4, Node16, Node48, Node256 };
+
+/** Header of every node, a child slot holds either an inner node or a leaf. */
+struct RadixNode {
+  explicit RadixNode(RadixNodeType type) : type_(type) {}
+  virtual ~RadixNode() = default;
+
+  auto IsLeaf() const -> bool { return type_ == RadixNodeType::Leaf; }
+
+  RadixNodeType type_;
+};
+
+/** A whole key and its value. */
+struct RadixLeaf : public RadixNode {
+  RadixLeaf(std::string key, const RID &value) : RadixNode(RadixNodeType::Leaf), key_(std::move(key)), value_(value) {}
+
+  std::string key_;
+  RID value_;
+};
+
+/**
+ * The part of the header shared by inner nodes. All bytes of the prefix are
+ * counted in prefix_len_ but only the first MAX_PREFIX_LEN are kept, the rest
+ * are read from the key of any leaf below. The key that ends right after the
+ * prefix is kept in leaf_.
+ */
+struct RadixInner : public RadixNode {
+  static constexpr uint32_t MAX_PREFIX_LEN = 8;
+
+  explicit RadixInner(RadixNodeType type) : RadixNode(type) {}
+
+  uint16_t num_children_{0};
+  uint32_t prefix_len_{0};
+  std::array<uint8_t, MAX_PREFIX_LEN> prefix_{};
+  std::unique_ptr<RadixLeaf> leaf_;
+};
+
+/** Up to 4 children, keys_ sorted. */
+struct RadixNode4 : public RadixInner {
+  RadixNode4() : RadixInner(RadixNodeType::Node4) {}
+
+  std::array<uint8_t, 4> keys_{};
+  std::array<std::unique_ptr<RadixNode>, 4> children_;
+};
+
+/** Up to 16 children, keys_ sorted and searched all at once with SSE2. */
+struct RadixNode16 : public RadixInner {
+  RadixNode16() : RadixInner(RadixNodeType::Node16) {}
+
+  std::array<uint8_t, 16> keys_{};
+  std::array<std::unique_ptr<RadixNode>, 16> children_;
+};
+
+/** Up to 48 children, child_index_ maps a key byte to its slot in children_ plus one, 0 if there is none. */
+struct RadixNode48 : public RadixInner {
+  RadixNode48() : RadixInner(RadixNodeType::Node48) {}
+
+  std::array<uint8_t, 256> child_index_{};
+  std::array<std::unique_ptr<RadixNode>, 48> children_;
+};
+
+/** A child slot for every key byte. */
+struct RadixNode256 : public RadixInner {
+  RadixNode256() : RadixInner(RadixNodeType::Node256) {}
+
+  std::array<std::unique_ptr<RadixNode>, 256> children_;
+};
+
+namespace {
+
+using RadixChild = std::unique_ptr<RadixNode>;
+
+auto AsInner(RadixNode *node) -> RadixInner * { return static_cast<RadixInner *>(node); }
+
+auto KeyByte(const std::string &key, size_t depth) -> uint8_t { return static_cast<uint8_t>(key[depth]); }
+
+// Slot of the child for byte, nullptr if there is none
+auto FindChild(const RadixInner *node, uint8_t byte) -> const RadixChild * {
+  switch (node->type_) {
+    case RadixNodeType::Node4: {
+      const auto *node4 = static_cast<const RadixNode4 *>(node);
+      for (int i = 0; i < node4->num_children_; i++) {
+        if (node4->keys_[i] == byte) {
+          return &node4->children_[i];
+        }
+      }
+      return nullptr;
+    }
+    case RadixNodeType::Node16: {
+      const auto *node16 = static_cast<const RadixNode16 *>(node);
+#if defined(__SSE2__)
+      auto keys = _mm_loadu_si128(reinterpret_cast<const __m128i *>(node16->keys_.data()));
+      auto match = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(byte)));
+      auto mask = static_cast<uint32_t>(_mm_movemask_epi8(match)) & ((1U << node16->num_children_) - 1);
+      return mask == 0 ? nullptr : &node16->children_[__builtin_ctz(mask)];
+#else
+      for (int i = 0; i < node16->num_children_; i++) {
+        if (node16->keys_[i] == byte) {
+          return &node16->children_[i];
+        }
+      }
+      return nullptr;
+#endif
+    }
+    case RadixNodeType::Node48: {
+      const auto *node48 = static_cast<const RadixNode48 *>(node);
+      auto index = node48->child_index_[byte];
+      return index == 0 ? nullptr : &node48->children_[index - 1];
+    }
+    case RadixNodeType::Node256: {
+      const auto *node256 = static_cast<const RadixNode256 *>(node);
+      return node256->children_[byte] == nullptr ? nullptr : &node256->children_[byte];
+    }
+    default:
+      return nullptr;
+  }
+}
+
+auto FindChild(RadixInner *node, uint8_t byte) -> RadixChild * {
+  return const_cast<RadixChild *>(FindChild(static_cast<const RadixInner *>(node), byte));
+}
+
+// Calls visit(byte, child) on the children of node in order of their bytes, or the other way round, until it
+// returns false
+template <typename ChildVisitor>
+auto ForEachChild(const RadixInner *node, bool descending, ChildVisitor &&visit) -> bool {
+  switch (node->type_) {
+    case RadixNodeType::Node4:
+    case RadixNodeType::Node16: {
+      const uint8_t *keys;
+      const RadixChild *children;
+      if (node->type_ == RadixNodeType::Node4) {
+        keys = static_cast<const RadixNode4 *>(node)->keys_.data();
+        children = static_cast<const RadixNode4 *>(node)->children_.data();
+      } else {
+        keys = static_cast<const RadixNode16 *>(node)->keys_.data();
+        children = static_cast<const RadixNode16 *>(node)->children_.data();
+      }
+      int num_children = node->num_children_;
+      for (int k = 0; k < num_children; k++) {
+        auto i = descending ? num_children - 1 - k : k;
+        if (!visit(keys[i], children[i].get())) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case RadixNodeType::Node48: {
+      const auto *node48 = static_cast<const RadixNode48 *>(node);
+      for (int k = 0; k < 256; k++) {
+        auto byte = static_cast<uint8_t>(descending ? 255 - k : k);
+        auto index = node48->child_index_[byte];
+        if (index != 0 && !visit(byte, node48->children_[index - 1].get())) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case RadixNodeType::Node256: {
+      const auto *node256 = static_cast<const RadixNode256 *>(node);
+      for (int k = 0; k < 256; k++) {
+        auto byte = static_cast<uint8_t>(descending ? 255 - k : k);
+        if (node256->children_[byte] != nullptr && !visit(byte, node256->children_[byte].get())) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      return true;
+  }
+}
+
+// Slot of the child with the smallest byte, nullptr if there are no children
+auto FirstChild(RadixInner *node) -> RadixChild * {
+  RadixChild *first = nullptr;
+  ForEachChild(node, false, [node, &first](uint8_t byte, const RadixNode * /* child */) {
+    first = FindChild(node, byte);
+    return false;
+  });
+  return first;
+}
+
+// Some leaf below node, every one of them has the whole prefix of node in its key
+auto AnyLeaf(const RadixNode *node) -> const RadixLeaf * {
+  while (!node->IsLeaf()) {
+    const auto *inner = static_cast<const RadixInner *>(node);
+    if (inner->leaf_ != nullptr) {
+      return inner->leaf_.get();
+    }
+    node = FirstChild(const_cast<RadixInner *>(inner))->get();
+  }
+  return static_cast<const RadixLeaf *>(node);
+}
+
+// Byte i of the prefix of node, which starts at depth of the key
+auto PrefixByte(const RadixInner *node, const RadixLeaf *any_leaf, size_t depth, uint32_t i) -> uint8_t {
+  return i < RadixInner::MAX_PREFIX_LEN ? node->prefix_[i] : KeyByte(any_leaf->key_, depth + i);
+}
+
+// Number of bytes of the prefix of node the key has from depth on
+auto PrefixMismatch(RadixInner *node, const std::string &key, size_t depth) -> uint32_t {
+  auto stored = std::min(node->prefix_len_, RadixInner::MAX_PREFIX_LEN);
+  for (uint32_t i = 0; i < stored; i++) {
+    if (depth + i >= key.size() || node->prefix_[i] != KeyByte(key, depth + i)) {
+      return i;
+    }
+  }
+  if (node->prefix_len_ > stored) {
+    const auto &leaf_key = AnyLeaf(node)->key_;
+    for (uint32_t i = stored; i < node->prefix_len_; i++) {
+      if (depth + i >= key.size() || leaf_key[depth + i] != key[depth + i]) {
+        return i;
+      }
+    }
+  }
+  return node->prefix_len_;
+}
+
+// Whether the stored bytes of the prefix of node match the key, the skipped ones are compared at the leaf
+auto PrefixMatches(const RadixInner *node, const std::string &key, size_t depth) -> bool {
+  if (depth + node->prefix_len_ > key.size()) {
+    return false;
+  }
+  auto stored = std::min(node->prefix_len_, RadixInner::MAX_PREFIX_LEN);
+  for (uint32_t i = 0; i < stored; i++) {
+    if (node->prefix_[i] != KeyByte(key, depth + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t N>
+void InsertSorted(std::array<uint8_t, N> *keys, std::array<RadixChild, N> *children, int count, uint8_t byte,
+                  RadixChild child) {
+  int pos = count;
+  for (; pos > 0 && (*keys)[pos - 1] > byte; pos--) {
+    (*keys)[pos] = (*keys)[pos - 1];
+    (*children)[pos] = std::move((*children)[pos - 1]);
+  }
+  (*keys)[pos] = byte;
+  (*children)[pos] = std::move(child);
+}
+
+template <size_t N>
+void RemoveSorted(std::array<uint8_t, N> *keys, std::array<RadixChild, N> *children, int count, uint8_t byte) {
+  int pos = 0;
+  while (pos < count && (*keys)[pos] != byte) {
+    pos++;
+  }
+  for (; pos + 1 < count; pos++) {
+    (*keys)[pos] = (*keys)[pos + 1];
+    (*children)[pos] = std::move((*children)[pos + 1]);
+  }
+  (*children)[count - 1].reset();
+}
+
+// Move everything but the children from one node to the node that replaces it
+void MoveHeader(RadixInner *to, RadixInner *from) {
+  to->num_children_ = from->num_children_;
+  to->prefix_len_ = from->prefix_len_;
+  to->prefix_ = from->prefix_;
+  to->leaf_ = std::move(from->leaf_);
+}
+
+// Add a child to the inner node in ref, which is replaced by a larger one if it is full
+void AddChild(RadixChild *ref, uint8_t byte, RadixChild child) {
+  auto *node = AsInner(ref->get());
+  switch (node->type_) {
+    case RadixNodeType::Node4: {
+      auto *node4 = static_cast<RadixNode4 *>(node);
+      if (node4->num_children_ < 4) {
+        InsertSorted(&node4->keys_, &node4->children_, node4->num_children_++, byte, std::move(child));
+        return;
+      }
+      auto node16 = std::make_unique<RadixNode16>();
+      MoveHeader(node16.get(), node4);
+      for (int i = 0; i < 4; i++) {
+        node16->keys_[i] = node4->keys_[i];
+        node16->children_[i] = std::move(node4->children_[i]);
+      }
+      *ref = std::move(node16);
+      break;
+    }
+    case RadixNodeType::Node16: {
+      auto *node16 = static_cast<RadixNode16 *>(node);
+      if (node16->num_children_ < 16) {
+        InsertSorted(&node16->keys_, &node16->children_, node16->num_children_++, byte, std::move(child));
+        return;
+      }
+      auto node48 = std::make_unique<RadixNode48>();
+      MoveHeader(node48.get(), node16);
+      for (int i = 0; i < 16; i++) {
+        node48->child_index_[node16->keys_[i]] = i + 1;
+        node48->children_[i] = std::move(node16->children_[i]);
+      }
+      *ref = std::move(node48);
+      break;
+    }
+    case RadixNodeType::Node48: {
+      auto *node48 = static_cast<RadixNode48 *>(node);
+      if (node48->num_children_ < 48) {
+        int slot = 0;
+        while (node48->children_[slot] != nullptr) {
+          slot++;
+        }
+        node48->child_index_[byte] = slot + 1;
+        node48->children_[slot] = std::move(child);
+        node48->num_children_++;
+        return;
+      }
+      auto node256 = std::make_unique<RadixNode256>();
+      MoveHeader(node256.get(), node48);
+      for (int b = 0; b < 256; b++) {
+        if (node48->child_index_[b] != 0) {
+          node256->children_[b] = std::move(node48->children_[node48->child_index_[b] - 1]);
+        }
+      }
+      *ref = std::move(node256);
+      break;
+    }
+    case RadixNodeType::Node256: {
+      auto *node256 = static_cast<RadixNode256 *>(node);
+      node256->children_[byte] = std::move(child);
+      node256->num_children_++;
+      return;
+    }
+    default:
+      return;
+  }
+  AddChild(ref, byte, std::move(child));
+}
+
+// Remove a child of the inner node in ref, which is replaced by a smaller one once it is mostly empty
+void RemoveChild(RadixChild *ref, uint8_t byte) {
+  auto *node = AsInner(ref->get());
+  switch (node->type_) {
+    case RadixNodeType::Node4: {
+      auto *node4 = static_cast<RadixNode4 *>(node);
+      RemoveSorted(&node4->keys_, &node4->children_, node4->num_children_--, byte);
+      return;
+    }
+    case RadixNodeType::Node16: {
+      auto *node16 = static_cast<RadixNode16 *>(node);
+      RemoveSorted(&node16->keys_, &node16->children_, node16->num_children_--, byte);
+      if (node16->num_children_ > 3) {
+        return;
+      }
+      auto node4 = std::make_unique<RadixNode4>();
+      MoveHeader(node4.get(), node16);
+      for (int i = 0; i < node16->num_children_; i++) {
+        node4->keys_[i] = node16->keys_[i];
+        node4->children_[i] = std::move(node16->children_[i]);
+      }
+      *ref = std::move(node4);
+      return;
+    }
+    case RadixNodeType::Node48: {
+      auto *node48 = static_cast<RadixNode48 *>(node);
+      node48->children_[node48->child_index_[byte] - 1].reset();
+      node48->child_index_[byte] = 0;
+      if (--node48->num_children_ > 12) {
+        return;
+      }
+      auto node16 = std::make_unique<RadixNode16>();
+      MoveHeader(node16.get(), node48);
+      int i = 0;
+      for (int b = 0; b < 256; b++) {
+        if (node48->child_index_[b] != 0) {
+          node16->keys_[i] = b;
+          node16->children_[i++] = std::move(node48->children_[node48->child_index_[b] - 1]);
+        }
+      }
+      *ref = std::move(node16);
+      return;
+    }
+    case RadixNodeType::Node256: {
+      auto *node256 = static_cast<RadixNode256 *>(node);
+      node256->children_[byte].reset();
+      if (--node256->num_children_ > 37) {
+        return;
+      }
+      auto node48 = std::make_unique<RadixNode48>();
+      MoveHeader(node48.get(), node256);
+      int slot = 0;
+      for (int b = 0; b < 256; b++) {
+        if (node256->children_[b] != nullptr) {
+          node48->child_index_[b] = slot + 1;
+          node48->children_[slot++] = std::move(node256->children_[b]);
+        }
+      }
+      *ref = std::move(node48);
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+// Put a leaf below the inner node in ref, whose prefix ends at depth of the key
+void PlaceLeaf(RadixChild *ref, RadixChild leaf, size_t depth) {
+  const auto &key = static_cast<RadixLeaf *>(leaf.get())->key_;
+  if (key.size() == depth) {
+    AsInner(ref->get())->leaf_.reset(static_cast<RadixLeaf *>(leaf.release()));
+    return;
+  }
+  AddChild(ref, KeyByte(key, depth), std::move(leaf));
+}
+
+// Replace the inner node in ref, whose prefix starts at depth, once it has a single entry left
+void Collapse(RadixChild *ref, size_t depth) {
+  auto *node = AsInner(ref->get());
+  if (node->num_children_ == 0) {
+    RadixChild leaf = std::move(node->leaf_);
+    *ref = std::move(leaf);
+    return;
+  }
+  if (node->num_children_ > 1 || node->leaf_ != nullptr) {
+    return;
+  }
+  RadixChild child = std::move(*FirstChild(node));
+  if (!child->IsLeaf()) {
+    // The child takes over the prefix of the node and the byte between them
+    auto *inner = AsInner(child.get());
+    inner->prefix_len_ += node->prefix_len_ + 1;
+    const auto &leaf_key = AnyLeaf(inner)->key_;
+    for (uint32_t i = 0; i < std::min(inner->prefix_len_, RadixInner::MAX_PREFIX_LEN); i++) {
+      inner->prefix_[i] = KeyByte(leaf_key, depth + i);
+    }
+  }
+  *ref = std::move(child);
+}
+
+/*
+ * Visit the leaves below node, whose prefix starts at depth of the keys, with
+ * keys in [*begin, *end). A bound is dropped (nullptr) once every key below
+ * is known to be within it, so most of a scan compares no keys at all.
+ */
+auto ScanNode(const RadixNode *node, size_t depth, const std::string *begin, const std::string *end, bool descending,
+              const AdaptiveRadixTree::Visitor &visitor) -> bool {
+  if (node->IsLeaf()) {
+    const auto *leaf = static_cast<const RadixLeaf *>(node);
+    if ((begin != nullptr && leaf->key_ < *begin) || (end != nullptr && leaf->key_ >= *end)) {
+      return true;
+    }
+    return visitor(leaf->key_, leaf->value_);
+  }
+
+  const auto *inner = static_cast<const RadixInner *>(node);
+  const RadixLeaf *any_leaf = inner->prefix_len_ > RadixInner::MAX_PREFIX_LEN ? AnyLeaf(inner) : nullptr;
+  for (uint32_t i = 0; i < inner->prefix_len_ && (begin != nullptr || end != nullptr); i++) {
+    auto byte = PrefixByte(inner, any_leaf, depth, i);
+    auto pos = depth + i;
+    // keys that go on past a bound they start with are greater than it
+    if (begin != nullptr) {
+      if (pos >= begin->size() || byte > KeyByte(*begin, pos)) {
+        begin = nullptr;
+      } else if (byte < KeyByte(*begin, pos)) {
+        return true;
+      }
+    }
+    if (end != nullptr) {
+      if (pos >= end->size() || byte > KeyByte(*end, pos)) {
+        return true;
+      }
+      if (byte < KeyByte(*end, pos)) {
+        end = nullptr;
+      }
+    }
+  }
+  depth += inner->prefix_len_;
+  if (begin != nullptr && depth >= begin->size()) {
+    begin = nullptr;
+  }
+  if (end != nullptr && depth >= end->size()) {
+    return true;
+  }
+
+  // the key that ends here is smaller than every key below
+  if (!descending && inner->leaf_ != nullptr && !ScanNode(inner->leaf_.get(), depth, begin, end, false, visitor)) {
+    return false;
+  }
+  auto completed = ForEachChild(inner, descending, [&](uint8_t byte, const RadixNode *child) {
+    const std::string *child_begin = begin;
+    const std::string *child_end = end;
+    if (begin != nullptr) {
+      if (byte < KeyByte(*begin, depth)) {
+        return true;
+      }
+      child_begin = byte == KeyByte(*begin, depth) ? begin : nullptr;
+    }
+    if (end != nullptr) {
+      if (byte > KeyByte(*end, depth)) {
+        return true;
+      }
+      child_end = byte == KeyByte(*end, depth) ? end : nullptr;
+    }
+    return ScanNode(child, depth + 1, child_begin, child_end, descending, visitor);
+  });
+  if (!completed) {
+    return false;
+  }
+  return !descending || inner->leaf_ == nullptr || ScanNode(inner->leaf_.get(), depth, begin, end, true, visitor);
+}
+
+}  // namespace
+
+AdaptiveRadixTree::AdaptiveRadixTree() = default;
+
+AdaptiveRadixTree::~AdaptiveRadixTree() = default;
+
+auto AdaptiveRadixTree::Insert(const std::string &key, const RID &value) -> bool {
+  std::unique_lock guard(this->latch_);
+  RadixChild *ref = &this->root_;
+  size_t depth = 0;
+  while (true) {
+    RadixNode *node = ref->get();
+    if (node == nullptr) {
+      *ref = std::make_unique<RadixLeaf>(key, value);
+      this->size_++;
+      return true;
+    }
+
+    if (node->IsLeaf()) {
+      const auto &other_key = static_cast<RadixLeaf *>(node)->key_;
+      if (other_key == key) {
+        return false;
+      }
+      // The two keys get a node where they part
+      auto inner = std::make_unique<RadixNode4>();
+      uint32_t common = 0;
+      while (depth + common < std::min(key.size(), other_key.size()) &&
+             key[depth + common] == other_key[depth + common]) {
+        if (common < RadixInner::MAX_PREFIX_LEN) {
+          inner->prefix_[common] = KeyByte(key, depth + common);
+        }
+        common++;
+      }
+      inner->prefix_len_ = common;
+      RadixChild other = std::move(*ref);
+      *ref = std::move(inner);
+      PlaceLeaf(ref, std::move(other), depth + common);
+      PlaceLeaf(ref, std::make_unique<RadixLeaf>(key, value), depth + common);
+      this->size_++;
+      return true;
+    }
+
+    auto *inner = AsInner(node);
+    if (inner->prefix_len_ > 0) {
+      auto mismatch = PrefixMismatch(inner, key, depth);
+      if (mismatch < inner->prefix_len_) {
+        // A new node takes the common part of the prefix, the old one keeps what follows the byte they part at
+        auto parent = std::make_unique<RadixNode4>();
+        parent->prefix_len_ = mismatch;
+        std::copy_n(inner->prefix_.begin(), std::min(mismatch, RadixInner::MAX_PREFIX_LEN), parent->prefix_.begin());
+        const RadixLeaf *any_leaf = AnyLeaf(inner);
+        auto byte = PrefixByte(inner, any_leaf, depth, mismatch);
+        std::array<uint8_t, RadixInner::MAX_PREFIX_LEN> rest{};
+        auto rest_len = inner->prefix_len_ - mismatch - 1;
+        for (uint32_t i = 0; i < std::min(rest_len, RadixInner::MAX_PREFIX_LEN); i++) {
+          rest[i] = PrefixByte(inner, any_leaf, depth, mismatch + 1 + i);
+        }
+        inner->prefix_ = rest;
+        inner->prefix_len_ = rest_len;
+        RadixChild old = std::move(*ref);
+        *ref = std::move(parent);
+        AddChild(ref, byte, std::move(old));
+        PlaceLeaf(ref, std::make_unique<RadixLeaf>(key, value), depth + mismatch);
+        this->size_++;
+        return true;
+      }
+      depth += inner->prefix_len_;
+    }
+
+    if (depth == key.size()) {
+      if (inner->leaf_ != nullptr) {
+        return false;
+      }
+      inner->leaf_ = std::make_unique<RadixLeaf>(key, value);
+      this->size_++;
+      return true;
+    }
+    RadixChild *child = FindChild(inner, KeyByte(key, depth));
+    if (child == nullptr) {
+      AddChild(ref, KeyByte(key, depth), std::make_unique<RadixLeaf>(key, value));
+      this->size_++;
+      return true;
+    }
+    ref = child;
+    depth++;
+  }
+}
+
+auto AdaptiveRadixTree::GetValue(const std::string &key, RID *value) const -> bool {
+  std::shared_lock guard(this->latch_);
+  const RadixNode *node = this->root_.get();
+  size_t depth = 0;
+  while (node != nullptr) {
+    const RadixLeaf *leaf = nullptr;
+    if (node->IsLeaf()) {
+      leaf = static_cast<const RadixLeaf *>(node);
+    } else {
+      const auto *inner = static_cast<const RadixInner *>(node);
+      if (!PrefixMatches(inner, key, depth)) {
+        return false;
+      }
+      depth += inner->prefix_len_;
+      if (depth < key.size()) {
+        const RadixChild *child = FindChild(inner, KeyByte(key, depth));
+        node = child == nullptr ? nullptr : child->get();
+        depth++;
+        continue;
+      }
+      leaf = inner->leaf_.get();
+    }
+    if (leaf == nullptr || leaf->key_ != key) {
+      return false;
+    }
+    *value = leaf->value_;
+    return true;
+  }
+  return false;
+}
+
+auto AdaptiveRadixTree::Remove(const std::string &key, const RID &value) -> bool {
+  std::unique_lock guard(this->latch_);
+  RadixChild *parent = nullptr;
+  size_t parent_depth = 0;
+  RadixChild *ref = &this->root_;
+  size_t depth = 0;
+  while (true) {
+    RadixNode *node = ref->get();
+    if (node == nullptr) {
+      return false;
+    }
+
+    if (node->IsLeaf()) {
+      auto *leaf = static_cast<RadixLeaf *>(node);
+      if (leaf->key_ != key || !(leaf->value_ == value)) {
+        return false;
+      }
+      if (parent == nullptr) {
+        ref->reset();
+      } else {
+        RemoveChild(parent, KeyByte(key, depth - 1));
+        Collapse(parent, parent_depth);
+      }
+      this->size_--;
+      return true;
+    }
+
+    auto *inner = AsInner(node);
+    if (!PrefixMatches(inner, key, depth)) {
+      return false;
+    }
+    auto node_depth = depth;
+    depth += inner->prefix_len_;
+    if (depth == key.size()) {
+      if (inner->leaf_ == nullptr || inner->leaf_->key_ != key || !(inner->leaf_->value_ == value)) {
+        return false;
+      }
+      inner->leaf_.reset();
+      Collapse(ref, node_depth);
+      this->size_--;
+      return true;
+    }
+    RadixChild *child = FindChild(inner, KeyByte(key, depth));
+    if (child == nullptr) {
+      return false;
+    }
+    parent = ref;
+    parent_depth = node_depth;
+    ref = child;
+    depth++;
+  }
+}
+
+void AdaptiveRadixTree::Scan(const std::string &begin, const std::optional<std::string> &end, bool descending,
+                             const Visitor &visitor) const {
+  std::shared_lock guard(this->latch_);
+  if (this->root_ != nullptr) {
+    ScanNode(this->root_.get(), 0, begin.empty() ? nullptr : &begin, end.has_value() ? &*end : nullptr, descending,
+             visitor);
+  }
+}
+
+auto AdaptiveRadixTree::GetSize() const -> size_t {
+  std::shared_lock guard(this->latch_);
+  return this->size_;
+}
+
+auto AdaptiveRadixTree::PrefixEnd(std::string prefix) -> std::optional<std::string> {
+  while (!prefix.empty() && static_cast<uint8_t>(prefix.back()) == 0xFF) {
+    prefix.pop_back();
+  }
+  if (prefix.empty()) {
+    return std::nullopt;
+  }
+  prefix.back() = static_cast<char>(static_cast<uint8_t>(prefix.back()) + 1);
+  return prefix;
+}
+
+}  // namespace bustub
@@ -0,0 +1,161 @@
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "storage/index/art_index.h"
+#include "storage/index/key_encoding.h"
+
+namespace bustub {
+
+namespace {
+
+// Entries a cursor takes from the tree at a time
+constexpr size_t ART_SCAN_BATCH_SIZE = 64;
+
+// Append the encoding of value to key
+void AppendEncoding(const Value &value, std::string *key) {
+  auto offset = key->size();
+  auto end = KeyEncoding::Encode(value, nullptr, 0, offset);
+  key->resize(end);
+  KeyEncoding::Encode(value, key->data(), end, offset);
+}
+
+/*
+ * Scans [begin, end) of the tree. The tree is only latched while a batch of
+ * entries is taken from it, the next batch starts right after the last entry
+ * of the one before, so writes to the index (of the same statement too) go on
+ * between batches.
+ */
+class ArtCursor : public IndexCursor {
+ public:
+  ArtCursor(const AdaptiveRadixTree *tree, std::string begin, std::optional<std::string> end, bool descending)
+      : tree_(tree), begin_(std::move(begin)), end_(std::move(end)), descending_(descending) {}
+
+  auto Next(RID *rid) -> bool override {
+    if (pos_ == batch_.size()) {
+      if (is_done_) {
+        return false;
+      }
+      Fill();
+      if (batch_.empty()) {
+        return false;
+      }
+    }
+    *rid = batch_[pos_++];
+    return true;
+  }
+
+ private:
+  void Fill() {
+    batch_.clear();
+    pos_ = 0;
+    std::string last_key;
+    tree_->Scan(begin_, end_, descending_, [this, &last_key](const std::string &key, const RID &value) {
+      batch_.push_back(value);
+      if (batch_.size() < ART_SCAN_BATCH_SIZE) {
+        return true;
+      }
+      last_key = key;
+      return false;
+    });
+    if (batch_.size() < ART_SCAN_BATCH_SIZE) {
+      is_done_ = true;
+    } else if (descending_) {
+      end_ = std::move(last_key);
+    } else {
+      // the smallest key after the last one
+      begin_ = last_key + '\0';
+    }
+  }
+
+  const AdaptiveRadixTree *tree_;
+  std::string begin_;
+  std::optional<std::string> end_;
+  bool descending_;
+  std::vector<RID> batch_;
+  size_t pos_{0};
+  bool is_done_{false};
+};
+
+}  // namespace
+
+ArtIndex::ArtIndex(std::unique_ptr<IndexMetadata> &&metadata) : Index(std::move(metadata)) {}
+
+auto ArtIndex::EncodeKey(const Tuple &key) const -> std::string {
+  std::string encoded;
+  for (uint32_t i = 0; i < GetKeySchema()->GetColumnCount(); i++) {
+    AppendEncoding(key.GetValue(GetKeySchema(), i), &encoded);
+  }
+  return encoded;
+}
+
+auto ArtIndex::EntryKey(const Tuple &key, RID rid) const -> std::string {
+  auto encoded = EncodeKey(key);
+  if (!GetMetadata()->IsUnique()) {
+    char rid_bytes[sizeof(int64_t)];
+    KeyEncoding::WriteInteger<int64_t>(rid.Get(), rid_bytes);
+    encoded.append(rid_bytes, sizeof(rid_bytes));
+  }
+  return encoded;
+}
+
+void ArtIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  container_.Insert(EntryKey(key, rid), rid);
+}
+
+void ArtIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  container_.Remove(EntryKey(key, rid), rid);
+}
+
+void ArtIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  auto encoded = EncodeKey(key);
+  if (GetMetadata()->IsUnique()) {
+    RID rid;
+    if (container_.GetValue(encoded, &rid)) {
+      result->push_back(rid);
+    }
+    return;
+  }
+  // the entries of the key are all the keys that start with it
+  auto end = AdaptiveRadixTree::PrefixEnd(encoded);
+  container_.Scan(encoded, end, false, [result](const std::string & /* key */, const RID &rid) {
+    result->push_back(rid);
+    return true;
+  });
+}
+
+auto ArtIndex::Scan(bool descending) -> std::unique_ptr<IndexCursor> {
+  return std::make_unique<ArtCursor>(&container_, "", std::nullopt, descending);
+}
+
+auto ArtIndex::ScanRange(const std::optional<Tuple> &begin, const std::optional<Tuple> &end)
+    -> std::unique_ptr<IndexCursor> {
+  // the entries of a key that is not unique come after the key itself, so they are in the range of their key
+  std::optional<std::string> end_key;
+  if (end.has_value()) {
+    end_key = EncodeKey(*end);
+  }
+  return std::make_unique<ArtCursor>(&container_, begin.has_value() ? EncodeKey(*begin) : "", std::move(end_key),
+                                     false);
+}
+
+auto ArtIndex::ScanPrefix(const std::vector<Value> &prefix, bool partial_last) -> std::unique_ptr<IndexCursor> {
+  BUSTUB_ASSERT(prefix.size() <= GetKeySchema()->GetColumnCount(), "prefix longer than the key");
+  std::string encoded;
+  for (size_t i = 0; i < prefix.size(); i++) {
+    auto type = GetKeySchema()->GetColumn(i).GetType();
+    AppendEncoding(prefix[i].GetTypeId() == type ? prefix[i] : prefix[i].CastAs(type), &encoded);
+  }
+  if (partial_last && !prefix.empty() && GetKeySchema()->GetColumn(prefix.size() - 1).GetType() == TypeId::VARCHAR &&
+      !prefix.back().IsNull()) {
+    // drop the terminator, so longer strings match as well
+    encoded.resize(encoded.size() - 2);
+  }
+  auto end = AdaptiveRadixTree::PrefixEnd(encoded);
+  return std::make_unique<ArtCursor>(&container_, std::move(encoded), std::move(end), false);
+}
+
+}  // namespace bustub
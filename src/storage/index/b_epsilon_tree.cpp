@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/index/b_epsilon_tree.h"
+#include "storage/page/header_page.h"
+
+namespace bustub {
+INDEX_TEMPLATE_ARGUMENTS
+BEPSILONTREE_TYPE::BEpsilonTree(std::string name, BufferPoolManager *buffer_pool_manager,
+                                const KeyComparator &comparator, int leaf_max_size, int fanout)
+    : index_name_(std::move(name)),
+      root_page_id_(INVALID_PAGE_ID),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      // leaves are split by count, so they must fit max size entries with the longest keys
+      leaf_max_size_(std::min({leaf_max_size, static_cast<int>(LEAF_PAGE_SIZE),
+                               LEAF_PAGE_USABLE_SIZE / LeafPage::LargestEntrySize()})),
+      // large keys leave room for fewer pivots
+      fanout_(std::min(fanout, InternalPage::MaxFanout())) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key. A message buffered
+ * on the way down is newer than anything below it, so the first one found
+ * decides.
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction)
+    -> bool {
+  latch_.RLock();
+  bool found = false;
+  page_id_t page_id = root_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    auto *tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    page_id_t next_page_id = INVALID_PAGE_ID;
+    if (tree_page->IsLeafPage()) {
+      ValueType value;
+      found = reinterpret_cast<LeafPage *>(tree_page)->Bisect(key, &value, comparator_);
+      if (found) {
+        result->push_back(value);
+      }
+    } else {
+      auto *internal_page = reinterpret_cast<InternalPage *>(tree_page);
+      const auto *message = internal_page->FindMessage(key, comparator_);
+      if (message == nullptr) {
+        next_page_id = internal_page->ValueAt(internal_page->LookUpIndex(key, comparator_));
+      } else if (!message->is_delete_) {
+        result->push_back(message->value_);
+        found = true;
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  latch_.RUnlock();
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION AND DELETION
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void BEPSILONTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  latch_.WLock();
+  Apply(Message{key, value, false});
+  latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BEPSILONTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  latch_.WLock();
+  if (!IsEmpty()) {
+    Apply(Message{key, ValueType(), true});
+  }
+  latch_.WUnlock();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BEPSILONTREE_TYPE::Apply(const Message &message) {
+  page_id_t old_root_page_id = root_page_id_;
+  if (IsEmpty()) {
+    Page *root_page = buffer_pool_manager_->NewPage(&root_page_id_);
+    reinterpret_cast<LeafPage *>(root_page->GetData())->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_);
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  }
+
+  // the root is split like any other page, the tree grows until a root holds all of the pieces
+  auto siblings = PushDown(root_page_id_, {message});
+  while (!siblings.empty()) {
+    std::vector<Pivot> pivots{{KeyType(), root_page_id_}};
+    pivots.insert(pivots.end(), siblings.begin(), siblings.end());
+    Page *root_page = buffer_pool_manager_->NewPage(&root_page_id_);
+    auto *root_internal_page = reinterpret_cast<InternalPage *>(root_page->GetData());
+    root_internal_page->Init(root_page_id_, INVALID_PAGE_ID, fanout_);
+    siblings = StoreInternal(root_internal_page, pivots, {});
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  }
+
+  // a delete may empty a root leaf, an empty internal page can not happen since pages never merge
+  if (message.is_delete_) {
+    Page *root_page = buffer_pool_manager_->FetchPage(root_page_id_);
+    auto *root_tree_page = reinterpret_cast<BPlusTreePage *>(root_page->GetData());
+    bool is_empty = root_tree_page->IsLeafPage() && root_tree_page->GetSize() == 0;
+    buffer_pool_manager_->UnpinPage(root_page_id_, false);
+    if (is_empty) {
+      buffer_pool_manager_->DeletePage(root_page_id_);
+      root_page_id_ = INVALID_PAGE_ID;
+    }
+  }
+  if (root_page_id_ != old_root_page_id) {
+    UpdateRootPageId();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::PushDown(page_id_t page_id, std::vector<Message> &&messages) -> std::vector<Pivot> {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  auto *tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  auto siblings = tree_page->IsLeafPage()
+                      ? PushDownLeaf(reinterpret_cast<LeafPage *>(tree_page), std::move(messages))
+                      : PushDownInternal(reinterpret_cast<InternalPage *>(tree_page), std::move(messages));
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  return siblings;
+}
+
+/*
+ * Merge the messages into the entries of the leaf and split the result into
+ * as many evenly filled leaves as needed
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::PushDownLeaf(LeafPage *leaf_page, std::vector<Message> &&messages) -> std::vector<Pivot> {
+  int size = leaf_page->GetSize();
+  std::vector<MappingType> entries;
+  entries.reserve(size + messages.size());
+  int index = 0;
+  for (const auto &message : messages) {
+    while (index < size && comparator_(leaf_page->KeyAt(index), message.key_) < 0) {
+      entries.push_back(leaf_page->GetPairAt(index++));
+    }
+    if (index < size && comparator_(leaf_page->KeyAt(index), message.key_) == 0) {
+      index++;
+    }
+    if (!message.is_delete_) {
+      entries.emplace_back(message.key_, message.value_);
+    }
+  }
+  while (index < size) {
+    entries.push_back(leaf_page->GetPairAt(index++));
+  }
+
+  auto num_entries = static_cast<int>(entries.size());
+  int parts = std::max(1, (num_entries + leaf_max_size_ - 1) / leaf_max_size_);
+  std::vector<Pivot> siblings;
+  LeafPage *previous_page = nullptr;
+  for (int part = 0; part < parts; part++) {
+    int first = part * num_entries / parts;
+    int last = (part + 1) * num_entries / parts;
+    auto *part_page = leaf_page;
+    if (part > 0) {
+      page_id_t new_page_id;
+      part_page = reinterpret_cast<LeafPage *>(buffer_pool_manager_->NewPage(&new_page_id)->GetData());
+      part_page->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);
+      part_page->SetNextPageId(previous_page->GetNextPageId());
+      part_page->SetPrevPageId(previous_page->GetPageId());
+      previous_page->SetNextPageId(new_page_id);
+      siblings.emplace_back(entries[first].first, new_page_id);
+    }
+    part_page->Assign(entries.data() + first, last - first);
+    if (previous_page != nullptr && previous_page != leaf_page) {
+      buffer_pool_manager_->UnpinPage(previous_page->GetPageId(), true);
+    }
+    previous_page = part_page;
+  }
+  if (previous_page != leaf_page) {
+    buffer_pool_manager_->UnpinPage(previous_page->GetPageId(), true);
+  }
+  return siblings;
+}
+
+/*
+ * Add the messages to the buffer. While it overflows, the messages for the
+ * child that gets the most of them are pushed down in one batch.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::PushDownInternal(InternalPage *internal_page, std::vector<Message> &&messages)
+    -> std::vector<Pivot> {
+  std::vector<Pivot> pivots;
+  std::vector<Message> buffer;
+  internal_page->LoadPivots(&pivots);
+  internal_page->LoadBuffer(&buffer);
+  buffer = MergeMessages(std::move(buffer), std::move(messages));
+
+  auto less = [this](const Message &message, const KeyType &key) { return comparator_(message.key_, key) < 0; };
+  auto capacity = static_cast<size_t>(internal_page->GetBufferCapacity());
+  while (buffer.size() > capacity) {
+    // the messages for a child are the ones between its pivot and the next
+    size_t child = 0;
+    auto batch_begin = buffer.begin();
+    auto batch_end = buffer.begin();
+    auto begin = buffer.begin();
+    for (size_t i = 0; i < pivots.size(); i++) {
+      auto end = i + 1 < pivots.size() ? std::lower_bound(begin, buffer.end(), pivots[i + 1].first, less)
+                                       : buffer.end();
+      if (end - begin > batch_end - batch_begin) {
+        child = i;
+        batch_begin = begin;
+        batch_end = end;
+      }
+      begin = end;
+    }
+    std::vector<Message> batch(batch_begin, batch_end);
+    buffer.erase(batch_begin, batch_end);
+    auto new_pivots = PushDown(pivots[child].second, std::move(batch));
+    pivots.insert(pivots.begin() + child + 1, new_pivots.begin(), new_pivots.end());
+  }
+  return StoreInternal(internal_page, pivots, buffer);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::StoreInternal(InternalPage *internal_page, const std::vector<Pivot> &pivots,
+                                      const std::vector<Message> &messages) -> std::vector<Pivot> {
+  auto less = [this](const Message &message, const KeyType &key) { return comparator_(message.key_, key) < 0; };
+  auto num_pivots = static_cast<int>(pivots.size());
+  int parts = (num_pivots + fanout_ - 1) / fanout_;
+  std::vector<Pivot> siblings;
+  auto begin = messages.begin();
+  for (int part = 0; part < parts; part++) {
+    int first = part * num_pivots / parts;
+    int last = (part + 1) * num_pivots / parts;
+    auto end = last < num_pivots ? std::lower_bound(begin, messages.end(), pivots[last].first, less) : messages.end();
+    auto *part_page = internal_page;
+    if (part > 0) {
+      page_id_t new_page_id;
+      part_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->NewPage(&new_page_id)->GetData());
+      part_page->Init(new_page_id, INVALID_PAGE_ID, fanout_);
+      siblings.emplace_back(pivots[first].first, new_page_id);
+    }
+    part_page->StorePivots(std::vector<Pivot>(pivots.begin() + first, pivots.begin() + last));
+    part_page->StoreBuffer(std::vector<Message>(begin, end));
+    if (part > 0) {
+      buffer_pool_manager_->UnpinPage(part_page->GetPageId(), true);
+    }
+    begin = end;
+  }
+  return siblings;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::MergeMessages(std::vector<Message> &&older, std::vector<Message> &&newer) const
+    -> std::vector<Message> {
+  if (older.empty()) {
+    return std::move(newer);
+  }
+  std::vector<Message> merged;
+  merged.reserve(older.size() + newer.size());
+  auto old_message = older.begin();
+  for (const auto &message : newer) {
+    while (old_message != older.end() && comparator_(old_message->key_, message.key_) < 0) {
+      merged.push_back(*old_message++);
+    }
+    if (old_message != older.end() && comparator_(old_message->key_, message.key_) == 0) {
+      old_message++;
+    }
+    merged.push_back(message);
+  }
+  merged.insert(merged.end(), old_message, older.end());
+  return merged;
+}
+
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BEPSILONTREE_TYPE::GetRootPageId() -> page_id_t { return root_page_id_; }
+
+/*
+ * Keep the root page id in the header page, the record is created the first
+ * time the tree gets a root
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BEPSILONTREE_TYPE::UpdateRootPageId() {
+  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  if (!header_page->UpdateRecord(index_name_, root_page_id_)) {
+    header_page->InsertRecord(index_name_, root_page_id_);
+  }
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+template class BEpsilonTree<GenericKey<4>, RID, GenericComparator<4>>;
+template class BEpsilonTree<GenericKey<8>, RID, GenericComparator<8>>;
+template class BEpsilonTree<GenericKey<16>, RID, GenericComparator<16>>;
+template class BEpsilonTree<GenericKey<32>, RID, GenericComparator<32>>;
+template class BEpsilonTree<GenericKey<64>, RID, GenericComparator<64>>;
+}  // namespace bustub
@@ -1,6 +1,9 @@
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include "common/config.h"
 #include "common/exception.h"
@@ -14,13 +17,21 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, bool is_unique, double merge_fill)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      // an internal page holds one extra entry right before it is split
+      internal_max_size_(std::min(internal_max_size, static_cast<int>(INTERNAL_PAGE_SIZE) - 1)),
+      is_unique_(is_unique),
+      merge_fill_(merge_fill),
+      max_pinned_pages_(
+          std::min(static_cast<size_t>(BPLUS_TREE_PINNED_PAGES), buffer_pool_manager->GetPoolSize() / 8)) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() { delete this->pinned_pages_.load(); }
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -28,90 +39,555 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manag
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsUnique() const -> bool { return this->is_unique_; }
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, page_id_t *page_id) -> bool {
-  Page *root_page_with_page_type = this->buffer_pool_manager_->FetchPage(this->GetRootPageId());
-  auto *root_page = reinterpret_cast<BPlusTreePage *>(root_page_with_page_type->GetData());
-  if (root_page->IsLeafPage()) {
-    *page_id = root_page->GetPageId();
-    this->buffer_pool_manager_->UnpinPage(this->GetRootPageId(), false);
-    return true;
+  Page *target_page_with_page_type = this->FindLeafPageRead(key);
+  if (target_page_with_page_type == nullptr) {
+    *page_id = INVALID_PAGE_ID;
+    return false;
   }
-  auto *root_page_internal = reinterpret_cast<InternalPage *>(root_page);
-  auto index = root_page_internal->BisectPosition(key, this->comparator_);
-  page_id_t target_page_id;
-  if (index == root_page_internal->GetSize() - 1) {
-    target_page_id = root_page_internal->ValueAt(index);
-  } else {
-    auto key_at_index_plus_one = root_page_internal->KeyAt(index + 1);
-    if (this->comparator_(key_at_index_plus_one, key) == 0) {
-      target_page_id = root_page_internal->ValueAt(index + 1);
+  *page_id = target_page_with_page_type->GetPageId();
+  target_page_with_page_type->RUnlatch();
+  this->buffer_pool_manager_->UnpinPage(*page_id, false);
+  return true;
+}
+
+/*****************************************************************************
+ * LATCH CRABBING
+ *****************************************************************************/
+/*
+ * Walk from the root to a leaf holding at most two read latches at a time.
+ * The root latch is only held until the root page itself is latched.
+ * @return : the leaf page, read latched and pinned, nullptr if tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key, bool left_most, bool right_most, bool before_key)
+    -> Page * {
+  this->root_latch_.RLock();
+  if (this->root_page_id_ == INVALID_PAGE_ID) {
+    this->root_latch_.RUnlock();
+    return nullptr;
+  }
+  const auto *pinned_pages = this->BeginPinnedDescent();
+  Page *target_page_with_page_type = this->FetchTreePage(pinned_pages, this->root_page_id_);
+  target_page_with_page_type->RLatch();
+  this->root_latch_.RUnlock();
+  auto *target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
+  while (!target_page->IsLeafPage()) {
+    auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
+    page_id_t child_page_id;
+    if (left_most) {
+      child_page_id = target_page_internal->ValueAt(0);
+    } else if (right_most) {
+      child_page_id = target_page_internal->ValueAt(target_page_internal->GetSize() - 1);
+    } else if (before_key) {
+      child_page_id = target_page_internal->LookUpBefore(key, this->comparator_);
     } else {
-      target_page_id = root_page_internal->ValueAt(index);
+      child_page_id = target_page_internal->LookUp(key, this->comparator_);
     }
+    Page *child_page_with_page_type = this->FetchTreePage(pinned_pages, child_page_id);
+    child_page_with_page_type->RLatch();
+    target_page_with_page_type->RUnlatch();
+    this->UnpinTreePage(pinned_pages, target_page->GetPageId());
+    target_page_with_page_type = child_page_with_page_type;
+    target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
   }
-  // Unpin root page
-  this->buffer_pool_manager_->UnpinPage(this->GetRootPageId(), false);
-  Page *target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
+  // leaves are never pinned, the caller unpins the leaf as usual
+  this->EndPinnedDescent();
+  return target_page_with_page_type;
+}
+
+/*
+ * Optimistic descent for writers: internal pages are read latched exactly like
+ * a search, only the leaf is write latched. Good enough whenever the leaf does
+ * not need to split or merge, which is the common case.
+ * @return : the leaf page, write latched and pinned, nullptr if tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key) -> Page * {
+  this->root_latch_.RLock();
+  if (this->root_page_id_ == INVALID_PAGE_ID) {
+    this->root_latch_.RUnlock();
+    return nullptr;
+  }
+  const auto *pinned_pages = this->BeginPinnedDescent();
+  Page *target_page_with_page_type = this->FetchTreePage(pinned_pages, this->root_page_id_);
   auto *target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
-  while (!target_page->IsLeafPage()) {
+  if (target_page->IsLeafPage()) {
+    this->WLatchPage(target_page_with_page_type);
+    this->root_latch_.RUnlock();
+    this->EndPinnedDescent();
+    return target_page_with_page_type;
+  }
+  target_page_with_page_type->RLatch();
+  this->root_latch_.RUnlock();
+  while (true) {
     auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
-    index = target_page_internal->BisectPosition(key, this->comparator_);
-    page_id_t new_target_page_id;
-    if (index == target_page_internal->GetSize() - 1) {
-      new_target_page_id = target_page_internal->ValueAt(index);
+    page_id_t child_page_id = target_page_internal->LookUp(key, this->comparator_);
+    Page *child_page_with_page_type = this->FetchTreePage(pinned_pages, child_page_id);
+    auto *child_page = reinterpret_cast<BPlusTreePage *>(child_page_with_page_type->GetData());
+    // the child can not be freed while its parent is latched, so its type is stable
+    bool is_leaf = child_page->IsLeafPage();
+    if (is_leaf) {
+      this->WLatchPage(child_page_with_page_type);
     } else {
-      auto key_at_index_plus_one = target_page_internal->KeyAt(index + 1);
-      if (this->comparator_(key_at_index_plus_one, key) == 0) {
-        new_target_page_id = target_page_internal->ValueAt(index + 1);
-      } else {
-        new_target_page_id = target_page_internal->ValueAt(index);
-      }
+      child_page_with_page_type->RLatch();
     }
-    this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-    target_page_id = new_target_page_id;
-    target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
+    target_page_with_page_type->RUnlatch();
+    this->UnpinTreePage(pinned_pages, target_page->GetPageId());
+    target_page_with_page_type = child_page_with_page_type;
+    target_page = child_page;
+    if (is_leaf) {
+      this->EndPinnedDescent();
+      return target_page_with_page_type;
+    }
+  }
+}
+
+/*
+ * Pessimistic descent for writers. Caller must hold root_latch_ in write mode
+ * and the tree must not be empty. Every page on the path is write latched,
+ * ancestors (and the root latch) are released as soon as a safe node is met.
+ * On return latched_pages holds the still latched path, leaf at the back.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FindLeafPagePessimistic(const KeyType &key, Operation op, std::deque<Page *> *latched_pages,
+                                             bool *root_locked) {
+  Page *target_page_with_page_type = this->buffer_pool_manager_->FetchPage(this->root_page_id_);
+  this->WLatchPage(target_page_with_page_type);
+  auto *target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
+  if (this->IsSafe(target_page, op)) {
+    this->ReleaseLatchedPages(latched_pages, root_locked, false);
+  }
+  latched_pages->push_back(target_page_with_page_type);
+  while (!target_page->IsLeafPage()) {
+    auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
+    page_id_t child_page_id = target_page_internal->LookUp(key, this->comparator_);
+    target_page_with_page_type = this->buffer_pool_manager_->FetchPage(child_page_id);
+    this->WLatchPage(target_page_with_page_type);
     target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
+    if (this->IsSafe(target_page, op)) {
+      this->ReleaseLatchedPages(latched_pages, root_locked, false);
+    }
+    latched_pages->push_back(target_page_with_page_type);
   }
-  this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-  *page_id = target_page->GetPageId();
-  return true;
 }
+
+/*
+ * A node is safe if the operation can not propagate to its parent:
+ * insert will not split it and delete will not make it underflow.
+ * Compaction always changes the parent of the leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) const -> bool {
+  // pages hold keys of different lengths, so only the page knows how full it is
+  if (node->IsLeafPage()) {
+    auto *node_leaf = reinterpret_cast<LeafPage *>(node);
+    if (op == Operation::COMPACT) {
+      return false;
+    }
+    return op == Operation::INSERT ? !node_leaf->IsFull() : node_leaf->CanLendEntry(this->merge_fill_);
+  }
+  auto *node_internal = reinterpret_cast<InternalPage *>(node);
+  return op == Operation::INSERT ? !node_internal->IsFull() : node_internal->CanLendEntry();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseLatchedPages(std::deque<Page *> *latched_pages, bool *root_locked, bool is_dirty) {
+  if (*root_locked) {
+    this->root_latch_.WUnlock();
+    *root_locked = false;
+  }
+  for (auto *page : *latched_pages) {
+    this->WUnlatchPage(page, is_dirty);
+    this->buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  latched_pages->clear();
+}
+
+/*****************************************************************************
+ * PINNED PAGES
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::PinnedPages::Find(page_id_t page_id) const -> Page * {
+  auto it = std::lower_bound(pages_.begin(), pages_.end(), page_id,
+                             [](const std::pair<page_id_t, Page *> &page, page_id_t id) { return page.first < id; });
+  return it != pages_.end() && it->first == page_id ? it->second : nullptr;
+}
+
+/*
+ * Pages of a snapshot stay pinned until every descent that may have taken it
+ * has ended. A page id in a snapshot is never given to another page while the
+ * tree holds the pin, so its frame always holds that page, although the page
+ * may no longer be part of the tree. Descents validate what they read exactly
+ * as with fetched pages.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BeginPinnedDescent() -> const PinnedPages * {
+  this->pinned_readers_++;
+  return this->pinned_pages_.load();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::EndPinnedDescent() {
+  // the last descent out gives back pages of replaced snapshots, unless a refresh is about to do it
+  if (this->pinned_readers_.fetch_sub(1) == 1 && this->has_retired_pinned_pages_) {
+    std::unique_lock<std::mutex> lock(this->pinned_latch_, std::try_to_lock);
+    if (lock.owns_lock()) {
+      this->ReclaimPinnedPages();
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchTreePage(const PinnedPages *pinned_pages, page_id_t page_id) -> Page * {
+  Page *page = pinned_pages == nullptr ? nullptr : pinned_pages->Find(page_id);
+  return page != nullptr ? page : this->buffer_pool_manager_->FetchPage(page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UnpinTreePage(const PinnedPages *pinned_pages, page_id_t page_id) {
+  if (pinned_pages == nullptr || pinned_pages->Find(page_id) == nullptr) {
+    this->buffer_pool_manager_->UnpinPage(page_id, false);
+  }
+}
+
+/*
+ * Take whole levels of internal pages from the root down while they fit in
+ * max_pinned_pages_. Pages pinned by an older snapshot are not fetched again.
+ * Each page is read latched while its children are read, the snapshot does
+ * not have to be consistent: a change after the epoch was read moves the
+ * epoch on and the next refresh fixes it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RefreshPinnedPages() {
+  if (this->pinned_pages_epoch_ == this->pinned_epoch_) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(this->pinned_latch_);
+  uint64_t epoch = this->pinned_epoch_;
+  if (this->pinned_pages_epoch_ == epoch) {
+    return;
+  }
+  auto pinned_pages = std::make_unique<PinnedPages>();
+  pinned_pages->epoch_ = epoch;
+  auto fetch = [this](page_id_t page_id) {
+    auto it = this->pinned_frames_.find(page_id);
+    if (it != this->pinned_frames_.end()) {
+      return it->second;
+    }
+    Page *page = this->buffer_pool_manager_->FetchPage(page_id);
+    if (page != nullptr) {
+      this->pinned_frames_.emplace(page_id, page);
+    }
+    return page;
+  };
+
+  std::vector<page_id_t> level;
+  page_id_t root_page_id = this->root_page_id_;
+  if (root_page_id != INVALID_PAGE_ID) {
+    level.push_back(root_page_id);
+  }
+  while (!level.empty() && pinned_pages->pages_.size() + level.size() <= this->max_pinned_pages_) {
+    // a level is only taken if it consists of internal pages, they all are once the first one is
+    Page *first_page = fetch(level[0]);
+    if (first_page == nullptr || reinterpret_cast<BPlusTreePage *>(first_page->GetData())->IsLeafPage()) {
+      break;
+    }
+    std::vector<page_id_t> next_level;
+    for (auto page_id : level) {
+      Page *page = fetch(page_id);
+      if (page == nullptr) {
+        next_level.clear();
+        break;
+      }
+      pinned_pages->pages_.emplace_back(page_id, page);
+      page->RLatch();
+      auto *internal_page = reinterpret_cast<InternalPage *>(page->GetData());
+      if (!internal_page->IsLeafPage()) {
+        for (int i = 0; i < internal_page->GetSize(); i++) {
+          next_level.push_back(internal_page->ValueAt(i));
+        }
+      }
+      page->RUnlatch();
+    }
+    level = std::move(next_level);
+  }
+  std::sort(pinned_pages->pages_.begin(), pinned_pages->pages_.end());
+
+  PinnedPages *old_pinned_pages = this->pinned_pages_.exchange(pinned_pages.release());
+  this->pinned_pages_epoch_ = epoch;
+  if (old_pinned_pages != nullptr) {
+    this->retired_pinned_pages_.emplace_back(old_pinned_pages);
+  }
+  // pages fetched to look at but not taken are given back too
+  this->has_retired_pinned_pages_ = true;
+  this->ReclaimPinnedPages();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReclaimPinnedPages() {
+  // a descent that begins after this check takes the current snapshot
+  if (this->pinned_readers_ != 0) {
+    return;
+  }
+  const PinnedPages *pinned_pages = this->pinned_pages_;
+  for (auto it = this->pinned_frames_.begin(); it != this->pinned_frames_.end();) {
+    if (pinned_pages == nullptr || pinned_pages->Find(it->first) == nullptr) {
+      this->buffer_pool_manager_->UnpinPage(it->first, false);
+      it = this->pinned_frames_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  this->retired_pinned_pages_.clear();
+  this->has_retired_pinned_pages_ = false;
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the values associated with input key, in order
  * This method is used for point query
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  page_id_t target_page_id = INVALID_PAGE_ID;
-  if (this->IsEmpty()) {
-    return false;
+  // Latch free lookup first, fall back to read crabbing if writers keep getting in the way
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+    const auto *pinned_pages = this->BeginPinnedDescent();
+    auto lookup_result = this->GetValueOptimistic(key, result, pinned_pages);
+    this->EndPinnedDescent();
+    if (lookup_result == LookupResult::LATCH) {
+      break;
+    }
+    if (lookup_result != LookupResult::RETRY) {
+      return lookup_result == LookupResult::FOUND;
+    }
   }
-  BUSTUB_ASSERT((this->FindLeaf(key, &target_page_id)), "No");
-  if (target_page_id == INVALID_PAGE_ID) {
+  return this->ScanKey(
+      key,
+      [result](const ValueType &value) {
+        result->push_back(value);
+        return true;
+      },
+      transaction);
+}
+
+/*
+ * Stream the values of input key to consumer while the leaf is read latched
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ScanKey(const KeyType &key, const std::function<bool(const ValueType &)> &consumer,
+                             Transaction *transaction) -> bool {
+  Page *target_page_with_page_type = this->FindLeafPageRead(key);
+  if (target_page_with_page_type == nullptr) {
     return false;
   }
-  Page *target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-  auto *target_page_general = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
-  auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page_general);
+  auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page_with_page_type->GetData());
+  auto index = target_page_leaf->BisectPosition(key, this->comparator_) + 1;
+  bool found = index < target_page_leaf->GetSize() && this->comparator_(target_page_leaf->KeyAt(index), key) == 0;
+  if (found) {
+    this->ScanValues(target_page_leaf, index, consumer);
+  }
+  target_page_with_page_type->RUnlatch();
+  this->buffer_pool_manager_->UnpinPage(target_page_leaf->GetPageId(), false);
+  return found;
+}
+
+/*
+ * Batched lookup. The read latched path of the previous key is kept, and only
+ * the part below the deepest page whose key range still holds the next key is
+ * replaced, so that sorted keys share their upper levels and often their leaf
+ * as well. Latches are only taken top-down, like in FindLeafPageRead. While in
+ * the parent of a leaf, the leaf of the next key is pinned ahead of time, and
+ * its header and the middle of its entries, where the search starts, are
+ * prefetched into the cache.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                               Transaction *transaction) {
+  // keep the capacity of the result vectors, callers looking up batch after batch reuse them
+  results->resize(keys.size());
+  for (auto &result : *results) {
+    result.clear();
+  }
+  this->root_latch_.RLock();
+  if (this->root_page_id_ == INVALID_PAGE_ID || keys.empty()) {
+    this->root_latch_.RUnlock();
+    return;
+  }
+  const auto *pinned_pages = this->BeginPinnedDescent();
+  // path[i + 1] is the child at child_indexes[i] of path[i]
+  std::vector<Page *> path{this->FetchTreePage(pinned_pages, this->root_page_id_)};
+  std::vector<int> child_indexes;
+  path.back()->RLatch();
+  this->root_latch_.RUnlock();
+  Page *prefetched_page = nullptr;
+  for (size_t i = 0; i < keys.size(); i++) {
+    const auto &key = keys[i];
+    size_t depth = 1;
+    while (depth < path.size()) {
+      auto *parent_page = reinterpret_cast<InternalPage *>(path[depth - 1]->GetData());
+      auto index = child_indexes[depth - 1];
+      if ((index > 0 && this->comparator_(key, parent_page->KeyAt(index)) < 0) ||
+          (index + 1 < parent_page->GetSize() && this->comparator_(key, parent_page->KeyAt(index + 1)) >= 0)) {
+        break;
+      }
+      depth++;
+    }
+    while (path.size() > depth) {
+      path.back()->RUnlatch();
+      this->UnpinTreePage(pinned_pages, path.back()->GetPageId());
+      path.pop_back();
+      child_indexes.pop_back();
+    }
+    auto *target_page = reinterpret_cast<BPlusTreePage *>(path.back()->GetData());
+    while (!target_page->IsLeafPage()) {
+      auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
+      auto index = target_page_internal->LookUpIndex(key, this->comparator_);
+      page_id_t child_page_id = target_page_internal->ValueAt(index);
+      Page *child_page_with_page_type;
+      if (prefetched_page != nullptr && prefetched_page->GetPageId() == child_page_id) {
+        child_page_with_page_type = std::exchange(prefetched_page, nullptr);
+      } else {
+        child_page_with_page_type = this->FetchTreePage(pinned_pages, child_page_id);
+      }
+      child_page_with_page_type->RLatch();
+      path.push_back(child_page_with_page_type);
+      child_indexes.push_back(index);
+      target_page = reinterpret_cast<BPlusTreePage *>(child_page_with_page_type->GetData());
+    }
+    // a prefetched leaf the key did not end up in is not needed anymore
+    if (prefetched_page != nullptr) {
+      this->UnpinTreePage(pinned_pages, prefetched_page->GetPageId());
+      prefetched_page = nullptr;
+    }
+    if (i + 1 < keys.size() && path.size() > 1) {
+      auto *parent_page = reinterpret_cast<InternalPage *>(path[path.size() - 2]->GetData());
+      auto next_page_id = parent_page->LookUp(keys[i + 1], this->comparator_);
+      if (next_page_id != path.back()->GetPageId()) {
+        prefetched_page = this->FetchTreePage(pinned_pages, next_page_id);
+        if (prefetched_page != nullptr) {
+          __builtin_prefetch(prefetched_page->GetData());
+          __builtin_prefetch(prefetched_page->GetData() + BUSTUB_PAGE_SIZE / 2);
+        }
+      }
+    }
+    auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page);
+    auto index = target_page_leaf->BisectPosition(key, this->comparator_) + 1;
+    if (index < target_page_leaf->GetSize() && this->comparator_(target_page_leaf->KeyAt(index), key) == 0) {
+      auto *result = &(*results)[i];
+      this->ScanValues(target_page_leaf, index, [result](const ValueType &value) {
+        result->push_back(value);
+        return true;
+      });
+    }
+  }
+  if (prefetched_page != nullptr) {
+    this->UnpinTreePage(pinned_pages, prefetched_page->GetPageId());
+  }
+  for (auto *page : path) {
+    page->RUnlatch();
+    this->UnpinTreePage(pinned_pages, page->GetPageId());
+  }
+  this->EndPinnedDescent();
+}
+
+/*
+ * Optimistic lock coupling lookup. No latch is taken: the version of every page
+ * is read before the page is used and validated afterwards, and a child is
+ * only trusted after its parent has been validated again, since a parent
+ * version change is the only way a child can be split, merged or freed.
+ * @return : RETRY if a concurrent writer got in the way, LATCH if the values
+ * are stored in posting pages, which are only read with the leaf latched
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValueOptimistic(const KeyType &key, std::vector<ValueType> *result,
+                                        const PinnedPages *pinned_pages) -> LookupResult {
+  page_id_t root_page_id = this->root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    return LookupResult::NOT_FOUND;
+  }
+  Page *target_page_with_page_type = this->FetchTreePage(pinned_pages, root_page_id);
+  auto *target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
+  auto version = target_page->GetVersion();
+  // an old root may already be freed, make sure it was still the root once pinned
+  if ((version & 1) != 0 || this->root_page_id_ != root_page_id) {
+    this->UnpinTreePage(pinned_pages, root_page_id);
+    return LookupResult::RETRY;
+  }
+  while (!target_page->IsLeafPage()) {
+    auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
+    page_id_t child_page_id = target_page_internal->LookUp(key, this->comparator_);
+    if (!target_page->ValidateVersion(version)) {
+      this->UnpinTreePage(pinned_pages, target_page->GetPageId());
+      return LookupResult::RETRY;
+    }
+    Page *child_page_with_page_type = this->FetchTreePage(pinned_pages, child_page_id);
+    auto *child_page = reinterpret_cast<BPlusTreePage *>(child_page_with_page_type->GetData());
+    auto child_version = child_page->GetVersion();
+    if ((child_version & 1) != 0 || !target_page->ValidateVersion(version)) {
+      this->UnpinTreePage(pinned_pages, child_page_id);
+      this->UnpinTreePage(pinned_pages, target_page->GetPageId());
+      return LookupResult::RETRY;
+    }
+    this->UnpinTreePage(pinned_pages, target_page->GetPageId());
+    target_page = child_page;
+    version = child_version;
+  }
+  auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page);
   ValueType value;
-  auto index = target_page_leaf->BisectPosition(key, this->comparator_);
-  if (index + 1 >= target_page_leaf->GetSize()) {
-    this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-    return false;
+  bool is_found = target_page_leaf->Bisect(key, &value, this->comparator_);
+  std::vector<ValueType> values;
+  if (is_found && !this->is_unique_ && LeafPage::IsInlineList(value)) {
+    target_page_leaf->GetInlineList(value, &values);
+  }
+  bool is_valid = target_page->ValidateVersion(version);
+  this->UnpinTreePage(pinned_pages, target_page->GetPageId());
+  if (!is_valid) {
+    return LookupResult::RETRY;
   }
-  if (this->comparator_(target_page_leaf->KeyAt(index + 1), key) == 0) {
-    value = target_page_leaf->ValueAt(index + 1);
+  if (!is_found) {
+    return LookupResult::NOT_FOUND;
+  }
+  if (this->is_unique_ || (!LeafPage::IsInlineList(value) && !LeafPage::IsOverflowList(value))) {
     result->push_back(value);
-    this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-    return true;
+  } else if (LeafPage::IsInlineList(value)) {
+    result->insert(result->end(), values.begin(), values.end());
+  } else {
+    return LookupResult::LATCH;
   }
-  this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-  return false;
+  return LookupResult::FOUND;
+}
+
+/*
+ * Write latch a page and mark it as being modified for optimistic readers
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::WLatchPage(Page *page) {
+  page->WLatch();
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->BeginWrite();
+}
+
+/*
+ * Publish a new version if the page was modified, then release the write latch.
+ * A modified internal page may have new or fewer children, which the pinned
+ * pages are collected from.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::WUnlatchPage(Page *page, bool is_dirty) {
+  auto *tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (is_dirty && !tree_page->IsLeafPage()) {
+    this->pinned_epoch_++;
+  }
+  tree_page->EndWrite(is_dirty);
+  page->WUnlatch();
 }
 
 /*****************************************************************************
@@ -120,141 +596,449 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
 /*
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
- * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * entry, otherwise insert into leaf page. In a non-unique tree the value of
+ * an existing key is added to its posting list, which never splits the leaf.
+ * @return: if user try to insert a duplicate key (or key & value pair in a
+ * non-unique tree) return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  if (this->IsEmpty()) {
-    Page *root_page_with_page_type = this->buffer_pool_manager_->NewPage(&this->root_page_id_);
-    UpdateRootPageId(0);
-    auto *root_page = reinterpret_cast<LeafPage *>(root_page_with_page_type->GetData());
-    root_page->Init(this->GetRootPageId(), INVALID_PAGE_ID, this->leaf_max_size_);
-    root_page->SetNextPageId(INVALID_PAGE_ID);
-    root_page->InsertAt(0, key, value);
-    // Unpin leaf pages
-    this->buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  // First try with only the leaf write latched
+  Page *target_page_with_page_type = this->FindLeafPageOptimistic(key);
+  if (target_page_with_page_type != nullptr) {
+    auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page_with_page_type->GetData());
+    auto index = target_page_leaf->BisectPosition(key, this->comparator_) + 1;
+    bool is_duplicate =
+        index < target_page_leaf->GetSize() && this->comparator_(target_page_leaf->KeyAt(index), key) == 0;
+    bool is_done = true;
+    bool is_inserted = false;
+    if (is_duplicate) {
+      is_inserted = !this->is_unique_ && this->InsertIntoPostingList(target_page_leaf, index, value);
+      this->num_values_ += is_inserted ? 1 : 0;
+    } else if (this->IsSafe(target_page_leaf, Operation::INSERT)) {
+      this->MakeRoom(target_page_leaf, LeafPage::EntrySize(key));
+      target_page_leaf->InsertAt(index, key, value);
+      this->num_keys_++;
+      this->num_values_++;
+      is_inserted = true;
+    } else {
+      is_done = false;
+    }
+    this->WUnlatchPage(target_page_with_page_type, is_inserted);
+    this->buffer_pool_manager_->UnpinPage(target_page_leaf->GetPageId(), is_inserted);
+    if (is_done) {
+      return is_inserted;
+    }
+  }
+  // The leaf may split, retry with write crabbing from the root
+  this->root_latch_.WLock();
+  bool root_locked = true;
+  if (this->root_page_id_ == INVALID_PAGE_ID) {
+    this->StartNewTree(key, value);
+    this->root_latch_.WUnlock();
+    this->RefreshPinnedPages();
     return true;
   }
-  page_id_t target_page_id;
-  BUSTUB_ASSERT(this->FindLeaf(key, &target_page_id), "No");
-  Page *target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-  auto *target_page_general = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
-  auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page_general);
-  auto index = target_page_leaf->BisectPosition(key, this->comparator_);
-  KeyType target_key = target_page_leaf->KeyAt(index + 1);
-  if (this->comparator_(target_key, key) == 0) {
-    this->buffer_pool_manager_->UnpinPage(target_page_id, true);
-    return false;
+  std::deque<Page *> latched_pages;
+  this->FindLeafPagePessimistic(key, Operation::INSERT, &latched_pages, &root_locked);
+  auto *target_page_leaf = reinterpret_cast<LeafPage *>(latched_pages.back()->GetData());
+  auto index = target_page_leaf->BisectPosition(key, this->comparator_) + 1;
+  if (index < target_page_leaf->GetSize() && this->comparator_(target_page_leaf->KeyAt(index), key) == 0) {
+    bool is_inserted = !this->is_unique_ && this->InsertIntoPostingList(target_page_leaf, index, value);
+    this->num_values_ += is_inserted ? 1 : 0;
+    this->ReleaseLatchedPages(&latched_pages, &root_locked, is_inserted);
+    return is_inserted;
   }
-  target_page_leaf->InsertAt(index + 1, key, value);
+  this->MakeRoom(target_page_leaf, LeafPage::EntrySize(key));
+  target_page_leaf->InsertAt(index, key, value);
+  this->num_keys_++;
+  this->num_values_++;
   // Check size
-  if (target_page_leaf->GetSize() >= target_page_leaf->GetMaxSize()) {
+  if (target_page_leaf->IsOverflow()) {
     page_id_t new_page_id;
     Page *new_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_page_id);
-    auto *new_page_general = reinterpret_cast<BPlusTreePage *>(new_page_with_page_type->GetData());
-    auto *new_page_leaf = reinterpret_cast<LeafPage *>(new_page_general);
-    new_page_leaf->Init(new_page_id, target_page_leaf->GetParentPageId(), target_page_leaf->GetMaxSize());
-    // What if it is a root page? Should we use MinSize?
-    if (!target_page_leaf->IsRootPage()) {
-      new_page_leaf->RedistributeFrom(target_page_leaf, target_page_leaf->GetMinSize());
-    } else {
-      new_page_leaf->RedistributeFrom(target_page_leaf, target_page_leaf->GetSize() / 2);
-    }
-    auto old_next_page_id = target_page_leaf->GetNextPageId();
+    auto *new_page_leaf = reinterpret_cast<LeafPage *>(new_page_with_page_type->GetData());
+    new_page_leaf->Init(new_page_id, target_page_leaf->GetParentPageId(), target_page_leaf->GetMaxSize(),
+                        !this->is_unique_);
+    new_page_leaf->RedistributeFrom(target_page_leaf, this->SplitPosition(target_page_leaf));
+    new_page_leaf->SetNextPageId(target_page_leaf->GetNextPageId());
+    new_page_leaf->SetPrevPageId(target_page_leaf->GetPageId());
+    this->SetPrevOf(target_page_leaf->GetNextPageId(), new_page_id);
     target_page_leaf->SetNextPageId(new_page_id);
-    new_page_leaf->SetNextPageId(old_next_page_id);
-    KeyType insert_key = new_page_leaf->KeyAt(0);
-    page_id_t insert_page_id = new_page_id;
-    // Unpin leaf pages, put it down
-    this->buffer_pool_manager_->UnpinPage(target_page_id, true);
+    this->num_leaves_++;
+    // Push up the shortest key between the two leaves instead of a full one
+    KeyType insert_key =
+        this->comparator_.Separator(target_page_leaf->KeyAt(target_page_leaf->GetSize() - 1), new_page_leaf->KeyAt(0));
+    // The new leaf is unreachable until its parent is updated, no need to latch it
     this->buffer_pool_manager_->UnpinPage(new_page_id, true);
-    // Check if it is a root page
-    if (target_page_leaf->IsRootPage()) {
-      Page *root_page_with_page_type = this->buffer_pool_manager_->NewPage(&this->root_page_id_);
+    this->InsertIntoParent(&latched_pages, insert_key, new_page_id);
+  }
+  this->ReleaseLatchedPages(&latched_pages, &root_locked, true);
+  this->RefreshPinnedPages();
+  return true;
+}
+
+/*
+ * Create a root leaf holding a single entry. Caller holds root_latch_.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t root_page_id;
+  Page *root_page_with_page_type = this->buffer_pool_manager_->NewPage(&root_page_id);
+  auto *root_page = reinterpret_cast<LeafPage *>(root_page_with_page_type->GetData());
+  root_page->Init(root_page_id, INVALID_PAGE_ID, this->leaf_max_size_, !this->is_unique_);
+  root_page->InsertAt(0, key, value);
+  this->num_keys_++;
+  this->num_values_++;
+  this->num_leaves_ = 1;
+  this->height_ = 1;
+  // publish the root only once it is initialized, optimistic readers do not take root_latch_
+  this->root_page_id_ = root_page_id;
+  UpdateRootPageId(0);
+  this->buffer_pool_manager_->UnpinPage(root_page_id, true);
+}
+
+/*
+ * The page at the back of latched_pages has just been split and new_page_id
+ * is its new right sibling, key separates the two. Insert the separator into
+ * the parent, splitting ancestors as long as needed. All pages touched here are
+ * latched by the pessimistic descent since they were not safe.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(std::deque<Page *> *latched_pages, const KeyType &key, page_id_t new_page_id) {
+  auto level = static_cast<int>(latched_pages->size()) - 1;
+  KeyType insert_key = key;
+  page_id_t insert_page_id = new_page_id;
+  while (true) {
+    auto *child_page = reinterpret_cast<BPlusTreePage *>((*latched_pages)[level]->GetData());
+    if (child_page->IsRootPage()) {
+      page_id_t new_root_page_id;
+      Page *new_root_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_root_page_id);
+      auto *new_root_page_internal = reinterpret_cast<InternalPage *>(new_root_page_with_page_type->GetData());
+      new_root_page_internal->Init(new_root_page_id, INVALID_PAGE_ID, this->internal_max_size_);
+      new_root_page_internal->SetValueAt(0, child_page->GetPageId());
+      new_root_page_internal->InsertAt(1, insert_key, insert_page_id);
+      child_page->SetParentPageId(new_root_page_id);
+      this->SetParentOf(insert_page_id, new_root_page_id);
+      this->root_page_id_ = new_root_page_id;
       UpdateRootPageId(0);
-      auto *root_page = reinterpret_cast<InternalPage *>(root_page_with_page_type->GetData());
-      root_page->Init(this->GetRootPageId(), INVALID_PAGE_ID, this->internal_max_size_);
-      // Update pointers
-      root_page->SetValueAt(0, target_page_id);
-      root_page->SetKeyAt(1, insert_key);
-      root_page->SetValueAt(1, insert_page_id);
-      root_page->IncrementSize();
-      root_page->UpdateChildrenPointers(this->buffer_pool_manager_);
-      // Unpin leaf pages
-      this->buffer_pool_manager_->UnpinPage(root_page_id_, true);
-      return true;
+      this->height_++;
+      this->buffer_pool_manager_->UnpinPage(new_root_page_id, true);
+      return;
     }
-    // Now handle parent node
-    auto parent_page_id = target_page_leaf->GetParentPageId();
-    Page *parent_page_with_page_type = this->buffer_pool_manager_->FetchPage(parent_page_id);
-    auto *parent_page_general = reinterpret_cast<BPlusTreePage *>(parent_page_with_page_type->GetData());
-    auto *parent_page_internal = reinterpret_cast<InternalPage *>(parent_page_general);
-    while (parent_page_internal->GetSize() >= parent_page_internal->GetMaxSize()) {
-      // Insert the key into parent node
-      index = parent_page_internal->BisectPosition(insert_key, this->comparator_);
-      parent_page_internal->InsertAt(index + 1, insert_key, insert_page_id);
-      // Split parent node
-      // New a parent page
-      page_id_t new_parent_page_id;
-      Page *new_parent_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_parent_page_id);
-      auto *new_parent_page_general = reinterpret_cast<BPlusTreePage *>(new_parent_page_with_page_type->GetData());
-      auto *new_parent_page_internal = reinterpret_cast<InternalPage *>(new_parent_page_general);
-      new_parent_page_internal->Init(new_parent_page_id, parent_page_internal->GetParentPageId(),
-                                     parent_page_internal->GetMaxSize());
-      // Redistribute keys and values
-      new_parent_page_internal->RedistributeFrom(parent_page_internal,
-                                                 parent_page_internal->GetSize() / 2);  // Here is bug
-      insert_key = new_parent_page_internal->Rearrange();
-      insert_page_id = new_parent_page_id;
-      // Update child pages pointers
-      parent_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-      new_parent_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-      // Check if it is the root page
-      if (parent_page_internal->IsRootPage()) {
-        // Routine
-        page_id_t new_root_page_id;
-        Page *new_root_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_root_page_id);
-        auto *new_root_page_general = reinterpret_cast<BPlusTreePage *>(new_root_page_with_page_type->GetData());
-        auto *new_root_page_internal = reinterpret_cast<InternalPage *>(new_root_page_general);
-        // Init
-        new_root_page_internal->Init(new_root_page_id, INVALID_PAGE_ID, parent_page_internal->GetMaxSize());
-        // Insert the last key into root page
-        new_root_page_internal->InsertAt(1, insert_key, new_parent_page_id);
-        new_root_page_internal->SetValueAt(0, parent_page_id);
-        new_root_page_internal->SetValueAt(1, new_parent_page_id);
-        new_root_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-        this->root_page_id_ = new_root_page_id;
-        UpdateRootPageId(0);
-        // Unpin
-        this->buffer_pool_manager_->UnpinPage(parent_page_id, true);
-        this->buffer_pool_manager_->UnpinPage(new_parent_page_id, true);
-        this->buffer_pool_manager_->UnpinPage(new_root_page_id, true);
-        return true;
+    BUSTUB_ASSERT(level > 0, "Parent of a splitting page must be latched");
+    auto *parent_page_internal = reinterpret_cast<InternalPage *>((*latched_pages)[level - 1]->GetData());
+    auto index = parent_page_internal->ValueIndex(child_page->GetPageId()) + 1;
+    if (parent_page_internal->HasRoomFor(insert_key)) {
+      parent_page_internal->InsertAt(index, insert_key, insert_page_id);
+      return;
+    }
+    // Split parent node, the middle key moves up and is not kept in either half
+    std::vector<std::pair<KeyType, page_id_t>> entries;
+    entries.reserve(parent_page_internal->GetSize() + 1);
+    for (int i = 0; i < parent_page_internal->GetSize(); i++) {
+      entries.push_back(parent_page_internal->GetPairAt(i));
+    }
+    entries.insert(entries.begin() + index, std::make_pair(insert_key, insert_page_id));
+    auto split_index =
+        this->SplitPosition(entries, parent_page_internal->GetSize() >= parent_page_internal->GetMaxSize());
+    page_id_t new_parent_page_id;
+    Page *new_parent_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_parent_page_id);
+    auto *new_parent_page_internal = reinterpret_cast<InternalPage *>(new_parent_page_with_page_type->GetData());
+    new_parent_page_internal->Init(new_parent_page_id, parent_page_internal->GetParentPageId(),
+                                   parent_page_internal->GetMaxSize());
+    parent_page_internal->Assign(entries.data(), split_index);
+    new_parent_page_internal->Assign(entries.data() + split_index, static_cast<int>(entries.size()) - split_index);
+    insert_key = entries[split_index].first;
+    insert_page_id = new_parent_page_id;
+    new_parent_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
+    this->buffer_pool_manager_->UnpinPage(new_parent_page_id, true);
+    level--;
+  }
+}
+
+/*
+ * Where to split the entries of an overflowing internal page. A page that is
+ * full by count is split in the middle, one that ran out of bytes is split so
+ * that both halves get about the same number of bytes.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SplitPosition(const std::vector<std::pair<KeyType, page_id_t>> &entries, bool by_count) const
+    -> int {
+  auto count = static_cast<int>(entries.size());
+  if (by_count) {
+    return count / 2;
+  }
+  int total_bytes = 0;
+  for (int i = 1; i < count; i++) {
+    total_bytes += InternalPage::EntrySize(entries[i].first);
+  }
+  int split_index = 1;
+  for (int left_bytes = 0; split_index < count - 2 && left_bytes * 2 < total_bytes; split_index++) {
+    left_bytes += InternalPage::EntrySize(entries[split_index].first);
+  }
+  return std::max(split_index, 2);
+}
+
+/*
+ * Where to split an overflowing leaf, the same way: in the middle unless it
+ * ran out of bytes
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SplitPosition(const LeafPage *leaf) const -> int {
+  auto count = leaf->GetSize();
+  if (leaf->GetUsedBytes() + LeafPage::LargestEntrySize() <= LEAF_PAGE_USABLE_SIZE) {
+    return count / 2;
+  }
+  int split_index = 0;
+  for (int left_bytes = 0; split_index < count - 1 && left_bytes * 2 < leaf->GetUsedBytes(); split_index++) {
+    left_bytes += LeafPage::EntrySize(leaf->KeyAt(split_index));
+  }
+  return std::max(split_index, 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetParentOf(page_id_t child_page_id, page_id_t parent_page_id) {
+  Page *child_page_with_page_type = this->buffer_pool_manager_->FetchPage(child_page_id);
+  auto *child_page = reinterpret_cast<BPlusTreePage *>(child_page_with_page_type->GetData());
+  child_page->SetParentPageId(parent_page_id);
+  this->buffer_pool_manager_->UnpinPage(child_page_id, true);
+}
+
+/*
+ * Point the prev link of leaf_page_id, the right neighbour of a write latched
+ * leaf, at prev_page_id. Latching to the right never waits on a writer going
+ * the other way: writers only latch a left leaf under their common parent,
+ * which the caller holds as well, and hold no leaf while latching a left
+ * internal page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SetPrevOf(page_id_t leaf_page_id, page_id_t prev_page_id) {
+  if (leaf_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  Page *leaf_page_with_page_type = this->buffer_pool_manager_->FetchPage(leaf_page_id);
+  this->WLatchPage(leaf_page_with_page_type);
+  reinterpret_cast<LeafPage *>(leaf_page_with_page_type->GetData())->SetPrevPageId(prev_page_id);
+  this->WUnlatchPage(leaf_page_with_page_type, true);
+  this->buffer_pool_manager_->UnpinPage(leaf_page_id, true);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Build the tree bottom-up: leaves are filled left to right from the sorted
+ * input, then every internal level is packed over the one below it until a
+ * single root is left. Pages are filled to fill_factor of their capacity but
+ * never below their min size, so the result is a regular b+ tree that can be
+ * modified afterwards. Duplicate keys keep their first pair only, unless the
+ * tree is non-unique: then they are stored as one posting list, inline as long
+ * as it leaves room for the pairs the leaf is still going to get.
+ * @return: false if the tree is not empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType *)> &next_pair, double fill_factor) -> bool {
+  this->root_latch_.WLock();
+  if (this->root_page_id_ != INVALID_PAGE_ID) {
+    this->root_latch_.WUnlock();
+    return false;
+  }
+  // a leaf splits once it reaches max size, so it holds at most max size - 1 pairs
+  auto leaf_capacity = this->leaf_max_size_ - 1;
+  auto leaf_fill = std::clamp(static_cast<int>(fill_factor * leaf_capacity), std::max(this->leaf_max_size_ / 2, 1),
+                              leaf_capacity);
+  // and it keeps room for one more pair, which only matters for long keys
+  auto largest_entry = LeafPage::LargestEntrySize();
+  auto leaf_fill_bytes = std::clamp(static_cast<int>(fill_factor * LEAF_PAGE_USABLE_SIZE),
+                                    LEAF_PAGE_USABLE_SIZE / 2 + largest_entry, LEAF_PAGE_USABLE_SIZE - largest_entry);
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  LeafPage *target_page_leaf = nullptr;
+  KeySample sample;
+  uint64_t num_keys = 0;
+  MappingType pair;
+  bool has_pair = next_pair(&pair);
+  while (has_pair) {
+    KeyType key = pair.first;
+    std::vector<ValueType> values{pair.second};
+    has_pair = next_pair(&pair);
+    while (has_pair && this->comparator_(key, pair.first) == 0) {
+      if (!this->is_unique_) {
+        values.push_back(pair.second);
+      }
+      has_pair = next_pair(&pair);
+    }
+    BUSTUB_ASSERT(!has_pair || this->comparator_(key, pair.first) < 0, "Bulk load input must be sorted");
+    if (target_page_leaf == nullptr || target_page_leaf->GetSize() >= leaf_fill ||
+        target_page_leaf->GetUsedBytes() + LeafPage::EntrySize(key) > leaf_fill_bytes) {
+      KeyType separator = key;
+      if (target_page_leaf != nullptr) {
+        separator = this->comparator_.Separator(target_page_leaf->KeyAt(target_page_leaf->GetSize() - 1), key);
       }
-      // Unpin parent pages
-      auto old_parent_page_id = parent_page_id;
-      // Change the variables
-      parent_page_id = parent_page_internal->GetParentPageId();
-      // Unpin parent pages
-      this->buffer_pool_manager_->UnpinPage(old_parent_page_id, true);
-      this->buffer_pool_manager_->UnpinPage(new_parent_page_id, true);
-      parent_page_with_page_type = this->buffer_pool_manager_->FetchPage(parent_page_id);
-      parent_page_general = reinterpret_cast<BPlusTreePage *>(parent_page_with_page_type->GetData());
-      parent_page_internal = reinterpret_cast<InternalPage *>(parent_page_general);
-    }
-    index = parent_page_internal->BisectPosition(insert_key, this->comparator_);
-    parent_page_internal->InsertAt(index + 1, insert_key, insert_page_id);
-    this->buffer_pool_manager_->UnpinPage(parent_page_id, true);
+      page_id_t new_page_id;
+      Page *new_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_page_id);
+      auto *new_page_leaf = reinterpret_cast<LeafPage *>(new_page_with_page_type->GetData());
+      new_page_leaf->Init(new_page_id, INVALID_PAGE_ID, this->leaf_max_size_, !this->is_unique_);
+      if (target_page_leaf != nullptr) {
+        new_page_leaf->SetPrevPageId(target_page_leaf->GetPageId());
+        target_page_leaf->SetNextPageId(new_page_id);
+        this->buffer_pool_manager_->UnpinPage(target_page_leaf->GetPageId(), true);
+      }
+      target_page_leaf = new_page_leaf;
+      level.emplace_back(separator, new_page_id);
+    }
+    auto index = target_page_leaf->GetSize();
+    std::sort(values.begin(), values.end(),
+              [](const ValueType &lhs, const ValueType &rhs) { return lhs.Get() < rhs.Get(); });
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    this->MakeRoom(target_page_leaf, LeafPage::EntrySize(key));
+    target_page_leaf->InsertAt(index, key, values[0]);
+    num_keys++;
+    for (size_t i = 0; i < values.size(); i++) {
+      sample.Add(key);
+    }
+    if (values.size() > 1) {
+      auto reserved = (leaf_fill - index - 1) * LeafPage::EntrySize(key);
+      auto size = BPlusTreePostingPage::EncodedSize(values);
+      if (size > POSTING_LIST_INLINE_SIZE || target_page_leaf->GetFreeBytes() < reserved + size ||
+          !target_page_leaf->SetInlineList(index, values)) {
+        page_id_t head_page_id = BPlusTreePostingPage::CreateChain(this->buffer_pool_manager_, values);
+        target_page_leaf->SetValueAt(index, LeafPage::MakeOverflowList(head_page_id));
+      }
+    }
+  }
+  if (target_page_leaf == nullptr) {
+    this->root_latch_.WUnlock();
     return true;
   }
-  // Insertion without overflow
-  this->buffer_pool_manager_->UnpinPage(target_page_id, true);
+  this->buffer_pool_manager_->UnpinPage(target_page_leaf->GetPageId(), true);
+  this->BalanceLastLeaves(&level);
+  this->num_keys_ = num_keys;
+  this->num_values_ = sample.count_;
+  this->num_leaves_ = level.size();
+  this->height_ = 1;
+  this->BuildHistogram(sample, INDEX_HISTOGRAM_BUCKETS);
+  while (level.size() > 1) {
+    level = this->BuildInternalLevel(level, fill_factor);
+    this->height_++;
+  }
+  // publish the root only once the whole tree is built
+  this->root_page_id_ = level[0].second;
+  UpdateRootPageId(0);
+  this->root_latch_.WUnlock();
+  this->RefreshPinnedPages();
   return true;
+}
 
-  this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-  return false;
+/*
+ * The last leaf gets whatever is left of the input and may be below min size.
+ * Merge it into its left neighbour if both fit in one leaf, otherwise split
+ * their pairs evenly.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BalanceLastLeaves(std::vector<std::pair<KeyType, page_id_t>> *level) {
+  if (level->size() < 2) {
+    return;
+  }
+  auto left_page_id = (*level)[level->size() - 2].second;
+  auto right_page_id = level->back().second;
+  auto *left_page_leaf = reinterpret_cast<LeafPage *>(this->buffer_pool_manager_->FetchPage(left_page_id)->GetData());
+  auto *right_page_leaf = reinterpret_cast<LeafPage *>(this->buffer_pool_manager_->FetchPage(right_page_id)->GetData());
+  if (right_page_leaf->GetSize() >= this->leaf_max_size_ / 2 ||
+      right_page_leaf->GetUsedBytes() * 2 >= LEAF_PAGE_USABLE_SIZE) {
+    this->buffer_pool_manager_->UnpinPage(left_page_id, false);
+    this->buffer_pool_manager_->UnpinPage(right_page_id, false);
+    return;
+  }
+  if (left_page_leaf->CanMergeWith(right_page_leaf)) {
+    this->MakeRoomForMerge(left_page_leaf, right_page_leaf);
+    left_page_leaf->MergeWith(right_page_leaf, true);
+    left_page_leaf->SetNextPageId(right_page_leaf->GetNextPageId());
+    this->SetPrevOf(right_page_leaf->GetNextPageId(), left_page_id);
+    this->buffer_pool_manager_->UnpinPage(left_page_id, true);
+    this->buffer_pool_manager_->UnpinPage(right_page_id, false);
+    this->buffer_pool_manager_->DeletePage(right_page_id);
+    level->pop_back();
+    return;
+  }
+  // move pairs over for as long as that evens out the bytes of the two
+  while (true) {
+    auto last = left_page_leaf->GetSize() - 1;
+    auto bytes = LeafPage::EntrySize(left_page_leaf->KeyAt(last));
+    if (right_page_leaf->GetUsedBytes() + bytes > left_page_leaf->GetUsedBytes() - bytes) {
+      break;
+    }
+    this->MakeRoomForEntry(right_page_leaf, left_page_leaf, last);
+    right_page_leaf->InsertFrom(0, left_page_leaf, last);
+    left_page_leaf->RemoveAt(last);
+  }
+  level->back().first =
+      this->comparator_.Separator(left_page_leaf->KeyAt(left_page_leaf->GetSize() - 1), right_page_leaf->KeyAt(0));
+  this->buffer_pool_manager_->UnpinPage(left_page_id, true);
+  this->buffer_pool_manager_->UnpinPage(right_page_id, true);
+}
+
+/*
+ * Pack the pages of one level under new internal pages and return the new level.
+ * Pages are filled up to fill_factor of both their max size and their bytes.
+ * Group sizes are decided up front so that the last page is not left underfull.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BuildInternalLevel(const std::vector<std::pair<KeyType, page_id_t>> &children,
+                                        double fill_factor) -> std::vector<std::pair<KeyType, page_id_t>> {
+  auto min_size = (this->internal_max_size_ + 1) / 2;
+  auto fill = std::clamp(static_cast<int>(fill_factor * this->internal_max_size_), std::max(min_size, 2),
+                         this->internal_max_size_);
+  auto largest_entry = INTERNAL_PAGE_SLOT_SIZE + static_cast<int>(sizeof(KeyType));
+  auto fill_bytes = std::clamp(static_cast<int>(fill_factor * INTERNAL_PAGE_USABLE_SIZE),
+                               INTERNAL_PAGE_USABLE_SIZE / 2 + largest_entry, INTERNAL_PAGE_USABLE_SIZE);
+  // bytes of a page holding children [begin, begin + size), the first key is not stored
+  auto group_bytes = [&children](size_t begin, int size) {
+    auto bytes = INTERNAL_PAGE_SLOT_SIZE;
+    for (int i = 1; i < size; i++) {
+      bytes += InternalPage::EntrySize(children[begin + i].first);
+    }
+    return bytes;
+  };
+  std::vector<int> group_sizes;
+  for (size_t begin = 0; begin < children.size(); begin += group_sizes.back()) {
+    int size = 1;
+    auto bytes = INTERNAL_PAGE_SLOT_SIZE;
+    while (begin + size < children.size() && size < fill &&
+           bytes + InternalPage::EntrySize(children[begin + size].first) <= fill_bytes) {
+      bytes += InternalPage::EntrySize(children[begin + size].first);
+      size++;
+    }
+    group_sizes.push_back(size);
+  }
+  auto last_begin = children.size() - group_sizes.back();
+  if (group_sizes.size() >= 2 && group_sizes.back() < min_size &&
+      group_bytes(last_begin, group_sizes.back()) * 2 < INTERNAL_PAGE_USABLE_SIZE) {
+    auto total = group_sizes[group_sizes.size() - 2] + group_sizes.back();
+    group_sizes.pop_back();
+    auto begin = last_begin - group_sizes.back();
+    if (total <= this->internal_max_size_ && group_bytes(begin, total) <= INTERNAL_PAGE_USABLE_SIZE) {
+      group_sizes.back() = total;
+    } else {
+      group_sizes.back() = total - total / 2;
+      group_sizes.push_back(total / 2);
+    }
+  }
+
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  size_t child_index = 0;
+  for (auto group_size : group_sizes) {
+    page_id_t new_page_id;
+    Page *new_page_with_page_type = this->buffer_pool_manager_->NewPage(&new_page_id);
+    auto *new_page_internal = reinterpret_cast<InternalPage *>(new_page_with_page_type->GetData());
+    new_page_internal->Init(new_page_id, INVALID_PAGE_ID, this->internal_max_size_);
+    new_page_internal->Assign(children.data() + child_index, group_size);
+    new_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
+    level.emplace_back(children[child_index].first, new_page_id);
+    child_index += group_size;
+    this->buffer_pool_manager_->UnpinPage(new_page_id, true);
+  }
+  return level;
 }
 
 /*****************************************************************************
@@ -269,243 +1053,473 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  if (this->IsEmpty()) {
+  this->RemoveEntry(key, nullptr, transaction);
+}
+
+/*
+ * Delete the key & value pair only, other values of the key are kept
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  this->RemoveEntry(key, &value, transaction);
+}
+
+/*
+ * Remove key, or only its pair with value if value is not null
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveEntry(const KeyType &key, const ValueType *value, Transaction *transaction) {
+  // First try with only the leaf write latched
+  Page *target_page_with_page_type = this->FindLeafPageOptimistic(key);
+  if (target_page_with_page_type == nullptr) {
     return;
   }
-  page_id_t target_page_id;
-  BUSTUB_ASSERT(this->FindLeaf(key, &target_page_id), "No");
-  Page *target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-  auto *target_page_general = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
-  auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page_general);
-  if (target_page_leaf->IsRootPage()) {
-    // Do something for root page
-    if (target_page_leaf->GetSize() == 1) {
-      this->root_page_id_ = INVALID_PAGE_ID;
-      UpdateRootPageId(0);
-      this->buffer_pool_manager_->UnpinPage(target_page_id, false);
-      this->buffer_pool_manager_->DeletePage(target_page_id);
-      return;
-    }
-  }
-  auto index = target_page_leaf->BisectPosition(key, this->comparator_);
-  KeyType target_key = target_page_leaf->KeyAt(index + 1);
-  if (this->comparator_(target_key, key) != 0) {
-    this->buffer_pool_manager_->UnpinPage(target_page_id, false);
+  auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page_with_page_type->GetData());
+  bool is_dirty;
+  bool is_done = this->RemoveFromLeaf(target_page_leaf, key, value, this->IsSafe(target_page_leaf, Operation::DELETE),
+                                      &is_dirty);
+  this->WUnlatchPage(target_page_with_page_type, is_dirty);
+  this->buffer_pool_manager_->UnpinPage(target_page_leaf->GetPageId(), is_dirty);
+  if (is_done) {
     return;
   }
-  target_page_leaf->RemoveAt(index + 1);
-  if (target_page_leaf->GetSize() >= target_page_leaf->GetMinSize()) {
-    this->buffer_pool_manager_->UnpinPage(target_page_id, true);
+  // The leaf may underflow, retry with write crabbing from the root
+  this->root_latch_.WLock();
+  bool root_locked = true;
+  if (this->root_page_id_ == INVALID_PAGE_ID) {
+    this->root_latch_.WUnlock();
     return;
   }
-  // Handle underflow
-  bool is_merge;
-  bool is_right;
-  page_id_t sibling_page_id;
-  target_page_leaf->StealOrMerge(&is_merge, &is_right, this->buffer_pool_manager_, this->comparator_, &sibling_page_id,
-                                 &index);
-  Page *sibling_page_with_page_type = this->buffer_pool_manager_->FetchPage(sibling_page_id);
-  auto *sibling_page_general = reinterpret_cast<BPlusTreePage *>(sibling_page_with_page_type->GetData());
-  auto *sibling_page_leaf = reinterpret_cast<LeafPage *>(sibling_page_general);
-  Page *parent_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_leaf->GetParentPageId());
-  auto *parent_page_general = reinterpret_cast<BPlusTreePage *>(parent_page_with_page_type->GetData());
-  auto *parent_page_internal = reinterpret_cast<InternalPage *>(parent_page_general);
-  if (!is_merge) {
-    KeyType stolen_key;
-    ValueType stolen_value;
-    if (is_right) {
-      stolen_key = sibling_page_leaf->KeyAt(0);
-      stolen_value = sibling_page_leaf->ValueAt(0);
-      sibling_page_leaf->RemoveAt(0);
-      target_page_leaf->InsertAt(target_page_leaf->GetSize(), stolen_key, stolen_value);
-      parent_page_internal->SetKeyAt(index, sibling_page_leaf->KeyAt(0));
-    } else {
-      stolen_key = sibling_page_leaf->KeyAt(sibling_page_leaf->GetSize() - 1);
-      stolen_value = sibling_page_leaf->ValueAt(sibling_page_leaf->GetSize() - 1);
-      sibling_page_leaf->RemoveAt(sibling_page_leaf->GetSize() - 1);
-      target_page_leaf->InsertAt(0, stolen_key, stolen_value);
-      parent_page_internal->SetKeyAt(index + 1, target_page_leaf->KeyAt(0));
-    }
-    this->buffer_pool_manager_->UnpinPage(sibling_page_id, true);
-    this->buffer_pool_manager_->UnpinPage(target_page_id, true);
-    this->buffer_pool_manager_->UnpinPage(parent_page_internal->GetPageId(), true);
+  std::deque<Page *> latched_pages;
+  this->FindLeafPagePessimistic(key, Operation::DELETE, &latched_pages, &root_locked);
+  target_page_leaf = reinterpret_cast<LeafPage *>(latched_pages.back()->GetData());
+  this->RemoveFromLeaf(target_page_leaf, key, value, true, &is_dirty);
+  if (!is_dirty) {
+    this->ReleaseLatchedPages(&latched_pages, &root_locked, false);
     return;
   }
-  // Merge
-  LeafPage *new_leaf;
-  page_id_t delete_page_id;
-  if (is_right) {
-    target_page_leaf->MergeWith(sibling_page_leaf, true);
-    target_page_leaf->SetNextPageId(sibling_page_leaf->GetNextPageId());
-    new_leaf = target_page_leaf;
-    delete_page_id = sibling_page_id;
-  } else {
-    sibling_page_leaf->MergeWith(target_page_leaf, true);
-    sibling_page_leaf->SetNextPageId(target_page_leaf->GetNextPageId());
-    new_leaf = sibling_page_leaf;
-    delete_page_id = target_page_id;
+  this->Rebalance(&latched_pages, &root_locked, this->merge_fill_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Rebalance(std::deque<Page *> *latched_pages, bool *root_locked, double merge_fill) {
+  std::vector<Page *> sibling_pages;
+  std::vector<page_id_t> deleted_pages;
+  this->HandleUnderflow(latched_pages, &sibling_pages, &deleted_pages, merge_fill);
+  for (auto *sibling_page : sibling_pages) {
+    this->WUnlatchPage(sibling_page, true);
+    this->buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
   }
-  this->buffer_pool_manager_->UnpinPage(target_page_leaf->GetPageId(), true);
-  this->buffer_pool_manager_->UnpinPage(sibling_page_leaf->GetPageId(), true);
-  this->buffer_pool_manager_->DeletePage(delete_page_id);
-  // Handle parent node
-  if (is_right) {
-    parent_page_internal->RemoveAt(index);
-  } else {
-    parent_page_internal->RemoveAt(index + 1);
+  this->ReleaseLatchedPages(latched_pages, root_locked, true);
+  // Pages can only be freed once nobody holds a pin on them, including the pinned pages
+  this->RefreshPinnedPages();
+  for (auto deleted_page_id : deleted_pages) {
+    this->buffer_pool_manager_->DeletePage(deleted_page_id);
   }
+}
 
-  while (parent_page_internal->GetSize() < parent_page_internal->GetMinSize()) {
+/*
+ * Find the underfull leaves in one pass over the leaves first, then merge
+ * each with write crabbing like a delete would. A leaf may have changed in
+ * between, so it is checked again once latched. At a merge fill of 1 the
+ * leaf merges with its sibling whenever both fit on one page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Compact(double fill, Transaction *transaction) {
+  std::vector<KeyType> keys;
+  for (auto iterator = this->Begin(); !iterator.IsEnd(); iterator.SkipLeaf()) {
+    const auto *leaf = iterator.leaf_;
+    if (!leaf->IsRootPage() && leaf->IsUnderflow(fill)) {
+      keys.push_back(leaf->KeyAt(0));
+    }
+  }
+  for (const auto &key : keys) {
+    this->root_latch_.WLock();
+    bool root_locked = true;
+    if (this->root_page_id_ == INVALID_PAGE_ID) {
+      this->root_latch_.WUnlock();
+      return;
+    }
+    std::deque<Page *> latched_pages;
+    this->FindLeafPagePessimistic(key, Operation::COMPACT, &latched_pages, &root_locked);
+    auto *leaf = reinterpret_cast<LeafPage *>(latched_pages.back()->GetData());
+    if (leaf->IsRootPage() || !leaf->IsUnderflow(fill)) {
+      this->ReleaseLatchedPages(&latched_pages, &root_locked, false);
+      continue;
+    }
+    this->Rebalance(&latched_pages, &root_locked, 1);
+  }
+}
+
+/*
+ * Removing one value of a posting list does not change the number of entries
+ * and is always done, removing the whole entry only if can_remove_entry is set.
+ * @return : false if the entry has to be removed but can_remove_entry is not set
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveFromLeaf(LeafPage *leaf, const KeyType &key, const ValueType *value, bool can_remove_entry,
+                                    bool *is_dirty) -> bool {
+  *is_dirty = false;
+  auto index = leaf->BisectPosition(key, this->comparator_) + 1;
+  if (index >= leaf->GetSize() || this->comparator_(leaf->KeyAt(index), key) != 0) {
+    return true;
+  }
+  auto current = leaf->ValueAt(index);
+  bool is_list = !this->is_unique_ && (LeafPage::IsInlineList(current) || LeafPage::IsOverflowList(current));
+  if (value != nullptr && is_list) {
+    *is_dirty = this->RemoveFromPostingList(leaf, index, *value);
+    this->num_values_ -= *is_dirty ? 1 : 0;
+    return true;
+  }
+  if (value != nullptr && !(current == *value)) {
+    return true;
+  }
+  if (!can_remove_entry) {
+    return false;
+  }
+  uint64_t num_values = 0;
+  this->ScanValues(leaf, index, [&num_values](const ValueType &) {
+    num_values++;
+    return true;
+  });
+  if (is_list && LeafPage::IsOverflowList(current)) {
+    BPlusTreePostingPage::FreeChain(this->buffer_pool_manager_, current.GetPageId());
+  }
+  leaf->RemoveAt(index);
+  this->num_keys_--;
+  this->num_values_ -= num_values;
+  *is_dirty = true;
+  return true;
+}
+
+/*
+ * Walk up the latched path and fix underflowing pages, either by borrowing one
+ * entry from a sibling or by merging the right page of the pair into the left
+ * one. Siblings are write latched while their parent is latched and stay
+ * latched until the caller is done, except for leaves, which are released
+ * once merged. Separators have different sizes, so when the keys to move do
+ * not fit the page is left underfull instead. Leaves underflow below
+ * merge_fill, a low one lets them shrink further before they are merged.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::HandleUnderflow(std::deque<Page *> *latched_pages, std::vector<Page *> *sibling_pages,
+                                     std::vector<page_id_t> *deleted_pages, double merge_fill) {
+  auto level = static_cast<int>(latched_pages->size()) - 1;
+  while (true) {
+    auto *target_page = reinterpret_cast<BPlusTreePage *>((*latched_pages)[level]->GetData());
     // First handle root page
-    if (parent_page_internal->IsRootPage()) {
-      this->root_page_id_ = parent_page_internal->ValueAt(0);
-      Page *new_root_page_with_page_type = this->buffer_pool_manager_->FetchPage(this->root_page_id_);
-      auto *new_root_page_general = reinterpret_cast<BPlusTreePage *>(new_root_page_with_page_type->GetData());
-      new_root_page_general->SetParentPageId(INVALID_PAGE_ID);
-      UpdateRootPageId(0);
-      this->buffer_pool_manager_->UnpinPage(this->root_page_id_, true);
-      this->buffer_pool_manager_->UnpinPage(parent_page_internal->GetPageId(), true);
-      this->buffer_pool_manager_->DeletePage(parent_page_internal->GetPageId());
+    if (target_page->IsRootPage()) {
+      if (target_page->IsLeafPage() && target_page->GetSize() == 0) {
+        this->root_page_id_ = INVALID_PAGE_ID;
+        UpdateRootPageId(0);
+        this->num_leaves_ = 0;
+        this->height_ = 0;
+        deleted_pages->push_back(target_page->GetPageId());
+      } else if (!target_page->IsLeafPage() && target_page->GetSize() == 1) {
+        this->root_page_id_ = reinterpret_cast<InternalPage *>(target_page)->ValueAt(0);
+        this->SetParentOf(this->root_page_id_, INVALID_PAGE_ID);
+        UpdateRootPageId(0);
+        this->height_--;
+        deleted_pages->push_back(target_page->GetPageId());
+      }
       return;
     }
-    parent_page_internal->StealOrMerge(&is_merge, &is_right, this->buffer_pool_manager_, this->comparator_,
-                                       &sibling_page_id, &index);
-    sibling_page_with_page_type = this->buffer_pool_manager_->FetchPage(sibling_page_id);
-    sibling_page_general = reinterpret_cast<BPlusTreePage *>(sibling_page_with_page_type->GetData());
-    auto sibling_page_internal = reinterpret_cast<InternalPage *>(sibling_page_general);
-    Page *grand_parent_page_with_page_type =
-        this->buffer_pool_manager_->FetchPage(parent_page_internal->GetParentPageId());
-    auto *grand_parent_page_general = reinterpret_cast<BPlusTreePage *>(grand_parent_page_with_page_type->GetData());
-    auto *grand_parent_page_internal = reinterpret_cast<InternalPage *>(grand_parent_page_general);
-    auto sibling_index = grand_parent_page_internal->BisectPosition(sibling_page_internal->KeyAt(1), this->comparator_);
-    if (!is_merge) {
-      KeyType stolen_key;
-      page_id_t stolen_page_id;
+    bool is_underflow = target_page->IsLeafPage() ? reinterpret_cast<LeafPage *>(target_page)->IsUnderflow(merge_fill)
+                                                   : reinterpret_cast<InternalPage *>(target_page)->IsUnderflow();
+    if (!is_underflow) {
+      return;
+    }
+    BUSTUB_ASSERT(level > 0, "Parent of an underflowing page must be latched");
+    auto *parent_page_internal = reinterpret_cast<InternalPage *>((*latched_pages)[level - 1]->GetData());
+    auto index = parent_page_internal->ValueIndex(target_page->GetPageId());
+    // Prefer the left sibling, the leftmost child has to use its right one
+    bool is_right = index == 0;
+    auto sibling_index = is_right ? index + 1 : index - 1;
+    Page *sibling_page_with_page_type =
+        this->buffer_pool_manager_->FetchPage(parent_page_internal->ValueAt(sibling_index));
+    this->WLatchPage(sibling_page_with_page_type);
+    sibling_pages->push_back(sibling_page_with_page_type);
+    auto *sibling_page = reinterpret_cast<BPlusTreePage *>(sibling_page_with_page_type->GetData());
+
+    // Merge the right page of the pair into the left one unless the sibling can spare an entry
+    auto *left_page = is_right ? target_page : sibling_page;
+    auto *right_page = is_right ? sibling_page : target_page;
+    auto right_index = is_right ? sibling_index : index;
+    bool is_steal;
+    if (target_page->IsLeafPage()) {
+      is_steal = reinterpret_cast<LeafPage *>(sibling_page)->CanLendEntry(merge_fill) ||
+                 !reinterpret_cast<LeafPage *>(left_page)->CanMergeWith(reinterpret_cast<LeafPage *>(right_page));
+    } else {
+      auto *sibling_page_internal = reinterpret_cast<InternalPage *>(sibling_page);
+      is_steal = sibling_page_internal->CanLendEntry() ||
+                 !reinterpret_cast<InternalPage *>(left_page)->CanMergeWith(
+                     reinterpret_cast<InternalPage *>(right_page), parent_page_internal->KeyAt(right_index));
+    }
+
+    if (is_steal) {
+      // Steal one entry from the sibling
+      if (target_page->IsLeafPage()) {
+        auto *target_page_leaf = reinterpret_cast<LeafPage *>(target_page);
+        auto *sibling_page_leaf = reinterpret_cast<LeafPage *>(sibling_page);
+        if (is_right) {
+          auto separator = this->comparator_.Separator(sibling_page_leaf->KeyAt(0), sibling_page_leaf->KeyAt(1));
+          if (!parent_page_internal->CanSetKeyAt(sibling_index, separator)) {
+            return;
+          }
+          this->MakeRoomForEntry(target_page_leaf, sibling_page_leaf, 0);
+          target_page_leaf->InsertFrom(target_page_leaf->GetSize(), sibling_page_leaf, 0);
+          sibling_page_leaf->RemoveAt(0);
+          parent_page_internal->SetKeyAt(sibling_index, separator);
+        } else {
+          auto last = sibling_page_leaf->GetSize() - 1;
+          auto separator =
+              this->comparator_.Separator(sibling_page_leaf->KeyAt(last - 1), sibling_page_leaf->KeyAt(last));
+          if (!parent_page_internal->CanSetKeyAt(index, separator)) {
+            return;
+          }
+          this->MakeRoomForEntry(target_page_leaf, sibling_page_leaf, last);
+          target_page_leaf->InsertFrom(0, sibling_page_leaf, last);
+          sibling_page_leaf->RemoveAt(last);
+          parent_page_internal->SetKeyAt(index, separator);
+        }
+        return;
+      }
+      auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
+      auto *sibling_page_internal = reinterpret_cast<InternalPage *>(sibling_page);
       if (is_right) {
-        stolen_key = grand_parent_page_internal->KeyAt(sibling_index);
-        stolen_page_id = sibling_page_internal->ValueAt(0);
-        parent_page_internal->InsertAt(parent_page_internal->GetSize(), stolen_key, stolen_page_id);
-        grand_parent_page_internal->SetKeyAt(sibling_index, sibling_page_internal->KeyAt(1));
-        sibling_page_internal->RemoveAt(0);
+        // Separator comes down, first key of sibling goes up
+        auto down_key = parent_page_internal->KeyAt(sibling_index);
+        if (!target_page_internal->HasRoomFor(down_key) ||
+            !parent_page_internal->CanSetKeyAt(sibling_index, sibling_page_internal->KeyAt(1))) {
+          return;
+        }
+        auto stolen_page_id = sibling_page_internal->ValueAt(0);
+        target_page_internal->InsertAt(target_page_internal->GetSize(), down_key, stolen_page_id);
+        parent_page_internal->SetKeyAt(sibling_index, sibling_page_internal->Rearrange());
+        this->SetParentOf(stolen_page_id, target_page_internal->GetPageId());
       } else {
-        stolen_key = grand_parent_page_internal->KeyAt(sibling_index + 1);
-        stolen_page_id = sibling_page_internal->ValueAt(sibling_page_internal->GetSize() - 1);
-        parent_page_internal->InsertAt(0, stolen_key, stolen_page_id);
-        parent_page_internal->SetKeyAt(1, stolen_key); // Here used to be a bug
-        grand_parent_page_internal->SetKeyAt(sibling_index + 1,
-                                             sibling_page_internal->KeyAt(sibling_page_internal->GetSize() - 1));
-        sibling_page_internal->RemoveAt(sibling_page_internal->GetSize() - 1);
+        auto last = sibling_page_internal->GetSize() - 1;
+        auto down_key = parent_page_internal->KeyAt(index);
+        auto up_key = sibling_page_internal->KeyAt(last);
+        if (!target_page_internal->HasRoomFor(down_key) || !parent_page_internal->CanSetKeyAt(index, up_key)) {
+          return;
+        }
+        auto stolen_page_id = sibling_page_internal->ValueAt(last);
+        target_page_internal->InsertAt(0, up_key, stolen_page_id);
+        target_page_internal->SetKeyAt(1, down_key);
+        parent_page_internal->SetKeyAt(index, up_key);
+        sibling_page_internal->RemoveAt(last);
+        this->SetParentOf(stolen_page_id, target_page_internal->GetPageId());
       }
-      parent_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-      sibling_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-      grand_parent_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-      this->buffer_pool_manager_->UnpinPage(sibling_page_internal->GetParentPageId(), true);
-      this->buffer_pool_manager_->UnpinPage(parent_page_internal->GetPageId(), true);
-      this->buffer_pool_manager_->UnpinPage(grand_parent_page_internal->GetPageId(), true);
       return;
     }
-    // Merge
-    InternalPage *new_internal;
-    page_id_t delete_internal_page_id;
-    if (is_right) {
-      auto it_key = grand_parent_page_internal->RemoveAt(sibling_index);
-      auto it_page_id = sibling_page_internal->ValueAt(0);
-      auto limit = sibling_page_internal->GetSize();
-      for (int i = 0; i < limit; i++) {
-        parent_page_internal->InsertAt(parent_page_internal->GetSize(), it_key, it_page_id);
-        it_key = sibling_page_internal->KeyAt(i + 1);
-        it_page_id = sibling_page_internal->ValueAt(i + 1);
-      }
-      new_internal = parent_page_internal;
-      delete_internal_page_id = sibling_page_id;
+
+    if (target_page->IsLeafPage()) {
+      auto *left_page_leaf = reinterpret_cast<LeafPage *>(left_page);
+      auto *right_page_leaf = reinterpret_cast<LeafPage *>(right_page);
+      this->MakeRoomForMerge(left_page_leaf, right_page_leaf);
+      left_page_leaf->MergeWith(right_page_leaf, true);
+      left_page_leaf->SetNextPageId(right_page_leaf->GetNextPageId());
+      this->SetPrevOf(right_page_leaf->GetNextPageId(), left_page_leaf->GetPageId());
+      this->num_leaves_--;
     } else {
-      auto it_key = grand_parent_page_internal->RemoveAt(sibling_index + 1);
-      auto it_page_id = parent_page_internal->ValueAt(0);
-      auto limit = parent_page_internal->GetSize();
-      for (int i = 0; i < limit; i++) {
-        sibling_page_internal->InsertAt(sibling_page_internal->GetSize(), it_key, it_page_id);
-        it_key = parent_page_internal->KeyAt(i + 1);
-        it_page_id = parent_page_internal->ValueAt(i + 1);  // Here used to be a bug
+      auto *left_page_internal = reinterpret_cast<InternalPage *>(left_page);
+      auto *right_page_internal = reinterpret_cast<InternalPage *>(right_page);
+      // The separator becomes the key of the first moved child
+      left_page_internal->InsertAt(left_page_internal->GetSize(), parent_page_internal->KeyAt(right_index),
+                                   right_page_internal->ValueAt(0));
+      this->SetParentOf(right_page_internal->ValueAt(0), left_page_internal->GetPageId());
+      for (int i = 1; i < right_page_internal->GetSize(); i++) {
+        left_page_internal->InsertAt(left_page_internal->GetSize(), right_page_internal->KeyAt(i),
+                                     right_page_internal->ValueAt(i));
+        this->SetParentOf(right_page_internal->ValueAt(i), left_page_internal->GetPageId());
       }
-      new_internal = sibling_page_internal;
-      delete_internal_page_id = parent_page_internal->GetPageId();
-    }
-    new_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-    for (int i = 0; i < new_internal->GetSize(); i++) {
-      auto child_page_id = new_internal->ValueAt(i);
-      Page *child_page_with_page_type = this->buffer_pool_manager_->FetchPage(child_page_id);
-      auto *child_page_general = reinterpret_cast<BPlusTreePage *>(child_page_with_page_type->GetData());
-      if (child_page_general->IsLeafPage()) {
-        auto *child_page_leaf = reinterpret_cast<LeafPage *>(child_page_general);
-        if (i < new_internal->GetSize() - 1 && child_page_leaf->GetNextPageId() != new_internal->ValueAt(i + 1)) {
-          child_page_leaf->SetNextPageId(new_internal->ValueAt(i + 1));
-          this->buffer_pool_manager_->UnpinPage(child_page_id, true);
-          continue;
-        }
-        this->buffer_pool_manager_->UnpinPage(child_page_id, false);
+      right_page_internal->SetSize(0);
+    }
+    parent_page_internal->RemoveAt(right_index);
+    deleted_pages->push_back(right_page->GetPageId());
+    level--;
+    if (target_page->IsLeafPage()) {
+      // The leaves are done, let go of them before latching internal siblings: a writer holding one of those
+      // may be waiting to latch a leaf for its prev link
+      for (auto *leaf_page : {latched_pages->back(), sibling_pages->back()}) {
+        this->WUnlatchPage(leaf_page, true);
+        this->buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
       }
+      latched_pages->pop_back();
+      sibling_pages->pop_back();
     }
-    grand_parent_page_internal->UpdateChildrenPointers(this->buffer_pool_manager_);
-    this->buffer_pool_manager_->UnpinPage(parent_page_internal->GetPageId(), true);
-    this->buffer_pool_manager_->UnpinPage(sibling_page_internal->GetPageId(), true);
-    this->buffer_pool_manager_->DeletePage(delete_internal_page_id);
-    parent_page_internal = grand_parent_page_internal;
   }
-  this->buffer_pool_manager_->UnpinPage(parent_page_internal->GetPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::LeftMostLeaf() -> page_id_t {
-  auto root_page_with_page_type = this->buffer_pool_manager_->FetchPage(this->GetRootPageId());
-  auto *root_page = reinterpret_cast<BPlusTreePage *>(root_page_with_page_type->GetData());
-  if (root_page->IsLeafPage()) {
-    auto root_page_id = root_page->GetPageId();
-    this->buffer_pool_manager_->UnpinPage(this->GetRootPageId(), false);
-    return root_page_id;
-  }
-  auto *root_page_internal = reinterpret_cast<InternalPage *>(root_page);
-  auto target_page_id = root_page_internal->ValueAt(0);
-  this->buffer_pool_manager_->UnpinPage(this->GetRootPageId(), false);
-  auto target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-  auto *target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
-  while (!target_page->IsLeafPage()) {
-    auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
-    target_page_id = target_page_internal->ValueAt(0);
-    this->buffer_pool_manager_->UnpinPage(target_page->GetPageId(), false);
-    target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-    target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
+  Page *target_page_with_page_type = this->FindLeafPageRead(KeyType{}, true, false);
+  if (target_page_with_page_type == nullptr) {
+    return INVALID_PAGE_ID;
   }
-  auto ret = target_page->GetPageId();
-  this->buffer_pool_manager_->UnpinPage(target_page->GetPageId(), false);
+  auto ret = target_page_with_page_type->GetPageId();
+  target_page_with_page_type->RUnlatch();
+  this->buffer_pool_manager_->UnpinPage(ret, false);
   return ret;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::RightMostLeaf() -> page_id_t {
-  auto root_page_with_page_type = this->buffer_pool_manager_->FetchPage(this->GetRootPageId());
-  auto *root_page = reinterpret_cast<BPlusTreePage *>(root_page_with_page_type->GetData());
-  if (root_page->IsLeafPage()) {
-    auto root_page_id = root_page->GetPageId();
-    this->buffer_pool_manager_->UnpinPage(this->GetRootPageId(), false);
-    return root_page_id;
-  }
-  auto *root_page_internal = reinterpret_cast<InternalPage *>(root_page);
-  auto target_page_id = root_page_internal->ValueAt(root_page_internal->GetSize() - 1);
-  this->buffer_pool_manager_->UnpinPage(this->GetRootPageId(), false);
-  auto target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-  auto *target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
-  while (!target_page->IsLeafPage()) {
-    auto *target_page_internal = reinterpret_cast<InternalPage *>(target_page);
-    target_page_id = target_page_internal->ValueAt(target_page_internal->GetSize() - 1);
-    this->buffer_pool_manager_->UnpinPage(target_page->GetPageId(), false);
-    target_page_with_page_type = this->buffer_pool_manager_->FetchPage(target_page_id);
-    target_page = reinterpret_cast<BPlusTreePage *>(target_page_with_page_type->GetData());
+  Page *target_page_with_page_type = this->FindLeafPageRead(KeyType{}, false, true);
+  if (target_page_with_page_type == nullptr) {
+    return INVALID_PAGE_ID;
   }
-  auto ret = target_page->GetPageId();
-  this->buffer_pool_manager_->UnpinPage(target_page->GetPageId(), false);
+  auto ret = target_page_with_page_type->GetPageId();
+  target_page_with_page_type->RUnlatch();
+  this->buffer_pool_manager_->UnpinPage(ret, false);
   return ret;
 }
 
+/*****************************************************************************
+ * POSTING LISTS
+ *****************************************************************************/
+/*
+ * Add value to the values of the entry at index. A list that outgrows
+ * POSTING_LIST_INLINE_SIZE or the free space of the leaf goes to posting pages.
+ * @return : false if the key & value pair already exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertIntoPostingList(LeafPage *leaf, int index, const ValueType &value) -> bool {
+  auto current = leaf->ValueAt(index);
+  if (LeafPage::IsOverflowList(current)) {
+    return BPlusTreePostingPage::InsertIntoChain(this->buffer_pool_manager_, current.GetPageId(), value);
+  }
+  std::vector<ValueType> values;
+  if (LeafPage::IsInlineList(current)) {
+    leaf->GetInlineList(current, &values);
+  } else {
+    values.push_back(current);
+  }
+  auto position = std::lower_bound(values.begin(), values.end(), value,
+                                   [](const ValueType &lhs, const ValueType &rhs) { return lhs.Get() < rhs.Get(); });
+  if (position != values.end() && *position == value) {
+    return false;
+  }
+  values.insert(position, value);
+  if (BPlusTreePostingPage::EncodedSize(values) <= POSTING_LIST_INLINE_SIZE && leaf->SetInlineList(index, values)) {
+    return true;
+  }
+  leaf->SetValueAt(index, LeafPage::MakeOverflowList(
+                              BPlusTreePostingPage::CreateChain(this->buffer_pool_manager_, values)));
+  return true;
+}
+
+/*
+ * Remove value from the values of the entry at index, which has a posting
+ * list. A list left with one value stores it directly, a short list in
+ * posting pages is moved back into the leaf if there is room.
+ * @return : false if the key & value pair does not exist
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &value) -> bool {
+  auto current = leaf->ValueAt(index);
+  std::vector<ValueType> values;
+  if (LeafPage::IsOverflowList(current)) {
+    auto head_page_id = current.GetPageId();
+    if (!BPlusTreePostingPage::RemoveFromChain(this->buffer_pool_manager_, head_page_id, value)) {
+      return false;
+    }
+    // half of the inline limit, so that a list going back and forth does not move every time
+    if (!BPlusTreePostingPage::ReadShortChain(this->buffer_pool_manager_, head_page_id, POSTING_LIST_INLINE_SIZE / 2,
+                                              &values)) {
+      return true;
+    }
+    if (values.size() == 1) {
+      leaf->SetValueAt(index, values[0]);
+    } else if (!leaf->SetInlineList(index, values)) {
+      return true;
+    }
+    BPlusTreePostingPage::FreeChain(this->buffer_pool_manager_, head_page_id);
+    return true;
+  }
+  leaf->GetInlineList(current, &values);
+  auto position = std::lower_bound(values.begin(), values.end(), value,
+                                   [](const ValueType &lhs, const ValueType &rhs) { return lhs.Get() < rhs.Get(); });
+  if (position == values.end() || !(*position == value)) {
+    return false;
+  }
+  values.erase(position);
+  if (values.size() == 1) {
+    leaf->SetValueAt(index, values[0]);
+  } else {
+    // a shorter list always fits where the longer one was
+    leaf->SetInlineList(index, values);
+  }
+  return true;
+}
+
+/*
+ * Call consumer on every value of the entry at index, in order
+ * @return : false if consumer stopped the scan
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ScanValues(const LeafPage *leaf, int index, const std::function<bool(const ValueType &)> &consumer)
+    -> bool {
+  auto current = leaf->ValueAt(index);
+  if (this->is_unique_ || (!LeafPage::IsInlineList(current) && !LeafPage::IsOverflowList(current))) {
+    return consumer(current);
+  }
+  if (LeafPage::IsOverflowList(current)) {
+    return BPlusTreePostingPage::ScanChain(this->buffer_pool_manager_, current.GetPageId(), consumer);
+  }
+  std::vector<ValueType> values;
+  leaf->GetInlineList(current, &values);
+  for (const auto &value : values) {
+    if (!consumer(value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::SpillPostingList(LeafPage *leaf, int index) {
+  std::vector<ValueType> values;
+  leaf->GetInlineList(leaf->ValueAt(index), &values);
+  page_id_t head_page_id = BPlusTreePostingPage::CreateChain(this->buffer_pool_manager_, values);
+  leaf->SetValueAt(index, LeafPage::MakeOverflowList(head_page_id));
+}
+
+/*
+ * Leaves split and merge by their entries alone, inline lists are moved out
+ * whenever the entries and lists would not fit in one page otherwise
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MakeRoom(LeafPage *leaf, int bytes) {
+  while (leaf->GetFreeBytes() < bytes) {
+    auto index = leaf->LargestInlineList();
+    BUSTUB_ASSERT(index >= 0, "Leaf entries alone always fit in a page");
+    this->SpillPostingList(leaf, index);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MakeRoomForEntry(LeafPage *to_leaf, LeafPage *from_leaf, int from_index) {
+  auto list_size = from_leaf->InlineListSizeAt(from_index);
+  auto entry_size = LeafPage::EntrySize(from_leaf->KeyAt(from_index));
+  if (list_size > 0 && to_leaf->GetFreeBytes() < entry_size + list_size) {
+    this->SpillPostingList(from_leaf, from_index);
+  }
+  this->MakeRoom(to_leaf, entry_size);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MakeRoomForMerge(LeafPage *left_leaf, LeafPage *right_leaf) {
+  auto used_bytes = [](LeafPage *leaf) { return BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - leaf->GetFreeBytes(); };
+  while (left_leaf->GetFreeBytes() < used_bytes(right_leaf)) {
+    auto *leaf = right_leaf->LargestInlineList() >= 0 ? right_leaf : left_leaf;
+    auto index = leaf->LargestInlineList();
+    BUSTUB_ASSERT(index >= 0, "Leaf entries alone always fit in a page");
+    this->SpillPostingList(leaf, index);
+  }
+}
+
 /*****************************************************************************
  * INDEX ITERATOR
  *****************************************************************************/
@@ -516,8 +1530,11 @@ auto BPLUSTREE_TYPE::RightMostLeaf() -> page_id_t {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  auto left_most_page_id = this->LeftMostLeaf();
-  return INDEXITERATOR_TYPE(left_most_page_id, buffer_pool_manager_, 0);
+  Page *target_page_with_page_type = this->FindLeafPageRead(KeyType{}, true);
+  if (target_page_with_page_type == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  return INDEXITERATOR_TYPE(this, target_page_with_page_type, 0);
 }
 
 /*
@@ -527,28 +1544,218 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-  page_id_t page_id;
-  this->FindLeaf(key, &page_id);
-  auto *page = this->buffer_pool_manager_->FetchPage(page_id);
-  auto *leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
+  Page *target_page_with_page_type = this->FindLeafPageRead(key);
+  if (target_page_with_page_type == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf_page = reinterpret_cast<LeafPage *>(target_page_with_page_type->GetData());
   auto index = leaf_page->BisectPosition(key, this->comparator_);
-  this->buffer_pool_manager_->UnpinPage(page_id, false);
-  return INDEXITERATOR_TYPE(page_id, buffer_pool_manager_, index + 1);
+  return INDEXITERATOR_TYPE(this, target_page_with_page_type, index + 1);
 }
 
 /*
  * Input parameter is void, construct an index iterator representing the end
- * of the key/value pair in the leaf node
+ * of the key/value pair in the leaf node. It holds no page.
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
-  auto right_most_page_id = this->RightMostLeaf();
-  auto *page = this->buffer_pool_manager_->FetchPage(right_most_page_id);
-  auto *leaf_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  auto size = leaf_page->GetSize();
-  this->buffer_pool_manager_->UnpinPage(right_most_page_id, false);
-  return INDEXITERATOR_TYPE(right_most_page_id, buffer_pool_manager_, size);
+auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+
+/*
+ * Input parameter is void, find the rightmost leaf page and construct a
+ * reverse index iterator on its last pair
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin() -> INDEXITERATOR_TYPE {
+  Page *target_page_with_page_type = this->FindLeafPageRead(KeyType{}, false, true);
+  if (target_page_with_page_type == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf_page = reinterpret_cast<LeafPage *>(target_page_with_page_type->GetData());
+  return INDEXITERATOR_TYPE(this, target_page_with_page_type, leaf_page->GetSize() - 1, true);
+}
+
+/*
+ * Input parameter is high key, find the leaf page that contains the input key
+ * first, then construct a reverse index iterator on the last pair not greater
+ * than it
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  Page *target_page_with_page_type = this->FindLeafPageRead(key);
+  if (target_page_with_page_type == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf_page = reinterpret_cast<LeafPage *>(target_page_with_page_type->GetData());
+  auto index = leaf_page->BisectPosition(key, this->comparator_);
+  if (index + 1 < leaf_page->GetSize() && this->comparator_(leaf_page->KeyAt(index + 1), key) == 0) {
+    index++;
+  }
+  return INDEXITERATOR_TYPE(this, target_page_with_page_type, index, true);
+}
+
+/*
+ * Read the upper levels from the root down, one page at a time, until a level
+ * has enough separator keys in the range. Pages are not latched together, so
+ * splits and merges meanwhile only make the ranges less even; pages that are
+ * no internal pages any more are skipped.
+ * @return : the keys that start every range but the first
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SplitKeys(const std::optional<KeyType> &low, const std::optional<KeyType> &high, int num_parts)
+    -> std::vector<KeyType> {
+  std::vector<KeyType> separators;
+  std::vector<page_id_t> level;
+  this->root_latch_.RLock();
+  if (this->root_page_id_ != INVALID_PAGE_ID) {
+    level.push_back(this->root_page_id_);
+  }
+  this->root_latch_.RUnlock();
+  auto after_low = [&](const KeyType &key) { return !low.has_value() || this->comparator_(*low, key) < 0; };
+  auto not_after_high = [&](const KeyType &key) { return !high.has_value() || this->comparator_(key, *high) <= 0; };
+  while (static_cast<int>(separators.size()) + 1 < num_parts && !level.empty()) {
+    std::vector<KeyType> level_separators;
+    std::vector<page_id_t> children;
+    for (auto page_id : level) {
+      Page *page_with_page_type = this->buffer_pool_manager_->FetchPage(page_id);
+      if (page_with_page_type == nullptr) {
+        continue;
+      }
+      page_with_page_type->RLatch();
+      auto *page = reinterpret_cast<BPlusTreePage *>(page_with_page_type->GetData());
+      if (page->GetPageType() == IndexPageType::INTERNAL_PAGE && page->GetPageId() == page_id) {
+        auto *internal_page = reinterpret_cast<InternalPage *>(page);
+        // child i holds the keys in [KeyAt(i), KeyAt(i + 1))
+        for (int i = 0; i < internal_page->GetSize(); i++) {
+          if (i + 1 < internal_page->GetSize() && !after_low(internal_page->KeyAt(i + 1))) {
+            continue;
+          }
+          if (i > 0 && !not_after_high(internal_page->KeyAt(i))) {
+            break;
+          }
+          if (i > 0 && after_low(internal_page->KeyAt(i))) {
+            level_separators.push_back(internal_page->KeyAt(i));
+          }
+          children.push_back(internal_page->ValueAt(i));
+        }
+      }
+      page_with_page_type->RUnlatch();
+      this->buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+    // the level below only has leaves once no page of this level is internal
+    if (level_separators.size() <= separators.size()) {
+      break;
+    }
+    separators = std::move(level_separators);
+    level = std::move(children);
+  }
+
+  auto less = [this](const KeyType &a, const KeyType &b) { return this->comparator_(a, b) < 0; };
+  auto equal = [this](const KeyType &a, const KeyType &b) { return this->comparator_(a, b) == 0; };
+  std::sort(separators.begin(), separators.end(), less);
+  separators.erase(std::unique(separators.begin(), separators.end(), equal), separators.end());
+  if (static_cast<int>(separators.size()) + 1 <= num_parts) {
+    return separators;
+  }
+  // n separators bound n + 1 subtrees, take the bounds of num_parts runs of them
+  std::vector<KeyType> split_keys;
+  auto num_subtrees = separators.size() + 1;
+  for (int i = 1; i < num_parts; i++) {
+    split_keys.push_back(separators[i * num_subtrees / num_parts - 1]);
+  }
+  return split_keys;
+}
+
+/*****************************************************************************
+ * STATISTICS
+ *****************************************************************************/
+/*
+ * The fill factor is the share of leaf slots in use, long posting lists and
+ * keys shorter than the key type make it an estimate.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetStatistics() const -> Statistics {
+  Statistics statistics;
+  statistics.num_keys_ = this->num_keys_;
+  statistics.num_values_ = this->num_values_;
+  statistics.height_ = this->height_;
+  statistics.num_leaves_ = this->num_leaves_;
+  auto num_slots = static_cast<double>(statistics.num_leaves_) * (this->leaf_max_size_ - 1);
+  statistics.leaf_fill_factor_ = num_slots == 0 ? 0 : static_cast<double>(statistics.num_keys_) / num_slots;
+  std::scoped_lock lock(this->histogram_latch_);
+  statistics.histogram_bounds_ = this->histogram_bounds_;
+  statistics.histogram_counts_ = this->histogram_counts_;
+  return statistics;
+}
+
+/*
+ * Like ANALYZE: walk the leaves from left to right, which also corrects the
+ * counts should they have drifted. Writers may run meanwhile, the result is
+ * as exact as a snapshot at some point of the walk would be.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Analyze(int num_buckets) {
+  KeySample sample;
+  uint64_t num_keys = 0;
+  for (auto iterator = this->Begin(); !iterator.IsEnd(); ++iterator) {
+    const auto &key = (*iterator).first;
+    if (sample.count_ == 0 || this->comparator_(sample.last_, key) != 0) {
+      num_keys++;
+    }
+    sample.Add(key);
+  }
+  this->num_keys_ = num_keys;
+  this->num_values_ = sample.count_;
+  this->BuildHistogram(sample, num_buckets);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::KeySample::Add(const KeyType &key) {
+  if (count_ % stride_ == 0) {
+    keys_.push_back(key);
+    if (keys_.size() >= 2 * static_cast<size_t>(INDEX_HISTOGRAM_SAMPLE)) {
+      for (size_t i = 0; i < keys_.size() / 2; i++) {
+        keys_[i] = keys_[i * 2];
+      }
+      keys_.resize(keys_.size() / 2);
+      stride_ *= 2;
+    }
+  }
+  last_ = key;
+  count_++;
+}
+
+/*
+ * Bucket i ends at the sampled key closest below rank (i + 1) * count /
+ * num_buckets and the last one at the largest key. A key that ends several
+ * buckets, because it has that many values, ends a single bucket holding all
+ * of their values.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BuildHistogram(const KeySample &sample, int num_buckets) {
+  std::vector<KeyType> bounds;
+  std::vector<uint64_t> counts;
+  if (sample.count_ > 0) {
+    auto num_bounds = std::min(static_cast<uint64_t>(num_buckets), sample.count_);
+    bounds.push_back(sample.keys_[0]);
+    uint64_t begin = 0;
+    for (uint64_t i = 1; i <= num_bounds; i++) {
+      auto end = i * sample.count_ / num_bounds;
+      auto index = std::min(static_cast<size_t>((end - 1) / sample.stride_), sample.keys_.size() - 1);
+      const auto &bound = i == num_bounds ? sample.last_ : sample.keys_[index];
+      if (counts.empty() || this->comparator_(bound, bounds.back()) != 0) {
+        bounds.push_back(bound);
+        counts.push_back(0);
+      }
+      counts.back() += end - begin;
+      begin = end;
+    }
+  }
+  std::scoped_lock lock(this->histogram_latch_);
+  this->histogram_bounds_ = std::move(bounds);
+  this->histogram_counts_ = std::move(counts);
 }
 
 /**
@@ -570,6 +1777,7 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return this->root_page_id_;
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
+  this->pinned_epoch_++;
   auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
@@ -774,5 +1982,7 @@ template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTree<GenericKey<128>, RID, GenericComparator<128>>;
+template class BPlusTree<GenericKey<256>, RID, GenericComparator<256>>;
 
 }  // namespace bustub
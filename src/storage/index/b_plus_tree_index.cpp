@@ -9,23 +9,88 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <utility>
+
 #include "storage/index/b_plus_tree_index.h"
+#include "storage/index/external_merge_sort.h"
+#include "storage/table/table_heap.h"
 
 namespace bustub {
+
+namespace {
+
+template <typename Iterator>
+class IteratorCursor : public IndexCursor {
+ public:
+  explicit IteratorCursor(Iterator &&iterator) : iterator_(std::move(iterator)) {}
+
+  auto Next(RID *rid) -> bool override {
+    if (iterator_.IsEnd()) {
+      return false;
+    }
+    *rid = (*iterator_).second;
+    ++iterator_;
+    return true;
+  }
+
+ private:
+  Iterator iterator_;
+};
+
+// Scans [begin, end) of a tree, opened on the first Next so that cursors can be handed to other threads
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class RangeCursor : public IndexCursor {
+  using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
+ public:
+  RangeCursor(Tree *tree, const KeyComparator &comparator, std::optional<KeyType> begin, std::optional<KeyType> end)
+      : tree_(tree), comparator_(comparator), begin_(std::move(begin)), end_(std::move(end)) {}
+
+  auto Next(RID *rid) -> bool override {
+    if (!is_open_) {
+      iterator_ = begin_.has_value() ? tree_->Begin(*begin_) : tree_->Begin();
+      is_open_ = true;
+    }
+    if (iterator_.IsEnd() || (end_.has_value() && comparator_((*iterator_).first, *end_) >= 0)) {
+      // let go of the leaf, the next range starts on it
+      iterator_ = IndexIterator<KeyType, ValueType, KeyComparator>();
+      return false;
+    }
+    *rid = (*iterator_).second;
+    ++iterator_;
+    return true;
+  }
+
+ private:
+  Tree *tree_;
+  KeyComparator comparator_;
+  std::optional<KeyType> begin_;
+  std::optional<KeyType> end_;
+  bool is_open_{false};
+  IndexIterator<KeyType, ValueType, KeyComparator> iterator_;
+};
+
+}  // namespace
+
 /*
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
+      buffer_pool_manager_(buffer_pool_manager),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE,
+                 GetMetadata()->IsUnique()) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Insert(index_key, rid, transaction);
 }
@@ -34,20 +99,112 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
-  container_.Remove(index_key, transaction);
+  container_.Remove(index_key, rid, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, const std::function<bool(const RID &)> &consumer,
+                                   Transaction *transaction) {
+  KeyType index_key;
+  index_key.SetFromKey(key, GetKeySchema());
+
+  container_.ScanKey(index_key, consumer, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                    Transaction *transaction) {
+  std::vector<KeyType> index_keys(keys.size());
+  std::vector<size_t> order(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i], GetKeySchema());
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [this, &index_keys](size_t a, size_t b) { return comparator_(index_keys[a], index_keys[b]) < 0; });
+  std::vector<KeyType> sorted_keys;
+  sorted_keys.reserve(keys.size());
+  for (auto i : order) {
+    sorted_keys.push_back(index_keys[i]);
+  }
+  std::vector<std::vector<RID>> sorted_results;
+  container_.GetValues(sorted_keys, &sorted_results, transaction);
+  results->assign(keys.size(), {});
+  for (size_t i = 0; i < order.size(); i++) {
+    (*results)[order[i]] = std::move(sorted_results[i]);
+  }
+}
+
+/*
+ * Sort all keys of the table with an external merge sort, then build the tree
+ * bottom-up instead of descending from the root once per tuple.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(TableHeap *table_heap, const Schema &tuple_schema, Transaction *transaction,
+                                    double fill_factor) {
+  ExternalMergeSort<KeyType, ValueType, KeyComparator> sorter(buffer_pool_manager_, comparator_);
+  KeyType index_key;
+  for (auto tuple = table_heap->Begin(transaction); tuple != table_heap->End(); ++tuple) {
+    index_key.SetFromKey(tuple->KeyFromTuple(tuple_schema, *GetKeySchema(), GetKeyAttrs()), GetKeySchema());
+    sorter.Add(index_key, tuple->GetRid());
+  }
+  sorter.Finish();
+  container_.BulkLoad([&sorter](MappingType *pair) { return sorter.Next(pair); }, fill_factor);
+}
+
+/*
+ * The tree keeps its histogram on whole keys, the optimizer gets it on the
+ * first key column.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetStatistics() const -> std::optional<IndexStatistics> {
+  auto tree_statistics = container_.GetStatistics();
+  IndexStatistics statistics;
+  statistics.num_values_ = tree_statistics.num_values_;
+  statistics.num_keys_ = tree_statistics.num_keys_;
+  statistics.height_ = tree_statistics.height_;
+  statistics.num_leaves_ = tree_statistics.num_leaves_;
+  statistics.leaf_fill_factor_ = tree_statistics.leaf_fill_factor_;
+  for (const auto &bound : tree_statistics.histogram_bounds_) {
+    statistics.histogram_bounds_.push_back(bound.ToValue(GetKeySchema(), 0));
+  }
+  statistics.histogram_counts_ = std::move(tree_statistics.histogram_counts_);
+  return statistics;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::Analyze(Transaction *transaction) { container_.Analyze(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::Scan(bool descending) -> std::unique_ptr<IndexCursor> {
+  return std::make_unique<IteratorCursor<INDEXITERATOR_TYPE>>(descending ? container_.RBegin() : container_.Begin());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::ScanPartitions(int num_parts) -> std::vector<std::unique_ptr<IndexCursor>> {
+  using Cursor = RangeCursor<KeyType, ValueType, KeyComparator>;
+  auto split_keys = container_.SplitKeys(std::nullopt, std::nullopt, num_parts);
+  std::vector<std::unique_ptr<IndexCursor>> cursors;
+  std::optional<KeyType> begin;
+  for (const auto &split_key : split_keys) {
+    cursors.push_back(std::make_unique<Cursor>(&container_, comparator_, begin, split_key));
+    begin = split_key;
+  }
+  cursors.push_back(std::make_unique<Cursor>(&container_, comparator_, begin, std::nullopt));
+  return cursors;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
@@ -57,10 +214,20 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_.End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator() -> INDEXITERATOR_TYPE { return container_.RBegin(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return container_.RBegin(key);
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeIndex<GenericKey<128>, RID, GenericComparator<128>>;
+template class BPlusTreeIndex<GenericKey<256>, RID, GenericComparator<256>>;
 
 }  // namespace bustub
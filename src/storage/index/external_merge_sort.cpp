@@ -0,0 +1,213 @@
+/**
+ * external_merge_sort.cpp
+ */
+#include "storage/index/external_merge_sort.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define RUN_PAGE_CAPACITY static_cast<int>((BUSTUB_PAGE_SIZE - sizeof(int)) / sizeof(MappingType))
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_MERGE_SORT_TYPE::ExternalMergeSort(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                                            int buffer_pages, int merge_fan_in)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      buffer_capacity_(static_cast<size_t>(std::max(buffer_pages, 1)) * RUN_PAGE_CAPACITY),
+      merge_fan_in_(std::max(merge_fan_in, 2)),
+      heap_(HeapCompare{&comparator_}) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_MERGE_SORT_TYPE::~ExternalMergeSort() {
+  // Free whatever the reader did not consume
+  for (auto &run : runs_) {
+    if (run.page_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(run.page_->GetPageId(), false);
+    }
+    for (auto i = run.page_index_; i < run.page_ids_.size(); i++) {
+      buffer_pool_manager_->DeletePage(run.page_ids_[i]);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_MERGE_SORT_TYPE::Add(const KeyType &key, const ValueType &value) {
+  buffer_.emplace_back(key, value);
+  if (buffer_.size() >= buffer_capacity_) {
+    SpillRun();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_MERGE_SORT_TYPE::SpillRun() {
+  std::sort(buffer_.begin(), buffer_.end(),
+            [this](const MappingType &lhs, const MappingType &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+  Run run;
+  for (size_t i = 0; i < buffer_.size(); i += RUN_PAGE_CAPACITY) {
+    page_id_t page_id;
+    Page *page = buffer_pool_manager_->NewPage(&page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for external sort run");
+    }
+    auto count = static_cast<int>(std::min(buffer_.size() - i, static_cast<size_t>(RUN_PAGE_CAPACITY)));
+    memcpy(page->GetData(), &count, sizeof(int));
+    memcpy(page->GetData() + sizeof(int), &buffer_[i], count * sizeof(MappingType));
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    run.page_ids_.push_back(page_id);
+  }
+  runs_.push_back(std::move(run));
+  run_count_++;
+  buffer_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_MERGE_SORT_TYPE::Finish() {
+  if (runs_.empty()) {
+    // Everything fits in memory, no need to touch the buffer pool
+    std::sort(buffer_.begin(), buffer_.end(),
+              [this](const MappingType &lhs, const MappingType &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+    buffer_index_ = 0;
+    return;
+  }
+  if (!buffer_.empty()) {
+    SpillRun();
+  }
+  buffer_.shrink_to_fit();
+  while (runs_.size() > merge_fan_in_) {
+    std::vector<Run> merged_runs;
+    for (size_t begin = 0; begin < runs_.size(); begin += merge_fan_in_) {
+      merged_runs.push_back(MergeRuns(begin, std::min(begin + merge_fan_in_, runs_.size())));
+    }
+    runs_ = std::move(merged_runs);
+  }
+  for (size_t i = 0; i < runs_.size(); i++) {
+    if (AdvanceRun(&runs_[i])) {
+      heap_.emplace(RunPairAt(runs_[i]), i);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_MERGE_SORT_TYPE::Next(MappingType *pair) -> bool {
+  if (runs_.empty()) {
+    if (buffer_index_ >= buffer_.size()) {
+      return false;
+    }
+    *pair = buffer_[buffer_index_++];
+    return true;
+  }
+  if (heap_.empty()) {
+    return false;
+  }
+  auto [top_pair, run_index] = heap_.top();
+  heap_.pop();
+  *pair = top_pair;
+  auto &run = runs_[run_index];
+  run.offset_++;
+  if (AdvanceRun(&run)) {
+    heap_.emplace(RunPairAt(run), run_index);
+  }
+  return true;
+}
+
+/*
+ * Merge pass, holds one pinned page per input run plus the output page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_MERGE_SORT_TYPE::MergeRuns(size_t begin, size_t end) -> Run {
+  if (end - begin == 1) {
+    return std::move(runs_[begin]);
+  }
+  for (auto i = begin; i < end; i++) {
+    if (AdvanceRun(&runs_[i])) {
+      heap_.emplace(RunPairAt(runs_[i]), i);
+    }
+  }
+  Run merged_run;
+  page_id_t page_id = INVALID_PAGE_ID;
+  Page *page = nullptr;
+  int count = 0;
+  while (!heap_.empty()) {
+    if (page == nullptr || count == RUN_PAGE_CAPACITY) {
+      if (page != nullptr) {
+        memcpy(page->GetData(), &count, sizeof(int));
+        buffer_pool_manager_->UnpinPage(page_id, true);
+      }
+      page = buffer_pool_manager_->NewPage(&page_id);
+      if (page == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for external sort run");
+      }
+      merged_run.page_ids_.push_back(page_id);
+      count = 0;
+    }
+    auto [top_pair, run_index] = heap_.top();
+    heap_.pop();
+    memcpy(page->GetData() + sizeof(int) + count * sizeof(MappingType), static_cast<void *>(&top_pair),
+           sizeof(MappingType));
+    count++;
+    auto &run = runs_[run_index];
+    run.offset_++;
+    if (AdvanceRun(&run)) {
+      heap_.emplace(RunPairAt(run), run_index);
+    }
+  }
+  if (page != nullptr) {
+    memcpy(page->GetData(), &count, sizeof(int));
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
+  return merged_run;
+}
+
+/*
+ * Make sure the run has a pinned page with an unread pair. Exhausted pages are
+ * deleted right away so that the sort never holds more than one page per run.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_MERGE_SORT_TYPE::AdvanceRun(Run *run) -> bool {
+  while (true) {
+    if (run->page_ != nullptr) {
+      int count;
+      memcpy(&count, run->page_->GetData(), sizeof(int));
+      if (run->offset_ < count) {
+        return true;
+      }
+      auto page_id = run->page_->GetPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      buffer_pool_manager_->DeletePage(page_id);
+      run->page_ = nullptr;
+      run->page_index_++;
+    }
+    if (run->page_index_ >= run->page_ids_.size()) {
+      return false;
+    }
+    run->page_ = buffer_pool_manager_->FetchPage(run->page_ids_[run->page_index_]);
+    if (run->page_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for external sort run");
+    }
+    run->offset_ = 0;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_MERGE_SORT_TYPE::RunPairAt(const Run &run) const -> MappingType {
+  MappingType pair;
+  memcpy(static_cast<void *>(&pair), run.page_->GetData() + sizeof(int) + run.offset_ * sizeof(MappingType),
+         sizeof(MappingType));
+  return pair;
+}
+
+template class ExternalMergeSort<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExternalMergeSort<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExternalMergeSort<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExternalMergeSort<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExternalMergeSort<GenericKey<64>, RID, GenericComparator<64>>;
+template class ExternalMergeSort<GenericKey<128>, RID, GenericComparator<128>>;
+template class ExternalMergeSort<GenericKey<256>, RID, GenericComparator<256>>;
+
+}  // namespace bustub
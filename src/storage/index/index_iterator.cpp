@@ -2,10 +2,13 @@
  * index_iterator.cpp
  */
 #include "storage/index/index_iterator.h"
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
+#include <utility>
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
+#include "storage/index/b_plus_tree.h"
 #include "storage/page/b_plus_tree_page.h"
 
 #define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -18,34 +21,54 @@ namespace bustub {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(page_id_t leaf_id, BufferPoolManager *bpm, int index) {
-  this->leaf_id_ = leaf_id;
-  this->bpm_ = bpm;
+INDEXITERATOR_TYPE::IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index,
+                                  bool is_reverse) {
+  this->tree_ = tree;
+  this->page_ = page;
+  this->leaf_ = reinterpret_cast<LeafPage *>(page->GetData());
   this->index_ = index;
+  this->is_reverse_ = is_reverse;
+  this->Settle();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
+INDEXITERATOR_TYPE::~IndexIterator() { this->Release(); }  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool {
-  auto *page = this->bpm_->FetchPage(this->leaf_id_);
-  auto *leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
-  auto flag = leaf_page->GetNextPageId() == INVALID_PAGE_ID && this->index_ == leaf_page->GetSize();
-  this->bpm_->UnpinPage(leaf_id_, false);
-  return flag;
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept { *this = std::move(other); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept -> INDEXITERATOR_TYPE & {
+  if (this != &other) {
+    this->Release();
+    this->tree_ = other.tree_;
+    this->page_ = std::exchange(other.page_, nullptr);
+    this->leaf_ = std::exchange(other.leaf_, nullptr);
+    this->index_ = std::exchange(other.index_, 0);
+    this->is_reverse_ = other.is_reverse_;
+    this->values_ = std::move(other.values_);
+    this->value_index_ = std::exchange(other.value_index_, 0);
+    other.values_.clear();
+  }
+  return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return this->page_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::IsReverse() const -> bool { return this->is_reverse_; }
+
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
   if (this->IsEnd()) {
     throw std::runtime_error("Out of bounds");
   }
-  auto *page = this->bpm_->FetchPage(this->leaf_id_);
-  auto *leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
-  auto &ret = leaf_page->GetPairAt(index_);
-  this->bpm_->UnpinPage(leaf_id_, false);
-  return ret;
+  this->current_ = this->leaf_->GetPairAt(this->index_);
+  if (!this->values_.empty()) {
+    this->current_.second = this->values_[this->value_index_];
+  }
+  return this->current_;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -53,23 +76,196 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
   if (this->IsEnd()) {
     throw std::runtime_error("Out of bounds");
   }
-  auto *page = this->bpm_->FetchPage(this->leaf_id_);
-  auto *leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
-  if (this->index_ == leaf_page->GetSize()) {
-    auto old_leaf_page_id = leaf_id_;
-    this->leaf_id_ = leaf_page->GetNextPageId();
-    this->index_ = 0;
-    this->bpm_->UnpinPage(old_leaf_page_id, false);
+  // step through the values of a posting list before moving to the next key
+  if (this->value_index_ + 1 < static_cast<int>(this->values_.size())) {
+    this->value_index_++;
     return *this;
   }
-  this->index_ += 1;
-  this->bpm_->UnpinPage(leaf_id_, false);
+  this->values_.clear();
+  this->value_index_ = 0;
+  this->index_ += this->is_reverse_ ? -1 : 1;
+  this->Settle();
   return *this;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator!=(const IndexIterator &itr) const -> bool {
-  return this->leaf_id_ != itr.leaf_id_ || this->index_ != itr.index_ || this->bpm_ != itr.bpm_;
+void INDEXITERATOR_TYPE::SkipLeaf() {
+  this->values_.clear();
+  this->value_index_ = 0;
+  this->index_ = this->is_reverse_ ? -1 : this->leaf_->GetSize();
+  this->Settle();
+}
+
+/*
+ * Plain entries are copied a leaf at a time, posting lists are expanded one
+ * value at a time
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::NextBatch(std::vector<MappingType> *batch, int max_size) -> int {
+  int appended = 0;
+  while (appended < max_size && !this->IsEnd()) {
+    if (!this->leaf_->HasPostingLists() && this->is_reverse_) {
+      auto end = std::max(-1, this->index_ - (max_size - appended));
+      for (int i = this->index_; i > end; i--) {
+        batch->push_back(this->leaf_->GetPairAt(i));
+      }
+      appended += this->index_ - end;
+      this->index_ = end;
+      this->Settle();
+      continue;
+    }
+    if (!this->leaf_->HasPostingLists()) {
+      auto end = std::min(this->leaf_->GetSize(), this->index_ + max_size - appended);
+      for (int i = this->index_; i < end; i++) {
+        batch->push_back(this->leaf_->GetPairAt(i));
+      }
+      appended += end - this->index_;
+      this->index_ = end;
+      this->Settle();
+      continue;
+    }
+    batch->push_back(**this);
+    appended++;
+    ++(*this);
+  }
+  return appended;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const -> bool {
+  if (this->page_ == nullptr || itr.page_ == nullptr) {
+    return this->page_ == itr.page_;
+  }
+  return this->page_->GetPageId() == itr.page_->GetPageId() && this->index_ == itr.index_ &&
+         this->value_index_ == itr.value_index_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Settle() {
+  while (!this->IsEnd() && this->is_reverse_ && this->index_ < 0) {
+    this->MoveToPrevLeaf();
+  }
+  while (!this->IsEnd() && !this->is_reverse_ && this->index_ >= this->leaf_->GetSize()) {
+    this->MoveToNextLeaf();
+  }
+  if (!this->IsEnd()) {
+    this->LoadValues();
+  }
+}
+
+/*
+ * Latch the next leaf before releasing the current one. Writers latch a left
+ * sibling while holding its right neighbour, so waiting for the next leaf
+ * could deadlock: if it is busy, release everything and search the tree again
+ * for the first key after the last one of this leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::MoveToNextLeaf() {
+  auto *bpm = this->tree_->buffer_pool_manager_;
+  auto next_page_id = this->leaf_->GetNextPageId();
+  if (next_page_id == INVALID_PAGE_ID) {
+    this->Release();
+    return;
+  }
+  Page *next_page = bpm->FetchPage(next_page_id);
+  if (next_page != nullptr && next_page->TryRLatch()) {
+    this->Release();
+    this->page_ = next_page;
+    this->leaf_ = reinterpret_cast<LeafPage *>(next_page->GetData());
+    this->index_ = 0;
+    return;
+  }
+  if (next_page != nullptr) {
+    bpm->UnpinPage(next_page_id, false);
+  }
+  if (this->leaf_->GetSize() == 0) {
+    this->Release();
+    return;
+  }
+  KeyType last_key = this->leaf_->KeyAt(this->leaf_->GetSize() - 1);
+  this->Release();
+  this->page_ = this->tree_->FindLeafPageRead(last_key);
+  if (this->page_ == nullptr) {
+    return;
+  }
+  const auto &comparator = this->tree_->comparator_;
+  this->leaf_ = reinterpret_cast<LeafPage *>(this->page_->GetData());
+  this->index_ = this->leaf_->BisectPosition(last_key, comparator) + 1;
+  if (this->index_ < this->leaf_->GetSize() && comparator(this->leaf_->KeyAt(this->index_), last_key) == 0) {
+    this->index_++;
+  }
+}
+
+/*
+ * Same as MoveToNextLeaf the other way round. The previous leaf is latched
+ * while holding this one, so it still links to this leaf and all of its keys
+ * are smaller. Otherwise search the tree again for the last key before the
+ * first key of this leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::MoveToPrevLeaf() {
+  auto *bpm = this->tree_->buffer_pool_manager_;
+  auto prev_page_id = this->leaf_->GetPrevPageId();
+  if (prev_page_id == INVALID_PAGE_ID || this->leaf_->GetSize() == 0) {
+    this->Release();
+    return;
+  }
+  Page *prev_page = bpm->FetchPage(prev_page_id);
+  if (prev_page != nullptr && prev_page->TryRLatch()) {
+    this->Release();
+    this->page_ = prev_page;
+    this->leaf_ = reinterpret_cast<LeafPage *>(prev_page->GetData());
+    this->index_ = this->leaf_->GetSize() - 1;
+    return;
+  }
+  if (prev_page != nullptr) {
+    bpm->UnpinPage(prev_page_id, false);
+  }
+  KeyType first_key = this->leaf_->KeyAt(0);
+  this->Release();
+  this->page_ = this->tree_->FindLeafPageRead(first_key, false, false, true);
+  if (this->page_ == nullptr) {
+    return;
+  }
+  this->leaf_ = reinterpret_cast<LeafPage *>(this->page_->GetData());
+  this->index_ = this->leaf_->BisectPosition(first_key, this->tree_->comparator_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::LoadValues() {
+  if (!this->values_.empty() || !this->leaf_->HasPostingLists()) {
+    return;
+  }
+  auto value = this->leaf_->ValueAt(this->index_);
+  if (LeafPage::IsInlineList(value)) {
+    this->leaf_->GetInlineList(value, &this->values_);
+  } else if (LeafPage::IsOverflowList(value)) {
+    BPlusTreePostingPage::ScanChain(this->tree_->buffer_pool_manager_, value.GetPageId(), [this](const RID &rid) {
+      this->values_.push_back(rid);
+      return true;
+    });
+  }
+  if (this->is_reverse_) {
+    std::reverse(this->values_.begin(), this->values_.end());
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Release() {
+  if (this->page_ == nullptr) {
+    return;
+  }
+  auto page_id = this->page_->GetPageId();
+  this->page_->RUnlatch();
+  this->tree_->buffer_pool_manager_->UnpinPage(page_id, false);
+  this->page_ = nullptr;
+  this->leaf_ = nullptr;
+  this->index_ = 0;
+  this->values_.clear();
+  this->value_index_ = 0;
 }
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
@@ -81,5 +277,7 @@ template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
 template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+template class IndexIterator<GenericKey<128>, RID, GenericComparator<128>>;
+template class IndexIterator<GenericKey<256>, RID, GenericComparator<256>>;
 
 }  // namespace bustub
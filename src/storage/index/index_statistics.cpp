@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_statistics.cpp
+//
+// Identification: src/storage/index/index_statistics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/index_statistics.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+namespace {
+
+// share of values a range is assumed to select when there is no histogram
+constexpr double DEFAULT_SELECTIVITY = 1.0 / 3;
+
+auto IsNumeric(TypeId type) -> bool {
+  switch (type) {
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto ToDouble(const Value &value) -> double { return value.CastAs(TypeId::DECIMAL).GetAs<double>(); }
+
+auto IsLess(const Value &lhs, const Value &rhs) -> bool { return lhs.CompareLessThan(rhs) == CmpBool::CmpTrue; }
+
+}  // namespace
+
+auto IndexStatistics::ValuesPerKey() const -> double {
+  return num_keys_ == 0 ? 0 : static_cast<double>(num_values_) / static_cast<double>(num_keys_);
+}
+
+auto IndexStatistics::EstimateSelectivity(const std::optional<Value> &low, const std::optional<Value> &high) const
+    -> double {
+  if (!low.has_value() && !high.has_value()) {
+    return 1;
+  }
+  if (histogram_counts_.empty()) {
+    return DEFAULT_SELECTIVITY;
+  }
+  uint64_t total = 0;
+  double selected = 0;
+  for (size_t i = 0; i < histogram_counts_.size(); i++) {
+    const auto &lower = histogram_bounds_[i];
+    const auto &upper = histogram_bounds_[i + 1];
+    auto count = static_cast<double>(histogram_counts_[i]);
+    total += histogram_counts_[i];
+    if ((low.has_value() && IsLess(upper, *low)) || (high.has_value() && IsLess(*high, lower))) {
+      continue;
+    }
+    bool covers_lower = !low.has_value() || !IsLess(lower, *low);
+    bool covers_upper = !high.has_value() || !IsLess(*high, upper);
+    if (covers_lower && covers_upper) {
+      selected += count;
+      continue;
+    }
+    double share = 0.5;
+    if (IsNumeric(lower.GetTypeId()) && IsLess(lower, upper)) {
+      auto from = covers_lower ? ToDouble(lower) : ToDouble(*low);
+      auto to = covers_upper ? ToDouble(upper) : ToDouble(*high);
+      share = (to - from) / (ToDouble(upper) - ToDouble(lower));
+    }
+    // a range that reaches into the bucket gets at least the values of one key
+    share = std::clamp(share, std::min(ValuesPerKey() / count, 1.0), 1.0);
+    selected += share * count;
+  }
+  return total == 0 ? 0 : selected / static_cast<double>(total);
+}
+
+}  // namespace bustub
@@ -0,0 +1,206 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_encoding.cpp
+//
+// Identification: src/storage/index/key_encoding.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/key_encoding.h"
+
+#include <string>
+
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+// VARCHAR markers, NULL sorts before every string
+constexpr char NULL_STRING = 0x00;
+constexpr char NON_NULL_STRING = 0x01;
+constexpr char ESCAPED_ZERO = static_cast<char>(0xFF);
+
+void PutByte(char byte, char *data, size_t size, size_t *offset) {
+  if (*offset < size) {
+    data[*offset] = byte;
+  }
+  (*offset)++;
+}
+
+// Fixed size encodings are built in a buffer and copied as far as they fit
+template <typename T>
+void PutInteger(T value, char *data, size_t size, size_t *offset) {
+  char buffer[sizeof(T)];
+  KeyEncoding::WriteInteger<T>(value, buffer);
+  for (char byte : buffer) {
+    PutByte(byte, data, size, offset);
+  }
+}
+
+// Missing bytes of a value that was cut off read as zero
+template <typename T>
+auto GetInteger(const char *data, size_t size, size_t *offset) -> T {
+  char buffer[sizeof(T)] = {};
+  if (*offset < size) {
+    memcpy(buffer, data + *offset, std::min(sizeof(T), size - *offset));
+  }
+  *offset += sizeof(T);
+  return KeyEncoding::ReadInteger<T>(buffer);
+}
+
+}  // namespace
+
+auto KeyEncoding::Encode(const Value &value, char *data, size_t size, size_t offset) -> size_t {
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+      PutInteger<int8_t>(value.GetAs<int8_t>(), data, size, &offset);
+      break;
+    case TypeId::TINYINT:
+      PutInteger<int8_t>(value.GetAs<int8_t>(), data, size, &offset);
+      break;
+    case TypeId::SMALLINT:
+      PutInteger<int16_t>(value.GetAs<int16_t>(), data, size, &offset);
+      break;
+    case TypeId::INTEGER:
+      PutInteger<int32_t>(value.GetAs<int32_t>(), data, size, &offset);
+      break;
+    case TypeId::BIGINT:
+      PutInteger<int64_t>(value.GetAs<int64_t>(), data, size, &offset);
+      break;
+    case TypeId::DECIMAL: {
+      // stored with the sign bit flipped, so the unsigned order of the IEEE bits is the order of the doubles
+      uint64_t bits = 0;
+      if (!value.IsNull()) {
+        // zero and negative zero are the same key
+        auto decimal = value.GetAs<double>() + 0.0;
+        memcpy(&bits, &decimal, sizeof(bits));
+        bits = (bits >> 63) != 0 ? ~bits : bits ^ (uint64_t{1} << 63);
+      }
+      PutInteger<int64_t>(static_cast<int64_t>(bits ^ (uint64_t{1} << 63)), data, size, &offset);
+      break;
+    }
+    case TypeId::TIMESTAMP: {
+      uint64_t bits = value.IsNull() ? 0 : value.GetAs<uint64_t>() + 1;
+      PutInteger<int64_t>(static_cast<int64_t>(bits ^ (uint64_t{1} << 63)), data, size, &offset);
+      break;
+    }
+    case TypeId::VARCHAR: {
+      if (value.IsNull()) {
+        PutByte(NULL_STRING, data, size, &offset);
+        break;
+      }
+      PutByte(NON_NULL_STRING, data, size, &offset);
+      // values built from strings carry their terminating zero, it is not part of the key
+      const char *string = value.GetData();
+      uint32_t length = value.GetLength();
+      if (length > 0 && string[length - 1] == '\0') {
+        length--;
+      }
+      for (uint32_t i = 0; i < length; i++) {
+        PutByte(string[i], data, size, &offset);
+        if (string[i] == '\0') {
+          PutByte(ESCAPED_ZERO, data, size, &offset);
+        }
+      }
+      PutByte('\0', data, size, &offset);
+      PutByte('\0', data, size, &offset);
+      break;
+    }
+    default:
+      UNREACHABLE("Unsupported index key type");
+  }
+  return offset;
+}
+
+auto KeyEncoding::MaxKeySize(const Schema &key_schema) -> size_t {
+  size_t size = 0;
+  for (const auto &column : key_schema.GetColumns()) {
+    switch (column.GetType()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        size += sizeof(int8_t);
+        break;
+      case TypeId::SMALLINT:
+        size += sizeof(int16_t);
+        break;
+      case TypeId::INTEGER:
+        size += sizeof(int32_t);
+        break;
+      case TypeId::BIGINT:
+      case TypeId::DECIMAL:
+      case TypeId::TIMESTAMP:
+        size += sizeof(int64_t);
+        break;
+      case TypeId::VARCHAR:
+        // marker, string and terminator
+        size += 1 + column.GetLength() + 2;
+        break;
+      default:
+        UNREACHABLE("Unsupported index key type");
+    }
+  }
+  return size;
+}
+
+auto KeyEncoding::Decode(TypeId type, const char *data, size_t size, size_t *offset) -> Value {
+  switch (type) {
+    case TypeId::BOOLEAN:
+      return ValueFactory::GetBooleanValue(GetInteger<int8_t>(data, size, offset));
+    case TypeId::TINYINT:
+      return ValueFactory::GetTinyIntValue(GetInteger<int8_t>(data, size, offset));
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(GetInteger<int16_t>(data, size, offset));
+    case TypeId::INTEGER:
+      return ValueFactory::GetIntegerValue(GetInteger<int32_t>(data, size, offset));
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(GetInteger<int64_t>(data, size, offset));
+    case TypeId::DECIMAL: {
+      auto bits = static_cast<uint64_t>(GetInteger<int64_t>(data, size, offset)) ^ (uint64_t{1} << 63);
+      if (bits == 0) {
+        return ValueFactory::GetNullValueByType(TypeId::DECIMAL);
+      }
+      bits = (bits >> 63) != 0 ? bits ^ (uint64_t{1} << 63) : ~bits;
+      double decimal;
+      memcpy(&decimal, &bits, sizeof(decimal));
+      return ValueFactory::GetDecimalValue(decimal);
+    }
+    case TypeId::TIMESTAMP: {
+      auto bits = static_cast<uint64_t>(GetInteger<int64_t>(data, size, offset)) ^ (uint64_t{1} << 63);
+      return ValueFactory::GetTimestampValue(static_cast<int64_t>(bits - 1));
+    }
+    case TypeId::VARCHAR: {
+      if (*offset >= size || data[*offset] == NULL_STRING) {
+        (*offset)++;
+        return ValueFactory::GetNullValueByType(TypeId::VARCHAR);
+      }
+      (*offset)++;
+      std::string string;
+      while (*offset < size) {
+        char byte = data[(*offset)++];
+        if (byte != '\0') {
+          string.push_back(byte);
+          continue;
+        }
+        if (*offset < size && data[*offset] == ESCAPED_ZERO) {
+          string.push_back('\0');
+          (*offset)++;
+          continue;
+        }
+        (*offset)++;
+        break;
+      }
+      return ValueFactory::GetVarcharValue(string);
+    }
+    default:
+      UNREACHABLE("Unsupported index key type");
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_epsilon_tree_internal_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/page/b_epsilon_tree_internal_page.h"
+
+namespace bustub {
+
+/*
+ * Init method after creating a new internal page, it starts without pivots
+ * and with an empty buffer
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  static_assert(sizeof(BPlusTreePage) + sizeof(int) == B_EPSILON_INTERNAL_PAGE_HEADER_SIZE,
+                "b-epsilon tree internal page header size changed");
+  BUSTUB_ASSERT(max_size >= 2 && max_size <= MaxFanout(), "invalid b-epsilon tree fanout");
+  this->SetPageId(page_id);
+  this->SetSize(0);
+  this->SetPageType(IndexPageType::INTERNAL_PAGE);
+  this->SetParentPageId(parent_id);
+  this->SetMaxSize(max_size);
+  this->ResetVersion();
+  this->buffer_size_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::MaxFanout() -> int {
+  return static_cast<int>((BUSTUB_PAGE_SIZE - B_EPSILON_INTERNAL_PAGE_HEADER_SIZE) /
+                          (sizeof(Pivot) + sizeof(Message)));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType { return PivotArray()[index].first; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> page_id_t { return PivotArray()[index].second; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::LookUpIndex(const KeyType &key, const KeyComparator &comparator) const
+    -> int {
+  // first pivot in [1, size) with a key larger than key, the child is the one before it
+  const auto *pivots = PivotArray();
+  int left = 1;
+  int right = this->GetSize();
+  while (left < right) {
+    int middle = left + (right - left) / 2;
+    if (comparator(pivots[middle].first, key) <= 0) {
+      left = middle + 1;
+    } else {
+      right = middle;
+    }
+  }
+  return left - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::GetBufferSize() const -> int { return buffer_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::GetBufferCapacity() const -> int {
+  return static_cast<int>((BUSTUB_PAGE_SIZE - B_EPSILON_INTERNAL_PAGE_HEADER_SIZE -
+                           this->GetMaxSize() * sizeof(Pivot)) /
+                          sizeof(Message));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::FindMessage(const KeyType &key, const KeyComparator &comparator) const
+    -> const Message * {
+  const auto *messages = MessageArray();
+  const auto *message =
+      std::lower_bound(messages, messages + buffer_size_, key,
+                       [&comparator](const Message &a, const KeyType &b) { return comparator(a.key_, b) < 0; });
+  if (message == messages + buffer_size_ || comparator(message->key_, key) != 0) {
+    return nullptr;
+  }
+  return message;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::LoadPivots(std::vector<Pivot> *pivots) const {
+  pivots->assign(PivotArray(), PivotArray() + this->GetSize());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::StorePivots(const std::vector<Pivot> &pivots) {
+  BUSTUB_ASSERT(static_cast<int>(pivots.size()) <= this->GetMaxSize(), "too many pivots");
+  std::copy(pivots.begin(), pivots.end(), PivotArray());
+  this->SetSize(static_cast<int>(pivots.size()));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::LoadBuffer(std::vector<Message> *messages) const {
+  messages->assign(MessageArray(), MessageArray() + buffer_size_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::StoreBuffer(const std::vector<Message> &messages) {
+  BUSTUB_ASSERT(static_cast<int>(messages.size()) <= GetBufferCapacity(), "too many messages");
+  std::copy(messages.begin(), messages.end(), MessageArray());
+  buffer_size_ = static_cast<int>(messages.size());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::PivotArray() const -> const Pivot * {
+  return reinterpret_cast<const Pivot *>(data_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::PivotArray() -> Pivot * { return reinterpret_cast<Pivot *>(data_); }
+
+// the buffer starts right after room for max size pivots
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::MessageArray() const -> const Message * {
+  return reinterpret_cast<const Message *>(data_ + this->GetMaxSize() * sizeof(Pivot));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::MessageArray() -> Message * {
+  return reinterpret_cast<Message *>(data_ + this->GetMaxSize() * sizeof(Pivot));
+}
+
+template class BEpsilonTreeInternalPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class BEpsilonTreeInternalPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class BEpsilonTreeInternalPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class BEpsilonTreeInternalPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class BEpsilonTreeInternalPage<GenericKey<64>, RID, GenericComparator<64>>;
+}  // namespace bustub
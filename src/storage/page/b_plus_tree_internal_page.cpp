@@ -9,8 +9,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
@@ -19,6 +21,9 @@
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
+
+#define UNPREFIXED_KEY_FLAG 0x8000
+
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -29,29 +34,55 @@ namespace bustub {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  static_assert(sizeof(Slot) == INTERNAL_PAGE_SLOT_SIZE, "internal page slot size changed");
+  static_assert(sizeof(B_PLUS_TREE_INTERNAL_PAGE_TYPE) == INTERNAL_PAGE_HEADER_SIZE + INTERNAL_PAGE_SLOT_SIZE,
+                "internal page header size changed");
+  static_assert(sizeof(KeyType) < UNPREFIXED_KEY_FLAG, "key too large for an internal page slot");
   this->SetPageId(page_id);
   this->SetSize(1);
   this->SetPageType(IndexPageType::INTERNAL_PAGE);
   this->SetParentPageId(parent_id);
   this->SetMaxSize(max_size);
+  this->ResetVersion();
+  this->prefix_size_ = 0;
+  this->heap_begin_ = BUSTUB_PAGE_SIZE;
+  this->key_bytes_ = 0;
+  this->slots_[0] = Slot{INVALID_PAGE_ID, 0, 0};
 }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
- * array offset)
+ * array offset). Sizes and offsets are clamped so that optimistic readers
+ * seeing a torn page never read outside of it.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  MappingType k_v = this->array_[index];
-  return k_v.first;
+  KeyType key{};
+  auto *data = reinterpret_cast<char *>(&key);
+  const Slot &slot = this->slots_[index];
+  int prefix_size = 0;
+  if ((slot.key_size_ & UNPREFIXED_KEY_FLAG) == 0) {
+    prefix_size = std::min(static_cast<int>(this->prefix_size_), static_cast<int>(sizeof(KeyType)));
+    memcpy(data, reinterpret_cast<const char *>(this) + BUSTUB_PAGE_SIZE - prefix_size, prefix_size);
+  }
+  auto size = std::min(slot.key_size_ & ~UNPREFIXED_KEY_FLAG, static_cast<int>(sizeof(KeyType)) - prefix_size);
+  auto offset = std::min(static_cast<int>(slot.key_offset_), BUSTUB_PAGE_SIZE - size);
+  memcpy(data + prefix_size, reinterpret_cast<const char *>(this) + offset, size);
+  return key;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { this->array_[index].first = key; }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  // the first key is never used, so it is not stored either
+  if (index == 0) {
+    return;
+  }
+  this->ReleaseKey(index);
+  this->StoreKey(index, key);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const page_id_t &value) {
-  this->array_[index].second = value;
+  this->slots_[index].page_id_ = value;
 }
 
 /*
@@ -59,28 +90,32 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const page_id_t &valu
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
-  MappingType k_v = this->array_[index];
-  return k_v.second;
-}
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return this->slots_[index].page_id_; }
+
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Bisect(KeyType const &key, page_id_t *page_id,
                                             KeyComparator const &comparator) const -> bool {
   auto index = this->BisectPosition(key, comparator);
-  if (comparator(this->array_[index + 1].first, key) == 0) {
-    *page_id = this->array_[index].second;
+  if (index + 1 < this->GetSize() && comparator(this->KeyAt(index + 1), key) == 0) {
+    *page_id = this->ValueAt(index);
     return true;
   }
   return false;
 }
+
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAt(int index, KeyType const &key, page_id_t const &page_id) -> void {
-  for (int i = this->GetSize() - 1; i >= index; i--) {
-    this->array_[i + 1] = this->array_[i];
+  // the new slot must not run into the lowest keys of the heap
+  if (this->heap_begin_ < INTERNAL_PAGE_HEADER_SIZE + (this->GetSize() + 1) * INTERNAL_PAGE_SLOT_SIZE) {
+    this->Compact();
   }
-  this->array_[index].first = key;
-  this->array_[index].second = page_id;
+  memmove(static_cast<void *>(&this->slots_[index + 1]), static_cast<void *>(&this->slots_[index]),
+          (this->GetSize() - index) * sizeof(Slot));
+  this->slots_[index] = Slot{page_id, 0, 0};
   this->IncrementSize();
+  if (index > 0) {
+    this->StoreKey(index, key);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -90,7 +125,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::BisectPosition(KeyType const &key, KeyCompa
   auto r = size;
   while (l + 1 < r) {
     auto mid = (l + r) / 2;
-    if (comparator(this->array_[mid].first, key) < 0) {
+    if (comparator(this->KeyAt(mid), key) < 0) {
       l = mid;
     } else {
       r = mid;
@@ -98,10 +133,60 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::BisectPosition(KeyType const &key, KeyCompa
   }
   return l;
 }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookUp(KeyType const &key, KeyComparator const &comparator) const -> ValueType {
+  return this->slots_[this->LookUpIndex(key, comparator)].page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookUpIndex(KeyType const &key, KeyComparator const &comparator) const -> int {
+  // find the first index whose key is greater than the target, the first key is ignored.
+  // size is clamped so that optimistic readers seeing a torn page stay inside of it
+  auto l = 1;
+  auto r = std::min(this->GetSize(), static_cast<int>(INTERNAL_PAGE_SIZE));
+  while (l < r) {
+    auto mid = (l + r) / 2;
+    if (comparator(this->KeyAt(mid), key) <= 0) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  return l - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookUpBefore(KeyType const &key, KeyComparator const &comparator) const
+    -> ValueType {
+  // find the first index whose key is not smaller than the target, the first key is ignored.
+  auto l = 1;
+  auto r = std::min(this->GetSize(), static_cast<int>(INTERNAL_PAGE_SIZE));
+  while (l < r) {
+    auto mid = (l + r) / 2;
+    if (comparator(this->KeyAt(mid), key) < 0) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  return this->slots_[l - 1].page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int {
+  for (int i = 0; i < this->GetSize(); i++) {
+    if (this->slots_[i].page_id_ == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::UpdateChildrenPointers(BufferPoolManager *bpm) -> void {
   for (int i = 0; i < this->GetSize(); i++) {
-    auto id = this->array_[i].second;
+    auto id = this->slots_[i].page_id_;
     Page *page_with_page_type = bpm->FetchPage(id);
     auto *page = reinterpret_cast<BPlusTreePage *>(page_with_page_type);
     bool is_dirty = false;
@@ -119,113 +204,213 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::IncrementSize() -> void { this->SetSize(thi
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::DecrementSize() -> void { this->SetSize(this->GetSize() - 1); }
 
-INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RedistributeFrom(
-    BPlusTreeInternalPage<KeyType, ValueType, KeyComparator> *from_page, int index) -> void {
-  auto limit = from_page->GetSize();
-  for (int i = 1; i + index - 1 < limit; i++) {
-    // It should be i + index - 1 here. Important!
-    this->array_[i] = from_page->GetPairAt(i + index - 1);
-    this->IncrementSize();
-    from_page->DecrementSize();
-  }
-}
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAt(int index) -> KeyType {
   auto return_key = this->KeyAt(index);
-  for (int i = index; i < this->GetSize() - 1; i++) {
-    this->array_[i] = this->array_[i + 1];
-  }
+  this->ReleaseKey(index);
+  memmove(static_cast<void *>(&this->slots_[index]), static_cast<void *>(&this->slots_[index + 1]),
+          (this->GetSize() - index - 1) * sizeof(Slot));
   this->DecrementSize();
   return return_key;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Rearrange() -> KeyType {
-  auto return_key = this->array_[1].first;
-  this->array_[0].second = this->array_[1].second;
-  this->RemoveAt(1);
-  return return_key;
+  this->slots_[0].page_id_ = this->slots_[1].page_id_;
+  return this->RemoveAt(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetPairAt(int index) const -> MappingType {
+  return {this->KeyAt(index), this->ValueAt(index)};
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetPairAt(int index) const -> MappingType { return this->array_[index]; }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Assign(const std::pair<KeyType, page_id_t> *entries, int count) {
+  std::vector<KeyType> keys;
+  keys.reserve(count);
+  for (int i = 1; i < count; i++) {
+    keys.push_back(entries[i].first);
+  }
+  // the heap is rebuilt first, more slots than before may cover the old prefix
+  this->SetSize(count);
+  this->slots_[0].key_offset_ = 0;
+  this->slots_[0].key_size_ = 0;
+  this->Rebuild(keys);
+  for (int i = 0; i < count; i++) {
+    this->slots_[i].page_id_ = entries[i].second;
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::StealOrMerge(bool *is_merge, bool *is_right, BufferPoolManager *bpm,
-                                                  KeyComparator &cmp, page_id_t *sibling_page_id, int *sibling_index)
-    -> void {
-  page_id_t parent_id = this->GetParentPageId();
-  Page *parent_page = bpm->FetchPage(parent_id);
-  auto *parent = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(parent_page->GetData());
-  // int index = parent->BisectPosition(this->KeyAt(1), cmp);
-  // if (index + 1 < parent->GetSize() && cmp(parent->KeyAt(index + 1), this->KeyAt(1)) == 0) {
-  //   index = index + 1;
-  // }
-  int index = -1;
-  for (int i = 0; i < parent->GetSize(); i++) {
-    if (parent->ValueAt(i) == this->GetPageId()) {
-      index = i;
-      break;
-    }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Compact() {
+  std::vector<KeyType> keys;
+  keys.reserve(this->GetSize());
+  for (int i = 1; i < this->GetSize(); i++) {
+    keys.push_back(this->KeyAt(i));
   }
-  int left_index = index - 1;
-  int right_index = index + 1;
-  if (left_index < 0) {
-    // Must do something from right
-    *is_right = true;
-    *sibling_index = right_index;
-    Page *right_page = bpm->FetchPage(parent->ValueAt(right_index));
-    auto *right = reinterpret_cast<BPlusTreeInternalPage<KeyType, ValueType, KeyComparator> *>(right_page->GetData());
-    *sibling_page_id = right->GetPageId();
-    if (right->GetSize() == right->GetMinSize()) {
-      *is_merge = true;
-    } else {
-      *is_merge = false;
+  this->Rebuild(keys);
+}
+
+/*
+ * Rewrite the key heap from scratch with either the current prefix or the
+ * longest one shared by all keys, whichever takes less space. Keeping the
+ * current one never takes more than the space accounted for so far.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Rebuild(const std::vector<KeyType> &keys) {
+  KeyType current_prefix{};
+  auto current_prefix_size = std::min(static_cast<int>(this->prefix_size_), static_cast<int>(sizeof(KeyType)));
+  memcpy(reinterpret_cast<char *>(&current_prefix), this->KeyPrefix(), current_prefix_size);
+  // shared prefix, never longer than the first key since keys are zero padded
+  int shared_prefix_size = keys.empty() ? 0 : KeySignificantSize(keys.front());
+  for (size_t i = 1; i < keys.size() && shared_prefix_size > 0; i++) {
+    int common = 0;
+    while (common < shared_prefix_size &&
+           reinterpret_cast<const char *>(&keys.front())[common] == reinterpret_cast<const char *>(&keys[i])[common]) {
+      common++;
     }
-    bpm->UnpinPage(parent_id, false);
-    bpm->UnpinPage(right->GetPageId(), false);
-    return;
+    shared_prefix_size = common;
   }
-  if (right_index >= parent->GetSize()) {
-    // Must do something from left
-    *is_right = false;
-    *sibling_index = left_index;
-    Page *left_page = bpm->FetchPage(parent->ValueAt(left_index));
-    auto *left = reinterpret_cast<BPlusTreeInternalPage<KeyType, ValueType, KeyComparator> *>(left_page->GetData());
-    *sibling_page_id = left->GetPageId();
-    if (left->GetSize() == left->GetMinSize()) {
-      *is_merge = true;
-    } else {
-      *is_merge = false;
+  auto heap_size = [&keys](const KeyType &prefix, int prefix_size) {
+    auto bytes = prefix_size;
+    for (const auto &key : keys) {
+      bool is_prefixed = memcmp(&key, &prefix, prefix_size) == 0;
+      bytes += std::max(KeySignificantSize(key) - (is_prefixed ? prefix_size : 0), 0);
     }
-    bpm->UnpinPage(parent_id, false);
-    bpm->UnpinPage(left->GetPageId(), false);
+    return bytes;
+  };
+  const KeyType *prefix = &current_prefix;
+  auto prefix_size = current_prefix_size;
+  if (!keys.empty() && heap_size(keys.front(), shared_prefix_size) <= heap_size(current_prefix, current_prefix_size)) {
+    prefix = &keys.front();
+    prefix_size = shared_prefix_size;
+  }
+
+  this->prefix_size_ = prefix_size;
+  this->heap_begin_ = BUSTUB_PAGE_SIZE - prefix_size;
+  this->key_bytes_ = prefix_size;
+  memcpy(reinterpret_cast<char *>(this) + this->heap_begin_, prefix, prefix_size);
+  for (size_t i = 0; i < keys.size(); i++) {
+    this->WriteKey(static_cast<int>(i) + 1, keys[i]);
+  }
+  BUSTUB_ASSERT(this->heap_begin_ >= INTERNAL_PAGE_HEADER_SIZE + this->GetSize() * INTERNAL_PAGE_SLOT_SIZE,
+                "Internal page overflow");
+}
+
+/*****************************************************************************
+ * SPACE ACCOUNTING
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::EntrySize(const KeyType &key) -> int {
+  return INTERNAL_PAGE_SLOT_SIZE + KeySignificantSize(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetUsedBytes() const -> int {
+  return this->GetSize() * INTERNAL_PAGE_SLOT_SIZE + this->key_bytes_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FreeBytes() const -> int {
+  return INTERNAL_PAGE_USABLE_SIZE - this->GetUsedBytes();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const -> bool {
+  return this->GetSize() < this->GetMaxSize() && this->FreeBytes() >= EntrySize(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanSetKeyAt(int index, const KeyType &key) const -> bool {
+  auto released = index == 0 ? 0 : this->slots_[index].key_size_ & ~UNPREFIXED_KEY_FLAG;
+  return this->FreeBytes() + released >= KeySignificantSize(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsFull() const -> bool {
+  return this->GetSize() >= this->GetMaxSize() ||
+         this->FreeBytes() < INTERNAL_PAGE_SLOT_SIZE + static_cast<int>(sizeof(KeyType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderflow() const -> bool {
+  if (this->GetSize() >= this->GetMinSize()) {
+    return false;
+  }
+  return this->IsRootPage() || this->GetUsedBytes() * 2 < INTERNAL_PAGE_USABLE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanLendEntry() const -> bool {
+  if (this->GetSize() > this->GetMinSize()) {
+    return true;
+  }
+  // the root shrinks by count only, it may have to be replaced by its child
+  auto largest_entry = INTERNAL_PAGE_SLOT_SIZE + static_cast<int>(sizeof(KeyType));
+  return !this->IsRootPage() && (this->GetUsedBytes() - largest_entry) * 2 >= INTERNAL_PAGE_USABLE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMergeWith(const BPlusTreeInternalPage *right_page,
+                                                  const KeyType &separator) const -> bool {
+  if (this->GetSize() + right_page->GetSize() > this->GetMaxSize()) {
+    return false;
+  }
+  // keys of the right page may lose its prefix once moved
+  auto bytes = this->GetUsedBytes() + EntrySize(separator);
+  for (int i = 1; i < right_page->GetSize(); i++) {
+    bytes += EntrySize(right_page->KeyAt(i));
+  }
+  return bytes <= INTERNAL_PAGE_USABLE_SIZE;
+}
+
+/*
+ * The heap is rebuilt when there is not enough contiguous free space left,
+ * which may also find a new prefix.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::StoreKey(int index, const KeyType &key) {
+  auto slots_end = INTERNAL_PAGE_HEADER_SIZE + this->GetSize() * INTERNAL_PAGE_SLOT_SIZE;
+  if (this->heap_begin_ - slots_end >= KeySignificantSize(key)) {
+    this->WriteKey(index, key);
     return;
   }
-  Page *left_page = bpm->FetchPage(parent->ValueAt(left_index));
-  Page *right_page = bpm->FetchPage(parent->ValueAt(right_index));
-  auto *left = reinterpret_cast<BPlusTreeInternalPage<KeyType, ValueType, KeyComparator> *>(left_page->GetData());
-  auto *right = reinterpret_cast<BPlusTreeInternalPage<KeyType, ValueType, KeyComparator> *>(right_page->GetData());
-  if (left->GetSize() == left->GetMinSize() && right->GetSize() == right->GetMinSize()) {
-    *is_merge = true;
-    *is_right = true;
-    *sibling_index = right_index;
-    *sibling_page_id = right->GetPageId();
-  } else {
-    *is_merge = false;
-    *is_right = (left->GetSize() == left->GetMinSize() || right->GetSize() > right->GetMinSize());
-    if (*is_right) {
-      *sibling_page_id = right->GetPageId();
-      *sibling_index = right_index;
-    } else {
-      *sibling_page_id = left->GetPageId();
-      *sibling_index = left_index;
-    }
+  std::vector<KeyType> keys;
+  keys.reserve(this->GetSize());
+  for (int i = 1; i < this->GetSize(); i++) {
+    keys.push_back(i == index ? key : this->KeyAt(i));
   }
-  bpm->UnpinPage(parent_id, false);
-  bpm->UnpinPage(left->GetPageId(), false);
-  bpm->UnpinPage(right->GetPageId(), false);
+  this->Rebuild(keys);
+}
+
+/*
+ * Keys sharing the page prefix only store the rest of their bytes. The caller
+ * makes sure the heap has room for the key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::WriteKey(int index, const KeyType &key) {
+  const auto *data = reinterpret_cast<const char *>(&key);
+  bool is_prefixed = memcmp(data, this->KeyPrefix(), this->prefix_size_) == 0;
+  auto begin = is_prefixed ? static_cast<int>(this->prefix_size_) : 0;
+  auto size = std::max(KeySignificantSize(key) - begin, 0);
+  this->heap_begin_ -= size;
+  memcpy(reinterpret_cast<char *>(this) + this->heap_begin_, data + begin, size);
+  this->slots_[index].key_offset_ = this->heap_begin_;
+  this->slots_[index].key_size_ = is_prefixed ? size : (size | UNPREFIXED_KEY_FLAG);
+  this->key_bytes_ += size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::ReleaseKey(int index) {
+  this->key_bytes_ -= this->slots_[index].key_size_ & ~UNPREFIXED_KEY_FLAG;
+  this->slots_[index].key_offset_ = 0;
+  this->slots_[index].key_size_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyPrefix() const -> const char * {
+  return reinterpret_cast<const char *>(this) + BUSTUB_PAGE_SIZE - this->prefix_size_;
 }
 
 // valuetype for internalNode should be page id_t
@@ -234,4 +419,6 @@ template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator
 template class BPlusTreeInternalPage<GenericKey<16>, page_id_t, GenericComparator<16>>;
 template class BPlusTreeInternalPage<GenericKey<32>, page_id_t, GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+template class BPlusTreeInternalPage<GenericKey<128>, page_id_t, GenericComparator<128>>;
+template class BPlusTreeInternalPage<GenericKey<256>, page_id_t, GenericComparator<256>>;
 }  // namespace bustub
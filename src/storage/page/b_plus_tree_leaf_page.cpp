@@ -9,7 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -19,6 +21,7 @@
 #include "common/macros.h"
 #include "common/rid.h"
 #include "storage/index/index_iterator.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 #include "storage/page/b_plus_tree_page.h"
 #include "storage/page/page.h"
@@ -29,22 +32,42 @@ namespace bustub {
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
 
+namespace {
+
+// an inline posting list is referred to by RID(INVALID_PAGE_ID, offset << 16 | size)
+auto InlineListOffset(const RID &value) -> int { return static_cast<int>(value.GetSlotNum() >> 16); }
+auto InlineListSize(const RID &value) -> int { return static_cast<int>(value.GetSlotNum() & 0xffff); }
+auto MakeInlineList(int offset, int size) -> RID {
+  return {INVALID_PAGE_ID, static_cast<uint32_t>(offset) << 16 | static_cast<uint32_t>(size)};
+}
+
+}  // namespace
+
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * next/prev page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, bool has_posting_lists) {
+  // a split leaves both halves with room for another entry
+  static_assert(sizeof(Slot) + sizeof(KeyType) <= LEAF_PAGE_USABLE_SIZE / 4, "key too large for a leaf page");
   this->SetPageId(page_id);
   this->SetSize(0);
   this->SetPageType(IndexPageType::LEAF_PAGE);
   this->SetParentPageId(parent_id);
   this->SetMaxSize(max_size);
+  this->ResetVersion();
+  this->next_page_id_ = INVALID_PAGE_ID;
+  this->prev_page_id_ = INVALID_PAGE_ID;
+  this->heap_begin_ = BUSTUB_PAGE_SIZE;
+  this->heap_size_ = 0;
+  this->tail_bytes_ = 0;
+  this->has_posting_lists_ = has_posting_lists ? 1 : 0;
 }
 
 /**
- * Helper methods to set/get next page id
+ * Helper methods to set/get next/prev page id
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return this->next_page_id_; }
@@ -52,23 +75,33 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return thi
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { this->next_page_id_ = next_page_id; }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetPrevPageId() const -> page_id_t { return this->prev_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetPrevPageId(page_id_t prev_page_id) { this->prev_page_id_ = prev_page_id; }
+
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
- * array offset)
+ * array offset). The tail of a long key is clamped so that optimistic readers
+ * seeing a torn page never read outside of it.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  MappingType k_v = this->array_[index];
-  return k_v.first;
+  KeyType key{};
+  auto *data = reinterpret_cast<char *>(&key);
+  const Slot &slot = this->slots_[index];
+  memcpy(data, slot.key_head_, sizeof(slot.key_head_));
+  if constexpr (HAS_KEY_TAIL) {
+    auto size = std::min(static_cast<int>(slot.tail_size_), static_cast<int>(sizeof(KeyType) - sizeof(slot.key_head_)));
+    auto offset = std::min(static_cast<int>(slot.tail_offset_), BUSTUB_PAGE_SIZE - size);
+    memcpy(data + sizeof(slot.key_head_), reinterpret_cast<const char *>(this) + offset, size);
+  }
+  return key;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
-  // replace with your own code
-  MappingType k_v = this->array_[index];
-  return k_v.second;
-}
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType { return this->slots_[index].value_; }
 
 /*
  * Bisect for leaf page
@@ -76,11 +109,10 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Bisect(KeyType const &key, ValueType *value, KeyComparator const &comparator) const
     -> bool {
-  // replace with your own code
-  auto index = this->BisectPosition(key, comparator);
-  // std::cout << this->array_[index + 1].first << std::endl;
-  if (comparator(this->array_[index + 1].first, key) == 0) {
-    *value = this->array_[index].second;
+  auto index = this->BisectPosition(key, comparator) + 1;
+  auto size = std::min(this->GetSize(), static_cast<int>(LEAF_PAGE_SIZE));
+  if (index < size && comparator(this->KeyAt(index), key) == 0) {
+    *value = this->slots_[index].value_;
     return true;
   }
   return false;
@@ -88,13 +120,21 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Bisect(KeyType const &key, ValueType *value, Ke
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::BisectPosition(KeyType const &key, KeyComparator const &comparator) const -> int {
-  // replace with your own code
-  auto size = GetSize();
+  // size is clamped so that optimistic readers seeing a torn page stay inside of it
+  auto size = std::min(GetSize(), static_cast<int>(LEAF_PAGE_SIZE));
+  // integer keys are compared in place, several at a time
+  auto integer_type = IntegerKeyTypeOf(comparator);
+  if (integer_type != TypeId::INVALID) {
+    auto integer_key = KeyEncoding::ReadInteger(reinterpret_cast<const char *>(&key), integer_type);
+    auto index = KeySearch::LowerBound(reinterpret_cast<const char *>(this->slots_), sizeof(Slot), size, integer_key,
+                                       integer_type);
+    return index - 1;
+  }
   auto l = -1;
   auto r = size;
   while (l + 1 < r) {
     auto mid = (l + r) / 2;
-    if (comparator(this->array_[mid].first, key) < 0) {
+    if (comparator(this->KeyAt(mid), key) < 0) {
       l = mid;
     } else {
       r = mid;
@@ -102,15 +142,31 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::BisectPosition(KeyType const &key, KeyComparato
   }
   return l;
 }
+
+/*
+ * The caller must make sure the entry fits, see GetFreeBytes
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, KeyType const &key, ValueType const &value) -> void {
-  for (int i = this->GetSize() - 1; i >= index; i--) {
-    this->array_[i + 1] = this->array_[i];
+  auto tail_size = TailSize(key);
+  this->ReserveEntry(tail_size);
+  memmove(static_cast<void *>(&this->slots_[index + 1]), static_cast<void *>(&this->slots_[index]),
+          (this->GetSize() - index) * sizeof(Slot));
+  Slot &slot = this->slots_[index];
+  memcpy(slot.key_head_, &key, sizeof(slot.key_head_));
+  slot.value_ = value;
+  if constexpr (HAS_KEY_TAIL) {
+    this->heap_begin_ -= tail_size;
+    this->heap_size_ += tail_size;
+    this->tail_bytes_ += tail_size;
+    const auto *tail = reinterpret_cast<const char *>(&key) + sizeof(slot.key_head_);
+    memcpy(reinterpret_cast<char *>(this) + this->heap_begin_, tail, tail_size);
+    slot.tail_offset_ = this->heap_begin_;
+    slot.tail_size_ = tail_size;
   }
-  this->array_[index].first = key;
-  this->array_[index].second = value;
   this->IncrementSize();
 }
+
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::IncrementSize() -> void { this->SetSize(this->GetSize() + 1); }
 
@@ -120,9 +176,15 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::DecrementSize() -> void { this->SetSize(this->G
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAt(int index) -> KeyType {
   auto return_key = this->KeyAt(index);
-  for (int i = index; i < this->GetSize() - 1; i++) {
-    this->array_[i] = this->array_[i + 1];
+  if (this->HasPostingLists()) {
+    this->ReleaseInlineList(this->slots_[index].value_);
+  }
+  if constexpr (HAS_KEY_TAIL) {
+    this->tail_bytes_ -= this->slots_[index].tail_size_;
+    this->ReleaseHeapBytes(this->slots_[index].tail_size_);
   }
+  memmove(static_cast<void *>(&this->slots_[index]), static_cast<void *>(&this->slots_[index + 1]),
+          (this->GetSize() - index - 1) * sizeof(Slot));
   this->DecrementSize();
   return return_key;
 }
@@ -131,10 +193,11 @@ INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::RedistributeFrom(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *from_page,
                                                   int index) -> void {
   auto limit = from_page->GetSize();
-  for (int i = 0; i + index < limit; i++) {
-    this->array_[i] = from_page->GetPairAt(i + index);
-    this->IncrementSize();
-    from_page->DecrementSize();
+  for (int i = index; i < limit; i++) {
+    this->InsertFrom(this->GetSize(), from_page, i);
+  }
+  while (from_page->GetSize() > index) {
+    from_page->RemoveAt(from_page->GetSize() - 1);
   }
 }
 
@@ -145,9 +208,10 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::MergeWith(BPlusTreeLeafPage<KeyType, ValueType,
   auto offset = this->GetSize();
   if (is_right) {
     for (int i = 0; i < limit; i++) {
-      this->array_[i + offset] = from_page->GetPairAt(i);
-      this->IncrementSize();
-      from_page->DecrementSize();
+      this->InsertFrom(this->GetSize(), from_page, i);
+    }
+    while (from_page->GetSize() > 0) {
+      from_page->RemoveAt(from_page->GetSize() - 1);
     }
     BUSTUB_ASSERT(this->GetSize() == limit + offset, "No");
     BUSTUB_ASSERT(from_page->GetSize() == 0, "No");
@@ -159,91 +223,252 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::MergeWith(BPlusTreeLeafPage<KeyType, ValueType,
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::StealOrMerge(bool *is_merge, bool *is_right, BufferPoolManager *bpm,
-                                              KeyComparator &cmp, page_id_t *sibling_page_id, int *sibling_index)
-    -> void {
-  page_id_t parent_id = this->GetParentPageId();
-  Page *parent_page = bpm->FetchPage(parent_id);
-  auto *parent = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(parent_page->GetData());
-  // int index = parent->BisectPosition(this->KeyAt(0), cmp);
-  // if (cmp(parent->KeyAt(index + 1), this->KeyAt(0)) == 0) {
-  //   index = index + 1;
-  // }
-  int index = -1;
-  for (int i = 0; i < parent->GetSize(); i++) {
-    if (parent->ValueAt(i) == this->GetPageId()) {
-      index = i;
-      break;
-    }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Assign(const MappingType *entries, int count) {
+  this->SetSize(0);
+  this->heap_begin_ = BUSTUB_PAGE_SIZE;
+  this->heap_size_ = 0;
+  this->tail_bytes_ = 0;
+  for (int i = 0; i < count; i++) {
+    this->InsertAt(i, entries[i].first, entries[i].second);
   }
-  int left_index = index - 1;
-  int right_index = index + 1;
-  if (left_index < 0) {
-    // Must do something from right
-    *is_right = true;
-    *sibling_index = right_index;
-    Page *right_page = bpm->FetchPage(parent->ValueAt(right_index));
-    auto *right = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(right_page->GetData());
-    *sibling_page_id = right->GetPageId();
-    if (right->GetSize() == right->GetMinSize()) {
-      *is_merge = true;
-    } else {
-      *is_merge = false;
-    }
-    bpm->UnpinPage(parent_id, false);
-    bpm->UnpinPage(right->GetPageId(), false);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetPairAt(int index) const -> MappingType {
+  return {this->KeyAt(index), this->ValueAt(index)};
+}
+
+/*****************************************************************************
+ * SPACE ACCOUNTING
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::TailSize(const KeyType &key) -> int {
+  if constexpr (HAS_KEY_TAIL) {
+    return std::max(KeySignificantSize(key) - LEAF_PAGE_KEY_HEAD_SIZE, 0);
+  }
+  return 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::EntrySize(const KeyType &key) -> int {
+  return static_cast<int>(sizeof(Slot)) + TailSize(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::LargestEntrySize() -> int {
+  auto largest_tail = HAS_KEY_TAIL ? static_cast<int>(sizeof(KeyType)) - LEAF_PAGE_KEY_HEAD_SIZE : 0;
+  return static_cast<int>(sizeof(Slot)) + largest_tail;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetUsedBytes() const -> int {
+  return this->GetSize() * static_cast<int>(sizeof(Slot)) + this->tail_bytes_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsOverflow() const -> bool {
+  return this->GetSize() >= this->GetMaxSize() || this->GetUsedBytes() + LargestEntrySize() > LEAF_PAGE_USABLE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsFull() const -> bool {
+  return this->GetSize() + 1 >= this->GetMaxSize() ||
+         this->GetUsedBytes() + 2 * LargestEntrySize() > LEAF_PAGE_USABLE_SIZE;
+}
+
+/*
+ * Below merge_fill of max size and of the usable bytes. Empty leaves always
+ * underflow, so a tree never keeps one however lazily it merges.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetMergeSize(double merge_fill) const -> int {
+  if (this->IsRootPage()) {
+    return this->GetMinSize();
+  }
+  return std::max(1, static_cast<int>(this->GetMaxSize() * merge_fill));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderflow(double merge_fill) const -> bool {
+  if (this->GetSize() >= this->GetMergeSize(merge_fill)) {
+    return false;
+  }
+  return this->GetSize() == 0 || this->IsRootPage() || this->GetUsedBytes() < merge_fill * LEAF_PAGE_USABLE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CanLendEntry(double merge_fill) const -> bool {
+  if (this->GetSize() > this->GetMergeSize(merge_fill)) {
+    return true;
+  }
+  return !this->IsRootPage() && this->GetSize() > 1 &&
+         this->GetUsedBytes() - LargestEntrySize() >= merge_fill * LEAF_PAGE_USABLE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CanMergeWith(const BPlusTreeLeafPage *right_page) const -> bool {
+  return this->GetSize() + right_page->GetSize() < this->GetMaxSize() &&
+         this->GetUsedBytes() + right_page->GetUsedBytes() + LargestEntrySize() <= LEAF_PAGE_USABLE_SIZE;
+}
+
+/*****************************************************************************
+ * POSTING LISTS
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::HasPostingLists() const -> bool { return this->has_posting_lists_ != 0; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsInlineList(const ValueType &value) -> bool {
+  return value.GetPageId() == INVALID_PAGE_ID;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsOverflowList(const ValueType &value) -> bool {
+  return value.GetPageId() != INVALID_PAGE_ID && value.GetSlotNum() == LEAF_PAGE_OVERFLOW_SLOT;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::MakeOverflowList(page_id_t head_page_id) -> ValueType {
+  return {head_page_id, LEAF_PAGE_OVERFLOW_SLOT};
+}
+
+/*
+ * The list is bounds checked since optimistic readers may pass a torn value
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::GetInlineList(const ValueType &value, std::vector<ValueType> *result) const {
+  auto offset = InlineListOffset(value);
+  auto size = InlineListSize(value);
+  if (offset < LEAF_PAGE_HEADER_SIZE || offset + size > BUSTUB_PAGE_SIZE) {
     return;
   }
-  if (right_index >= parent->GetSize()) {
-    // Must do something from left
-    *is_right = false;
-    *sibling_index = left_index;
-    Page *left_page = bpm->FetchPage(parent->ValueAt(left_index));
-    auto *left = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(left_page->GetData());
-    *sibling_page_id = left->GetPageId();
-    if (left->GetSize() == left->GetMinSize()) {
-      *is_merge = true;
-    } else {
-      *is_merge = false;
+  BPlusTreePostingPage::Decode(reinterpret_cast<const char *>(this) + offset, size, result);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SetInlineList(int index, const std::vector<ValueType> &values) -> bool {
+  auto size = BPlusTreePostingPage::EncodedSize(values);
+  if (this->GetFreeBytes() + this->InlineListSizeAt(index) < size) {
+    return false;
+  }
+  this->SetValueAt(index, values[0]);
+  if (LEAF_PAGE_HEADER_SIZE + this->GetSize() * static_cast<int>(sizeof(Slot)) + size > this->heap_begin_) {
+    this->Compact();
+  }
+  this->heap_begin_ -= size;
+  this->heap_size_ += size;
+  BPlusTreePostingPage::Encode(values, reinterpret_cast<char *>(this) + this->heap_begin_);
+  this->slots_[index].value_ = MakeInlineList(this->heap_begin_, size);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  if (this->HasPostingLists()) {
+    this->ReleaseInlineList(this->slots_[index].value_);
+  }
+  this->slots_[index].value_ = value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::InlineListSizeAt(int index) const -> int {
+  auto value = this->slots_[index].value_;
+  return this->HasPostingLists() && IsInlineList(value) ? InlineListSize(value) : 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::LargestInlineList() const -> int {
+  int largest = -1;
+  int largest_size = 0;
+  for (int i = 0; i < this->GetSize(); i++) {
+    auto size = this->InlineListSizeAt(i);
+    if (size > largest_size) {
+      largest = i;
+      largest_size = size;
     }
-    bpm->UnpinPage(parent_id, false);
-    bpm->UnpinPage(left->GetPageId(), false);
+  }
+  return largest;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetFreeBytes() const -> int {
+  return LEAF_PAGE_USABLE_SIZE - this->GetSize() * static_cast<int>(sizeof(Slot)) - this->heap_size_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertFrom(int index,
+                                            const BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *from_page,
+                                            int from_index) {
+  auto value = from_page->ValueAt(from_index);
+  if (!from_page->HasPostingLists() || !IsInlineList(value)) {
+    this->InsertAt(index, from_page->KeyAt(from_index), value);
     return;
   }
-  Page *left_page = bpm->FetchPage(parent->ValueAt(left_index));
-  Page *right_page = bpm->FetchPage(parent->ValueAt(right_index));
-  auto *left = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(left_page->GetData());
-  auto *right = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(right_page->GetData());
-  if (left->GetSize() == left->GetMinSize() && right->GetSize() == right->GetMinSize()) {
-    *is_merge = true;
-    *is_right = true;
-    *sibling_index = right_index;
-    *sibling_page_id = right->GetPageId();
-  } else {
-    *is_merge = false;
-    *is_right = (left->GetSize() == left->GetMinSize() || right->GetSize() > right->GetMinSize());
-    if (*is_right) {
-      *sibling_page_id = right->GetPageId();
-      *sibling_index = right_index;
-    } else {
-      *sibling_page_id = left->GetPageId();
-      *sibling_index = left_index;
+  std::vector<ValueType> values;
+  from_page->GetInlineList(value, &values);
+  this->InsertAt(index, from_page->KeyAt(from_index), values[0]);
+  if (!this->SetInlineList(index, values)) {
+    UNREACHABLE("caller must make room for the posting list");
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ReserveEntry(int tail_size) {
+  auto slots_end = LEAF_PAGE_HEADER_SIZE + (this->GetSize() + 1) * static_cast<int>(sizeof(Slot));
+  if (slots_end + tail_size > this->heap_begin_) {
+    this->Compact();
+  }
+}
+
+/*
+ * Move the key tails and inline lists next to each other at the end of the
+ * page, freeing the holes left by released ones
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Compact() {
+  char buffer[BUSTUB_PAGE_SIZE];
+  auto *data = reinterpret_cast<char *>(this);
+  int heap_begin = BUSTUB_PAGE_SIZE;
+  for (int i = 0; i < this->GetSize(); i++) {
+    Slot &slot = this->slots_[i];
+    if constexpr (HAS_KEY_TAIL) {
+      heap_begin -= slot.tail_size_;
+      memcpy(buffer + heap_begin, data + slot.tail_offset_, slot.tail_size_);
+      slot.tail_offset_ = heap_begin;
     }
+    if (!this->HasPostingLists() || !IsInlineList(slot.value_)) {
+      continue;
+    }
+    auto size = InlineListSize(slot.value_);
+    heap_begin -= size;
+    memcpy(buffer + heap_begin, data + InlineListOffset(slot.value_), size);
+    slot.value_ = MakeInlineList(heap_begin, size);
   }
-  bpm->UnpinPage(parent_id, false);
-  bpm->UnpinPage(left->GetPageId(), false);
-  bpm->UnpinPage(right->GetPageId(), false);
+  memcpy(data + heap_begin, buffer + heap_begin, BUSTUB_PAGE_SIZE - heap_begin);
+  this->heap_begin_ = heap_begin;
+  this->heap_size_ = BUSTUB_PAGE_SIZE - heap_begin;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetPairAt(int index) const -> MappingType { return this->array_[index]; }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ReleaseInlineList(const ValueType &value) {
+  if (IsInlineList(value)) {
+    this->ReleaseHeapBytes(InlineListSize(value));
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetPairAt(int index) -> MappingType & { return this->array_[index]; }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ReleaseHeapBytes(int size) {
+  this->heap_size_ -= size;
+  if (this->heap_size_ == 0) {
+    this->heap_begin_ = BUSTUB_PAGE_SIZE;
+  }
+}
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeLeafPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeLeafPage<GenericKey<128>, RID, GenericComparator<128>>;
+template class BPlusTreeLeafPage<GenericKey<256>, RID, GenericComparator<256>>;
 }  // namespace bustub
@@ -20,6 +20,7 @@ namespace bustub {
  */
 auto BPlusTreePage::IsLeafPage() const -> bool { return this->page_type_ == IndexPageType::LEAF_PAGE; }
 auto BPlusTreePage::IsRootPage() const -> bool { return this->parent_page_id_ == INVALID_PAGE_ID; }
+auto BPlusTreePage::GetPageType() const -> IndexPageType { return this->page_type_; }
 void BPlusTreePage::SetPageType(IndexPageType page_type) { this->page_type_ = page_type; }
 
 /*
@@ -69,4 +70,32 @@ void BPlusTreePage::SetPageId(page_id_t page_id) { this->page_id_ = page_id; }
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
+/*
+ * Helper methods for optimistic lock coupling
+ * An odd version means a writer is modifying the page right now. BeginWrite
+ * and EndWrite must be called with the page write latch held, so there is
+ * only one writer at a time and plain stores are enough on the writer side.
+ */
+void BPlusTreePage::ResetVersion() { version_.store(0); }
+
+auto BPlusTreePage::GetVersion() const -> uint64_t { return version_.load(std::memory_order_acquire); }
+
+auto BPlusTreePage::ValidateVersion(uint64_t version) const -> bool {
+  // keep the optimistic reads of this page before the version check
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return version_.load(std::memory_order_relaxed) == version;
+}
+
+void BPlusTreePage::BeginWrite() {
+  version_.store(version_.load(std::memory_order_relaxed) | 1, std::memory_order_relaxed);
+  // make the odd version visible before any write to the page
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BPlusTreePage::EndWrite(bool is_dirty) {
+  auto version = version_.load(std::memory_order_relaxed) | 1;
+  // an untouched page gets its old version back so that readers need not restart
+  version_.store(is_dirty ? version + 1 : version - 1, std::memory_order_release);
+}
+
 }  // namespace bustub
@@ -0,0 +1,306 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+namespace {
+
+auto VarintSize(uint64_t value) -> int {
+  int size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+auto RidLess(const RID &lhs, const RID &rhs) -> bool { return lhs.Get() < rhs.Get(); }
+
+auto FetchPostingPage(BufferPoolManager *bpm, page_id_t page_id) -> BPlusTreePostingPage * {
+  Page *page = bpm->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for posting page");
+  }
+  return reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+}
+
+auto NewPostingPage(BufferPoolManager *bpm, page_id_t *page_id) -> BPlusTreePostingPage * {
+  Page *page = bpm->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no free frame for posting page");
+  }
+  auto *posting_page = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  posting_page->Init();
+  return posting_page;
+}
+
+}  // namespace
+
+void BPlusTreePostingPage::Init() {
+  this->last_rid_ = 0;
+  this->next_page_id_ = INVALID_PAGE_ID;
+  this->count_ = 0;
+  this->data_size_ = 0;
+}
+
+auto BPlusTreePostingPage::GetNextPageId() const -> page_id_t { return this->next_page_id_; }
+
+void BPlusTreePostingPage::SetNextPageId(page_id_t next_page_id) { this->next_page_id_ = next_page_id; }
+
+auto BPlusTreePostingPage::GetCount() const -> int { return this->count_; }
+
+auto BPlusTreePostingPage::GetDataSize() const -> int { return this->data_size_; }
+
+void BPlusTreePostingPage::GetRids(std::vector<RID> *result) const {
+  Decode(this->data_, std::clamp(this->data_size_, 0, POSTING_PAGE_DATA_SIZE), result);
+}
+
+auto BPlusTreePostingPage::SetRids(const std::vector<RID> &rids) -> bool {
+  auto size = EncodedSize(rids);
+  if (size > POSTING_PAGE_DATA_SIZE) {
+    return false;
+  }
+  Encode(rids, this->data_);
+  this->count_ = static_cast<int>(rids.size());
+  this->data_size_ = size;
+  this->last_rid_ = rids.empty() ? 0 : rids.back().Get();
+  return true;
+}
+
+/*****************************************************************************
+ * ENCODING
+ *****************************************************************************/
+auto BPlusTreePostingPage::EncodedSize(const std::vector<RID> &rids) -> int {
+  int size = 0;
+  uint64_t previous = 0;
+  for (const auto &rid : rids) {
+    auto value = static_cast<uint64_t>(rid.Get());
+    size += VarintSize(value - previous);
+    previous = value;
+  }
+  return size;
+}
+
+void BPlusTreePostingPage::Encode(const std::vector<RID> &rids, char *data) {
+  uint64_t previous = 0;
+  for (const auto &rid : rids) {
+    auto value = static_cast<uint64_t>(rid.Get());
+    auto delta = value - previous;
+    while (delta >= 0x80) {
+      *data++ = static_cast<char>((delta & 0x7f) | 0x80);
+      delta >>= 7;
+    }
+    *data++ = static_cast<char>(delta);
+    previous = value;
+  }
+}
+
+/*
+ * Lists stored in leaves are decoded by optimistic readers that may see a torn
+ * page, so decoding never reads past size bytes.
+ */
+void BPlusTreePostingPage::Decode(const char *data, int size, std::vector<RID> *result) {
+  uint64_t previous = 0;
+  int pos = 0;
+  while (pos < size) {
+    uint64_t delta = 0;
+    int shift = 0;
+    bool is_complete = false;
+    while (pos < size && shift < 64) {
+      auto byte = static_cast<uint8_t>(data[pos++]);
+      delta |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+      if ((byte & 0x80) == 0) {
+        is_complete = true;
+        break;
+      }
+    }
+    if (!is_complete) {
+      return;
+    }
+    previous += delta;
+    result->emplace_back(static_cast<int64_t>(previous));
+  }
+}
+
+/*****************************************************************************
+ * CHAIN OPERATIONS
+ *****************************************************************************/
+/*
+ * Pages are filled completely, inserts split them when needed.
+ */
+auto BPlusTreePostingPage::CreateChain(BufferPoolManager *bpm, const std::vector<RID> &rids) -> page_id_t {
+  BUSTUB_ASSERT(!rids.empty(), "A posting list is never empty");
+  page_id_t head_page_id = INVALID_PAGE_ID;
+  page_id_t previous_page_id = INVALID_PAGE_ID;
+  BPlusTreePostingPage *previous_page = nullptr;
+  size_t begin = 0;
+  while (begin < rids.size()) {
+    // the first RID of a page is stored in full
+    auto end = begin + 1;
+    auto size = VarintSize(rids[begin].Get());
+    while (end < rids.size()) {
+      auto delta_size = VarintSize(static_cast<uint64_t>(rids[end].Get()) - rids[end - 1].Get());
+      if (size + delta_size > POSTING_PAGE_DATA_SIZE) {
+        break;
+      }
+      size += delta_size;
+      end++;
+    }
+    page_id_t page_id;
+    auto *posting_page = NewPostingPage(bpm, &page_id);
+    posting_page->SetRids(std::vector<RID>(rids.begin() + begin, rids.begin() + end));
+    if (previous_page != nullptr) {
+      previous_page->SetNextPageId(page_id);
+      bpm->UnpinPage(previous_page_id, true);
+    } else {
+      head_page_id = page_id;
+    }
+    previous_page = posting_page;
+    previous_page_id = page_id;
+    begin = end;
+  }
+  bpm->UnpinPage(previous_page_id, true);
+  return head_page_id;
+}
+
+/*
+ * The RID goes to the first page whose last RID is not smaller, or to the last
+ * page. A page that overflows is split in half.
+ */
+auto BPlusTreePostingPage::InsertIntoChain(BufferPoolManager *bpm, page_id_t head_page_id, const RID &rid) -> bool {
+  page_id_t page_id = head_page_id;
+  while (true) {
+    auto *posting_page = FetchPostingPage(bpm, page_id);
+    auto next_page_id = posting_page->GetNextPageId();
+    if (next_page_id != INVALID_PAGE_ID && rid.Get() > posting_page->last_rid_) {
+      bpm->UnpinPage(page_id, false);
+      page_id = next_page_id;
+      continue;
+    }
+    std::vector<RID> rids;
+    posting_page->GetRids(&rids);
+    auto position = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+    if (position != rids.end() && *position == rid) {
+      bpm->UnpinPage(page_id, false);
+      return false;
+    }
+    rids.insert(position, rid);
+    if (!posting_page->SetRids(rids)) {
+      auto half = rids.size() / 2;
+      page_id_t new_page_id;
+      auto *new_posting_page = NewPostingPage(bpm, &new_page_id);
+      new_posting_page->SetRids(std::vector<RID>(rids.begin() + half, rids.end()));
+      new_posting_page->SetNextPageId(next_page_id);
+      rids.resize(half);
+      posting_page->SetRids(rids);
+      posting_page->SetNextPageId(new_page_id);
+      bpm->UnpinPage(new_page_id, true);
+    }
+    bpm->UnpinPage(page_id, true);
+    return true;
+  }
+}
+
+/*
+ * A page that becomes empty is unlinked and freed. The first page is referred
+ * to by the leaf, so it takes over the content of its successor instead.
+ */
+auto BPlusTreePostingPage::RemoveFromChain(BufferPoolManager *bpm, page_id_t head_page_id, const RID &rid) -> bool {
+  page_id_t previous_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = head_page_id;
+  while (true) {
+    auto *posting_page = FetchPostingPage(bpm, page_id);
+    auto next_page_id = posting_page->GetNextPageId();
+    if (next_page_id != INVALID_PAGE_ID && rid.Get() > posting_page->last_rid_) {
+      bpm->UnpinPage(page_id, false);
+      previous_page_id = page_id;
+      page_id = next_page_id;
+      continue;
+    }
+    std::vector<RID> rids;
+    posting_page->GetRids(&rids);
+    auto position = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+    if (position == rids.end() || !(*position == rid)) {
+      bpm->UnpinPage(page_id, false);
+      return false;
+    }
+    rids.erase(position);
+    if (!rids.empty() || next_page_id == INVALID_PAGE_ID) {
+      posting_page->SetRids(rids);
+      bpm->UnpinPage(page_id, true);
+      return true;
+    }
+    if (previous_page_id == INVALID_PAGE_ID) {
+      auto *next_posting_page = FetchPostingPage(bpm, next_page_id);
+      next_posting_page->GetRids(&rids);
+      posting_page->SetRids(rids);
+      posting_page->SetNextPageId(next_posting_page->GetNextPageId());
+      bpm->UnpinPage(next_page_id, false);
+      bpm->UnpinPage(page_id, true);
+      bpm->DeletePage(next_page_id);
+      return true;
+    }
+    bpm->UnpinPage(page_id, false);
+    auto *previous_posting_page = FetchPostingPage(bpm, previous_page_id);
+    previous_posting_page->SetNextPageId(next_page_id);
+    bpm->UnpinPage(previous_page_id, true);
+    bpm->DeletePage(page_id);
+    return true;
+  }
+}
+
+auto BPlusTreePostingPage::ScanChain(BufferPoolManager *bpm, page_id_t head_page_id,
+                                     const std::function<bool(const RID &)> &consumer) -> bool {
+  std::vector<RID> rids;
+  for (page_id_t page_id = head_page_id; page_id != INVALID_PAGE_ID;) {
+    auto *posting_page = FetchPostingPage(bpm, page_id);
+    rids.clear();
+    posting_page->GetRids(&rids);
+    auto next_page_id = posting_page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    for (const auto &rid : rids) {
+      if (!consumer(rid)) {
+        return false;
+      }
+    }
+    page_id = next_page_id;
+  }
+  return true;
+}
+
+auto BPlusTreePostingPage::ReadShortChain(BufferPoolManager *bpm, page_id_t head_page_id, int max_size,
+                                          std::vector<RID> *result) -> bool {
+  auto *posting_page = FetchPostingPage(bpm, head_page_id);
+  bool is_short = posting_page->GetNextPageId() == INVALID_PAGE_ID && posting_page->GetDataSize() <= max_size;
+  if (is_short) {
+    posting_page->GetRids(result);
+  }
+  bpm->UnpinPage(head_page_id, false);
+  return is_short;
+}
+
+void BPlusTreePostingPage::FreeChain(BufferPoolManager *bpm, page_id_t head_page_id) {
+  for (page_id_t page_id = head_page_id; page_id != INVALID_PAGE_ID;) {
+    auto next_page_id = FetchPostingPage(bpm, page_id)->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    bpm->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
@@ -10,37 +10,114 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/page/hash_table_block_page.h"
 #include "storage/index/generic_key.h"
+#include "storage/page/hash_table_probe.h"
 
 namespace bustub {
 
+// Number of occupied indexes in a row at the start of the count lowest bits of occupied
+static auto OccupiedRun(uint64_t occupied, size_t count) -> size_t {
+  auto unoccupied = ~occupied;
+  if (count < 64) {
+    unoccupied |= uint64_t{1} << count;
+  }
+  return unoccupied == 0 ? 64 : __builtin_ctzll(unoccupied);
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const -> KeyType {
-  return {};
+  return array_[bucket_ind].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const -> ValueType {
-  return {};
+  return array_[bucket_ind].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  auto bit = static_cast<char>(1 << (bucket_ind % 8));
+  if ((occupied_[bucket_ind / 8].fetch_or(bit) & bit) != 0) {
+    return false;
+  }
+  array_[bucket_ind] = MappingType(key, value);
+  // readers only look at the pair once they see it readable
+  readable_[bucket_ind / 8].fetch_or(bit, std::memory_order_release);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {}
+auto HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) -> bool {
+  auto bit = static_cast<char>(1 << (bucket_ind % 8));
+  return (readable_[bucket_ind / 8].fetch_and(static_cast<char>(~bit)) & bit) != 0;
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const -> bool {
-  return false;
+  return (occupied_[bucket_ind / 8].load(std::memory_order_acquire) & (1 << (bucket_ind % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const -> bool {
-  return false;
+  return (readable_[bucket_ind / 8].load(std::memory_order_acquire) & (1 << (bucket_ind % 8))) != 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::FindKey(slot_offset_t bucket_ind, const KeyType &key, KeyComparator cmp,
+                                    std::vector<slot_offset_t> *slots) const -> slot_offset_t {
+  for (auto ind = bucket_ind; ind < BLOCK_ARRAY_SIZE;) {
+    auto shift = ind % 64;
+    auto count = std::min<size_t>(64 - shift, BLOCK_ARRAY_SIZE - ind);
+    auto run = OccupiedRun(LoadWord(occupied_, ind / 64) >> shift, count);
+    if (run > 0) {
+      // loaded after the occupied bits, a pair that is readable is completely written
+      auto readable = LoadWord(readable_, ind / 64) >> shift;
+      auto candidates = readable & (run == 64 ? ~uint64_t{0} : (uint64_t{1} << run) - 1);
+      if (candidates != 0) {
+        candidates &= HashTableProbe::MatchPrefix(
+            reinterpret_cast<const char *>(&array_[ind].first), static_cast<int>(sizeof(MappingType)),
+            static_cast<int>(run), reinterpret_cast<const char *>(&key), sizeof(KeyType));
+      }
+      for (; candidates != 0; candidates &= candidates - 1) {
+        auto slot = ind + __builtin_ctzll(candidates);
+        if (cmp(array_[slot].first, key) == 0) {
+          slots->push_back(slot);
+        }
+      }
+    }
+    if (run < count) {
+      return ind + run;
+    }
+    ind += count;
+  }
+  return BLOCK_ARRAY_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::FindUnoccupied(slot_offset_t bucket_ind) const -> slot_offset_t {
+  for (auto ind = bucket_ind; ind < BLOCK_ARRAY_SIZE;) {
+    auto shift = ind % 64;
+    auto count = std::min<size_t>(64 - shift, BLOCK_ARRAY_SIZE - ind);
+    auto run = OccupiedRun(LoadWord(occupied_, ind / 64) >> shift, count);
+    if (run < count) {
+      return ind + run;
+    }
+    ind += count;
+  }
+  return BLOCK_ARRAY_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::LoadWord(const std::atomic_char *bits, size_t word) const -> uint64_t {
+  uint64_t result = 0;
+  for (size_t i = 0; i < 8 && word * 8 + i < (BLOCK_ARRAY_SIZE - 1) / 8 + 1; i++) {
+    auto byte = static_cast<unsigned char>(bits[word * 8 + i].load(std::memory_order_acquire));
+    result |= static_cast<uint64_t>(byte) << (8 * i);
+  }
+  return result;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
@@ -50,5 +127,7 @@ template class HashTableBlockPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class HashTableBlockPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class HashTableBlockPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class HashTableBlockPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class HashTableBlockPage<GenericKey<128>, RID, GenericComparator<128>>;
+template class HashTableBlockPage<GenericKey<256>, RID, GenericComparator<256>>;
 
 }  // namespace bustub
@@ -134,6 +134,13 @@ TEST(BinderTest, BindSelectTableColumn) {
   PrintStatements(statements);
 }
 
+TEST(BinderTest, BindAnalyze) {
+  auto statements = TryBind("analyze y");
+  PrintStatements(statements);
+  EXPECT_THROW(TryBind("analyze zzzz"), Exception);
+  EXPECT_THROW(TryBind("vacuum y"), Exception);
+}
+
 TEST(BinderTest, FailBindUnknownColumn) {
   EXPECT_THROW(TryBind("select zzzz from y"), Exception);
   EXPECT_THROW(TryBind("select y.zzzz from y"), Exception);
@@ -17,13 +17,16 @@
 #include "common/logger.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/hash_table_block_page.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -57,7 +60,7 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
+TEST(HashTablePageTest, BucketPageSampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -114,4 +117,64 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BlockPageFindKeyTest) {
+  using KeyType = GenericKey<8>;
+  using ValueType = RID;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  auto *block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, GenericComparator<8>> *>(
+      bpm->NewPage(&block_page_id, nullptr)->GetData());
+  auto key = [](int64_t value) {
+    KeyType index_key;
+    index_key.SetFromInteger(value);
+    return index_key;
+  };
+
+  // a run of 100 slots across a bitmap word, every third holding key 7
+  for (slot_offset_t i = 50; i < 150; i++) {
+    EXPECT_TRUE(block_page->Insert(i, key(i % 3 == 0 ? 7 : static_cast<int64_t>(i)), RID(0, i)));
+  }
+  EXPECT_FALSE(block_page->Insert(60, key(7), RID(1, 60)));
+  std::vector<slot_offset_t> slots;
+  EXPECT_EQ(block_page->FindKey(40, key(7), comparator, &slots), 40);
+  EXPECT_TRUE(slots.empty());
+  EXPECT_EQ(block_page->FindKey(50, key(7), comparator, &slots), 150);
+  EXPECT_EQ(slots.size(), 33);
+  for (auto slot : slots) {
+    EXPECT_EQ(slot % 3, 0);
+    EXPECT_EQ(block_page->ValueAt(slot).GetSlotNum(), slot);
+  }
+
+  // tombstones are skipped but keep the run going
+  EXPECT_TRUE(block_page->Remove(99));
+  EXPECT_FALSE(block_page->Remove(99));
+  EXPECT_TRUE(block_page->IsOccupied(99));
+  EXPECT_FALSE(block_page->IsReadable(99));
+  slots.clear();
+  EXPECT_EQ(block_page->FindKey(90, key(7), comparator, &slots), 150);
+  EXPECT_EQ(slots.size(), 19);
+  EXPECT_EQ(block_page->FindUnoccupied(0), 0);
+  EXPECT_EQ(block_page->FindUnoccupied(64), 150);
+
+  // a run that reaches the end of the block goes on in the next one
+  for (slot_offset_t i = BLOCK_ARRAY_SIZE - 10; i < BLOCK_ARRAY_SIZE; i++) {
+    EXPECT_TRUE(block_page->Insert(i, key(7), RID(0, i)));
+  }
+  slots.clear();
+  EXPECT_EQ(block_page->FindKey(BLOCK_ARRAY_SIZE - 20, key(7), comparator, &slots), BLOCK_ARRAY_SIZE - 20);
+  EXPECT_EQ(block_page->FindKey(BLOCK_ARRAY_SIZE - 10, key(7), comparator, &slots), BLOCK_ARRAY_SIZE);
+  EXPECT_EQ(slots.size(), 10);
+  EXPECT_EQ(block_page->FindUnoccupied(BLOCK_ARRAY_SIZE - 5), BLOCK_ARRAY_SIZE);
+
+  bpm->UnpinPage(block_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,21 +10,26 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <memory>
+#include <string>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
 #include "common/logger.h"
 #include "container/disk/hash/disk_extendible_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +122,138 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowShrinkTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // every key gets two values, so buckets split in the middle of a key's values
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, -i - 1));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 42, 42));
+  ht.VerifyIntegrity();
+  auto global_depth = ht.GetGlobalDepth();
+  EXPECT_GE(global_depth, 5);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << i;
+    std::sort(res.begin(), res.end());
+    EXPECT_EQ(res, (std::vector<int>{-i - 1, i}));
+  }
+
+  // empty buckets merge and the directory shrinks as they do
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, -i - 1));
+    if (i % 4 != 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, 1, 1));
+  ht.VerifyIntegrity();
+  EXPECT_LE(ht.GetGlobalDepth(), global_depth);
+  for (int i = 0; i < num_keys; i += 4) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(ht.GetGlobalDepth(), 0);
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 4, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // threads insert, look up and remove keys of their own while buckets split and merge under them
+  const int num_threads = 4;
+  const int num_keys = 5000;
+  std::vector<std::thread> threads;
+  for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&ht, thread_id] {
+      for (int round = 0; round < 2; round++) {
+        for (int i = thread_id; i < num_keys; i += num_threads) {
+          EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        }
+        for (int i = thread_id; i < num_keys; i += num_threads) {
+          std::vector<int> res;
+          EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+          EXPECT_EQ(res, std::vector<int>{i});
+        }
+        for (int i = thread_id; i < num_keys; i += num_threads) {
+          if (round == 0 || i % 2 == 0) {
+            EXPECT_TRUE(ht.Remove(nullptr, i, i));
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(ht.GetValue(nullptr, i, &res), i % 2 == 1) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, CatalogIndexTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  auto catalog = std::make_unique<Catalog>(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  Schema schema({Column("id", TypeId::INTEGER), Column("name", TypeId::VARCHAR, 32)});
+  auto *table_info = catalog->CreateTable(&txn, "foo", schema);
+  RID rid;
+  for (int i = 0; i < 3000; i++) {
+    table_info->table_->InsertTuple(
+        Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::to_string(i % 100))}, &schema),
+        &rid, &txn);
+  }
+
+  // a hash index is filled from the table like a b+ tree index, whatever the size of its key
+  auto *id_index = catalog->CreateIndex(&txn, "foo_id", "foo", schema, {0}, true, IndexType::HashTableIndex);
+  auto *name_index = catalog->CreateIndex(&txn, "foo_name", "foo", schema, {1}, false, IndexType::HashTableIndex);
+  ASSERT_NE(id_index, Catalog::NULL_INDEX_INFO);
+  ASSERT_NE(name_index, Catalog::NULL_INDEX_INFO);
+  EXPECT_EQ(id_index->index_type_, IndexType::HashTableIndex);
+  EXPECT_EQ(name_index->key_size_, 64);
+  EXPECT_EQ(id_index->index_->Scan(false), nullptr);
+  std::vector<RID> rids;
+  for (int i = 0; i < 3000; i += 7) {
+    rids.clear();
+    id_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(i)}, &id_index->key_schema_), &rids, &txn);
+    ASSERT_EQ(rids.size(), 1) << i;
+    Tuple tuple;
+    ASSERT_TRUE(table_info->table_->GetTuple(rids[0], &tuple, &txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+  }
+  rids.clear();
+  name_index->index_->ScanKey(Tuple({ValueFactory::GetVarcharValue("42")}, &name_index->key_schema_), &rids, &txn);
+  EXPECT_EQ(rids.size(), 30);
+
+  catalog.reset();
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,231 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/disk/hash/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  {
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+    EXPECT_GE(ht.GetSize(), 1000);
+
+    // every key gets two values, a repeated pair is rejected
+    for (int i = 0; i < 5; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i + 1));
+      EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    }
+    for (int i = 0; i < 5; i++) {
+      std::vector<int> res;
+      EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+      std::sort(res.begin(), res.end());
+      EXPECT_EQ(res, (std::vector<int>{i, 2 * i + 1}));
+    }
+    EXPECT_EQ(ht.GetNumEntries(), 10);
+
+    // a removed pair leaves a tombstone the key's other value is still found past
+    for (int i = 0; i < 5; i++) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+      EXPECT_FALSE(ht.Remove(nullptr, i, i));
+      std::vector<int> res;
+      EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+      EXPECT_EQ(res, std::vector<int>{2 * i + 1});
+      EXPECT_TRUE(ht.Remove(nullptr, i, 2 * i + 1));
+      res.clear();
+      EXPECT_FALSE(ht.GetValue(nullptr, i, &res));
+    }
+    EXPECT_EQ(ht.GetNumEntries(), 0);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  {
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 0, HashFunction<int>(), 8);
+    auto initial_size = ht.GetSize();
+
+    // the table doubles a few times, every key is found while the pairs move over
+    const int num_keys = 20000;
+    bool was_resizing = false;
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+      was_resizing = was_resizing || ht.IsResizing();
+      if (i % 997 == 0) {
+        for (int j = 0; j <= i; j += 13) {
+          std::vector<int> res;
+          ASSERT_TRUE(ht.GetValue(nullptr, j, &res)) << j;
+          EXPECT_EQ(res, std::vector<int>{j});
+        }
+      }
+    }
+    EXPECT_TRUE(was_resizing);
+    EXPECT_GE(ht.GetSize(), initial_size * 16);
+    EXPECT_LE(ht.GetNumEntries(), ht.GetSize() * LINEAR_PROBE_MAX_LOAD + 1);
+    EXPECT_FALSE(ht.Insert(nullptr, 42, 42));
+
+    // removes leave tombstones, the table is rebuilt as large once they make up most of it instead of growing
+    auto size = ht.GetSize();
+    for (int round = 0; round < 4; round++) {
+      for (int i = 0; i < num_keys; i++) {
+        ASSERT_TRUE(ht.Remove(nullptr, i + round * num_keys, i)) << i;
+        ASSERT_TRUE(ht.Insert(nullptr, i + (round + 1) * num_keys, i)) << i;
+      }
+    }
+    EXPECT_LE(ht.GetSize(), 2 * size);
+    EXPECT_EQ(ht.GetNumEntries(), num_keys);
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      ASSERT_TRUE(ht.GetValue(nullptr, i + 4 * num_keys, &res)) << i;
+      res.clear();
+      EXPECT_FALSE(ht.GetValue(nullptr, i, &res)) << i;
+    }
+
+    // an explicit resize moves the pairs over with the writes that follow
+    size = ht.GetSize();
+    ht.Resize(size);
+    EXPECT_TRUE(ht.IsResizing());
+    EXPECT_GE(ht.GetSize(), 2 * size);
+    for (int i = 0; ht.IsResizing(); i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, -i - 1, i));
+    }
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      ASSERT_TRUE(ht.GetValue(nullptr, i + 4 * num_keys, &res)) << i;
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  {
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 0, HashFunction<int>(), 16);
+
+    // threads insert, look up and remove keys of their own while the table resizes under them, and all of them
+    // insert the same shared pairs, each of which goes in once
+    const int num_threads = 4;
+    const int num_keys = 8000;
+    std::vector<std::thread> threads;
+    std::atomic<int> shared_inserted{0};
+    for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+      threads.emplace_back([&ht, &shared_inserted, thread_id] {
+        for (int round = 0; round < 2; round++) {
+          for (int i = thread_id; i < num_keys; i += num_threads) {
+            EXPECT_TRUE(ht.Insert(nullptr, i, i));
+            shared_inserted += static_cast<int>(ht.Insert(nullptr, -1 - i / num_threads % 100, round));
+          }
+          for (int i = thread_id; i < num_keys; i += num_threads) {
+            std::vector<int> res;
+            EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+            EXPECT_EQ(res, std::vector<int>{i});
+          }
+          for (int i = thread_id; i < num_keys; i += num_threads) {
+            if (round == 0 || i % 2 == 0) {
+              EXPECT_TRUE(ht.Remove(nullptr, i, i));
+            }
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(shared_inserted, 200);
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      EXPECT_EQ(ht.GetValue(nullptr, i, &res), i % 2 == 1) << i;
+    }
+    for (int i = 0; i < 100; i++) {
+      std::vector<int> res;
+      EXPECT_TRUE(ht.GetValue(nullptr, -1 - i, &res));
+      std::sort(res.begin(), res.end());
+      EXPECT_EQ(res, (std::vector<int>{0, 1}));
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, CatalogIndexTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  auto catalog = std::make_unique<Catalog>(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  Schema schema({Column("id", TypeId::INTEGER), Column("name", TypeId::VARCHAR, 32)});
+  auto *table_info = catalog->CreateTable(&txn, "foo", schema);
+  RID rid;
+  for (int i = 0; i < 3000; i++) {
+    table_info->table_->InsertTuple(
+        Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::to_string(i % 100))}, &schema),
+        &rid, &txn);
+  }
+
+  auto *id_index =
+      catalog->CreateIndex(&txn, "foo_id", "foo", schema, {0}, true, IndexType::LinearProbeHashTableIndex);
+  auto *name_index =
+      catalog->CreateIndex(&txn, "foo_name", "foo", schema, {1}, false, IndexType::LinearProbeHashTableIndex);
+  ASSERT_NE(id_index, Catalog::NULL_INDEX_INFO);
+  ASSERT_NE(name_index, Catalog::NULL_INDEX_INFO);
+  EXPECT_EQ(id_index->index_type_, IndexType::LinearProbeHashTableIndex);
+  EXPECT_EQ(id_index->index_->Scan(false), nullptr);
+  std::vector<RID> rids;
+  for (int i = 0; i < 3000; i += 7) {
+    rids.clear();
+    id_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(i)}, &id_index->key_schema_), &rids, &txn);
+    ASSERT_EQ(rids.size(), 1) << i;
+    Tuple tuple;
+    ASSERT_TRUE(table_info->table_->GetTuple(rids[0], &tuple, &txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+  }
+  rids.clear();
+  name_index->index_->ScanKey(Tuple({ValueFactory::GetVarcharValue("42")}, &name_index->key_schema_), &rids, &txn);
+  EXPECT_EQ(rids.size(), 30);
+
+  catalog.reset();
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -4,8 +4,10 @@
 
 #include <memory>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "container/hash/extendible_hash_table.h"
+#include "container/hash/hash_function.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -68,4 +70,60 @@ TEST(ExtendibleHashTableTest, ConcurrentInsertTest) {
   }
 }
 
+TEST(ExtendibleHashTableTest, ConcurrentMixedTest) {
+  const int num_threads = 4;
+  const int num_keys = 4000;
+  auto table = std::make_unique<ExtendibleHashTable<int, int>>(4);
+  for (int i = 0; i < num_keys; i += 2) {
+    table->Insert(i, i);
+  }
+
+  // readers find the even keys while writers split buckets with the odd ones and update the even ones in place
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([tid, &table]() {
+      for (int i = 2 * tid + 1; i < num_keys; i += 2 * num_threads) {
+        if (tid % 2 == 0) {
+          table->Insert(i, i);
+          table->Insert(i - 1, i - 1);
+        } else {
+          int val;
+          EXPECT_TRUE(table->Find(i - 1, val));
+          EXPECT_EQ(i - 1, val);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    int val;
+    bool inserted = i % 2 == 0 || (i / 2) % num_threads % 2 == 0;
+    ASSERT_EQ(inserted, table->Find(i, val)) << i;
+    if (inserted) {
+      EXPECT_EQ(i, val);
+      EXPECT_TRUE(table->Remove(i));
+    }
+    EXPECT_FALSE(table->Remove(i));
+  }
+}
+
+TEST(ExtendibleHashTableTest, HashFunctionTest) {
+  // murmur spreads keys that share their low bits, which std::hash of an int would put in one bucket
+  auto table = std::make_unique<ExtendibleHashTable<int, int, HashFunction<int>>>(4);
+  for (int i = 0; i < 1000; i++) {
+    table->Insert(i << 16, i);
+  }
+  EXPECT_LT(table->GetGlobalDepth(), 16);
+  for (int i = 0; i < 1000; i++) {
+    int val;
+    ASSERT_TRUE(table->Find(i << 16, val));
+    EXPECT_EQ(i, val);
+  }
+  int val;
+  EXPECT_FALSE(table->Find(1, val));
+}
+
 }  // namespace bustub
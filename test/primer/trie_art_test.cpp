@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// trie_art_test.cpp
+//
+// Identification: test/primer/trie_art_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "primer/p0_trie.h"
+
+namespace bustub {
+
+// Keys that share long prefixes, end inside one another and use every byte value
+auto MakeArtKey(std::mt19937 *generator) -> std::string {
+  static const std::vector<std::string> prefixes = {"", "a", "ab", "abcdefghijklmnop", "abcdefghijklmnopqrstuvwxyz",
+                                                    std::string("\0\0\0", 3), "\xff\xfe"};
+  std::string key = prefixes[(*generator)() % prefixes.size()];
+  auto length = (*generator)() % 4;
+  for (size_t i = 0; i < length; i++) {
+    // few bytes in most keys, so nodes fill up to 256 children in some places only
+    key.push_back(static_cast<char>((*generator)() % 8 == 0 ? (*generator)() % 256 : 'a' + (*generator)() % 4));
+  }
+  return key;
+}
+
+void CheckArtTrie(Trie *trie, const std::map<std::string, int> &expected, const std::vector<std::string> &keys) {
+  for (const auto &key : keys) {
+    bool success;
+    auto value = trie->GetValue<int>(key, &success);
+    auto iter = expected.find(key);
+    ASSERT_EQ(success, iter != expected.end()) << key;
+    if (success) {
+      EXPECT_EQ(value, iter->second) << key;
+    }
+  }
+}
+
+TEST(TrieArtTest, RandomOperationTest) {
+  Trie trie;
+  std::map<std::string, int> expected;
+  std::vector<std::string> keys;
+  std::mt19937 generator(15445);
+  for (int i = 0; i < 50000; i++) {
+    auto key = MakeArtKey(&generator);
+    keys.push_back(key);
+    if (generator() % 3 == 0) {
+      EXPECT_EQ(trie.Remove(key), !key.empty() && expected.erase(key) == 1) << key;
+    } else {
+      bool inserted = !key.empty() && expected.count(key) == 0;
+      EXPECT_EQ(trie.Insert(key, i), inserted) << key;
+      if (inserted) {
+        expected[key] = i;
+      }
+    }
+  }
+  CheckArtTrie(&trie, expected, keys);
+
+  // removing all but a few keys shrinks the nodes and merges them, the rest is still found
+  int kept = 0;
+  for (auto iter = expected.begin(); iter != expected.end();) {
+    if (kept++ % 50 == 0) {
+      ++iter;
+      continue;
+    }
+    EXPECT_TRUE(trie.Remove(iter->first)) << iter->first;
+    iter = expected.erase(iter);
+  }
+  CheckArtTrie(&trie, expected, keys);
+  for (const auto &[key, value] : expected) {
+    EXPECT_TRUE(trie.Remove(key)) << key;
+  }
+  expected.clear();
+  CheckArtTrie(&trie, expected, keys);
+  EXPECT_TRUE(trie.Insert<int>("abc", 1));
+}
+
+TEST(TrieArtTest, PrefixTest) {
+  Trie trie;
+  // the long prefix is split inside of and past its stored bytes
+  EXPECT_TRUE(trie.Insert<int>("prefix-longer-than-eight-bytes-1", 1));
+  EXPECT_TRUE(trie.Insert<int>("prefix-longer-than-eight-bytes-2", 2));
+  EXPECT_TRUE(trie.Insert<int>("prefix-longer-than-nine-bytes", 3));
+  EXPECT_TRUE(trie.Insert<int>("prefix", 4));
+  EXPECT_TRUE(trie.Insert<int>("pre", 5));
+  EXPECT_FALSE(trie.Insert<int>("prefix-longer-than-eight-bytes-1", 6));
+
+  bool success;
+  EXPECT_EQ(trie.GetValue<int>("prefix-longer-than-eight-bytes-2", &success), 2);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(trie.GetValue<int>("prefix-longer-than-nine-bytes", &success), 3);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(trie.GetValue<int>("pre", &success), 5);
+  EXPECT_TRUE(success);
+  // only the stored bytes of a prefix are compared on the way down, the rest at the leaf
+  trie.GetValue<int>("prefix-longer-than-eight-bytez-1", &success);
+  EXPECT_FALSE(success);
+  trie.GetValue<int>("prefix-longer", &success);
+  EXPECT_FALSE(success);
+  // a value is only found as the type it was inserted with
+  trie.GetValue<std::string>("prefix", &success);
+  EXPECT_FALSE(success);
+
+  EXPECT_TRUE(trie.Remove("prefix-longer-than-nine-bytes"));
+  EXPECT_TRUE(trie.Remove("prefix"));
+  EXPECT_FALSE(trie.Remove("prefix"));
+  EXPECT_EQ(trie.GetValue<int>("prefix-longer-than-eight-bytes-1", &success), 1);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(trie.GetValue<int>("pre", &success), 5);
+  EXPECT_TRUE(success);
+}
+
+TEST(TrieArtTest, ConcurrentTest) {
+  Trie trie;
+  const int num_threads = 4;
+  const int num_keys = 20000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([tid, &trie]() {
+      for (int i = tid; i < num_keys; i += num_threads) {
+        EXPECT_TRUE(trie.Insert("key" + std::to_string(i), i));
+        bool success;
+        auto value = trie.GetValue<int>("key" + std::to_string(i / 2), &success);
+        EXPECT_EQ(value, success ? i / 2 : 0);
+        if (i % 3 == 0) {
+          EXPECT_TRUE(trie.Remove("key" + std::to_string(i)));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_keys; i++) {
+    bool success;
+    auto value = trie.GetValue<int>("key" + std::to_string(i), &success);
+    EXPECT_EQ(success, i % 3 != 0) << i;
+    EXPECT_EQ(value, success ? i : 0) << i;
+  }
+}
+
+TEST(TrieArtTest, SnapshotReadTest) {
+  Trie trie;
+  const int num_stable_keys = 1000;
+  for (int i = 0; i < num_stable_keys; i++) {
+    ASSERT_TRUE(trie.Insert("stable" + std::to_string(i), i));
+  }
+
+  // readers never wait for the writer, and always see a whole version: every stable key, and churned keys with
+  // their values or not at all
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 3; tid++) {
+    readers.emplace_back([tid, &trie, &done]() {
+      for (int i = tid; !done; i = (i + 7) % num_stable_keys) {
+        bool success;
+        auto value = trie.GetValue<int>("stable" + std::to_string(i), &success);
+        ASSERT_TRUE(success) << i;
+        ASSERT_EQ(value, i);
+        value = trie.GetValue<int>("stable" + std::to_string(i) + "-churn", &success);
+        ASSERT_EQ(value, success ? -i : 0);
+      }
+    });
+  }
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < num_stable_keys; i++) {
+      auto key = "stable" + std::to_string(i) + "-churn";
+      EXPECT_TRUE(round % 2 == 0 ? trie.Insert(key, -i) : trie.Remove(key));
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+}  // namespace bustub
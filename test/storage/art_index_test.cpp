@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index_test.cpp
+//
+// Identification: test/storage/art_index_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "gtest/gtest.h"
+#include "storage/index/adaptive_radix_tree.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// Random keys from a small alphabet with zero and 0xFF bytes, so that keys share prefixes, end inside the prefixes
+// of others and nodes grow to every size
+auto RandomRadixKey(std::mt19937 *generator) -> std::string {
+  static const std::string alphabet = std::string("\0\x01" "abc\xFF", 6) + "defghijklmnopqrstuvwxyz0123456789";
+  std::string key;
+  auto length = (*generator)() % 12;
+  auto spread = (*generator)() % 2 == 0 ? 3 : alphabet.size();
+  for (size_t i = 0; i < length; i++) {
+    key.push_back(alphabet[(*generator)() % spread]);
+  }
+  return key;
+}
+
+auto ScanTree(const AdaptiveRadixTree &tree, const std::string &begin, const std::optional<std::string> &end,
+              bool descending) -> std::vector<std::string> {
+  std::vector<std::string> keys;
+  tree.Scan(begin, end, descending, [&keys](const std::string &key, const RID &value) {
+    keys.push_back(key);
+    return true;
+  });
+  return keys;
+}
+
+// NOLINTNEXTLINE
+TEST(AdaptiveRadixTreeTest, RandomOperationTest) {
+  AdaptiveRadixTree tree;
+  std::map<std::string, RID> expected;
+  std::mt19937 generator(15445);
+  for (int i = 0; i < 30000; i++) {
+    auto key = RandomRadixKey(&generator);
+    RID rid(i, i);
+    if (generator() % 3 == 0) {
+      auto found = expected.find(key);
+      EXPECT_FALSE(tree.Remove(key, RID(-1, 0)));
+      EXPECT_EQ(tree.Remove(key, found == expected.end() ? rid : found->second), found != expected.end());
+      expected.erase(key);
+    } else {
+      EXPECT_EQ(tree.Insert(key, rid), expected.emplace(key, rid).second);
+    }
+
+    if (i % 1000 == 0) {
+      ASSERT_EQ(tree.GetSize(), expected.size());
+      for (const auto &[expected_key, expected_rid] : expected) {
+        RID value;
+        ASSERT_TRUE(tree.GetValue(expected_key, &value));
+        EXPECT_EQ(value, expected_rid);
+      }
+      // ranges in both directions, with bounds that are and are not keys
+      for (int j = 0; j < 20; j++) {
+        auto begin = RandomRadixKey(&generator);
+        std::optional<std::string> end;
+        if (j % 4 != 0) {
+          end = RandomRadixKey(&generator);
+        }
+        std::vector<std::string> range;
+        for (auto iter = expected.lower_bound(begin); iter != expected.end() && (!end || iter->first < *end); ++iter) {
+          range.push_back(iter->first);
+        }
+        ASSERT_EQ(ScanTree(tree, begin, end, false), range) << i;
+        ASSERT_EQ(ScanTree(tree, begin, end, true), std::vector<std::string>(range.rbegin(), range.rend())) << i;
+      }
+    }
+  }
+
+  for (const auto &[key, rid] : expected) {
+    EXPECT_TRUE(tree.Remove(key, rid));
+  }
+  EXPECT_EQ(tree.GetSize(), 0);
+  EXPECT_TRUE(ScanTree(tree, "", std::nullopt, false).empty());
+
+  EXPECT_EQ(AdaptiveRadixTree::PrefixEnd("ab"), "ac");
+  EXPECT_EQ(AdaptiveRadixTree::PrefixEnd(std::string("a\xFF\xFF")), "b");
+  EXPECT_EQ(AdaptiveRadixTree::PrefixEnd(std::string("\xFF")), std::nullopt);
+}
+
+// NOLINTNEXTLINE
+TEST(AdaptiveRadixTreeTest, ConcurrentTest) {
+  AdaptiveRadixTree tree;
+  const int num_threads = 4;
+  const int num_keys = 4000;
+  std::vector<std::thread> threads;
+  for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&tree, thread_id] {
+      for (int i = thread_id; i < num_keys; i += num_threads) {
+        EXPECT_TRUE(tree.Insert("key" + std::to_string(i), RID(0, i)));
+      }
+      for (int i = thread_id; i < num_keys; i += num_threads) {
+        RID rid;
+        EXPECT_TRUE(tree.GetValue("key" + std::to_string(i), &rid));
+        if (i % 2 == 0) {
+          EXPECT_TRUE(tree.Remove("key" + std::to_string(i), rid));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(tree.GetSize(), num_keys / 2);
+  auto keys = ScanTree(tree, "", std::nullopt, false);
+  ASSERT_EQ(keys.size(), num_keys / 2);
+  EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+}
+
+auto CollectRids(IndexCursor *cursor) -> std::vector<RID> {
+  std::vector<RID> rids;
+  RID rid;
+  while (cursor->Next(&rid)) {
+    rids.push_back(rid);
+  }
+  return rids;
+}
+
+// NOLINTNEXTLINE
+TEST(ArtIndexTest, CatalogIndexTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  auto catalog = std::make_unique<Catalog>(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  Schema schema({Column("id", TypeId::INTEGER), Column("name", TypeId::VARCHAR, 512)});
+  auto *table_info = catalog->CreateTable(&txn, "foo", schema);
+  // names sort apart from ids, and longer than any generic key
+  auto name_of = [](int id) { return "name" + std::to_string((id % 100 + 100) % 100) + std::string(300, 'x'); };
+  std::map<int, RID> rid_of;
+  for (int i = -1000; i < 1000; i++) {
+    RID rid;
+    table_info->table_->InsertTuple(
+        Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(name_of(i))}, &schema), &rid, &txn);
+    rid_of[i] = rid;
+  }
+
+  auto *id_index = catalog->CreateIndex(&txn, "foo_id", "foo", schema, {0}, true, IndexType::ArtIndex);
+  auto *name_index = catalog->CreateIndex(&txn, "foo_name", "foo", schema, {1}, false, IndexType::ArtIndex);
+  auto *both_index = catalog->CreateIndex(&txn, "foo_both", "foo", schema, {1, 0}, true, IndexType::ArtIndex);
+  ASSERT_NE(id_index, Catalog::NULL_INDEX_INFO);
+  ASSERT_NE(name_index, Catalog::NULL_INDEX_INFO);
+  ASSERT_NE(both_index, Catalog::NULL_INDEX_INFO);
+  EXPECT_EQ(name_index->index_type_, IndexType::ArtIndex);
+  EXPECT_TRUE(IsOrderedIndex(name_index->index_type_));
+
+  // point lookups
+  std::vector<RID> rids;
+  for (int i = -1000; i < 1000; i += 7) {
+    rids.clear();
+    id_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(i)}, &id_index->key_schema_), &rids, &txn);
+    ASSERT_EQ(rids, std::vector<RID>{rid_of[i]}) << i;
+  }
+  rids.clear();
+  name_index->index_->ScanKey(Tuple({ValueFactory::GetVarcharValue(name_of(42))}, &name_index->key_schema_), &rids,
+                              &txn);
+  EXPECT_EQ(rids.size(), 20);
+
+  // negative ids come first, in both directions
+  auto ids = CollectRids(id_index->index_->Scan(false).get());
+  ASSERT_EQ(ids.size(), 2000);
+  auto iter = rid_of.begin();
+  for (const auto &rid : ids) {
+    EXPECT_EQ(rid, (iter++)->second);
+  }
+  auto descending_ids = CollectRids(id_index->index_->Scan(true).get());
+  EXPECT_EQ(descending_ids, std::vector<RID>(ids.rbegin(), ids.rend()));
+
+  // [-10, 10) by range
+  auto *art_ids = dynamic_cast<ArtIndex *>(id_index->index_.get());
+  ASSERT_NE(art_ids, nullptr);
+  Tuple begin({ValueFactory::GetIntegerValue(-10)}, &id_index->key_schema_);
+  Tuple end({ValueFactory::GetIntegerValue(10)}, &id_index->key_schema_);
+  auto range = CollectRids(art_ids->ScanRange(begin, end).get());
+  EXPECT_EQ(range, std::vector<RID>(ids.begin() + 990, ids.begin() + 1010));
+
+  // names name4... are name4, name40 to name49 and their ids by prefix of the composite key
+  auto *art_both = dynamic_cast<ArtIndex *>(both_index->index_.get());
+  auto prefixed = CollectRids(art_both->ScanPrefix({ValueFactory::GetVarcharValue("name4")}, true).get());
+  EXPECT_EQ(prefixed.size(), 11 * 20);
+  EXPECT_TRUE(CollectRids(art_both->ScanPrefix({ValueFactory::GetVarcharValue("name4")}).get()).empty());
+  auto exact = CollectRids(art_both->ScanPrefix({ValueFactory::GetVarcharValue(name_of(42))}).get());
+  ASSERT_EQ(exact.size(), 20);
+  EXPECT_EQ(exact[0], rid_of[-958]);
+  auto whole = CollectRids(
+      art_both->ScanPrefix({ValueFactory::GetVarcharValue(name_of(42)), ValueFactory::GetIntegerValue(42)}).get());
+  EXPECT_EQ(whole, std::vector<RID>{rid_of[42]});
+
+  // entries of a key that is not unique go one at a time
+  Tuple key({ValueFactory::GetVarcharValue(name_of(7))}, &name_index->key_schema_);
+  name_index->index_->DeleteEntry(key, rid_of[7], &txn);
+  rids.clear();
+  name_index->index_->ScanKey(key, &rids, &txn);
+  EXPECT_EQ(rids.size(), 19);
+  id_index->index_->DeleteEntry(Tuple({ValueFactory::GetIntegerValue(7)}, &id_index->key_schema_), rid_of[7], &txn);
+  rids.clear();
+  id_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(7)}, &id_index->key_schema_), &rids, &txn);
+  EXPECT_TRUE(rids.empty());
+
+  catalog.reset();
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
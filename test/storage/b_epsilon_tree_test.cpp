@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_epsilon_tree_test.cpp
+//
+// Identification: test/storage/b_epsilon_tree_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_epsilon_tree.h"
+#include "storage/index/b_epsilon_tree_index.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using EpsilonTree = BEpsilonTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+auto MakeKey(int64_t key) -> GenericKey<8> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+TEST(BEpsilonTreeTest, RandomOperationTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // small leaves and fanout, so buffers are flushed and pages split at every level
+  EpsilonTree tree("foo_pk", bpm, comparator, 4, 4);
+  EXPECT_TRUE(tree.IsEmpty());
+  std::map<int64_t, int64_t> expected;
+  std::mt19937 generator(15445);
+  std::uniform_int_distribution<int64_t> key_distribution(0, 1999);
+  std::vector<RID> rids;
+  auto check = [&]() {
+    for (int64_t key = -1; key <= 2000; key++) {
+      rids.clear();
+      auto found = expected.find(key);
+      ASSERT_EQ(tree.GetValue(MakeKey(key), &rids), found != expected.end()) << key;
+      if (found != expected.end()) {
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0].GetSlotNum(), found->second) << key;
+      }
+    }
+  };
+
+  // inserts overwrite existing keys, removes of missing keys do nothing
+  for (int64_t i = 0; i < 30000; i++) {
+    auto key = key_distribution(generator);
+    if (generator() % 3 == 0) {
+      tree.Remove(MakeKey(key));
+      expected.erase(key);
+    } else {
+      tree.Insert(MakeKey(key), RID(0, i));
+      expected[key] = i;
+    }
+    if (i % 10000 == 9999) {
+      check();
+    }
+  }
+  for (int64_t key = 0; key < 2000; key += 2) {
+    tree.Remove(MakeKey(key));
+    expected.erase(key);
+  }
+  check();
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BEpsilonTreeTest, EmptyRootTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  EpsilonTree tree("foo_pk", bpm, comparator);
+  tree.Remove(MakeKey(1));
+  EXPECT_TRUE(tree.IsEmpty());
+  tree.Insert(MakeKey(1), RID(0, 1));
+  tree.Insert(MakeKey(2), RID(0, 2));
+  EXPECT_FALSE(tree.IsEmpty());
+  tree.Remove(MakeKey(1));
+  tree.Remove(MakeKey(2));
+  EXPECT_TRUE(tree.IsEmpty());
+  std::vector<RID> rids;
+  EXPECT_FALSE(tree.GetValue(MakeKey(1), &rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BEpsilonTreeTest, IndexTest) {
+  auto table_schema = ParseCreateStatement("a bigint,b integer");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", table_schema.get(), std::vector<uint32_t>{0});
+  BEpsilonTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(std::move(metadata), bpm);
+  auto key_tuple = [&index](int64_t key) {
+    return Tuple({ValueFactory::GetBigIntValue(key)}, index.GetKeySchema());
+  };
+  for (int64_t key = 0; key < 5000; key++) {
+    index.InsertEntry(key_tuple(key), RID(0, key), nullptr);
+  }
+  for (int64_t key = 0; key < 5000; key += 2) {
+    index.DeleteEntry(key_tuple(key), RID(0, key), nullptr);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 5000; key++) {
+    rids.clear();
+    index.ScanKey(key_tuple(key), &rids, nullptr);
+    if (key % 2 == 0) {
+      EXPECT_TRUE(rids.empty()) << key;
+    } else {
+      ASSERT_EQ(rids.size(), 1) << key;
+      EXPECT_EQ(rids[0], RID(0, key));
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BEpsilonTreeTest, ConcurrentTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  EpsilonTree tree("foo_pk", bpm, comparator, 8, 4);
+  const int64_t num_keys = 4000;
+  std::vector<std::thread> threads;
+  // writers insert interleaved keys, readers check that keys never change their value
+  for (int64_t offset = 0; offset < 2; offset++) {
+    threads.emplace_back([&tree, offset, num_keys]() {
+      for (int64_t key = offset; key < num_keys; key += 2) {
+        tree.Insert(MakeKey(key), RID(0, key));
+      }
+    });
+  }
+  for (int reader = 0; reader < 2; reader++) {
+    threads.emplace_back([&tree, num_keys]() {
+      std::vector<RID> rids;
+      for (int64_t key = 0; key < num_keys; key++) {
+        rids.clear();
+        if (tree.GetValue(MakeKey(key), &rids)) {
+          ASSERT_EQ(rids.size(), 1);
+          EXPECT_EQ(rids[0], RID(0, key));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(MakeKey(key), &rids)) << key;
+    EXPECT_EQ(rids[0], RID(0, key));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,220 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/external_merge_sort.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using LeafPageForTest = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+
+// walk the leaf chain, check keys are increasing and return the number of leaves
+auto CountLeaves(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree, BufferPoolManager *bpm,
+                 int64_t *pair_count) -> int64_t {
+  int64_t leaves = 0;
+  int64_t previous_key = 0;
+  *pair_count = 0;
+  page_id_t page_id = tree->LeftMostLeaf();
+  while (page_id != INVALID_PAGE_ID) {
+    auto *leaf = reinterpret_cast<LeafPageForTest *>(bpm->FetchPage(page_id)->GetData());
+    for (int i = 0; i < leaf->GetSize(); i++) {
+      EXPECT_GT(leaf->KeyAt(i).ToString(), previous_key);
+      previous_key = leaf->KeyAt(i).ToString();
+      (*pair_count)++;
+    }
+    leaves++;
+    auto next_page_id = leaf->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return leaves;
+}
+
+TEST(BPlusTreeBulkLoadTest, ExternalSortTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(20, disk_manager);
+
+  std::vector<int64_t> keys(20000);
+  std::iota(keys.begin(), keys.end(), 1);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+
+  {
+    // one page of pairs in memory forces a lot of runs through a small buffer pool
+    ExternalMergeSort<GenericKey<8>, RID, GenericComparator<8>> sorter(bpm, comparator, 1);
+    GenericKey<8> index_key;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      sorter.Add(index_key, RID(key));
+    }
+    sorter.Finish();
+    EXPECT_GT(sorter.GetRunCount(), 10);
+
+    std::pair<GenericKey<8>, RID> pair;
+    int64_t expected_key = 1;
+    while (sorter.Next(&pair)) {
+      EXPECT_EQ(pair.first.ToString(), expected_key);
+      EXPECT_EQ(pair.second.GetSlotNum(), expected_key);
+      expected_key++;
+    }
+    EXPECT_EQ(expected_key, keys.size() + 1);
+  }
+
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeBulkLoadTest, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 64, 16);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  int64_t scale = 10000;
+  int64_t next_key = 1;
+  auto next_pair = [&](std::pair<GenericKey<8>, RID> *pair) {
+    if (next_key > scale) {
+      return false;
+    }
+    pair->first.SetFromInteger(next_key);
+    pair->second.Set(0, next_key);
+    next_key++;
+    return true;
+  };
+  ASSERT_TRUE(tree.BulkLoad(next_pair, 1.0));
+  // a second bulk load into a non-empty tree is rejected
+  ASSERT_FALSE(tree.BulkLoad(next_pair, 1.0));
+
+  // fully packed leaves hold 63 pairs each
+  int64_t pair_count;
+  EXPECT_EQ(CountLeaves(&tree, bpm, &pair_count), (scale + 62) / 63);
+  EXPECT_EQ(pair_count, scale);
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // the loaded tree must behave like any other tree
+  RID rid;
+  for (int64_t key = scale + 1; key <= 2 * scale; key++) {
+    index_key.SetFromInteger(key);
+    rid.Set(0, key);
+    EXPECT_TRUE(tree.Insert(index_key, rid));
+  }
+  CountLeaves(&tree, bpm, &pair_count);
+  EXPECT_EQ(pair_count, 2 * scale);
+  for (int64_t key = 1; key <= 2 * scale; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeBulkLoadTest, FillFactorTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // sizes chosen so that the last leaf and the last internal page come out short
+  for (int64_t scale : {1, 2, 5, 101, 1000, 4321}) {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> loaded_tree("foo_pk", bpm, comparator, 11, 5);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> inserted_tree("foo_pk", bpm, comparator, 11, 5);
+    int64_t next_key = 1;
+    ASSERT_TRUE(loaded_tree.BulkLoad(
+        [&](std::pair<GenericKey<8>, RID> *pair) {
+          if (next_key > scale) {
+            return false;
+          }
+          pair->first.SetFromInteger(next_key);
+          pair->second.Set(0, next_key);
+          next_key++;
+          return true;
+        },
+        0.8));
+    GenericKey<8> index_key;
+    RID rid;
+    for (int64_t key = 1; key <= scale; key++) {
+      index_key.SetFromInteger(key);
+      rid.Set(0, key);
+      inserted_tree.Insert(index_key, rid);
+    }
+
+    int64_t loaded_pairs;
+    int64_t inserted_pairs;
+    auto loaded_leaves = CountLeaves(&loaded_tree, bpm, &loaded_pairs);
+    auto inserted_leaves = CountLeaves(&inserted_tree, bpm, &inserted_pairs);
+    EXPECT_EQ(loaded_pairs, scale);
+    EXPECT_EQ(inserted_pairs, scale);
+    EXPECT_LE(loaded_leaves, inserted_leaves);
+
+    // removing in reverse order walks every merge path, which relies on min sizes
+    for (int64_t key = scale; key >= 1; key--) {
+      index_key.SetFromInteger(key);
+      loaded_tree.Remove(index_key);
+      std::vector<RID> rids;
+      if (key > 1) {
+        index_key.SetFromInteger(key - 1);
+        ASSERT_TRUE(loaded_tree.GetValue(index_key, &rids));
+      }
+    }
+    EXPECT_TRUE(loaded_tree.IsEmpty());
+    for (int64_t key = 1; key <= scale; key++) {
+      index_key.SetFromInteger(key);
+      inserted_tree.Remove(index_key);
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -100,7 +101,7 @@ void DeleteHelperSplit(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
+TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -152,7 +153,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
+TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -203,7 +204,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
+TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -245,7 +246,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
+TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -288,7 +289,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
+TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -333,4 +334,206 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, MixTest2) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree with small pages so that splits and merges happen all the time
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // first, populate index with even keys
+  std::vector<int64_t> keys;
+  for (int64_t key = 2; key <= 2000; key += 2) {
+    keys.push_back(key);
+  }
+  LaunchParallelTest(4, InsertHelperSplit, &tree, keys, 4);
+
+  // concurrently insert odd keys, remove even keys and look up everything
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key < 2000; key += 2) {
+    odd_keys.push_back(key);
+  }
+  auto mix_helper = [&](uint64_t thread_itr) {
+    if (thread_itr % 3 == 0) {
+      InsertHelperSplit(&tree, odd_keys, 2, thread_itr / 3);
+    } else if (thread_itr % 3 == 1) {
+      DeleteHelperSplit(&tree, keys, 2, thread_itr / 3);
+    } else {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (int64_t key = 1; key <= 2000; key++) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        tree.GetValue(index_key, &rids);
+        EXPECT_LE(rids.size(), 1);
+      }
+    }
+  };
+  LaunchParallelTest(6, mix_helper);
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= 2000; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    bool is_present = tree.GetValue(index_key, &rids);
+    EXPECT_EQ(is_present, key % 2 == 1);
+    if (is_present) {
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+  }
+
+  // remove everything, the tree has to shrink back to empty
+  DeleteHelper(&tree, odd_keys);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ReadMostlyTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  std::vector<int64_t> keys;
+  for (int64_t key = 2; key <= 2000; key += 2) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+
+  // one writer keeps splitting pages while readers look up keys that are always present
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key < 2000; key += 2) {
+    odd_keys.push_back(key);
+  }
+  auto read_mostly_helper = [&](uint64_t thread_itr) {
+    if (thread_itr == 0) {
+      InsertHelper(&tree, odd_keys);
+      return;
+    }
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    for (int round = 0; round < 3; round++) {
+      for (auto key : keys) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(tree.GetValue(index_key, &rids));
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0].GetSlotNum(), key);
+      }
+    }
+  };
+  LaunchParallelTest(4, read_mostly_helper);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, BatchLookupTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  std::vector<GenericKey<8>> lookup_keys;
+  std::vector<std::vector<RID>> results;
+  tree.GetValues(lookup_keys, &results);
+  EXPECT_TRUE(results.empty());
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 2; key <= 2000; key += 2) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+
+  // even keys stay while odd keys come and go, batches are sorted, reversed or repeat keys
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key < 2000; key += 2) {
+    odd_keys.push_back(key);
+  }
+  auto batch_helper = [&](uint64_t thread_itr) {
+    if (thread_itr == 0) {
+      InsertHelper(&tree, odd_keys);
+      DeleteHelper(&tree, odd_keys);
+      return;
+    }
+    std::vector<int64_t> batch_keys;
+    for (int64_t key = 0; key <= 2001; key++) {
+      batch_keys.push_back(key);
+      if (key % 100 == 0) {
+        batch_keys.push_back(key);
+      }
+    }
+    if (thread_itr == 2) {
+      std::reverse(batch_keys.begin(), batch_keys.end());
+    }
+    std::vector<GenericKey<8>> index_keys(batch_keys.size());
+    for (size_t i = 0; i < batch_keys.size(); i++) {
+      index_keys[i].SetFromInteger(batch_keys[i]);
+    }
+    std::vector<std::vector<RID>> batch_results;
+    for (int round = 0; round < 3; round++) {
+      tree.GetValues(index_keys, &batch_results);
+      ASSERT_EQ(batch_results.size(), batch_keys.size());
+      for (size_t i = 0; i < batch_keys.size(); i++) {
+        auto key = batch_keys[i];
+        if (key % 2 == 0 && key > 0 && key <= 2000) {
+          ASSERT_EQ(batch_results[i].size(), 1) << key;
+          EXPECT_EQ(batch_results[i][0].GetSlotNum(), key);
+        } else {
+          EXPECT_LE(batch_results[i].size(), 1) << key;
+        }
+      }
+    }
+  };
+  LaunchParallelTest(3, batch_helper);
+
+  // the odd keys are all gone again
+  for (int64_t key = 0; key <= 2001; key++) {
+    lookup_keys.emplace_back();
+    lookup_keys.back().SetFromInteger(key);
+  }
+  tree.GetValues(lookup_keys, &results);
+  for (int64_t key = 0; key <= 2001; key++) {
+    EXPECT_EQ(results[key].size(), key % 2 == 0 && key > 0 && key <= 2000 ? 1 : 0) << key;
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -0,0 +1,309 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_iterator_test.cpp
+//
+// Identification: test/storage/b_plus_tree_iterator_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+
+void InsertKeys(Tree *tree, int64_t first_key, int64_t last_key, int64_t step) {
+  GenericKey<8> index_key;
+  for (int64_t key = first_key; key <= last_key; key += step) {
+    index_key.SetFromInteger(key);
+    tree->Insert(index_key, RID(0, key));
+  }
+}
+
+TEST(BPlusTreeIteratorTest, LeafBoundaryTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // small leaves so that most keys sit at a leaf boundary
+  Tree tree("foo_pk", bpm, comparator, 3, 4);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  EXPECT_TRUE(tree.Begin() == tree.End());
+  InsertKeys(&tree, 2, 200, 2);
+
+  // every key is visited exactly once, whatever leaf the scan starts in
+  for (int64_t start_key = 0; start_key <= 201; start_key++) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(start_key);
+    int64_t expected_key = std::max<int64_t>(2, (start_key + 1) / 2 * 2);
+    for (auto iterator = tree.Begin(index_key); iterator != tree.End(); ++iterator) {
+      ASSERT_EQ((*iterator).first.ToString(), expected_key);
+      ASSERT_EQ((*iterator).second.GetSlotNum(), expected_key);
+      expected_key += 2;
+    }
+    ASSERT_EQ(expected_key, 202);
+  }
+
+  // iterators hold their leaf until destroyed, so they must go before the buffer pool
+  {
+    // iterators are equal at the same position only
+    auto first = tree.Begin();
+    auto second = tree.Begin();
+    EXPECT_TRUE(first == second);
+    ++second;
+    EXPECT_TRUE(first != second);
+    ++first;
+    EXPECT_TRUE(first == second);
+    EXPECT_TRUE(first != tree.End());
+
+    // a moved iterator keeps the position and the moved from one is at the end
+    auto moved = std::move(first);
+    EXPECT_EQ((*moved).first.ToString(), 4);
+    EXPECT_TRUE(first.IsEnd());  // NOLINT
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeIteratorTest, ReverseIteratorTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 3, 4);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  EXPECT_TRUE(tree.RBegin() == tree.End());
+  InsertKeys(&tree, 2, 200, 2);
+
+  // every key not greater than the start key is visited exactly once, largest first
+  for (int64_t start_key = 0; start_key <= 201; start_key++) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(start_key);
+    int64_t expected_key = std::min<int64_t>(200, start_key / 2 * 2);
+    for (auto iterator = tree.RBegin(index_key); iterator != tree.End(); ++iterator) {
+      ASSERT_EQ((*iterator).first.ToString(), expected_key);
+      ASSERT_EQ((*iterator).second.GetSlotNum(), expected_key);
+      expected_key -= 2;
+    }
+    ASSERT_EQ(expected_key, 0);
+  }
+
+  // remove enough keys to merge leaves, the prev links have to follow
+  GenericKey<8> index_key;
+  for (int64_t key = 4; key <= 200; key += 4) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  {
+    std::vector<std::pair<GenericKey<8>, RID>> batch;
+    auto iterator = tree.RBegin();
+    EXPECT_TRUE(iterator.IsReverse());
+    int64_t expected_key = 198;
+    while (iterator.NextBatch(&batch, 7) > 0) {
+      for (const auto &[key, rid] : batch) {
+        ASSERT_EQ(key.ToString(), expected_key);
+        expected_key -= 4;
+      }
+      batch.clear();
+    }
+    EXPECT_EQ(expected_key, -2);
+  }
+
+  // walking the leaves forward, each one links back to the one before it
+  auto leaf_page_id = tree.GetRootPageId();
+  auto *page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(leaf_page_id)->GetData());
+  while (!page->IsLeafPage()) {
+    auto child_page_id = reinterpret_cast<InternalPage *>(page)->ValueAt(0);
+    bpm->UnpinPage(leaf_page_id, false);
+    leaf_page_id = child_page_id;
+    page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(leaf_page_id)->GetData());
+  }
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  while (leaf_page_id != INVALID_PAGE_ID) {
+    auto *leaf = reinterpret_cast<LeafPage *>(page);
+    ASSERT_EQ(leaf->GetPrevPageId(), prev_page_id);
+    prev_page_id = leaf_page_id;
+    leaf_page_id = leaf->GetNextPageId();
+    bpm->UnpinPage(prev_page_id, false);
+    if (leaf_page_id != INVALID_PAGE_ID) {
+      page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(leaf_page_id)->GetData());
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeIteratorTest, NextBatchTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 16, 8);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  InsertKeys(&tree, 1, 1000, 1);
+
+  // batches span leaves and mix with single steps
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(10);
+  auto iterator = tree.Begin(index_key);
+  std::vector<std::pair<GenericKey<8>, RID>> batch;
+  int64_t expected_key = 10;
+  while (true) {
+    batch.clear();
+    auto size = iterator.NextBatch(&batch, 37);
+    ASSERT_EQ(size, static_cast<int>(batch.size()));
+    if (size == 0) {
+      break;
+    }
+    for (const auto &[key, rid] : batch) {
+      ASSERT_EQ(key.ToString(), expected_key);
+      ASSERT_EQ(rid.GetSlotNum(), expected_key);
+      expected_key++;
+    }
+    if (!iterator.IsEnd()) {
+      ASSERT_EQ((*iterator).first.ToString(), expected_key);
+      ++iterator;
+      expected_key++;
+    }
+  }
+  EXPECT_EQ(expected_key, 1001);
+  EXPECT_TRUE(iterator.IsEnd());
+  EXPECT_EQ(iterator.NextBatch(&batch, 10), 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeIteratorTest, ConcurrentScanTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 4, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys stay, odd keys are inserted and removed while scans run, which
+  // splits and merges leaves next to the ones the scans hold
+  const int64_t num_keys = 1000;
+  InsertKeys(&tree, 2, num_keys, 2);
+  std::atomic<bool> is_done{false};
+  std::thread writer([&tree, &is_done] {
+    GenericKey<8> index_key;
+    for (int round = 0; round < 5; round++) {
+      InsertKeys(&tree, 1, num_keys, 2);
+      for (int64_t key = 1; key <= num_keys; key += 2) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key);
+      }
+    }
+    is_done = true;
+  });
+
+  std::vector<std::thread> scanners;
+  for (int thread_id = 0; thread_id < 2; thread_id++) {
+    scanners.emplace_back([&tree, &is_done, thread_id] {
+      std::vector<std::pair<GenericKey<8>, RID>> batch;
+      do {
+        int64_t previous_key = 0;
+        int64_t next_even_key = 2;
+        auto iterator = tree.Begin();
+        while (!iterator.IsEnd()) {
+          batch.clear();
+          if (thread_id == 0) {
+            iterator.NextBatch(&batch, 5);
+          } else {
+            batch.push_back(*iterator);
+            ++iterator;
+          }
+          for (const auto &[key, rid] : batch) {
+            // keys come out in order, each at most once, and no stable key is missed
+            ASSERT_GT(key.ToString(), previous_key);
+            ASSERT_EQ(rid.GetSlotNum(), key.ToString());
+            if (key.ToString() % 2 == 0) {
+              ASSERT_EQ(key.ToString(), next_even_key);
+              next_even_key += 2;
+            }
+            previous_key = key.ToString();
+          }
+        }
+        ASSERT_EQ(next_even_key, num_keys + 2);
+      } while (!is_done);
+    });
+  }
+  // and the same from right to left
+  scanners.emplace_back([&tree, &is_done] {
+    do {
+      int64_t previous_key = num_keys + 1;
+      int64_t next_even_key = num_keys;
+      for (auto iterator = tree.RBegin(); !iterator.IsEnd(); ++iterator) {
+        auto key = (*iterator).first.ToString();
+        ASSERT_LT(key, previous_key);
+        if (key % 2 == 0) {
+          ASSERT_EQ(key, next_even_key);
+          next_even_key -= 2;
+        }
+        previous_key = key;
+      }
+      ASSERT_EQ(next_even_key, 0);
+    } while (!is_done);
+  });
+  writer.join();
+  for (auto &scanner : scanners) {
+    scanner.join();
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
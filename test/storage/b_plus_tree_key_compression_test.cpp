@@ -0,0 +1,307 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_compression_test.cpp
+//
+// Identification: test/storage/b_plus_tree_key_compression_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using WideKey = GenericKey<64>;
+using WideComparator = GenericComparator<64>;
+using WideTree = BPlusTree<WideKey, RID, WideComparator>;
+using WideInternalPage = BPlusTreeInternalPage<WideKey, page_id_t, WideComparator>;
+
+auto MakeWideKey(Schema *schema, int32_t a, const std::string &b) -> WideKey {
+  std::vector<Value> values{ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(b)};
+  Tuple tuple(values, schema);
+  WideKey key;
+  key.SetFromKey(tuple, schema);
+  return key;
+}
+
+// Long keys that only differ in their middle, like most composite or string keys do
+auto WideKeyString(int64_t n) -> std::string {
+  std::stringstream ss;
+  ss << "customer-" << std::setw(12) << std::setfill('0') << n << "-account-settings";
+  return ss.str();
+}
+
+struct TreeShape {
+  int height_{0};
+  int leaf_pages_{0};
+  int internal_pages_{0};
+  int max_fan_out_{0};
+};
+
+void WalkTree(page_id_t page_id, BufferPoolManager *bpm, int depth, TreeShape *shape) {
+  auto *page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+  shape->height_ = std::max(shape->height_, depth);
+  if (page->IsLeafPage()) {
+    shape->leaf_pages_++;
+  } else {
+    auto *internal = reinterpret_cast<WideInternalPage *>(page);
+    shape->internal_pages_++;
+    shape->max_fan_out_ = std::max(shape->max_fan_out_, internal->GetSize());
+    for (int i = 0; i < internal->GetSize(); i++) {
+      WalkTree(internal->ValueAt(i), bpm, depth + 1, shape);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+}
+
+TEST(BPlusTreeKeyCompressionTest, SeparatorTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(48)");
+  WideComparator comparator(key_schema.get());
+
+  auto check = [&](const WideKey &lhs, const WideKey &rhs) {
+    auto separator = comparator.Separator(lhs, rhs);
+    EXPECT_LT(comparator(lhs, separator), 0);
+    EXPECT_LE(comparator(separator, rhs), 0);
+    return separator;
+  };
+
+  // the first differing string is cut short
+  auto separator = check(MakeWideKey(key_schema.get(), 1, "apple"), MakeWideKey(key_schema.get(), 1, "banana"));
+  EXPECT_EQ(separator.ToValue(key_schema.get(), 0).GetAs<int32_t>(), 1);
+  EXPECT_EQ(separator.ToValue(key_schema.get(), 1).ToString(), "b");
+  separator = check(MakeWideKey(key_schema.get(), 1, WideKeyString(1234)),
+                    MakeWideKey(key_schema.get(), 1, WideKeyString(1299)));
+  EXPECT_EQ(separator.ToValue(key_schema.get(), 1).ToString(), "customer-00000000129");
+  // once between both keys, the remaining columns do not matter
+  separator = check(MakeWideKey(key_schema.get(), 1, "zzz"), MakeWideKey(key_schema.get(), 5, "aaa"));
+  EXPECT_EQ(separator.ToValue(key_schema.get(), 0).GetAs<int32_t>(), 2);
+  EXPECT_EQ(separator.ToValue(key_schema.get(), 1).ToString(), "");
+  // nothing shorter exists, the right key is used as is
+  auto rhs = MakeWideKey(key_schema.get(), 1, "abcd");
+  separator = check(MakeWideKey(key_schema.get(), 1, "abc"), rhs);
+  EXPECT_EQ(comparator(separator, rhs), 0);
+  rhs = MakeWideKey(key_schema.get(), 2, "x");
+  separator = check(MakeWideKey(key_schema.get(), 1, "y"), rhs);
+  EXPECT_EQ(comparator(separator, rhs), 0);
+}
+
+TEST(BPlusTreeKeyCompressionTest, WideKeyTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(48)");
+  WideComparator comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // default page sizes, internal pages are limited by their bytes
+  WideTree tree("foo_pk", bpm, comparator);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys(20000);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    EXPECT_TRUE(tree.Insert(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), RID(key)));
+  }
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // full 64 byte keys would allow at most this many children
+  auto uncompressed_fan_out = static_cast<int>((BUSTUB_PAGE_SIZE - 32) / (sizeof(WideKey) + sizeof(page_id_t)));
+  TreeShape shape;
+  WalkTree(tree.GetRootPageId(), bpm, 1, &shape);
+  EXPECT_GT(shape.max_fan_out_, uncompressed_fan_out);
+  EXPECT_LE(shape.height_, 3);
+
+  // removing in random order goes through merges and borrows of internal pages
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15645));
+  for (size_t i = 0; i < keys.size(); i++) {
+    tree.Remove(MakeWideKey(key_schema.get(), keys[i] % 3, WideKeyString(keys[i])));
+    if (i % 100 == 0) {
+      for (size_t j = i + 1; j < keys.size(); j += 97) {
+        rids.clear();
+        ASSERT_TRUE(tree.GetValue(MakeWideKey(key_schema.get(), keys[j] % 3, WideKeyString(keys[j])), &rids));
+      }
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeKeyCompressionTest, PartialRemoveTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(48)");
+  WideComparator comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  WideTree tree("foo_pk", bpm, comparator);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // ascending runs under a few distinct first columns, so pages hold keys with and without the page prefix
+  const int64_t scale = 12000;
+  for (int64_t key = 0; key < scale; key++) {
+    EXPECT_TRUE(tree.Insert(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), RID(key)));
+  }
+  // half full internal pages are merged and borrowed from while they keep filling up with keys
+  std::vector<int64_t> even_keys(scale / 2);
+  std::generate(even_keys.begin(), even_keys.end(), [key = -2]() mutable { return key += 2; });
+  // this order used to grow the slot array into the lowest key of the heap
+  std::shuffle(even_keys.begin(), even_keys.end(), std::mt19937(2));
+  for (auto key : even_keys) {
+    tree.Remove(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)));
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), &rids), key % 2 == 1);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeKeyCompressionTest, ConcurrentWideKeyTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(48)");
+  WideComparator comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  WideTree tree("foo_pk", bpm, comparator);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int num_threads = 4;
+  const int64_t keys_per_thread = 3000;
+  auto run = [&](auto &&work) {
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back(work, tid);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+  run([&](int tid) {
+    for (int64_t key = tid; key < num_threads * keys_per_thread; key += num_threads) {
+      tree.Insert(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), RID(key));
+    }
+  });
+  // half of the keys are removed while the other half is read
+  run([&](int tid) {
+    std::vector<RID> rids;
+    for (int64_t key = tid; key < num_threads * keys_per_thread; key += num_threads) {
+      if (key % 2 == 0) {
+        tree.Remove(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)));
+      } else {
+        rids.clear();
+        EXPECT_TRUE(tree.GetValue(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), &rids));
+      }
+    }
+  });
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_threads * keys_per_thread; key++) {
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(MakeWideKey(key_schema.get(), key % 3, WideKeyString(key)), &rids), key % 2 == 1);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Reports height, page count and lookup latency of trees over wide keys.
+ */
+TEST(BPlusTreeKeyCompressionTest, DISABLED_WideKeyBenchmark) {
+  const int64_t scale = 200000;
+  for (const auto *schema_string : {"b varchar(56)", "a integer,b varchar(48)"}) {
+    auto key_schema = ParseCreateStatement(schema_string);
+    bool is_composite = key_schema->GetColumnCount() == 2;
+    WideComparator comparator(key_schema.get());
+    auto make_key = [&](int64_t n) {
+      std::vector<Value> values;
+      if (is_composite) {
+        values.push_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(n % 16)));
+      }
+      values.push_back(ValueFactory::GetVarcharValue(WideKeyString(n)));
+      Tuple tuple(values, key_schema.get());
+      WideKey key;
+      key.SetFromKey(tuple, key_schema.get());
+      return key;
+    };
+
+    auto *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(1024, disk_manager);
+    WideTree tree("foo_pk", bpm, comparator);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    std::vector<int64_t> keys(scale);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+    for (auto key : keys) {
+      tree.Insert(make_key(key), RID(key));
+    }
+    TreeShape shape;
+    WalkTree(tree.GetRootPageId(), bpm, 1, &shape);
+
+    std::vector<RID> rids;
+    auto start = std::chrono::steady_clock::now();
+    for (auto key : keys) {
+      rids.clear();
+      tree.GetValue(make_key(key), &rids);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << schema_string << ": height " << shape.height_ << ", leaf pages " << shape.leaf_pages_
+              << ", internal pages " << shape.internal_pages_ << ", max fan-out " << shape.max_fan_out_
+              << ", lookup " << elapsed / scale << " ns" << std::endl;
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+}  // namespace bustub
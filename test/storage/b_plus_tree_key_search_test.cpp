@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_key_search_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/key_search.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+template <typename T>
+void CheckLowerBound(TypeId type) {
+  std::mt19937_64 generator(15445);
+  for (int count = 0; count < 100; count++) {
+    // keys are read at any stride, as they are interleaved with values in pages
+    for (int stride : {static_cast<int>(sizeof(T)), 12, 16}) {
+      std::vector<int64_t> keys(count);
+      for (auto &key : keys) {
+        key = static_cast<T>(generator());
+      }
+      std::sort(keys.begin(), keys.end());
+      std::vector<char> data(count * stride);
+      for (int i = 0; i < count; i++) {
+        KeyEncoding::WriteInteger<T>(static_cast<T>(keys[i]), data.data() + i * stride);
+      }
+      // existing keys, keys in between and keys out of the range of T
+      std::vector<int64_t> search_keys{INT64_MIN, INT64_MAX, std::numeric_limits<T>::min(),
+                                       std::numeric_limits<T>::max()};
+      for (auto key : keys) {
+        search_keys.push_back(key);
+        search_keys.push_back(key + 1);
+      }
+      for (auto key : search_keys) {
+        auto expected = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        ASSERT_EQ(KeySearch::LowerBound(data.data(), stride, count, key, type), expected)
+            << "count " << count << ", stride " << stride << ", key " << key;
+      }
+    }
+  }
+}
+
+TEST(BPlusTreeKeySearchTest, LowerBoundTest) {
+  CheckLowerBound<int8_t>(TypeId::TINYINT);
+  CheckLowerBound<int16_t>(TypeId::SMALLINT);
+  CheckLowerBound<int32_t>(TypeId::INTEGER);
+  CheckLowerBound<int64_t>(TypeId::BIGINT);
+}
+
+TEST(BPlusTreeKeySearchTest, ComparatorTest) {
+  auto integer_schema = ParseCreateStatement("a integer");
+  auto two_column_schema = ParseCreateStatement("a integer,b integer");
+  EXPECT_EQ(GenericComparator<4>(integer_schema.get()).GetIntegerType(), TypeId::INTEGER);
+  EXPECT_EQ(GenericComparator<8>(two_column_schema.get()).GetIntegerType(), TypeId::INVALID);
+
+  // integer keys order like their values, NULL first
+  GenericComparator<4> comparator(integer_schema.get());
+  std::vector<Value> values{ValueFactory::GetNullValueByType(TypeId::INTEGER), ValueFactory::GetIntegerValue(-70000),
+                            ValueFactory::GetIntegerValue(-1), ValueFactory::GetIntegerValue(0),
+                            ValueFactory::GetIntegerValue(255), ValueFactory::GetIntegerValue(256)};
+  std::vector<GenericKey<4>> keys(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    keys[i].SetFromKey(Tuple({values[i]}, integer_schema.get()), integer_schema.get());
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      EXPECT_EQ(comparator(keys[i], keys[j]), i < j ? -1 : (i == j ? 0 : 1));
+    }
+  }
+}
+
+TEST(BPlusTreeKeySearchTest, IntegerTreeTest) {
+  auto key_schema = ParseCreateStatement("a integer");
+  GenericComparator<4> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<4>, RID, GenericComparator<4>> tree("foo_pk", bpm, comparator);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // negative keys sort before positive ones
+  std::vector<int32_t> keys;
+  for (int32_t key = -3000; key <= 3000; key += 3) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  auto to_key = [&key_schema](int32_t key) {
+    GenericKey<4> index_key;
+    index_key.SetFromKey(Tuple({ValueFactory::GetIntegerValue(key)}, key_schema.get()), key_schema.get());
+    return index_key;
+  };
+  for (auto key : keys) {
+    EXPECT_TRUE(tree.Insert(to_key(key), RID(0, key + 3000)));
+  }
+
+  std::vector<RID> rids;
+  for (int32_t key = -3001; key <= 3001; key++) {
+    rids.clear();
+    ASSERT_EQ(tree.GetValue(to_key(key), &rids), key % 3 == 0 && key >= -3000 && key <= 3000) << key;
+  }
+  int32_t expected_key = -3000;
+  for (auto iterator = tree.Begin(to_key(-3000)); iterator != tree.End(); ++iterator) {
+    ASSERT_EQ((*iterator).second.GetSlotNum(), expected_key + 3000);
+    expected_key += 3;
+  }
+  EXPECT_EQ(expected_key, 3003);
+
+  for (auto key : keys) {
+    tree.Remove(to_key(key));
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
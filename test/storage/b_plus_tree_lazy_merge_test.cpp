@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_lazy_merge_test.cpp
+//
+// Identification: test/storage/b_plus_tree_lazy_merge_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using LazyTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+auto LazyKey(int64_t key) -> GenericKey<8> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+// Every key of expected is found and the leaves hold nothing else
+void CheckKeys(LazyTree *tree, const std::set<int64_t> &expected) {
+  std::vector<RID> rids;
+  for (auto key : expected) {
+    rids.clear();
+    ASSERT_TRUE(tree->GetValue(LazyKey(key), &rids)) << key;
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  auto expected_iter = expected.begin();
+  for (auto iter = tree->Begin(); !iter.IsEnd(); ++iter) {
+    ASSERT_NE(expected_iter, expected.end());
+    EXPECT_EQ((*iter).second.GetSlotNum(), *expected_iter);
+    ++expected_iter;
+  }
+  EXPECT_EQ(expected_iter, expected.end());
+}
+
+TEST(BPlusTreeLazyMergeTest, RandomOperationTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  for (double merge_fill : {0.5, 0.25, 0.0}) {
+    LazyTree tree("foo_pk", bpm, comparator, 16, 8, true, merge_fill);
+    std::set<int64_t> expected;
+    std::mt19937 generator(15445);
+    std::uniform_int_distribution<int64_t> key_distribution(0, 1999);
+    for (int i = 0; i < 20000; i++) {
+      auto key = key_distribution(generator);
+      if (generator() % 2 == 0) {
+        tree.Remove(LazyKey(key));
+        expected.erase(key);
+      } else if (tree.Insert(LazyKey(key), RID(0, key))) {
+        expected.insert(key);
+      }
+    }
+    CheckKeys(&tree, expected);
+
+    // the leaves of every other key are left underfull, unless they are merged right away
+    for (auto key : std::vector<int64_t>(expected.begin(), expected.end())) {
+      if (key % 4 != 0) {
+        tree.Remove(LazyKey(key));
+        expected.erase(key);
+      }
+    }
+    auto num_leaves = tree.GetStatistics().num_leaves_;
+    tree.Compact();
+    CheckKeys(&tree, expected);
+    auto statistics = tree.GetStatistics();
+    if (merge_fill < 0.5) {
+      EXPECT_LT(statistics.num_leaves_, num_leaves) << merge_fill;
+    }
+    EXPECT_GE(statistics.leaf_fill_factor_, 0.4) << merge_fill;
+
+    for (auto key : expected) {
+      tree.Remove(LazyKey(key));
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    tree.Compact();
+    EXPECT_TRUE(tree.IsEmpty());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeLazyMergeTest, ConcurrentCompactTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  LazyTree tree("foo_pk", bpm, comparator, 16, 8, true, 0);
+  for (int64_t key = 0; key < 4000; key++) {
+    tree.Insert(LazyKey(key), RID(0, key));
+  }
+  // a background compaction while a writer removes and inserts keys
+  std::thread compactor([&tree] {
+    for (int i = 0; i < 20; i++) {
+      tree.Compact();
+    }
+  });
+  std::set<int64_t> expected;
+  for (int64_t key = 0; key < 4000; key++) {
+    if (key % 3 != 0) {
+      tree.Remove(LazyKey(key));
+    } else {
+      expected.insert(key);
+    }
+  }
+  for (int64_t key = 4000; key < 5000; key++) {
+    tree.Insert(LazyKey(key), RID(0, key));
+    expected.insert(key);
+  }
+  compactor.join();
+  CheckKeys(&tree, expected);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
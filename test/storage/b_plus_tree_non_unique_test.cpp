@@ -0,0 +1,303 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_non_unique_test.cpp
+//
+// Identification: test/storage/b_plus_tree_non_unique_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using NonUniqueTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+using ExpectedValues = std::map<int64_t, std::vector<RID>>;
+
+// entries of a full size leaf
+const int FULL_LEAF_SIZE = (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<8>, RID>);
+
+// a few keys are hot enough to need posting pages, the others have short inline lists
+auto ValueCount(int64_t key) -> int { return key % 25 == 0 ? 1500 : static_cast<int>(key % 7) + 1; }
+
+// rids of one key are spread over a few table pages, like rows inserted over time
+auto ValueOf(int64_t key, int n) -> RID {
+  return {static_cast<page_id_t>(n / 40), static_cast<uint32_t>(key * 10000 + n)};
+}
+
+void CheckValues(NonUniqueTree *tree, const ExpectedValues &expected) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (const auto &[key, values] : expected) {
+    index_key.SetFromInteger(key);
+    rids.clear();
+    ASSERT_EQ(tree->GetValue(index_key, &rids), !values.empty());
+    ASSERT_EQ(rids, values) << "key " << key;
+  }
+}
+
+TEST(BPlusTreeNonUniqueTest, PostingListEncodingTest) {
+  std::vector<RID> rids;
+  for (int n = 0; n < 1000; n++) {
+    rids.push_back(ValueOf(7, n));
+  }
+  rids.emplace_back(INT32_MAX, UINT32_MAX - 1);
+  auto size = BPlusTreePostingPage::EncodedSize(rids);
+  // most RIDs are one slot after the previous one and take a single byte
+  EXPECT_LT(size, 1200);
+
+  std::vector<char> data(size);
+  BPlusTreePostingPage::Encode(rids, data.data());
+  std::vector<RID> decoded;
+  BPlusTreePostingPage::Decode(data.data(), size, &decoded);
+  EXPECT_EQ(decoded, rids);
+
+  // a cut off list decodes to a prefix of it
+  decoded.clear();
+  BPlusTreePostingPage::Decode(data.data(), size - 1, &decoded);
+  EXPECT_EQ(decoded, std::vector<RID>(rids.begin(), rids.end() - 1));
+}
+
+TEST(BPlusTreeNonUniqueTest, InsertRemoveTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // full size leaves run out of bytes and spill lists, small ones split and merge with lists in them
+  for (int leaf_max_size : {FULL_LEAF_SIZE, 8}) {
+    NonUniqueTree tree("foo_pk", bpm, comparator, leaf_max_size, 5, false);
+    ExpectedValues expected;
+    std::vector<std::pair<int64_t, RID>> pairs;
+    for (int64_t key = 1; key <= 200; key++) {
+      for (int n = 0; n < ValueCount(key); n++) {
+        pairs.emplace_back(key, ValueOf(key, n));
+        expected[key].push_back(ValueOf(key, n));
+      }
+    }
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(15445));
+
+    GenericKey<8> index_key;
+    for (const auto &[key, rid] : pairs) {
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.Insert(index_key, rid));
+    }
+    // only the exact pair is a duplicate
+    index_key.SetFromInteger(25);
+    EXPECT_FALSE(tree.Insert(index_key, ValueOf(25, 17)));
+    index_key.SetFromInteger(3);
+    EXPECT_FALSE(tree.Insert(index_key, ValueOf(3, 0)));
+    CheckValues(&tree, expected);
+
+    // values are streamed in order and the scan can stop early
+    std::vector<RID> rids;
+    index_key.SetFromInteger(50);
+    EXPECT_TRUE(tree.ScanKey(index_key, [&rids](const RID &rid) {
+      rids.push_back(rid);
+      return rids.size() < 10;
+    }));
+    EXPECT_EQ(rids, std::vector<RID>(expected[50].begin(), expected[50].begin() + 10));
+    index_key.SetFromInteger(201);
+    EXPECT_FALSE(tree.ScanKey(index_key, [](const RID &rid) { return true; }));
+
+    // remove most pairs one by one, hot lists shrink back into their leaf
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(2));
+    pairs.resize(pairs.size() * 9 / 10);
+    for (const auto &[key, rid] : pairs) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, rid);
+      auto &values = expected[key];
+      values.erase(std::find(values.begin(), values.end(), rid));
+    }
+    index_key.SetFromInteger(2);
+    tree.Remove(index_key, RID(12345, 0));
+    CheckValues(&tree, expected);
+
+    // removing a key drops all of its values
+    for (int64_t key = 1; key <= 200; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeNonUniqueTest, IteratorTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  NonUniqueTree tree("foo_pk", bpm, comparator, FULL_LEAF_SIZE, 64, false);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<std::pair<int64_t, RID>> pairs;
+  GenericKey<8> index_key;
+  for (int64_t key : {1, 2, 3, 25}) {
+    for (int n = 0; n < ValueCount(key); n++) {
+      pairs.emplace_back(key, ValueOf(key, n));
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, ValueOf(key, n));
+    }
+  }
+
+  // every value of a key comes out, in order, before the next key
+  size_t i = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    ASSERT_LT(i, pairs.size());
+    EXPECT_EQ((*iterator).first.ToString(), pairs[i].first);
+    EXPECT_EQ((*iterator).second, pairs[i].second);
+    i++;
+  }
+  EXPECT_EQ(i, pairs.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeNonUniqueTest, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  NonUniqueTree tree("foo_pk", bpm, comparator, FULL_LEAF_SIZE, 64, false);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  ExpectedValues expected;
+  std::vector<std::pair<GenericKey<8>, RID>> pairs;
+  for (int64_t key = 1; key <= 2000; key++) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(key);
+    for (int n = 0; n < ValueCount(key); n++) {
+      pairs.emplace_back(index_key, ValueOf(key, n));
+      expected[key].push_back(ValueOf(key, n));
+    }
+    // values of a key may come in any order
+    std::reverse(pairs.end() - ValueCount(key), pairs.end());
+  }
+  size_t next = 0;
+  ASSERT_TRUE(tree.BulkLoad([&](std::pair<GenericKey<8>, RID> *pair) {
+    if (next == pairs.size()) {
+      return false;
+    }
+    *pair = pairs[next++];
+    return true;
+  }));
+  CheckValues(&tree, expected);
+
+  // the loaded lists behave like inserted ones
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= 2000; key++) {
+    index_key.SetFromInteger(key);
+    auto rid = ValueOf(key, ValueCount(key));
+    EXPECT_TRUE(tree.Insert(index_key, rid));
+    expected[key].push_back(rid);
+    tree.Remove(index_key, expected[key][0]);
+    expected[key].erase(expected[key].begin());
+  }
+  CheckValues(&tree, expected);
+  for (int64_t key = 1; key <= 2000; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeNonUniqueTest, ConcurrentTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  NonUniqueTree tree("foo_pk", bpm, comparator, 16, 5, false);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // every thread adds its own values to the same keys, then removes half of them
+  const int num_threads = 4;
+  const int64_t num_keys = 200;
+  std::vector<std::thread> threads;
+  for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&tree, thread_id] {
+      GenericKey<8> index_key;
+      for (int n = thread_id; n < 40; n += num_threads) {
+        for (int64_t key = 1; key <= num_keys; key++) {
+          index_key.SetFromInteger(key);
+          tree.Insert(index_key, ValueOf(key, n));
+        }
+      }
+      for (int n = thread_id; n < 40; n += 2 * num_threads) {
+        for (int64_t key = 1; key <= num_keys; key++) {
+          index_key.SetFromInteger(key);
+          tree.Remove(index_key, ValueOf(key, n));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ExpectedValues expected;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    for (int n = 0; n < 40; n++) {
+      if (n % (2 * num_threads) >= num_threads) {
+        expected[key].push_back(ValueOf(key, n));
+      }
+    }
+  }
+  CheckValues(&tree, expected);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_parallel_scan_test.cpp
+//
+// Identification: test/storage/b_plus_tree_parallel_scan_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "execution/executor_context.h"
+#include "execution/executors/index_scan_executor.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using ScanTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+auto ScanKey(int64_t key) -> GenericKey<8> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+// Keys of the ranges between the split keys, each range starts at its split key
+auto CountParts(ScanTree *tree, const std::vector<GenericKey<8>> &split_keys, const GenericComparator<8> &comparator)
+    -> std::vector<int> {
+  std::vector<int> counts(split_keys.size() + 1);
+  size_t part = 0;
+  for (auto iter = tree->Begin(); !iter.IsEnd(); ++iter) {
+    while (part < split_keys.size() && comparator((*iter).first, split_keys[part]) >= 0) {
+      part++;
+    }
+    counts[part]++;
+  }
+  return counts;
+}
+
+TEST(BPlusTreeParallelScanTest, SplitKeysTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  ScanTree tree("foo_pk", bpm, comparator, 16, 8);
+  EXPECT_TRUE(tree.SplitKeys(std::nullopt, std::nullopt, 4).empty());
+  std::vector<int64_t> keys(10000);
+  for (int64_t i = 0; i < static_cast<int64_t>(keys.size()); i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    tree.Insert(ScanKey(key), RID(0, key));
+  }
+
+  EXPECT_TRUE(tree.SplitKeys(std::nullopt, std::nullopt, 1).empty());
+  for (int num_parts : {2, 4, 7, 16}) {
+    auto split_keys = tree.SplitKeys(std::nullopt, std::nullopt, num_parts);
+    ASSERT_EQ(split_keys.size(), num_parts - 1);
+    auto counts = CountParts(&tree, split_keys, comparator);
+    for (auto count : counts) {
+      // subtrees of one level are about as large
+      EXPECT_GT(count, 10000 / num_parts / 4) << num_parts;
+      EXPECT_LT(count, 10000 / num_parts * 4) << num_parts;
+    }
+  }
+
+  // only keys inside of the range, which split it
+  auto low = ScanKey(1000);
+  auto high = ScanKey(2999);
+  auto split_keys = tree.SplitKeys(low, high, 4);
+  ASSERT_EQ(split_keys.size(), 3);
+  for (size_t i = 0; i < split_keys.size(); i++) {
+    EXPECT_GT(comparator(split_keys[i], low), 0);
+    EXPECT_LE(comparator(split_keys[i], high), 0);
+    EXPECT_TRUE(i == 0 || comparator(split_keys[i - 1], split_keys[i]) < 0);
+  }
+  // a range of one key is not split
+  EXPECT_TRUE(tree.SplitKeys(ScanKey(5000), ScanKey(5000), 4).empty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeParallelScanTest, ExecutorTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  auto catalog = std::make_unique<Catalog>(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  Schema schema(std::vector{Column{"v1", TypeId::INTEGER}});
+  auto *table_info = catalog->CreateTable(&txn, "foo", schema);
+  const int num_rows = 20000;
+  RID rid;
+  for (int i = 0; i < num_rows; i++) {
+    table_info->table_->InsertTuple(Tuple({ValueFactory::GetIntegerValue(num_rows - i)}, &schema), &rid, &txn);
+  }
+  auto *index_info = catalog->CreateIndex(&txn, "foo_v1", "foo", schema, {0});
+  ASSERT_EQ(index_info->index_->ScanPartitions(4).size(), 4);
+  ExecutorContext exec_ctx(&txn, catalog.get(), bpm, nullptr, nullptr);
+  auto output = std::make_shared<Schema>(schema);
+  auto scan = [&](const IndexScanPlanNode &plan) {
+    IndexScanExecutor executor(&exec_ctx, &plan);
+    std::vector<int> values;
+    // a second run starts over
+    for (int run = 0; run < 2; run++) {
+      values.clear();
+      executor.Init();
+      Tuple tuple;
+      while (executor.Next(&tuple, &rid)) {
+        values.push_back(tuple.GetValue(&schema, 0).GetAs<int32_t>());
+      }
+    }
+    return values;
+  };
+
+  auto values = scan(IndexScanPlanNode(output, index_info->index_oid_, false, 4));
+  ASSERT_EQ(values.size(), num_rows);
+  for (int i = 0; i < num_rows; i++) {
+    ASSERT_EQ(values[i], i + 1);
+  }
+  values = scan(IndexScanPlanNode(output, index_info->index_oid_, false, 4, false));
+  ASSERT_EQ(values.size(), num_rows);
+  std::sort(values.begin(), values.end());
+  for (int i = 0; i < num_rows; i++) {
+    ASSERT_EQ(values[i], i + 1);
+  }
+  // descending scans are not split
+  values = scan(IndexScanPlanNode(output, index_info->index_oid_, true, 4));
+  ASSERT_EQ(values.size(), num_rows);
+  EXPECT_EQ(values.front(), num_rows);
+  EXPECT_TRUE(std::is_sorted(values.rbegin(), values.rend()));
+
+  // stopping early stops workers that are waiting for room in their buffers
+  {
+    IndexScanPlanNode plan(output, index_info->index_oid_, false, 8, false);
+    IndexScanExecutor executor(&exec_ctx, &plan);
+    executor.Init();
+    Tuple tuple;
+    for (int i = 0; i < 10; i++) {
+      ASSERT_TRUE(executor.Next(&tuple, &rid));
+    }
+  }
+  EXPECT_EQ(scan(IndexScanPlanNode(output, index_info->index_oid_, false, 8)).size(), num_rows);
+
+  catalog.reset();
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_pinned_pages_test.cpp
+//
+// Identification: test/storage/b_plus_tree_pinned_pages_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+// Counts the pages fetched from it
+class CountingBufferPoolManager : public BufferPoolManagerInstance {
+ public:
+  using BufferPoolManagerInstance::BufferPoolManagerInstance;
+
+  std::atomic<int> num_fetches_{0};
+
+ protected:
+  auto FetchPgImp(page_id_t page_id) -> Page * override {
+    num_fetches_++;
+    return BufferPoolManagerInstance::FetchPgImp(page_id);
+  }
+};
+
+TEST(BPlusTreePinnedPagesTest, LookupFetchesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new CountingBufferPoolManager(1024, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // five levels, of which the top three fit in the 64 pages that are pinned
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 16, 8);
+  std::vector<int64_t> keys(10000);
+  for (int64_t i = 0; i < static_cast<int64_t>(keys.size()); i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+  }
+
+  std::vector<RID> rids;
+  bpm->num_fetches_ = 0;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids)) << key;
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  EXPECT_EQ(bpm->num_fetches_, 2 * keys.size());
+
+  // the root changes as the tree shrinks, lookups keep up with it
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_key.SetFromInteger(keys[i]);
+    tree.Remove(index_key);
+    if (i % 1000 == 999) {
+      for (size_t j = i + 1; j < keys.size(); j += 10) {
+        rids.clear();
+        index_key.SetFromInteger(keys[j]);
+        ASSERT_TRUE(tree.GetValue(index_key, &rids)) << keys[j];
+      }
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  // nothing is left pinned, every frame but the header page can be taken
+  for (size_t i = 0; i + 1 < bpm->GetPoolSize(); i++) {
+    ASSERT_NE(bpm->NewPage(&page_id), nullptr) << i;
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreePinnedPagesTest, ConcurrentRootChangeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // even keys stay in the tree, writers grow and shrink it with odd keys
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < 400; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+  }
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  threads.emplace_back([&tree, &done]() {
+    GenericKey<8> key;
+    for (int round = 0; round < 5; round++) {
+      for (int64_t i = 1; i < 2000; i += 2) {
+        key.SetFromInteger(i);
+        tree.Insert(key, RID(0, i));
+      }
+      for (int64_t i = 1; i < 2000; i += 2) {
+        key.SetFromInteger(i);
+        tree.Remove(key);
+      }
+    }
+    done = true;
+  });
+  for (int reader = 0; reader < 2; reader++) {
+    threads.emplace_back([&tree, &done]() {
+      GenericKey<8> key;
+      std::vector<RID> rids;
+      while (!done) {
+        for (int64_t i = 0; i < 400; i += 2) {
+          rids.clear();
+          key.SetFromInteger(i);
+          ASSERT_TRUE(tree.GetValue(key, &rids)) << i;
+          ASSERT_EQ(rids[0].GetSlotNum(), i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
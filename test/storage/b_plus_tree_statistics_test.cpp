@@ -0,0 +1,226 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_statistics_test.cpp
+//
+// Identification: test/storage/b_plus_tree_statistics_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "gtest/gtest.h"
+#include "optimizer/optimizer.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using StatisticsTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+// Height and leaves counted by walking the tree
+void CheckShape(StatisticsTree *tree, BufferPoolManager *bpm) {
+  auto statistics = tree->GetStatistics();
+  if (tree->IsEmpty()) {
+    EXPECT_EQ(statistics.height_, 0);
+    EXPECT_EQ(statistics.num_leaves_, 0);
+    return;
+  }
+  uint32_t height = 1;
+  auto page_id = tree->GetRootPageId();
+  auto *page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+  while (!page->IsLeafPage()) {
+    auto child_page_id = reinterpret_cast<BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *>(page)
+                             ->ValueAt(0);
+    bpm->UnpinPage(page_id, false);
+    page_id = child_page_id;
+    page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+    height++;
+  }
+  uint64_t num_leaves = 0;
+  while (page_id != INVALID_PAGE_ID) {
+    auto next_page_id = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(page)
+                            ->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    num_leaves++;
+    page_id = next_page_id;
+    if (page_id != INVALID_PAGE_ID) {
+      page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+    }
+  }
+  EXPECT_EQ(statistics.height_, height);
+  EXPECT_EQ(statistics.num_leaves_, num_leaves);
+  EXPECT_GT(statistics.leaf_fill_factor_, 0.4);
+  EXPECT_LE(statistics.leaf_fill_factor_, 1);
+}
+
+TEST(BPlusTreeStatisticsTest, CountsTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  StatisticsTree tree("foo_pk", bpm, comparator, 4, 4, false);
+  std::vector<int64_t> keys(500);
+  for (int64_t i = 0; i < static_cast<int64_t>(keys.size()); i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  GenericKey<8> index_key;
+  // every key gets two values, the repeated pair is rejected
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+    tree.Insert(index_key, RID(1, key));
+    tree.Insert(index_key, RID(1, key));
+  }
+  auto statistics = tree.GetStatistics();
+  EXPECT_EQ(statistics.num_keys_, 500);
+  EXPECT_EQ(statistics.num_values_, 1000);
+  CheckShape(&tree, bpm);
+
+  // odd keys lose one value, keys below 100 go as a whole
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    if (key < 100) {
+      tree.Remove(index_key);
+    } else if (key % 2 == 1) {
+      tree.Remove(index_key, RID(0, key));
+    }
+  }
+  statistics = tree.GetStatistics();
+  EXPECT_EQ(statistics.num_keys_, 400);
+  EXPECT_EQ(statistics.num_values_, 600);
+  CheckShape(&tree, bpm);
+
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  statistics = tree.GetStatistics();
+  EXPECT_EQ(statistics.num_keys_, 0);
+  EXPECT_EQ(statistics.num_values_, 0);
+  CheckShape(&tree, bpm);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeStatisticsTest, HistogramTest) {
+  auto table_schema = ParseCreateStatement("a bigint");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  auto metadata =
+      std::make_unique<IndexMetadata>("foo_pk", "foo", table_schema.get(), std::vector<uint32_t>{0}, false);
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(std::move(metadata), bpm);
+  auto key_tuple = [&index](int64_t key) {
+    return Tuple({ValueFactory::GetBigIntValue(key)}, index.GetKeySchema());
+  };
+  // keys below 1000 hold half of the values
+  for (int64_t i = 0; i < 10000; i++) {
+    auto key = i % 2 == 0 ? i / 2 % 1000 : 1000 + i;
+    index.InsertEntry(key_tuple(key), RID(0, i), nullptr);
+  }
+  auto statistics = index.GetStatistics();
+  ASSERT_TRUE(statistics.has_value());
+  EXPECT_EQ(statistics->num_values_, 10000);
+  EXPECT_EQ(statistics->num_keys_, 6000);
+  EXPECT_TRUE(statistics->histogram_counts_.empty());
+  EXPECT_DOUBLE_EQ(statistics->EstimateSelectivity(std::nullopt, std::nullopt), 1);
+
+  index.Analyze(nullptr);
+  statistics = index.GetStatistics();
+  ASSERT_EQ(statistics->histogram_bounds_.size(), INDEX_HISTOGRAM_BUCKETS + 1);
+  EXPECT_EQ(statistics->histogram_bounds_.front().GetAs<int64_t>(), 0);
+  EXPECT_EQ(statistics->histogram_bounds_.back().GetAs<int64_t>(), 10999);
+  uint64_t total = 0;
+  for (size_t i = 0; i < statistics->histogram_counts_.size(); i++) {
+    total += statistics->histogram_counts_[i];
+    const auto &bounds = statistics->histogram_bounds_;
+    EXPECT_LT(bounds[i].GetAs<int64_t>(), bounds[i + 1].GetAs<int64_t>());
+  }
+  EXPECT_EQ(total, 10000);
+  auto below = [](int64_t key) { return std::make_optional(ValueFactory::GetBigIntValue(key)); };
+  EXPECT_NEAR(statistics->EstimateSelectivity(std::nullopt, below(999)), 0.5, 0.05);
+  EXPECT_NEAR(statistics->EstimateSelectivity(below(0), below(499)), 0.25, 0.05);
+  EXPECT_NEAR(statistics->EstimateSelectivity(below(6000), std::nullopt), 0.25, 0.05);
+  EXPECT_DOUBLE_EQ(statistics->EstimateSelectivity(below(20000), std::nullopt), 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeStatisticsTest, PlannerTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  auto catalog = std::make_unique<Catalog>(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  Schema schema(std::vector{Column{"v1", TypeId::INTEGER}});
+  // a table of num_rows rows with an index on v1, and a plan that sorts it by v1
+  auto sort_plan = [&](const std::string &table_name, int num_rows) -> AbstractPlanNodeRef {
+    auto *table_info = catalog->CreateTable(&txn, table_name, schema);
+    RID rid;
+    for (int i = 0; i < num_rows; i++) {
+      table_info->table_->InsertTuple(Tuple({ValueFactory::GetIntegerValue(num_rows - i)}, &schema), &rid, &txn);
+    }
+    catalog->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
+        &txn, table_name + "_v1", table_name, schema, Schema::CopySchema(&schema, {0}), {0}, INTEGER_SIZE,
+        IntegerHashFunctionType{});
+    auto output = std::make_shared<Schema>(schema);
+    auto scan = std::make_shared<SeqScanPlanNode>(output, table_info->oid_, table_name);
+    std::vector<std::pair<OrderByType, AbstractExpressionRef>> order_bys{
+        {OrderByType::ASC, std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER)}};
+    return std::make_shared<SortPlanNode>(output, scan, std::move(order_bys));
+  };
+  auto small_plan = sort_plan("small", 3);
+  auto large_plan = sort_plan("large", 1000);
+
+  const auto *index_info = catalog->GetIndex("large_v1", "large");
+  auto statistics = index_info->GetStatistics();
+  ASSERT_TRUE(statistics.has_value());
+  EXPECT_EQ(statistics->num_values_, 1000);
+  EXPECT_EQ(statistics->height_, 2);
+  EXPECT_EQ(statistics->histogram_counts_.size(), INDEX_HISTOGRAM_BUCKETS);
+  index_info->index_->Analyze(&txn);
+  EXPECT_EQ(index_info->GetStatistics()->histogram_bounds_.size(), statistics->histogram_bounds_.size());
+
+  // sorting three rows is cheaper than fetching them by RID, the starter rules always take the index
+  EXPECT_EQ(Optimizer(*catalog, false).Optimize(small_plan)->GetType(), PlanType::Sort);
+  EXPECT_EQ(Optimizer(*catalog, false).Optimize(large_plan)->GetType(), PlanType::IndexScan);
+  EXPECT_EQ(Optimizer(*catalog, true).Optimize(small_plan)->GetType(), PlanType::IndexScan);
+
+  catalog.reset();
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
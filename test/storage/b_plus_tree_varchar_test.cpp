@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varchar_test.cpp
+//
+// Identification: test/storage/b_plus_tree_varchar_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using VarcharTree = BPlusTree<GenericKey<256>, RID, GenericComparator<256>>;
+
+// Strings of 1 to 191 characters, so leaves split by bytes long before they reach max size
+auto MakeName(int64_t key) -> std::string {
+  return std::string(key * 7919 % 188, static_cast<char>('a' + key % 26)) + std::to_string(key);
+}
+
+auto MakeVarcharKey(Schema *key_schema, const std::string &name) -> GenericKey<256> {
+  GenericKey<256> index_key;
+  index_key.SetFromKey(Tuple({ValueFactory::GetVarcharValue(name)}, key_schema), key_schema);
+  return index_key;
+}
+
+TEST(BPlusTreeVarcharTest, RandomOperationTest) {
+  auto key_schema = ParseCreateStatement("a varchar(200)");
+  GenericComparator<256> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  for (bool is_unique : {true, false}) {
+    VarcharTree tree("foo_pk", bpm, comparator, 128, 64, is_unique);
+    // name -> number of values
+    std::map<std::string, int> expected;
+    std::mt19937 generator(15445);
+    std::uniform_int_distribution<int64_t> key_distribution(0, 2999);
+    for (int i = 0; i < 20000; i++) {
+      auto key = key_distribution(generator);
+      auto name = MakeName(key);
+      auto index_key = MakeVarcharKey(key_schema.get(), name);
+      if (generator() % 3 == 0) {
+        tree.Remove(index_key);
+        expected.erase(name);
+      } else if (tree.Insert(index_key, RID(i, key))) {
+        expected[name]++;
+      }
+    }
+    std::vector<RID> rids;
+    for (int64_t key = 0; key < 3000; key++) {
+      auto name = MakeName(key);
+      rids.clear();
+      auto found = expected.find(name);
+      ASSERT_EQ(tree.GetValue(MakeVarcharKey(key_schema.get(), name), &rids), found != expected.end()) << name;
+      if (found != expected.end()) {
+        ASSERT_EQ(rids.size(), static_cast<size_t>(found->second)) << name;
+        EXPECT_EQ(rids[0].GetSlotNum(), key) << name;
+      }
+    }
+
+    // keys come back in string order
+    auto expected_iter = expected.begin();
+    for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+      ASSERT_NE(expected_iter, expected.end());
+      EXPECT_EQ(comparator((*iter).first, MakeVarcharKey(key_schema.get(), expected_iter->first)), 0);
+      if (!is_unique) {
+        // the values of a key come one after another
+        for (int i = 1; i < expected_iter->second; i++) {
+          ++iter;
+        }
+      }
+      ++expected_iter;
+    }
+    EXPECT_EQ(expected_iter, expected.end());
+
+    for (const auto &[name, count] : expected) {
+      tree.Remove(MakeVarcharKey(key_schema.get(), name));
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeVarcharTest, CatalogKeySizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  auto catalog = std::make_unique<Catalog>(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  Schema schema({Column("id", TypeId::INTEGER), Column("flag", TypeId::BOOLEAN), Column("score", TypeId::BIGINT),
+                 Column("short_name", TypeId::VARCHAR, 8), Column("name", TypeId::VARCHAR, 128),
+                 Column("text", TypeId::VARCHAR, 1024)});
+  auto *table_info = catalog->CreateTable(&txn, "foo", schema);
+  RID rid;
+  for (int i = 0; i < 1000; i++) {
+    table_info->table_->InsertTuple(
+        Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetBooleanValue(i % 2 == 0),
+               ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue(std::to_string(i % 100)),
+               ValueFactory::GetVarcharValue(MakeName(i)), ValueFactory::GetVarcharValue("")},
+              &schema),
+        &rid, &txn);
+  }
+
+  EXPECT_EQ(catalog->CreateIndex(&txn, "foo_id", "foo", schema, {0})->key_size_, 4);
+  EXPECT_EQ(catalog->CreateIndex(&txn, "foo_id_score", "foo", schema, {0, 2})->key_size_, 16);
+  EXPECT_EQ(catalog->CreateIndex(&txn, "foo_short_name", "foo", schema, {3}, false)->key_size_, 16);
+  EXPECT_EQ(catalog->CreateIndex(&txn, "foo_flag_short_name", "foo", schema, {1, 3}, false)->key_size_, 16);
+  auto *name_index = catalog->CreateIndex(&txn, "foo_name", "foo", schema, {4});
+  ASSERT_NE(name_index, Catalog::NULL_INDEX_INFO);
+  EXPECT_EQ(name_index->key_size_, 256);
+  EXPECT_EQ(catalog->CreateIndex(&txn, "foo_text", "foo", schema, {5}), Catalog::NULL_INDEX_INFO);
+
+  // the bulk loaded index finds every row by its string, and scans them in string order
+  std::vector<RID> rids;
+  for (int i = 0; i < 1000; i++) {
+    rids.clear();
+    name_index->index_->ScanKey(Tuple({ValueFactory::GetVarcharValue(MakeName(i))}, &name_index->key_schema_),
+                                &rids, &txn);
+    ASSERT_EQ(rids.size(), 1) << i;
+    Tuple tuple;
+    ASSERT_TRUE(table_info->table_->GetTuple(rids[0], &tuple, &txn));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+  }
+  std::vector<std::string> names;
+  auto cursor = name_index->index_->Scan(false);
+  while (cursor->Next(&rid)) {
+    Tuple tuple;
+    ASSERT_TRUE(table_info->table_->GetTuple(rid, &tuple, &txn));
+    names.push_back(tuple.GetValue(&schema, 4).ToString());
+  }
+  ASSERT_EQ(names.size(), 1000);
+  EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+  cursor.reset();
+
+  rids.clear();
+  auto *short_name_index = catalog->GetIndex("foo_short_name", "foo");
+  short_name_index->index_->ScanKey(Tuple({ValueFactory::GetVarcharValue("42")}, &short_name_index->key_schema_),
+                                    &rids, &txn);
+  EXPECT_EQ(rids.size(), 10);
+
+  catalog.reset();
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
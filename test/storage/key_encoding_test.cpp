@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_encoding_test.cpp
+//
+// Identification: test/storage/key_encoding_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/index/key_encoding.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// Keys built from rows that are listed in ascending order have to compare in that order
+template <size_t KeySize>
+void CheckOrder(Schema *key_schema, const std::vector<std::vector<Value>> &rows) {
+  GenericComparator<KeySize> comparator(key_schema);
+  std::vector<GenericKey<KeySize>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    ASSERT_TRUE(keys[i].SetFromValues(rows[i])) << i;
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      EXPECT_EQ(comparator(keys[i], keys[j]), i < j ? -1 : (i == j ? 0 : 1)) << i << " " << j;
+    }
+  }
+}
+
+TEST(KeyEncodingTest, IntegerOrderTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  std::vector<std::vector<Value>> rows{{ValueFactory::GetNullValueByType(TypeId::BIGINT)}};
+  for (int64_t key : {BUSTUB_INT64_MIN, int64_t{-4294967296}, int64_t{-256}, int64_t{-1}, int64_t{0}, int64_t{1},
+                      int64_t{255}, int64_t{256}, int64_t{4294967296}, BUSTUB_INT64_MAX}) {
+    rows.push_back({ValueFactory::GetBigIntValue(key)});
+  }
+  CheckOrder<8>(key_schema.get(), rows);
+}
+
+TEST(KeyEncodingTest, DecimalAndTimestampOrderTest) {
+  auto decimal_schema = ParseCreateStatement("a double");
+  std::vector<std::vector<Value>> rows{{ValueFactory::GetNullValueByType(TypeId::DECIMAL)}};
+  for (double key : {-1e300, -2.5, -1.0, -1e-300, 0.0, 1e-300, 0.5, 1.0, 1e300}) {
+    rows.push_back({ValueFactory::GetDecimalValue(key)});
+  }
+  CheckOrder<8>(decimal_schema.get(), rows);
+
+  Schema timestamp_schema({Column("a", TypeId::TIMESTAMP)});
+  rows = {{ValueFactory::GetTimestampValue(BUSTUB_TIMESTAMP_NULL)}};
+  for (uint64_t key : {uint64_t{0}, uint64_t{1}, uint64_t{1} << 40, uint64_t{1} << 62}) {
+    rows.push_back({ValueFactory::GetTimestampValue(key)});
+  }
+  CheckOrder<8>(&timestamp_schema, rows);
+}
+
+TEST(KeyEncodingTest, CompositeOrderTest) {
+  // a string sorts before its extensions, even when the next column is larger, and zero bytes are escaped
+  auto key_schema = ParseCreateStatement("a varchar(16),b integer");
+  auto row = [](const std::string &a, int32_t b) -> std::vector<Value> {
+    return {ValueFactory::GetVarcharValue(a), ValueFactory::GetIntegerValue(b)};
+  };
+  std::vector<std::vector<Value>> rows{
+      {ValueFactory::GetNullValueByType(TypeId::VARCHAR), ValueFactory::GetIntegerValue(100)},
+      row("", -5),
+      row("", 7),
+      row("a", 1000),
+      row(std::string("a\0", 2), -1),
+      row(std::string("a\0b", 3), 0),
+      row("ab", -1000),
+      row("b", 0),
+      row("\xff", 0),
+  };
+  CheckOrder<32>(key_schema.get(), rows);
+}
+
+TEST(KeyEncodingTest, RoundTripTest) {
+  auto key_schema = ParseCreateStatement("a tinyint,b smallint,c integer,d varchar(8),e double,f boolean");
+  std::vector<Value> values{ValueFactory::GetTinyIntValue(-7),
+                            ValueFactory::GetSmallIntValue(-300),
+                            ValueFactory::GetNullValueByType(TypeId::INTEGER),
+                            ValueFactory::GetVarcharValue(std::string("x\0y", 3)),
+                            ValueFactory::GetDecimalValue(-3.25),
+                            ValueFactory::GetBooleanValue(true)};
+  GenericKey<64> key;
+  ASSERT_TRUE(key.SetFromValues(values));
+  for (uint32_t i = 0; i < values.size(); i++) {
+    auto value = key.ToValue(key_schema.get(), i);
+    EXPECT_EQ(value.IsNull(), values[i].IsNull()) << i;
+    if (!values[i].IsNull()) {
+      EXPECT_EQ(value.CompareEquals(values[i]), CmpBool::CmpTrue) << i;
+    }
+  }
+  auto string = key.ToValue(key_schema.get(), 3);
+  EXPECT_EQ(std::string(string.GetData(), string.GetLength() - 1), std::string("x\0y", 3));
+
+  // keys that do not fit are cut off, but still decode
+  GenericKey<4> short_key;
+  EXPECT_FALSE(short_key.SetFromValues({ValueFactory::GetVarcharValue("abcdef")}));
+  auto prefix = short_key.ToValue(ParseCreateStatement("a varchar(8)").get(), 0);
+  EXPECT_EQ(prefix.ToString(), "abc");
+}
+
+TEST(KeyEncodingTest, TestIntegerKeyTest) {
+  GenericKey<8> key;
+  for (int64_t value : {int64_t{-1}, int64_t{0}, int64_t{42}, BUSTUB_INT64_MAX}) {
+    key.SetFromInteger(value);
+    EXPECT_EQ(key.ToString(), value);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,769 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "container/disk/hash/disk_extendible_hash_table.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "container/hash/extendible_hash_table.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/b_epsilon_tree.h"
+#include "storage/index/b_plus_tree.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+const char *const BENCH_DB_FILE = "bustub-b-plus-tree-bench.db";
+
+// Counts the pages fetched from it, and the pages allocated and freed
+class CountingBufferPoolManager : public BufferPoolManagerInstance {
+ public:
+  using BufferPoolManagerInstance::BufferPoolManagerInstance;
+
+  std::atomic<int64_t> num_fetches_{0};
+  std::atomic<int64_t> num_new_pages_{0};
+  std::atomic<int64_t> num_deleted_pages_{0};
+
+ protected:
+  auto FetchPgImp(page_id_t page_id) -> Page * override {
+    num_fetches_++;
+    return BufferPoolManagerInstance::FetchPgImp(page_id);
+  }
+
+  auto NewPgImp(page_id_t *page_id) -> Page * override {
+    num_new_pages_++;
+    return BufferPoolManagerInstance::NewPgImp(page_id);
+  }
+
+  auto DeletePgImp(page_id_t page_id) -> bool override {
+    num_deleted_pages_++;
+    return BufferPoolManagerInstance::DeletePgImp(page_id);
+  }
+};
+
+auto ElapsedSeconds(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto ColumnTypes(const Schema &key_schema) -> std::string {
+  std::string types;
+  for (const auto &column : key_schema.GetColumns()) {
+    types += (types.empty() ? "" : ",") + Type::TypeIdToString(column.GetType());
+  }
+  return types;
+}
+
+// Integer columns hold key, VARCHAR columns a string that sorts like key
+template <size_t KeySize>
+auto MakeKey(Schema *key_schema, int64_t key) -> GenericKey<KeySize> {
+  std::vector<Value> values;
+  for (const auto &column : key_schema->GetColumns()) {
+    if (column.GetType() == TypeId::VARCHAR) {
+      values.push_back(ValueFactory::GetVarcharValue(fmt::format("key-{:012}", key)));
+    } else {
+      values.push_back(ValueFactory::GetBigIntValue(key).CastAs(column.GetType()));
+    }
+  }
+  GenericKey<KeySize> index_key;
+  index_key.SetFromKey(Tuple(values, key_schema), key_schema);
+  return index_key;
+}
+
+/*
+ * Search a full leaf page for random keys, which is what every lookup ends
+ * with, without going through the buffer pool. Reports searches per second.
+ */
+template <size_t KeySize>
+void BenchLeafSearch(const Schema &schema, int64_t num_searches) {
+  using KeyType = GenericKey<KeySize>;
+  using ValueType = RID;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, GenericComparator<KeySize>>;
+  Schema key_schema(schema);
+  GenericComparator<KeySize> comparator(&key_schema);
+
+  std::vector<char> page(BUSTUB_PAGE_SIZE);
+  auto *leaf = reinterpret_cast<LeafPage *>(page.data());
+  leaf->Init(INVALID_PAGE_ID, INVALID_PAGE_ID);
+  // long keys fill the page before its max size
+  while (!leaf->IsOverflow()) {
+    leaf->InsertAt(leaf->GetSize(), MakeKey<KeySize>(&key_schema, 2 * leaf->GetSize()), RID(0, leaf->GetSize()));
+  }
+  int size = leaf->GetSize();
+
+  std::vector<KeyType> search_keys;
+  std::mt19937_64 generator(15445);
+  std::uniform_int_distribution<int64_t> distribution(0, 2 * size);
+  for (int64_t i = 0; i < num_searches; i++) {
+    search_keys.push_back(MakeKey<KeySize>(&key_schema, distribution(generator)));
+  }
+
+  int64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &key : search_keys) {
+    checksum += leaf->BisectPosition(key, comparator);
+  }
+  auto seconds = ElapsedSeconds(start);
+  std::cout << fmt::format("leaf search, ({}) {} byte keys, {} entries: {:.0f} searches/s (checksum {})",
+                           ColumnTypes(key_schema), KeySize, size, num_searches / seconds, checksum)
+            << std::endl;
+}
+
+/*
+ * Bulk load num_keys keys of one integer column, then look up random keys
+ * that all exist. Reports lookups per second.
+ */
+template <size_t KeySize>
+void BenchPointLookups(TypeId type, int64_t num_keys, int64_t num_lookups) {
+  using KeyType = GenericKey<KeySize>;
+  Schema key_schema({Column("key", type)});
+  GenericComparator<KeySize> comparator(&key_schema);
+
+  auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+  auto *bpm = new CountingBufferPoolManager(num_keys / 64 + 256, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  {
+    BPlusTree<KeyType, RID, GenericComparator<KeySize>> tree("bench", bpm, comparator);
+    int64_t next_key = 0;
+    tree.BulkLoad([&](std::pair<KeyType, RID> *pair) {
+      if (next_key == num_keys) {
+        return false;
+      }
+      *pair = {MakeKey<KeySize>(&key_schema, next_key), RID(0, next_key)};
+      next_key++;
+      return true;
+    });
+
+    std::vector<KeyType> lookup_keys;
+    std::mt19937_64 generator(15445);
+    std::uniform_int_distribution<int64_t> distribution(0, num_keys - 1);
+    for (int64_t i = 0; i < num_lookups; i++) {
+      lookup_keys.push_back(MakeKey<KeySize>(&key_schema, distribution(generator)));
+    }
+
+    std::vector<RID> result;
+    int64_t found = 0;
+    bpm->num_fetches_ = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &key : lookup_keys) {
+      result.clear();
+      found += static_cast<int64_t>(tree.GetValue(key, &result));
+    }
+    auto seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("point lookup, {} byte keys: {:.0f} lookups/s, {:.2f} page fetches each ({} of {} found)",
+                             KeySize, num_lookups / seconds, static_cast<double>(bpm->num_fetches_) / num_lookups,
+                             found, num_lookups)
+              << std::endl;
+
+    // the same keys in batches, sorted like an index join sorts them
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    std::vector<KeyType> batch;
+    std::vector<std::vector<RID>> results;
+    for (size_t first = 0; first < lookup_keys.size(); first += INDEX_JOIN_BATCH_SIZE) {
+      auto last = std::min(lookup_keys.size(), first + INDEX_JOIN_BATCH_SIZE);
+      batch.assign(lookup_keys.begin() + first, lookup_keys.begin() + last);
+      std::sort(batch.begin(), batch.end(),
+                [&comparator](const KeyType &a, const KeyType &b) { return comparator(a, b) < 0; });
+      tree.GetValues(batch, &results);
+      for (const auto &values : results) {
+        found += static_cast<int64_t>(!values.empty());
+      }
+    }
+    seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("batched lookup, {} byte keys, {} per batch: {:.0f} lookups/s ({} of {} found)", KeySize,
+                             INDEX_JOIN_BATCH_SIZE, num_lookups / seconds, found, num_lookups)
+              << std::endl;
+  }
+  bpm->UnpinPage(header_page_id, true);
+  delete bpm;
+  delete disk_manager;
+  std::remove(BENCH_DB_FILE);
+}
+
+/*
+ * Bulk load num_keys BIGINT keys, then count the keys in [num_keys / 4,
+ * num_keys) on one thread per range the tree splits it into. Reports keys
+ * counted per second for every number of threads.
+ */
+void BenchParallelRangeCount(int64_t num_keys) {
+  using KeyType = GenericKey<8>;
+  Schema key_schema({Column("key", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+
+  auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+  auto *bpm = new BufferPoolManagerInstance(num_keys / 64 + 256, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  {
+    BPlusTree<KeyType, RID, GenericComparator<8>> tree("bench", bpm, comparator);
+    int64_t next_key = 0;
+    tree.BulkLoad([&](std::pair<KeyType, RID> *pair) {
+      if (next_key == num_keys) {
+        return false;
+      }
+      *pair = {MakeKey<8>(&key_schema, next_key), RID(0, next_key)};
+      next_key++;
+      return true;
+    });
+
+    auto low = MakeKey<8>(&key_schema, num_keys / 4);
+    for (int num_threads : {1, 2, 4, 8}) {
+      auto start = std::chrono::steady_clock::now();
+      auto split_keys = tree.SplitKeys(low, std::nullopt, num_threads);
+      split_keys.insert(split_keys.begin(), low);
+      std::vector<int64_t> counts(split_keys.size());
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < split_keys.size(); i++) {
+        threads.emplace_back([&, i]() {
+          int64_t count = 0;
+          for (auto iterator = tree.Begin(split_keys[i]); !iterator.IsEnd(); ++iterator) {
+            if (i + 1 < split_keys.size() && comparator((*iterator).first, split_keys[i + 1]) >= 0) {
+              break;
+            }
+            count++;
+          }
+          counts[i] = count;
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      auto seconds = ElapsedSeconds(start);
+      auto count = std::accumulate(counts.begin(), counts.end(), int64_t{0});
+      std::cout << fmt::format("range count, {} of {} keys, {} ranges: {:.0f} keys/s", count, num_keys,
+                               split_keys.size(), count / seconds)
+                << std::endl;
+    }
+  }
+  bpm->UnpinPage(header_page_id, true);
+  delete bpm;
+  delete disk_manager;
+  std::remove(BENCH_DB_FILE);
+}
+
+/*
+ * Index a VARCHAR(128) column of num_rows rows, whose strings have 52 to 109
+ * characters, then look up random strings that all exist through the index
+ * and by scanning the table. Reports the latency of both.
+ */
+void BenchVarcharLookups(int64_t num_rows, int64_t num_lookups, int64_t num_scans) {
+  auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+  auto *bpm = new BufferPoolManagerInstance(num_rows / 8 + 256, disk_manager);
+  {
+    Catalog catalog(bpm, nullptr, nullptr);
+    Transaction txn(0);
+    Schema schema({Column("id", TypeId::INTEGER), Column("name", TypeId::VARCHAR, 128)});
+    auto name_of = [](int64_t row) { return fmt::format("{}{:012}", std::string(40 + row % 58, 'x'), row); };
+    auto *table_info = catalog.CreateTable(&txn, "bench", schema);
+    RID rid;
+    for (int64_t row = 0; row < num_rows; row++) {
+      table_info->table_->InsertTuple(
+          Tuple({ValueFactory::GetIntegerValue(row), ValueFactory::GetVarcharValue(name_of(row))}, &schema), &rid,
+          &txn);
+    }
+    auto *index_info = catalog.CreateIndex(&txn, "bench_name", "bench", schema, {1});
+
+    std::mt19937_64 generator(15445);
+    std::uniform_int_distribution<int64_t> distribution(0, num_rows - 1);
+    std::vector<Value> lookup_names;
+    for (int64_t i = 0; i < num_lookups; i++) {
+      lookup_names.push_back(ValueFactory::GetVarcharValue(name_of(distribution(generator))));
+    }
+
+    std::vector<RID> result;
+    int64_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &name : lookup_names) {
+      result.clear();
+      index_info->index_->ScanKey(Tuple({name}, &index_info->key_schema_), &result, &txn);
+      found += static_cast<int64_t>(result.size());
+    }
+    auto seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("varchar(128) point lookup, {} byte keys, {} rows: {:.2f} us per lookup ({} of {} found)",
+                             index_info->key_size_, num_rows, seconds * 1e6 / num_lookups, found, num_lookups)
+              << std::endl;
+
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < num_scans; i++) {
+      const auto &name = lookup_names[i % lookup_names.size()];
+      for (auto iter = table_info->table_->Begin(&txn); iter != table_info->table_->End(); ++iter) {
+        found += static_cast<int64_t>(iter->GetValue(&schema, 1).CompareEquals(name) == CmpBool::CmpTrue);
+      }
+    }
+    seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("varchar(128) sequential scan, {} rows: {:.2f} us per lookup ({} of {} found)", num_rows,
+                             seconds * 1e6 / num_scans, found, num_scans)
+              << std::endl;
+  }
+  delete bpm;
+  delete disk_manager;
+  std::remove(BENCH_DB_FILE);
+}
+
+/*
+ * Index a VARCHAR(128) column of num_rows URLs, which share long prefixes,
+ * with a b+ tree index and an adaptive radix tree index, then look up random
+ * URLs through both and scan ranges of 100 URLs from random URLs on. Reports
+ * how long building the index, a lookup and a range scan take.
+ */
+void BenchStringIndexes(int64_t num_rows, int64_t num_lookups, int64_t num_scans) {
+  using TreeIndex = BPlusTreeIndex<GenericKey<256>, RID, GenericComparator<256>>;
+  auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+  auto *bpm = new BufferPoolManagerInstance(num_rows / 4 + 256, disk_manager);
+  {
+    Catalog catalog(bpm, nullptr, nullptr);
+    Transaction txn(0);
+    Schema schema({Column("id", TypeId::INTEGER), Column("name", TypeId::VARCHAR, 128)});
+    auto name_of = [](int64_t row) {
+      return fmt::format("https://www.shop{}.example.com/products/{}/item-{}", row % 50, row % 1000, row);
+    };
+    auto *table_info = catalog.CreateTable(&txn, "bench", schema);
+    RID rid;
+    for (int64_t row = 0; row < num_rows; row++) {
+      table_info->table_->InsertTuple(
+          Tuple({ValueFactory::GetIntegerValue(row), ValueFactory::GetVarcharValue(name_of(row))}, &schema), &rid,
+          &txn);
+    }
+
+    std::mt19937_64 generator(15445);
+    std::uniform_int_distribution<int64_t> distribution(0, num_rows - 1);
+    std::vector<Value> lookup_names;
+    for (int64_t i = 0; i < num_lookups; i++) {
+      lookup_names.push_back(ValueFactory::GetVarcharValue(name_of(distribution(generator))));
+    }
+
+    for (auto index_type : {IndexType::BPlusTreeIndex, IndexType::ArtIndex}) {
+      auto index_name = index_type == IndexType::ArtIndex ? "radix tree" : "b+ tree";
+      auto start = std::chrono::steady_clock::now();
+      auto *index_info =
+          catalog.CreateIndex(&txn, fmt::format("bench_{}", index_name), "bench", schema, {1}, false, index_type);
+      auto build_seconds = ElapsedSeconds(start);
+
+      std::vector<RID> result;
+      int64_t found = 0;
+      start = std::chrono::steady_clock::now();
+      for (const auto &name : lookup_names) {
+        result.clear();
+        index_info->index_->ScanKey(Tuple({name}, &index_info->key_schema_), &result, &txn);
+        found += static_cast<int64_t>(result.size());
+      }
+      auto lookup_seconds = ElapsedSeconds(start);
+
+      int64_t scanned = 0;
+      start = std::chrono::steady_clock::now();
+      for (int64_t i = 0; i < num_scans; i++) {
+        Tuple begin({lookup_names[i % lookup_names.size()]}, &index_info->key_schema_);
+        if (index_type == IndexType::ArtIndex) {
+          auto cursor = dynamic_cast<ArtIndex *>(index_info->index_.get())->ScanRange(begin, std::nullopt);
+          for (int j = 0; j < 100 && cursor->Next(&rid); j++) {
+            scanned++;
+          }
+        } else {
+          GenericKey<256> begin_key;
+          begin_key.SetFromKey(begin, &index_info->key_schema_);
+          auto iter = dynamic_cast<TreeIndex *>(index_info->index_.get())->GetBeginIterator(begin_key);
+          for (int j = 0; j < 100 && !iter.IsEnd(); j++, ++iter) {
+            scanned++;
+          }
+        }
+      }
+      auto scan_seconds = ElapsedSeconds(start);
+      std::cout << fmt::format("varchar(128) {} index, {} rows: build {:.2f} s, {:.2f} us per lookup ({} of {} found), "
+                               "{:.2f} us per range of 100 ({} scanned)",
+                               index_name, num_rows, build_seconds, lookup_seconds * 1e6 / num_lookups, found,
+                               num_lookups, scan_seconds * 1e6 / num_scans, scanned)
+                << std::endl;
+    }
+  }
+  delete bpm;
+  delete disk_manager;
+  std::remove(BENCH_DB_FILE);
+}
+
+/*
+ * Insert num_keys keys in random order into a tree whose buffer pool only
+ * holds pool_size pages, then flush it. Reports inserts per second and the
+ * page reads and writes it took, and then the rate of point lookups.
+ */
+template <typename Tree, size_t KeySize>
+void BenchRandomInserts(const std::string &tree_name, TypeId type, int64_t num_keys, int64_t num_lookups,
+                        size_t pool_size) {
+  Schema key_schema({Column("key", type)});
+  GenericComparator<KeySize> comparator(&key_schema);
+
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; i++) {
+    keys[i] = i;
+  }
+  std::mt19937_64 generator(15445);
+  std::shuffle(keys.begin(), keys.end(), generator);
+
+  auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  {
+    Tree tree("bench", bpm, comparator);
+    auto start = std::chrono::steady_clock::now();
+    for (auto key : keys) {
+      tree.Insert(MakeKey<KeySize>(&key_schema, key), RID(0, key));
+    }
+    bpm->FlushAllPages();
+    auto seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("{} random insert, {} byte keys, {} page pool: {:.0f} inserts/s, {} reads, {} writes",
+                             tree_name, KeySize, pool_size, num_keys / seconds, disk_manager->GetNumReads(),
+                             disk_manager->GetNumWrites())
+              << std::endl;
+
+    std::uniform_int_distribution<int64_t> distribution(0, num_keys - 1);
+    std::vector<RID> result;
+    int64_t found = 0;
+    int reads = disk_manager->GetNumReads();
+    start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < num_lookups; i++) {
+      result.clear();
+      found += static_cast<int64_t>(tree.GetValue(MakeKey<KeySize>(&key_schema, distribution(generator)), &result));
+    }
+    seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("{} point lookup after random inserts: {:.0f} lookups/s, {} reads ({} of {} found)",
+                             tree_name, num_lookups / seconds, disk_manager->GetNumReads() - reads, found,
+                             num_lookups)
+              << std::endl;
+  }
+  bpm->UnpinPage(header_page_id, true);
+  delete bpm;
+  delete disk_manager;
+  std::remove(BENCH_DB_FILE);
+}
+
+/*
+ * Point lookups of random keys in a B+ tree and in a disk extendible hash
+ * table holding the same num_keys keys, from one thread and from four. The
+ * hash table directory is a single page, which caps num_keys. Reports
+ * lookups per second and page fetches per lookup.
+ */
+void BenchHashLookups(int64_t num_keys, int64_t num_lookups) {
+  using KeyType = GenericKey<8>;
+  Schema key_schema({Column("key", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+  std::vector<KeyType> lookup_keys;
+  std::mt19937_64 generator(15445);
+  std::uniform_int_distribution<int64_t> distribution(0, num_keys - 1);
+  for (int64_t i = 0; i < num_lookups; i++) {
+    lookup_keys.push_back(MakeKey<8>(&key_schema, distribution(generator)));
+  }
+
+  auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+  auto *bpm = new CountingBufferPoolManager(num_keys / 32 + 256, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  {
+    BPlusTree<KeyType, RID, GenericComparator<8>> tree("bench", bpm, comparator);
+    DiskExtendibleHashTable<KeyType, RID, GenericComparator<8>> hash_table("bench", bpm, comparator,
+                                                                          HashFunction<KeyType>());
+    for (int64_t key = 0; key < num_keys; key++) {
+      tree.Insert(MakeKey<8>(&key_schema, key), RID(0, key));
+      hash_table.Insert(nullptr, MakeKey<8>(&key_schema, key), RID(0, key));
+    }
+    auto run = [&](const std::string &index_name, const std::function<bool(const KeyType &)> &lookup) {
+      for (int num_threads : {1, 4}) {
+        std::atomic<int64_t> found{0};
+        bpm->num_fetches_ = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+          threads.emplace_back([&, thread_id] {
+            int64_t thread_found = 0;
+            for (auto i = static_cast<size_t>(thread_id); i < lookup_keys.size(); i += num_threads) {
+              thread_found += static_cast<int64_t>(lookup(lookup_keys[i]));
+            }
+            found += thread_found;
+          });
+        }
+        for (auto &thread : threads) {
+          thread.join();
+        }
+        auto seconds = ElapsedSeconds(start);
+        std::cout << fmt::format("{} equality lookup, {} keys, {} threads: {:.0f} lookups/s, {:.2f} page fetches each "
+                                 "({} of {} found)",
+                                 index_name, num_keys, num_threads, num_lookups / seconds,
+                                 static_cast<double>(bpm->num_fetches_) / num_lookups, found.load(), num_lookups)
+                  << std::endl;
+      }
+    };
+    run("b+ tree", [&tree](const KeyType &key) {
+      std::vector<RID> result;
+      return tree.GetValue(key, &result);
+    });
+    run("extendible hash", [&hash_table](const KeyType &key) {
+      std::vector<RID> result;
+      return hash_table.GetValue(nullptr, key, &result);
+    });
+  }
+  bpm->UnpinPage(header_page_id, true);
+  delete bpm;
+  delete disk_manager;
+  std::remove(BENCH_DB_FILE);
+}
+
+/*
+ * Loads num_keys keys into a disk extendible hash table, a linear probe hash
+ * table that resizes incrementally and one that moves every pair at once
+ * when it resizes, each starting out with a single page of slots. Reports
+ * the load factor, how long inserts take (the slowest ones pay for the
+ * resizes) and how long random lookups take.
+ */
+void BenchHashResize(int64_t num_keys, int64_t num_lookups) {
+  using KeyType = GenericKey<8>;
+  using ValueType = RID;
+  using Comparator = GenericComparator<8>;
+  Schema key_schema({Column("key", TypeId::BIGINT)});
+  Comparator comparator(&key_schema);
+  std::vector<KeyType> lookup_keys;
+  std::mt19937_64 generator(15445);
+  std::uniform_int_distribution<int64_t> distribution(0, num_keys - 1);
+  for (int64_t i = 0; i < num_lookups; i++) {
+    lookup_keys.push_back(MakeKey<8>(&key_schema, distribution(generator)));
+  }
+  auto percentile = [](std::vector<double> *values, double fraction) {
+    auto pos = values->begin() + static_cast<int64_t>(fraction * (values->size() - 1));
+    std::nth_element(values->begin(), pos, values->end());
+    return *pos;
+  };
+
+  auto bench = [&](const std::string &table_name, auto make_table, auto num_slots) {
+    auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+    auto *bpm = new CountingBufferPoolManager(num_keys / 32 + 256, disk_manager);
+    {
+      auto table = make_table(bpm);
+      std::vector<double> micros(num_keys);
+      for (int64_t key = 0; key < num_keys; key++) {
+        auto start = std::chrono::steady_clock::now();
+        table->Insert(nullptr, MakeKey<8>(&key_schema, key), RID(0, key));
+        micros[key] = ElapsedSeconds(start) * 1e6;
+      }
+      auto insert_average = std::accumulate(micros.begin(), micros.end(), 0.0) / num_keys;
+      auto insert_max = *std::max_element(micros.begin(), micros.end());
+      auto insert_p999 = percentile(&micros, 0.999);
+
+      std::vector<double> nanos(num_lookups);
+      int64_t found = 0;
+      std::vector<RID> result;
+      for (int64_t i = 0; i < num_lookups; i++) {
+        result.clear();
+        auto start = std::chrono::steady_clock::now();
+        found += static_cast<int64_t>(table->GetValue(nullptr, lookup_keys[i], &result));
+        nanos[i] = ElapsedSeconds(start) * 1e9;
+      }
+      auto lookup_average = std::accumulate(nanos.begin(), nanos.end(), 0.0) / num_lookups;
+      std::cout << fmt::format("{}, {} keys: load factor {:.2f}, insert {:.2f} us avg, {:.0f} us p99.9, {:.0f} us max; "
+                               "lookup {:.0f} ns avg, {:.0f} ns p99 ({} of {} found)",
+                               table_name, num_keys, num_keys / num_slots(table.get(), bpm), insert_average,
+                               insert_p999, insert_max, lookup_average, percentile(&nanos, 0.99), found, num_lookups)
+                << std::endl;
+    }
+    delete bpm;
+    delete disk_manager;
+    std::remove(BENCH_DB_FILE);
+  };
+
+  bench(
+      "extendible hash",
+      [&](BufferPoolManager *bpm) {
+        return std::make_unique<DiskExtendibleHashTable<KeyType, ValueType, Comparator>>("bench", bpm, comparator,
+                                                                                         HashFunction<KeyType>());
+      },
+      [](auto *table, CountingBufferPoolManager *bpm) {
+        // every page but the directory is a bucket
+        return static_cast<double>(bpm->num_new_pages_ - bpm->num_deleted_pages_ - 1) * BUCKET_ARRAY_SIZE;
+      });
+  for (auto [table_name, resize_step] : {std::make_pair("linear probe hash, incremental resize",
+                                                        static_cast<size_t>(LINEAR_PROBE_RESIZE_STEP)),
+                                         std::make_pair("linear probe hash, full rehash",
+                                                        std::numeric_limits<size_t>::max())}) {
+    bench(
+        table_name,
+        [&, resize_step = resize_step](BufferPoolManager *bpm) {
+          return std::make_unique<LinearProbeHashTable<KeyType, ValueType, Comparator>>(
+              "bench", bpm, comparator, 0, HashFunction<KeyType>(), resize_step);
+        },
+        [](auto *table, CountingBufferPoolManager *bpm) { return static_cast<double>(table->GetSize()); });
+  }
+}
+
+/*
+ * Looks up random keys of an in-memory extendible hash table, the page table
+ * of the buffer pool, from several threads at once. Reports lookups per
+ * second, which grow with the threads only as far as there are cores.
+ */
+void BenchPageTableLookups(int64_t num_keys, int64_t num_lookups) {
+  ExtendibleHashTable<page_id_t, frame_id_t> page_table(4);
+  for (int64_t key = 0; key < num_keys; key++) {
+    page_table.Insert(static_cast<page_id_t>(key), static_cast<frame_id_t>(key));
+  }
+  std::vector<page_id_t> lookup_keys;
+  std::mt19937_64 generator(15445);
+  std::uniform_int_distribution<page_id_t> distribution(0, static_cast<page_id_t>(num_keys - 1));
+  for (int64_t i = 0; i < num_lookups; i++) {
+    lookup_keys.push_back(distribution(generator));
+  }
+  for (int num_threads : {1, 2, 4}) {
+    std::atomic<int64_t> found{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+      threads.emplace_back([&, thread_id] {
+        int64_t thread_found = 0;
+        frame_id_t frame_id;
+        for (auto i = static_cast<size_t>(thread_id); i < lookup_keys.size(); i += num_threads) {
+          thread_found += static_cast<int64_t>(page_table.Find(lookup_keys[i], frame_id));
+        }
+        found += thread_found;
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("page table lookup, {} keys, {} threads: {:.0f} lookups/s ({} of {} found)", num_keys,
+                             num_threads, num_lookups / seconds, found.load(), num_lookups)
+              << std::endl;
+  }
+}
+
+/*
+ * Remove every other key of a random window and insert them again, which
+ * takes the leaves of the window from about 70% full to below half and back.
+ * Run once per merge fill, reports the pages allocated by splits and freed by
+ * merges, the page writes of a pool_size page buffer pool, and what a
+ * compaction reclaims after every other key of a quarter of the keys is gone.
+ */
+void BenchDeleteChurn(int64_t num_keys, int64_t num_rounds, size_t pool_size) {
+  Schema key_schema({Column("key", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+  std::vector<int64_t> keys(num_keys);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::mt19937_64 generator(15445);
+  std::shuffle(keys.begin(), keys.end(), generator);
+  auto window = std::max<int64_t>(num_keys / 100, 2);
+
+  for (double merge_fill : {0.5, 0.25, 0.0}) {
+    auto *disk_manager = new DiskManager(BENCH_DB_FILE);
+    auto *bpm = new CountingBufferPoolManager(pool_size, disk_manager);
+    page_id_t header_page_id;
+    bpm->NewPage(&header_page_id);
+    {
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+          "bench", bpm, comparator, LEAF_PAGE_USABLE_SIZE / sizeof(BPlusTreeLeafSlot<GenericKey<8>, RID>),
+          INTERNAL_PAGE_SIZE, true, merge_fill);
+      for (auto key : keys) {
+        tree.Insert(MakeKey<8>(&key_schema, key), RID(0, key));
+      }
+      bpm->FlushAllPages();
+      int64_t new_pages = bpm->num_new_pages_;
+      int64_t deleted_pages = bpm->num_deleted_pages_;
+      int writes = disk_manager->GetNumWrites();
+      std::uniform_int_distribution<int64_t> distribution(0, num_keys - window);
+      std::mt19937_64 round_generator(15445);
+      auto start = std::chrono::steady_clock::now();
+      for (int64_t round = 0; round < num_rounds; round++) {
+        auto first = distribution(round_generator);
+        for (auto key = first; key < first + window; key += 2) {
+          tree.Remove(MakeKey<8>(&key_schema, key));
+        }
+        for (auto key = first; key < first + window; key += 2) {
+          tree.Insert(MakeKey<8>(&key_schema, key), RID(0, key));
+        }
+      }
+      bpm->FlushAllPages();
+      auto seconds = ElapsedSeconds(start);
+      std::cout << fmt::format(
+                       "delete churn, merge fill {}: {:.0f} ops/s, {} pages split off, {} merged away, {} writes, "
+                       "leaves {:.0f}% full",
+                       merge_fill, num_rounds * window / seconds, bpm->num_new_pages_ - new_pages,
+                       bpm->num_deleted_pages_ - deleted_pages, disk_manager->GetNumWrites() - writes,
+                       tree.GetStatistics().leaf_fill_factor_ * 100)
+                << std::endl;
+
+      // leave the first quarter of the keys half as dense for compaction to clean up
+      for (int64_t key = 0; key < num_keys / 4; key += 2) {
+        tree.Remove(MakeKey<8>(&key_schema, key));
+      }
+      auto num_leaves = tree.GetStatistics().num_leaves_;
+      start = std::chrono::steady_clock::now();
+      tree.Compact();
+      seconds = ElapsedSeconds(start);
+      std::cout << fmt::format("compaction after merge fill {}: {} of {} leaves reclaimed in {:.3f} s", merge_fill,
+                               num_leaves - tree.GetStatistics().num_leaves_, num_leaves, seconds)
+                << std::endl;
+    }
+    bpm->UnpinPage(header_page_id, true);
+    delete bpm;
+    delete disk_manager;
+    std::remove(BENCH_DB_FILE);
+  }
+}
+
+}  // namespace bustub
+
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-b-plus-tree-bench");
+  program.add_argument("--keys").help("number of keys in the tree").default_value(std::string("1000000"));
+  program.add_argument("--lookups").help("number of point lookups").default_value(std::string("1000000"));
+  program.add_argument("--pool-size")
+      .help("buffer pool pages of the random insert benchmark")
+      .default_value(std::string("256"));
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  auto num_keys = std::stoll(program.get("--keys"));
+  auto num_lookups = std::stoll(program.get("--lookups"));
+  bustub::BenchLeafSearch<4>(bustub::Schema({bustub::Column("a", bustub::TypeId::INTEGER)}), num_lookups);
+  bustub::BenchLeafSearch<8>(bustub::Schema({bustub::Column("a", bustub::TypeId::BIGINT)}), num_lookups);
+  bustub::BenchLeafSearch<32>(
+      bustub::Schema({bustub::Column("a", bustub::TypeId::INTEGER), bustub::Column("b", bustub::TypeId::VARCHAR, 16)}),
+      num_lookups);
+  bustub::BenchPointLookups<4>(bustub::TypeId::INTEGER, num_keys, num_lookups);
+  bustub::BenchPointLookups<8>(bustub::TypeId::BIGINT, num_keys, num_lookups);
+  bustub::BenchParallelRangeCount(num_keys);
+  bustub::BenchHashLookups(std::min<int64_t>(num_keys, 50000), num_lookups);
+  bustub::BenchHashResize(std::min<int64_t>(num_keys, 50000), num_lookups);
+  bustub::BenchPageTableLookups(num_keys, num_lookups);
+  // scans read the whole table, a few of them are enough
+  bustub::BenchVarcharLookups(std::min<int64_t>(num_keys, 200000), num_lookups, 20);
+  bustub::BenchStringIndexes(std::min<int64_t>(num_keys, 200000), num_lookups, num_lookups / 10);
+
+  // the same random inserts into a B+ tree and a B-epsilon tree, with a buffer pool much smaller than the trees
+  auto pool_size = std::stoull(program.get("--pool-size"));
+  using Comparator = bustub::GenericComparator<8>;
+  bustub::BenchRandomInserts<bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, Comparator>, 8>(
+      "b+ tree", bustub::TypeId::BIGINT, num_keys, num_lookups, pool_size);
+  bustub::BenchRandomInserts<bustub::BEpsilonTree<bustub::GenericKey<8>, bustub::RID, Comparator>, 8>(
+      "b-epsilon tree", bustub::TypeId::BIGINT, num_keys, num_lookups, pool_size);
+  bustub::BenchDeleteChurn(num_keys, 200, pool_size);
+  return 0;
+}
@@ -0,0 +1,285 @@
+#include <malloc.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/rwlatch.h"
+#include "fmt/core.h"
+#include "primer/p0_trie.h"
+
+// Live heap bytes, counted by the allocation functions below
+static std::atomic<int64_t> heap_bytes{0};
+
+auto operator new(size_t size) -> void * {
+  void *ptr = std::malloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  heap_bytes += static_cast<int64_t>(malloc_usable_size(ptr));
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  if (ptr != nullptr) {
+    heap_bytes -= static_cast<int64_t>(malloc_usable_size(ptr));
+  }
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept { operator delete(ptr); }
+
+namespace bustub {
+
+/*
+ * The trie the primer started out with, one TrieNode per key character and a
+ * TrieNodeWithValue that a lookup finds with a dynamic_cast, to compare the
+ * adaptive radix tree of Trie against.
+ */
+class NodeTrie {
+ public:
+  NodeTrie() : root_(std::make_unique<TrieNode>('\0')) {}
+
+  template <typename T>
+  auto Insert(const std::string &key, T value) -> bool {
+    latch_.WLock();
+    std::unique_ptr<TrieNode> *node = &root_;
+    for (char c : key) {
+      auto *child = (*node)->GetChildNode(c);
+      node = child != nullptr ? child : (*node)->InsertChildNode(c, std::make_unique<TrieNode>(c));
+    }
+    if ((*node)->IsEndNode()) {
+      latch_.WUnlock();
+      return false;
+    }
+    node->reset(new TrieNodeWithValue<T>(std::move(**node), value));
+    latch_.WUnlock();
+    return true;
+  }
+
+  template <typename T>
+  auto GetValue(const std::string &key, bool *success) -> T {
+    latch_.RLock();
+    std::unique_ptr<TrieNode> *node = &root_;
+    for (char c : key) {
+      node = (*node)->GetChildNode(c);
+      if (node == nullptr) {
+        *success = false;
+        latch_.RUnlock();
+        return {};
+      }
+    }
+    auto *value_node = dynamic_cast<TrieNodeWithValue<T> *>(node->get());
+    *success = value_node != nullptr;
+    T value = *success ? value_node->GetValue() : T{};
+    latch_.RUnlock();
+    return value;
+  }
+
+ private:
+  std::unique_ptr<TrieNode> root_;
+  ReaderWriterLatch latch_;
+};
+
+auto ElapsedSeconds(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Made up words of one to four syllables, which share prefixes about as much as the words of a dictionary
+auto MakeWords(size_t num_words) -> std::vector<std::string> {
+  const std::string consonants = "bcdfghjklmnprstvwz";
+  const std::string vowels = "aeiouy";
+  std::mt19937 generator(15445);
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> words;
+  while (words.size() < num_words) {
+    std::string word;
+    auto num_syllables = 1 + generator() % 4;
+    for (size_t i = 0; i < num_syllables; i++) {
+      word.push_back(consonants[generator() % consonants.size()]);
+      word.push_back(vowels[generator() % vowels.size()]);
+      if (generator() % 3 == 0) {
+        word.push_back(consonants[generator() % consonants.size()]);
+      }
+    }
+    if (generator() % 4 == 0) {
+      word += generator() % 2 == 0 ? "ing" : "s";
+    }
+    if (seen.insert(word).second) {
+      words.push_back(word);
+    }
+  }
+  return words;
+}
+
+/*
+ * Inserts the words into a trie, then looks up num_lookups random words of
+ * them. Reports the heap the trie takes, how long the inserts took and how
+ * long a lookup takes.
+ */
+template <typename TrieType>
+void BenchTrie(const std::string &trie_name, const std::vector<std::string> &words, int64_t num_lookups) {
+  std::vector<const std::string *> lookups;
+  std::mt19937 generator(15445);
+  for (int64_t i = 0; i < num_lookups; i++) {
+    lookups.push_back(&words[generator() % words.size()]);
+  }
+
+  auto heap_before = heap_bytes.load();
+  auto trie = std::make_unique<TrieType>();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < words.size(); i++) {
+    trie->template Insert<int>(words[i], static_cast<int>(i));
+  }
+  auto insert_seconds = ElapsedSeconds(start);
+  auto trie_bytes = heap_bytes.load() - heap_before;
+
+  int64_t found = 0;
+  start = std::chrono::steady_clock::now();
+  for (const auto *word : lookups) {
+    bool success;
+    trie->template GetValue<int>(*word, &success);
+    found += static_cast<int64_t>(success);
+  }
+  auto lookup_seconds = ElapsedSeconds(start);
+  std::cout << fmt::format("{}, {} words: {:.1f} MiB, {:.0f} bytes per word, insert {:.3f} s, lookup {:.0f} ns "
+                           "({} of {} found)",
+                           trie_name, words.size(), trie_bytes / 1048576.0,
+                           static_cast<double>(trie_bytes) / words.size(), insert_seconds,
+                           lookup_seconds * 1e9 / num_lookups, found, num_lookups)
+            << std::endl;
+}
+
+// Trie behind one reader-writer latch, the way it was before readers took versions of it without a latch
+class LatchedTrie {
+ public:
+  template <typename T>
+  auto Insert(const std::string &key, T value) -> bool {
+    latch_.WLock();
+    auto inserted = trie_.Insert(key, value);
+    latch_.WUnlock();
+    return inserted;
+  }
+
+  auto Remove(const std::string &key) -> bool {
+    latch_.WLock();
+    auto removed = trie_.Remove(key);
+    latch_.WUnlock();
+    return removed;
+  }
+
+  template <typename T>
+  auto GetValue(const std::string &key, bool *success) -> T {
+    latch_.RLock();
+    auto value = trie_.GetValue<T>(key, success);
+    latch_.RUnlock();
+    return value;
+  }
+
+ private:
+  Trie trie_;
+  ReaderWriterLatch latch_;
+};
+
+/*
+ * Readers look up random words for a while, with and without a writer that
+ * inserts and removes other words all along. Reports the lookups and the
+ * writes per second.
+ */
+template <typename TrieType>
+void BenchReadsUnderWriter(const std::string &trie_name, const std::vector<std::string> &words, int num_readers) {
+  TrieType trie;
+  for (size_t i = 0; i < words.size(); i++) {
+    trie.template Insert<int>(words[i], static_cast<int>(i));
+  }
+  for (bool with_writer : {false, true}) {
+    std::atomic<bool> done{false};
+    std::atomic<int64_t> num_reads{0};
+    int64_t num_writes = 0;
+    std::vector<std::thread> readers;
+    for (int reader_id = 0; reader_id < num_readers; reader_id++) {
+      readers.emplace_back([&, reader_id] {
+        std::mt19937 generator(reader_id);
+        int64_t reads = 0;
+        while (!done) {
+          bool success;
+          trie.template GetValue<int>(words[generator() % words.size()], &success);
+          reads++;
+        }
+        num_reads += reads;
+      });
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (with_writer) {
+      for (size_t i = 0; ElapsedSeconds(start) < 1; i = (i + 1) % words.size()) {
+        auto key = words[i] + "~";
+        trie.template Insert<int>(key, 0);
+        trie.Remove(key);
+        num_writes += 2;
+      }
+    } else {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    done = true;
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    auto seconds = ElapsedSeconds(start);
+    std::cout << fmt::format("{}, {} readers, {}: {:.0f} lookups/s, {:.0f} writes/s", trie_name, num_readers,
+                             with_writer ? "one writer" : "no writer", num_reads / seconds, num_writes / seconds)
+              << std::endl;
+  }
+}
+
+}  // namespace bustub
+
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-trie-bench");
+  program.add_argument("--dict").help("file of words, one per line, made up words if not given");
+  program.add_argument("--words").help("number of made up words").default_value(std::string("235886"));
+  program.add_argument("--lookups").help("number of lookups").default_value(std::string("1000000"));
+  program.add_argument("--readers").help("number of reader threads next to the writer").default_value(std::string("3"));
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  std::vector<std::string> words;
+  if (auto dict = program.present("--dict")) {
+    std::unordered_set<std::string> seen;
+    std::ifstream file(*dict);
+    std::string word;
+    while (std::getline(file, word)) {
+      if (!word.empty() && seen.insert(word).second) {
+        words.push_back(word);
+      }
+    }
+  } else {
+    words = bustub::MakeWords(std::stoull(program.get("--words")));
+  }
+  if (words.empty()) {
+    std::cerr << "no words" << std::endl;
+    return 1;
+  }
+  auto num_lookups = std::stoll(program.get("--lookups"));
+  bustub::BenchTrie<bustub::NodeTrie>("node per character trie", words, num_lookups);
+  bustub::BenchTrie<bustub::Trie>("adaptive radix tree trie", words, num_lookups);
+  auto num_readers = std::stoi(program.get("--readers"));
+  bustub::BenchReadsUnderWriter<bustub::LatchedTrie>("trie under one latch", words, num_readers);
+  bustub::BenchReadsUnderWriter<bustub::Trie>("copy-on-write trie", words, num_readers);
+  return 0;
+}